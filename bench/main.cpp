@@ -0,0 +1,76 @@
+#include "Core/Benchmark.hpp"
+#include "Core/Device.hpp"
+#include "Core/Log.hpp"
+
+// [--name <name>] [--project <file.npj>] [--model <asset path>] [--models <n>] [--colliders <n>] [--warmup <n>]
+// [--frames <n>] [--width <n>] [--height <n>] [--radius <r>] [--output <path without extension>] [--window] [--statistics]
+// [--pipeline-cache <file>]
+static bool ParseArguments(int argc, char** argv, Nyxis::BenchmarkSettings& settings)
+{
+	for (int i = 1; i < argc; i++)
+	{
+		const std::string argument = argv[i];
+		const bool hasValue = i + 1 < argc;
+		if (argument == "--window")
+			settings.headless = false;
+		else if (argument == "--statistics")
+			settings.pipelineStatistics = true;
+		else if (argument == "--name" && hasValue)
+			settings.name = argv[++i];
+		else if (argument == "--project" && hasValue)
+			settings.projectPath = argv[++i];
+		else if (argument == "--model" && hasValue)
+			settings.modelPath = argv[++i];
+		else if (argument == "--models" && hasValue)
+			settings.modelCount = static_cast<uint32_t>(std::stoul(argv[++i]));
+		else if (argument == "--colliders" && hasValue)
+			settings.colliderCount = static_cast<uint32_t>(std::stoul(argv[++i]));
+		else if (argument == "--warmup" && hasValue)
+			settings.warmupFrames = static_cast<uint32_t>(std::stoul(argv[++i]));
+		else if (argument == "--frames" && hasValue)
+			settings.frameCount = static_cast<uint32_t>(std::stoul(argv[++i]));
+		else if (argument == "--width" && hasValue)
+			settings.width = static_cast<uint32_t>(std::stoul(argv[++i]));
+		else if (argument == "--height" && hasValue)
+			settings.height = static_cast<uint32_t>(std::stoul(argv[++i]));
+		else if (argument == "--radius" && hasValue)
+			settings.orbitRadius = std::stof(argv[++i]);
+		else if (argument == "--output" && hasValue)
+			settings.outputPath = argv[++i];
+		else if (argument == "--pipeline-cache" && hasValue)
+			Nyxis::Device::SetPipelineCachePath(argv[++i]);
+		else
+		{
+			std::cerr << "Unknown argument: " << argument << std::endl;
+			return false;
+		}
+	}
+	return true;
+}
+
+int main(int argc, char** argv)
+{
+	Nyxis::BenchmarkSettings settings{};
+	try
+	{
+		if (!ParseArguments(argc, argv, settings))
+			return EXIT_FAILURE;
+	}
+	catch (const std::exception &e)
+	{
+		std::cerr << "Invalid argument: " << e.what() << std::endl;
+		return EXIT_FAILURE;
+	}
+	Nyxis::Log::Init();
+	int result = EXIT_FAILURE;
+	try
+	{
+		result = Nyxis::Benchmark::Run(settings);
+	}
+	catch (const std::exception &e)
+	{
+		std::cerr << e.what() << std::endl;
+	}
+	Nyxis::Log::Shutdown();
+	return result;
+}
@@ -1,11 +1,17 @@
 #!/bin/bash
 
-# delete old spv files
-for FILE in *.spv;
-    do rm $FILE
-done
+# compiles the shaders of this directory and of pbr/, $1 is the compiler, e.g. glslc
+cd "$(dirname "$0")"
+shopt -s nullglob
+for DIRECTORY in . pbr;
+do
+    # delete old spv files
+    for FILE in $DIRECTORY/*.spv;
+        do rm $FILE
+    done
 
-# compile shaders
-for FILE in *.frag *.vert;
-    do $1 -c $FILE; 
-done
\ No newline at end of file
+    # compile shaders
+    for FILE in $DIRECTORY/*.frag $DIRECTORY/*.vert $DIRECTORY/*.comp;
+        do $1 -c $FILE -o $FILE.spv;
+    done
+done
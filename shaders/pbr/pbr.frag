@@ -23,6 +23,7 @@ layout (set = 0, binding = 0) uniform UBO {
 	uint entityID;
 	uint selectedEntityID;
 	bool isMouseClicked;
+	int jointOffset;
 } ubo;
 
 layout (set = 0, binding = 1) uniform UBOParams {
@@ -74,6 +75,21 @@ layout (push_constant) uniform Material {
 	uint nodeID;
 } material;
 
+// Specialization constants: the generic variant keeps every path and checks the material at runtime,
+// specialized variants get the feature set of their materials baked in and drop the unused paths
+layout (constant_id = 0) const bool SPECIALIZED = false;
+layout (constant_id = 1) const uint MATERIAL_FEATURES = 0;
+layout (constant_id = 2) const bool DEBUG_VIEWS = true;
+
+// keep in sync with GLTFRenderer::MaterialFeature
+const uint FEATURE_BASE_COLOR_MAP = 1 << 0;
+const uint FEATURE_PHYSICAL_DESCRIPTOR_MAP = 1 << 1;
+const uint FEATURE_NORMAL_MAP = 1 << 2;
+const uint FEATURE_OCCLUSION_MAP = 1 << 3;
+const uint FEATURE_EMISSIVE_MAP = 1 << 4;
+const uint FEATURE_SPECULAR_GLOSSINESS = 1 << 5;
+const uint FEATURE_ALPHA_MASK = 1 << 6;
+
 layout (location = 0) out vec4 outColor;
 layout (location = 1) out uint outColorID;
 
@@ -104,6 +120,21 @@ const float PBR_WORKFLOW_SPECULAR_GLOSINESS = 1.0f;
 
 #define MANUAL_SRGB 1
 
+bool hasTexture(uint feature, int textureSet)
+{
+	return SPECIALIZED ? (MATERIAL_FEATURES & feature) != 0 : textureSet > -1;
+}
+
+bool isSpecularGlossiness()
+{
+	return SPECIALIZED ? (MATERIAL_FEATURES & FEATURE_SPECULAR_GLOSSINESS) != 0 : material.workflow == PBR_WORKFLOW_SPECULAR_GLOSINESS;
+}
+
+bool isAlphaMask()
+{
+	return SPECIALIZED ? (MATERIAL_FEATURES & FEATURE_ALPHA_MASK) != 0 : material.alphaMask == 1.0f;
+}
+
 vec3 Uncharted2Tonemap(vec3 color)
 {
 	float A = 0.15;
@@ -244,8 +275,8 @@ void main()
 
 	vec3 f0 = vec3(0.04);
 
-	if (material.alphaMask == 1.0f) {
-		if (material.baseColorTextureSet > -1) {
+	if (isAlphaMask()) {
+		if (hasTexture(FEATURE_BASE_COLOR_MAP, material.baseColorTextureSet)) {
 			baseColor = SRGBtoLINEAR(texture(colorMap, material.baseColorTextureSet == 0 ? inUV0 : inUV1)) * material.baseColorFactor;
 		} else {
 			baseColor = material.baseColorFactor;
@@ -255,13 +286,13 @@ void main()
 		}
 	}
 
-	if (material.workflow == PBR_WORKFLOW_METALLIC_ROUGHNESS) {
+	if (!isSpecularGlossiness()) {
 		// Metallic and Roughness material properties are packed together
 		// In glTF, these factors can be specified by fixed scalar values
 		// or from a metallic-roughness map
 		perceptualRoughness = material.roughnessFactor;
 		metallic = material.metallicFactor;
-		if (material.physicalDescriptorTextureSet > -1) {
+		if (hasTexture(FEATURE_PHYSICAL_DESCRIPTOR_MAP, material.physicalDescriptorTextureSet)) {
 			// Roughness is stored in the 'g' channel, metallic is stored in the 'b' channel.
 			// This layout intentionally reserves the 'r' channel for (optional) occlusion map data
 			vec4 mrSample = texture(physicalDescriptorMap, material.physicalDescriptorTextureSet == 0 ? inUV0 : inUV1);
@@ -275,16 +306,16 @@ void main()
 		// convert to material roughness by squaring the perceptual roughness [2].
 
 		// The albedo may be defined from a base texture or a flat color
-		if (material.baseColorTextureSet > -1) {
+		if (hasTexture(FEATURE_BASE_COLOR_MAP, material.baseColorTextureSet)) {
 			baseColor = SRGBtoLINEAR(texture(colorMap, material.baseColorTextureSet == 0 ? inUV0 : inUV1)) * material.baseColorFactor;
 		} else {
 			baseColor = material.baseColorFactor;
 		}
 	}
 
-	if (material.workflow == PBR_WORKFLOW_SPECULAR_GLOSINESS) {
+	if (isSpecularGlossiness()) {
 		// Values from specular glossiness workflow are converted to metallic roughness
-		if (material.physicalDescriptorTextureSet > -1) {
+		if (hasTexture(FEATURE_PHYSICAL_DESCRIPTOR_MAP, material.physicalDescriptorTextureSet)) {
 			perceptualRoughness = 1.0 - texture(physicalDescriptorMap, material.physicalDescriptorTextureSet == 0 ? inUV0 : inUV1).a;
 		} else {
 			perceptualRoughness = 0.0;
@@ -324,7 +355,7 @@ void main()
 	vec3 specularEnvironmentR0 = specularColor.rgb;
 	vec3 specularEnvironmentR90 = vec3(1.0, 1.0, 1.0) * reflectance90;
 
-	vec3 n = (material.normalTextureSet > -1) ? getNormal() : normalize(inNormal);
+	vec3 n = hasTexture(FEATURE_NORMAL_MAP, material.normalTextureSet) ? getNormal() : normalize(inNormal);
 	vec3 v = normalize(ubo.camPos - inWorldPos);// Vector from surface point to camera
 	vec3 l = normalize(uboParams.lightDir.xyz);// Vector from surface point to light
 	vec3 h = normalize(l+v);// Half vector between both l and v
@@ -370,13 +401,13 @@ void main()
 
 	const float u_OcclusionStrength = 1.0f;
 	// Apply optional PBR terms for additional (optional) shading
-	if (material.occlusionTextureSet > -1) {
+	if (hasTexture(FEATURE_OCCLUSION_MAP, material.occlusionTextureSet)) {
 		float ao = texture(aoMap, (material.occlusionTextureSet == 0 ? inUV0 : inUV1)).r;
 		color = mix(color, color * ao, u_OcclusionStrength);
 	}
 
 	const float u_EmissiveFactor = 1.0f;
-	if (material.emissiveTextureSet > -1) {
+	if (hasTexture(FEATURE_EMISSIVE_MAP, material.emissiveTextureSet)) {
 		vec3 emissive = SRGBtoLINEAR(texture(emissiveMap, material.emissiveTextureSet == 0 ? inUV0 : inUV1)).rgb * u_EmissiveFactor;
 		color += emissive;
 	}
@@ -384,7 +415,7 @@ void main()
 	outColor = vec4(color, baseColor.a);
 
 	// Shader inputs debug visualization
-	if (uboParams.debugViewInputs > 0.0) {
+	if (DEBUG_VIEWS && uboParams.debugViewInputs > 0.0) {
 		int index = int(uboParams.debugViewInputs);
 		switch (index) {
 			case 1:
@@ -411,7 +442,7 @@ void main()
 
 	// PBR equation debug visualization
 	// "none", "Diff (l,n)", "F (l,h)", "G (l,v,h)", "D (h)", "Specular"
-	if (uboParams.debugViewEquation > 0.0) {
+	if (DEBUG_VIEWS && uboParams.debugViewEquation > 0.0) {
 		int index = int(uboParams.debugViewEquation);
 		switch (index) {
 			case 1:
@@ -13,19 +13,23 @@ layout (set = 0, binding = 0) uniform UBO {
 	mat4 model;
 	mat4 view;
 	vec3 camPos;
-	float mousePosX;
-	float mousePosY;
-	int entityID;
+	uint entityID;
+	uint selectedEntityID;
+	bool isMouseClicked;
+	int jointOffset;	// -1 if the vertices were already skinned by skin.comp
 } ubo;
 
-#define MAX_NUM_JOINTS 128
-
 layout (set = 2, binding = 0) uniform UBONode {
 	mat4 matrix;
-	mat4 jointMatrix[MAX_NUM_JOINTS];
+	uint jointOffset;
 	float jointCount;
 } node;
 
+// joint matrices of every skinned mesh drawn this frame
+layout (std430, set = 3, binding = 1) readonly buffer JointMatrices {
+	mat4 jointMatrices[];
+};
+
 layout (location = 0) out vec3 outWorldPos;
 layout (location = 1) out vec3 outNormal;
 layout (location = 2) out vec2 outUV0;
@@ -37,13 +41,14 @@ void main()
 	outColor0 = inColor0;
 
 	vec4 locPos;
-	if (node.jointCount > 0.0) {
+	if (node.jointCount > 0.0 && ubo.jointOffset >= 0) {
 		// Mesh is skinned
+		uint base = uint(ubo.jointOffset) + node.jointOffset;
 		mat4 skinMat = 
-			inWeight0.x * node.jointMatrix[int(inJoint0.x)] +
-			inWeight0.y * node.jointMatrix[int(inJoint0.y)] +
-			inWeight0.z * node.jointMatrix[int(inJoint0.z)] +
-			inWeight0.w * node.jointMatrix[int(inJoint0.w)];
+			inWeight0.x * jointMatrices[base + uint(inJoint0.x)] +
+			inWeight0.y * jointMatrices[base + uint(inJoint0.y)] +
+			inWeight0.z * jointMatrices[base + uint(inJoint0.z)] +
+			inWeight0.w * jointMatrices[base + uint(inJoint0.w)];
 
 		locPos = ubo.model * node.matrix * skinMat * vec4(inPos, 1.0);
 		outNormal = normalize(transpose(inverse(mat3(ubo.model * node.matrix * skinMat))) * inNormal);
@@ -3,35 +3,58 @@
 #include "Pipeline.hpp"
 #include "Core/Renderer.hpp"
 #include "Core/GLTFRenderer.hpp"
+#include "Core/DeletionQueue.hpp"
+#include "Core/GpuProfiler.hpp"
 #include "Core/FrameInfo.hpp"
+#include "Graphics/TextureStreamer.hpp"
 #include "Events/MouseEvents.hpp"
 #include "Scene/Components.hpp"
 #include "Scene/NyxisProject.hpp"
+#include "Utils/ImageWriter.hpp"
 
 namespace Nyxis
 {
+    void Application::SetHeadless(const HeadlessSettings& settings)
+    {
+        assert(s_Instance == nullptr && "Headless mode has to be set before the application is created");
+        s_Headless = true;
+        s_HeadlessSettings = settings;
+        Device::SetHeadless(true);
+    }
+
     Application::Application()
 	{
-        Renderer::Init(&m_Window, &m_Device);
+        if (s_Headless)
+            Renderer::InitHeadless(&m_Device, { s_HeadlessSettings.width, s_HeadlessSettings.height });
+        else
+            Renderer::Init(m_Window, &m_Device);
         m_FrameInfo = std::make_shared<FrameInfo>();
-        m_EditorLayer.OnAttach();
-    	auto commandBuffer = m_Device.beginSingleTimeCommands();
-        m_EditorLayer.Init(Renderer::GetUIRenderPass(), commandBuffer);
-        m_Device.endSingleTimeCommands(commandBuffer);
+        if (!s_Headless)
+        {
+            m_EditorLayer.OnAttach();
+    	    auto commandBuffer = m_Device.beginSingleTimeCommands();
+            m_EditorLayer.Init(Renderer::GetUIRenderPass(), commandBuffer);
+            m_Device.endSingleTimeCommands(commandBuffer);
+        }
     	m_Scene = std::make_shared<Scene>();
         m_CurrentProject = std::make_shared<NyxisProject>("Default", "default_project.npj");
         m_CurrentProject->Create();
         m_CurrentProject->AddScene(m_Scene);
         m_EditorLayer.SetScene(m_Scene);
     	s_Instance = this;
-        m_Window.SetEventCallback(std::bind(&Application::OnEvent, this, std::placeholders::_1));
+        // create rendering systems
+		GLTFRenderer::Init(Renderer::GetSwapChainRenderPass());
+        if (m_Window)
+            m_Window->SetEventCallback(std::bind(&Application::OnEvent, this, std::placeholders::_1));
 	}
 
     Application::~Application()
     {
-        m_EditorLayer.OnDetach();
+        if (!s_Headless)
+            m_EditorLayer.OnDetach();
 		GLTFRenderer::Shutdown();
         Renderer::Shutdown();
+        m_Device.savePipelineCache();
     }
 
     void Application::OnEvent(Event& e)
@@ -209,13 +232,21 @@ namespace Nyxis
         {
             GLTFRenderer::UpdatePipeline(type);
         }
+        if(pipeline->IsCompiling())
+        {
+            ImGui::SameLine();
+            ImGui::Text("Compiling...");
+        }
         ImGui::PopID();
     }
 
     void Application::Run()
 	{
-        // create rendering systems
-		GLTFRenderer::Init(Renderer::GetSwapChainRenderPass());
+        if (s_Headless)
+        {
+            RunHeadless();
+            return;
+        }
 
         // add functions to editor layer
         {
@@ -235,6 +266,57 @@ namespace Nyxis
                 ImGui::End();
                 });
 
+            EditorLayer::AddFunction([&]() {
+                ImGui::Begin("Frame Pacing");
+                auto pacing = Renderer::GetFramePacing();
+                static std::vector<const char*> modes = { "Low Latency", "Throughput" };
+                int mode = static_cast<int>(pacing.mode);
+                int framesInFlight = static_cast<int>(pacing.framesInFlight);
+                bool changed = ImGui::Combo("Mode", &mode, modes.data(), static_cast<int>(modes.size()));
+                changed |= ImGui::SliderInt("Frames in Flight", &framesInFlight, 1, SwapChain::MAX_FRAMES_IN_FLIGHT);
+                changed |= ImGui::DragFloat("Frame Limit (FPS)", &pacing.frameLimit, 1.0f, 0.0f, 1000.0f);
+                if (changed)
+                {
+                    pacing.mode = static_cast<FramePacing::Mode>(mode);
+                    pacing.framesInFlight = static_cast<uint32_t>(framesInFlight);
+                    Renderer::SetFramePacing(pacing);
+                }
+                const auto& latency = Renderer::GetLatencyStatistics();
+                ImGui::Text("Input to present: %.2f ms (last %.2f ms)", latency.averageMs, latency.lastMs);
+                ImGui::Text("Frame fence wait: %.2f ms", latency.waitMs);
+                ImGui::End();
+                });
+
+            EditorLayer::AddFunction([&]() {
+                ImGui::Begin("GPU Profiler");
+                if (!GpuProfiler::IsSupported())
+                {
+                    ImGui::Text("Timestamp queries are not supported");
+                    ImGui::End();
+                    return;
+                }
+                auto& settings = GpuProfiler::s_Settings;
+                ImGui::Checkbox("Enabled", &settings.enabled);
+                ImGui::BeginDisabled(!GpuProfiler::HasPipelineStatistics());
+                ImGui::Checkbox("Pipeline Statistics", &settings.pipelineStatistics);
+                ImGui::EndDisabled();
+                for (uint32_t i = 0; i < GpuProfiler::PASS_COUNT; i++)
+                {
+                    const auto pass = static_cast<GpuPass>(i);
+                    const auto& result = GpuProfiler::GetResult(pass);
+                    const auto& history = GpuProfiler::GetHistory(pass);
+                    const float peak = *std::max_element(history.begin(), history.end());
+                    const auto overlay = fmt::format("{:.3f} ms", result.ms);
+                    ImGui::PlotLines(GpuProfiler::GetPassName(pass), history.data(), static_cast<int>(history.size()),
+                        static_cast<int>(GpuProfiler::GetHistoryOffset()), overlay.c_str(), 0.0f, std::max(peak, 0.1f), ImVec2(0.0f, 40.0f));
+                    if (settings.pipelineStatistics && pass != GpuPass::World)
+                        ImGui::Text("Invocations: %llu vertex, %llu fragment", static_cast<unsigned long long>(result.vertexInvocations),
+                            static_cast<unsigned long long>(result.fragmentInvocations));
+                }
+                ImGui::Text("IBL Prefiltering: %.2f ms", GpuProfiler::GetEnvironmentTime());
+                ImGui::End();
+                });
+
             EditorLayer::AddFunction([&]() {
                     ImGui::Begin("Scene Settings");
                     ImGui::Text("SkyMap");
@@ -242,6 +324,32 @@ namespace Nyxis
                     ImGui::DragFloat("Gamma", &GLTFRenderer::s_SceneInfo.shaderValuesParams.gamma, 0.1f, 0.0f, 10.0f);
                     ImGui::DragFloat("lod", &GLTFRenderer::s_SceneInfo.shaderValuesParams.lod, 0.1f, 0.0f, 10.0f);
                     ImGui::DragFloat3("Light Direction", &GLTFRenderer::s_SceneInfo.shaderValuesParams.lightDir.x);
+                    ImGui::Checkbox("Mesh LOD", &GLTFRenderer::s_LodSettings.enabled);
+                    ImGui::DragFloat("LOD Pixel Error", &GLTFRenderer::s_LodSettings.pixelError, 0.1f, 0.1f, 16.0f);
+                    ImGui::Checkbox("Meshlet Culling", &GLTFRenderer::s_MeshletSettings.enabled);
+                    ImGui::Checkbox("Meshlet Cone Culling", &GLTFRenderer::s_MeshletSettings.coneCulling);
+                    ImGui::Checkbox("Compute Pre-Skinning", &GLTFRenderer::s_SkinningSettings.computePreSkin);
+                    {
+                        const auto& uploads = GLTFRenderer::s_UploadStatistics;
+                        ImGui::Text("Uploads: %llu bytes, %u models updated, %u skipped", static_cast<unsigned long long>(uploads.bytes),
+                            uploads.modelsUpdated, uploads.modelsSkipped);
+                        const auto arena = UniformArena::GetStatistics();
+                        ImGui::Text("Uniform Arena: %u slots, %.1f / %.1f KB", arena.allocations,
+                            arena.used / 1024.0f, arena.capacity / 1024.0f);
+                        const auto deletions = DeletionQueue::GetStatistics();
+                        ImGui::Text("Deferred Deletions: %zu pending, %llu released", deletions.pending,
+                            static_cast<unsigned long long>(deletions.released));
+                    }
+                    {
+                        auto& streaming = TextureStreamer::s_Settings;
+                        const auto& stats = TextureStreamer::GetStatistics();
+                        int budgetMB = static_cast<int>(streaming.budget >> 20);
+                        if (ImGui::DragInt("Texture Budget (MB)", &budgetMB, 8.0f, 16, 16384))
+                            streaming.budget = static_cast<VkDeviceSize>(budgetMB) << 20;
+                        ImGui::DragInt("Texture Mip Bias", &streaming.mipBias, 0.1f, -2, 4);
+                        ImGui::Text("Textures: %u resident %.1f MB / requested %.1f MB / budget %.1f MB, %u pending",
+                            stats.textureCount, stats.residentBytes / 1048576.0, stats.requestedBytes / 1048576.0, stats.budget / 1048576.0, stats.pendingUploads);
+                    }
                     if(ImGui::BeginCombo("Environment", GLTFRenderer::s_EnvMapFile.c_str()))
                     {
                         const std::string path = GetProject()->GetAssetPath() + "/environments/";
@@ -285,6 +393,8 @@ namespace Nyxis
                     if (ImGui::Combo("PBR Equation", &pbrIndex, &pbrEquations[0], pbrEquations.size(), pbrEquations.size()))
                         GLTFRenderer::s_SceneInfo.shaderValuesParams.debugViewEquation = static_cast<float>(pbrIndex);
 
+                    ImGui::Checkbox("Specialized Shaders", &GLTFRenderer::s_ShaderVariants);
+
                     ImGui::End();
                 });
 
@@ -326,26 +436,70 @@ namespace Nyxis
         }
 #endif
 
-    	while (!m_Window.ShouldClose()) {
+    	while (!m_Window->ShouldClose()) {
+            Renderer::PaceFrame();
             glfwPollEvents();
             auto newTime = std::chrono::high_resolution_clock::now();
             auto frameTime = std::chrono::duration<float, std::chrono::seconds::period>(newTime - currentTime).count();
             currentTime = newTime;
+            RunFrame(frameTime);
+    	}
 
-        	auto worldExtent = Renderer::GetAspectRatio();
-			float aspect = static_cast<float>(worldExtent.width) / static_cast<float>(worldExtent.height);
-        	auto worldCommandBuffer = Renderer::BeginWorldFrame();
-
-			m_FrameInfo->frameTime = frameTime;
-			m_FrameInfo->frameIndex = Renderer::GetFrameIndex();
-    		m_FrameInfo->commandBuffer = worldCommandBuffer;
-
-            Renderer::BeginMainRenderPass(m_FrameInfo->commandBuffer);
-            GLTFRenderer::Render();
+    	vkDeviceWaitIdle(m_Device.device());
+    }
 
-            m_PhysicsEngine.OnUpdate(m_FrameInfo->frameTime);
-            Renderer::EndMainRenderPass(worldCommandBuffer);
-            
+    void Application::RunFrame(float frameTime)
+    {
+        using Clock = std::chrono::steady_clock;
+        auto& timings = m_FrameInfo->cpuTimings;
+        const auto frameStart = Clock::now();
+        auto stageStart = frameStart;
+        // milliseconds since the previous stage ended
+        auto stage = [&stageStart]()
+        {
+            const auto now = Clock::now();
+            const float ms = std::chrono::duration<float, std::milli>(now - stageStart).count();
+            stageStart = now;
+            return ms;
+        };
+
+    	auto worldExtent = Renderer::GetAspectRatio();
+		float aspect = static_cast<float>(worldExtent.width) / static_cast<float>(worldExtent.height);
+    	auto worldCommandBuffer = Renderer::BeginWorldFrame();
+        // the swap chain was out of date and recreated
+        if (worldCommandBuffer == VK_NULL_HANDLE)
+            return;
+
+		m_FrameInfo->frameTime = frameTime;
+		m_FrameInfo->frameIndex = Renderer::GetFrameIndex();
+		m_FrameInfo->commandBuffer = worldCommandBuffer;
+        timings.acquire = stage();
+
+        m_Scene->UpdateWorldTransforms();
+        timings.transforms = stage();
+
+        // compute skinning, culling and queue ownership transfers have to be recorded outside of the render pass
+        GLTFRenderer::RecordEnvironmentTransfer();
+        GLTFRenderer::UpdateSkinning();
+        GLTFRenderer::CullMeshlets();
+        timings.compute = stage();
+        Renderer::BeginMainRenderPass(m_FrameInfo->commandBuffer);
+        GLTFRenderer::Render();
+        timings.render = stage();
+
+        m_PhysicsEngine.OnUpdate(m_FrameInfo->frameTime);
+        timings.physics = stage();
+        Renderer::EndMainRenderPass(worldCommandBuffer);
+        // transfers after the render pass: texture streaming for the mips requested this frame and the
+        // picking readback, there is nothing to pick without a window
+        TextureStreamer::Update(worldCommandBuffer);
+        if (!s_Headless)
+            GLTFRenderer::RecordPicking();
+        Renderer::EndWorldFrame();
+        timings.submit = stage();
+
+        if (!s_Headless)
+        {
         	auto commandBuffer = Renderer::BeginUIFrame();
 			m_FrameInfo->commandBuffer = commandBuffer;
 
@@ -354,12 +508,61 @@ namespace Nyxis
             m_EditorLayer.End();
     		Renderer::EndUIRenderPass(commandBuffer);
 			Renderer::SetWorldImageSize(m_EditorLayer.GetViewportExtent());
+        }
+        timings.ui = stage();
 
-            m_Scene->OnUpdate(m_FrameInfo->frameTime, aspect);
+        m_Scene->OnUpdate(m_FrameInfo->frameTime, aspect);
 
-    		GLTFRenderer::OnUpdate();
-    	}
+		GLTFRenderer::OnUpdate();
+        timings.update = stage();
+        timings.total = std::chrono::duration<float, std::milli>(stageStart - frameStart).count();
+    }
 
-    	vkDeviceWaitIdle(m_Device.device());
+    void Application::RunHeadless()
+    {
+        const auto& settings = s_HeadlessSettings;
+        LOG_INFO("[Core] Rendering {} headless frames at {}x{}", settings.frameCount, settings.width, settings.height);
+
+        Renderer::SetFrameCallback([&](const Renderer::CapturedFrame& frame)
+        {
+            if (settings.outputDirectory.empty())
+            {
+                m_CapturedFrames.push_back(frame);
+                return;
+            }
+            const auto path = (std::filesystem::path(settings.outputDirectory) / fmt::format("frame_{:05}.ppm", frame.frame)).string();
+            if (!writePPM(path, frame.extent.width, frame.extent.height, frame.pixels.data()))
+                LOG_ERROR("[Core] Failed to write frame {}", path);
+        });
+        if (!settings.outputDirectory.empty())
+            std::filesystem::create_directories(settings.outputDirectory);
+
+        if (!settings.projectPath.empty())
+        {
+            m_CurrentProject = std::make_shared<NyxisProject>("Headless", settings.projectPath);
+            m_CurrentProject->Load();
+        }
+        else
+        {
+            auto model = m_Scene->CreateEntity("Model");
+            m_Scene->GetComponent<TransformComponent>(model).translation.z = -5.0f;
+            m_Scene->AddComponent<Model>(model, "/models/microphone/scene.gltf");
+        }
+
+        // the camera projection is only set by the scene update, the first frame needs it as well
+        m_Scene->OnUpdate(0.0f, static_cast<float>(settings.width) / static_cast<float>(settings.height));
+
+        auto currentTime = std::chrono::high_resolution_clock::now();
+        for (uint32_t frame = 0; frame < settings.frameCount; frame++)
+        {
+            Renderer::PaceFrame();
+            auto newTime = std::chrono::high_resolution_clock::now();
+            auto frameTime = std::chrono::duration<float, std::chrono::seconds::period>(newTime - currentTime).count();
+            currentTime = newTime;
+            RunFrame(frameTime);
+        }
+
+        Renderer::FlushFrames();
+        Renderer::SetFrameCallback(nullptr);
     }
 } // namespace Nyxis
\ No newline at end of file
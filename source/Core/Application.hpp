@@ -2,6 +2,7 @@
 #include "Core/Nyxispch.hpp"
 #include "Core/Window.hpp"
 #include "Core/Device.hpp"
+#include "Core/Renderer.hpp"
 #include "Core/FrameInfo.hpp"
 #include "Core/Layer.hpp"
 #include "Core/Log.hpp"
@@ -13,6 +14,19 @@ namespace Nyxis
 {
 	class NyxisProject;
 
+	// renders the world pass without a window, swap chain or editor, e.g. on CI or render farm nodes
+	struct HeadlessSettings
+	{
+		uint32_t width = 1280;
+		uint32_t height = 720;
+		// frames rendered before Run returns
+		uint32_t frameCount = 1;
+		// project to load, the default scene otherwise
+		std::string projectPath;
+		// frames are written there as frame_<n>.ppm, empty keeps them in memory only
+		std::string outputDirectory;
+	};
+
 	class Application
     {
     public:
@@ -31,19 +45,32 @@ namespace Nyxis
         static constexpr int WIDTH = 1280;
         static constexpr int HEIGHT = 720;
 
+        // has to be called before the first GetInstance()
+        static void SetHeadless(const HeadlessSettings& settings);
+        static bool IsHeadless() { return s_Headless; }
+        // frames read back in headless mode, without an output directory every frame is kept
+        static const std::vector<Renderer::CapturedFrame>& GetCapturedFrames() { return s_Instance->m_CapturedFrames; }
+
         void Run();
+        // one frame: the world pass, the editor unless headless and the scene update. Stage timings land in the frame info
+        void RunFrame(float frameTime);
+        [[nodiscard]] bool ShouldClose() const { return m_Window && m_Window->ShouldClose(); }
 		static Ref<FrameInfo> GetFrameInfo() { return s_Instance->m_FrameInfo; }
 		static Ref<NyxisProject> GetProject() { return s_Instance->m_CurrentProject; }
 		static Ref<Scene> GetScene() { return s_Instance->m_Scene; }
 
 		static void SetScene(Ref<Scene> scene) { s_Instance->m_Scene = scene; }
         static void SetProject(Ref<NyxisProject> project) { s_Instance->m_CurrentProject = project; }
+        static PhysicsEngine& GetPhysicsEngine() { return s_Instance->m_PhysicsEngine; }
     private:
         Application();
     	static inline Application* s_Instance = nullptr;
+        static inline bool s_Headless = false;
+        static inline HeadlessSettings s_HeadlessSettings{};
         void OnEvent(Event& e);
+        void RunHeadless();
 
-    	Window& m_Window = Window::Get(WIDTH, HEIGHT, "Nyxis Engine");
+    	Window* m_Window = s_Headless ? nullptr : &Window::Get(WIDTH, HEIGHT, "Nyxis Engine");
         Device& m_Device = Device::Get();
         Ref<FrameInfo> m_FrameInfo = nullptr;
         Ref<Scene> m_Scene = nullptr;
@@ -52,6 +79,7 @@ namespace Nyxis
         LayerStack m_LayerStack{};
         EditorLayer m_EditorLayer{};
         PhysicsEngine m_PhysicsEngine{};
+        std::vector<Renderer::CapturedFrame> m_CapturedFrames;
 
     }; // class Application
 } // namespace Nyxis
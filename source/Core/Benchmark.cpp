@@ -0,0 +1,270 @@
+#include "Core/Benchmark.hpp"
+#include "Core/Application.hpp"
+#include "Core/GLTFRenderer.hpp"
+#include "Graphics/TextureStreamer.hpp"
+#include "Scene/Components.hpp"
+#include "Scene/NyxisProject.hpp"
+#include "Scene/SceneSerializer.hpp"
+
+#include "json/json.hpp"
+
+namespace Nyxis
+{
+    namespace
+    {
+        struct Metric
+        {
+            std::string name;
+            std::function<double(const Benchmark::Sample&)> value;
+        };
+
+        // nearest rank, values have to be sorted
+        double Percentile(const std::vector<double>& values, double percentile)
+        {
+            const auto rank = static_cast<size_t>(std::ceil(percentile / 100.0 * static_cast<double>(values.size())));
+            return values[std::clamp<size_t>(rank, 1, values.size()) - 1];
+        }
+    }
+
+    int Benchmark::Run(const BenchmarkSettings& settings)
+    {
+        if (settings.headless)
+        {
+            HeadlessSettings headless{};
+            headless.width = settings.width;
+            headless.height = settings.height;
+            headless.frameCount = settings.warmupFrames + settings.frameCount;
+            Application::SetHeadless(headless);
+        }
+
+        Application* app = Application::GetInstance();
+        GpuProfiler::s_Settings.enabled = true;
+        GpuProfiler::s_Settings.pipelineStatistics = settings.pipelineStatistics && GpuProfiler::HasPipelineStatistics();
+        LOG_INFO("[Core] Benchmark '{}': {} warmup and {} recorded frames", settings.name, settings.warmupFrames, settings.frameCount);
+
+        BuildScene(settings);
+        {
+            const auto extent = Renderer::GetAspectRatio();
+            Application::GetScene()->OnUpdate(0.0f, static_cast<float>(extent.width) / static_cast<float>(extent.height));
+        }
+
+        auto& device = Device::Get();
+        std::vector<Sample> samples;
+        samples.reserve(settings.frameCount);
+        // the GPU results of a frame are collected frames later, when its slot is recorded again
+        std::unordered_map<uint64_t, size_t> sampleFrames;
+        GpuProfiler::SetResultCallback([&samples, &sampleFrames](uint64_t frame, const GpuProfiler::FrameResults& results) {
+            const auto sample = sampleFrames.find(frame);
+            if (sample != sampleFrames.end())
+                samples[sample->second].gpu = results;
+        });
+        const uint32_t totalFrames = settings.warmupFrames + settings.frameCount;
+        for (uint32_t frame = 0; frame < totalFrames && !app->ShouldClose(); frame++)
+        {
+            Renderer::PaceFrame();
+            if (!settings.headless)
+                glfwPollEvents();
+
+            // the warmup frames hold the first camera pose
+            PlaceCamera(settings, frame < settings.warmupFrames ? 0 : frame - settings.warmupFrames);
+            app->RunFrame(TIME_STEP);
+            if (frame < settings.warmupFrames)
+                continue;
+
+            Sample sample{};
+            sample.cpu = Application::GetFrameInfo()->cpuTimings;
+            sample.drawCalls = GLTFRenderer::s_DrawStatistics.drawCalls;
+            sample.triangles = GLTFRenderer::s_DrawStatistics.triangles;
+            sample.deviceMemory = device.getMemoryBudget().usage;
+            sample.textureMemory = TextureStreamer::GetStatistics().residentBytes;
+            sampleFrames.emplace(GpuProfiler::GetFrame(), samples.size());
+            samples.push_back(sample);
+        }
+
+        if (settings.headless)
+            Renderer::FlushFrames();
+        vkDeviceWaitIdle(device.device());
+        // the last frames in flight were never followed by another frame in their slot
+        GpuProfiler::Flush();
+        GpuProfiler::SetResultCallback(nullptr);
+
+        const bool written = WriteResults(settings, samples);
+        delete app;
+        return written && samples.size() == settings.frameCount ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+
+    void Benchmark::BuildScene(const BenchmarkSettings& settings)
+    {
+        s_GridExtent = 0.0f;
+        if (!settings.projectPath.empty())
+        {
+            auto project = std::make_shared<NyxisProject>(settings.name, settings.projectPath);
+            Application::SetProject(project);
+            project->Load();
+        }
+        else if (settings.modelCount > 0)
+        {
+            // one file parsed once and shared, like a loaded scene with repeated models
+            constexpr float spacing = 2.0f;
+            const auto side = static_cast<uint32_t>(std::ceil(std::sqrt(static_cast<float>(settings.modelCount))));
+            const float offset = static_cast<float>(side - 1) * spacing * 0.5f;
+            s_GridExtent = offset;
+
+            SceneData data{};
+            data.name = settings.name;
+            for (uint32_t i = 0; i < settings.modelCount; i++)
+            {
+                TransformComponent transform{};
+                transform.translation = { static_cast<float>(i % side) * spacing - offset, 0.0f, static_cast<float>(i / side) * spacing - offset };
+                data.tags.emplace_back(fmt::format("Model {}", i));
+                data.transforms.push_back(transform);
+                data.parents.push_back(SceneData::NO_PARENT);
+                data.models.emplace_back(i, settings.modelPath);
+            }
+            SceneSerializer::Instantiate(data, Application::GetProject()->GetAssetPath());
+        }
+
+        if (settings.colliderCount == 0)
+            return;
+
+        // fixed seed, every run simulates the same bodies
+        auto scene = Application::GetScene();
+        auto& physics = Application::GetPhysicsEngine();
+        std::mt19937 random(1234u);
+        std::uniform_real_distribution<float> x(-physics.edges.x, physics.edges.x);
+        std::uniform_real_distribution<float> y(-physics.edges.y, physics.edges.y);
+        std::uniform_real_distribution<float> velocity(-1.0f, 1.0f);
+        for (uint32_t i = 0; i < settings.colliderCount; i++)
+        {
+            auto entity = scene->CreateEntity(fmt::format("Collider {}", i));
+            auto& transform = scene->GetComponent<TransformComponent>(entity);
+            transform.translation = { x(random), y(random), 0.0f };
+            transform.velocity = { velocity(random), velocity(random), 0.0f };
+            scene->AddComponent<Collider>(entity, ColliderType::Sphere, glm::vec3(0.1f), 0.1f);
+            scene->AddComponent<RigidBody>(entity);
+            scene->AddComponent<Gravity>(entity);
+        }
+        physics.enable = true;
+    }
+
+    void Benchmark::PlaceCamera(const BenchmarkSettings& settings, uint32_t frame)
+    {
+        const float radius = settings.orbitRadius > 0.0f ? settings.orbitRadius : std::max(5.0f, s_GridExtent * 2.0f + 3.0f);
+        const float angle = glm::two_pi<float>() * static_cast<float>(frame) / static_cast<float>(std::max(settings.frameCount, 1u));
+        const glm::vec3 position = { radius * std::cos(angle), settings.orbitHeight, radius * std::sin(angle) };
+
+        // the view translates by the negated position with z flipped, yaw turns the camera towards the origin
+        // the scene only updates the view after rendering, so it is set here as well
+        auto scene = Application::GetScene();
+        auto& transform = scene->GetComponent<TransformComponent>(scene->GetCameraEntity());
+        transform.translation = { -position.x, -position.y, position.z };
+        transform.rotation = { 0.0f, angle - glm::half_pi<float>(), 0.0f };
+        scene->GetCamera()->setViewYXZ(transform.translation, transform.rotation);
+    }
+
+    bool Benchmark::WriteResults(const BenchmarkSettings& settings, const std::vector<Sample>& samples)
+    {
+        std::vector<Metric> metrics = {
+            { "cpu_acquire_ms", [](const Sample& s) { return static_cast<double>(s.cpu.acquire); } },
+            { "cpu_transforms_ms", [](const Sample& s) { return static_cast<double>(s.cpu.transforms); } },
+            { "cpu_compute_ms", [](const Sample& s) { return static_cast<double>(s.cpu.compute); } },
+            { "cpu_render_ms", [](const Sample& s) { return static_cast<double>(s.cpu.render); } },
+            { "cpu_physics_ms", [](const Sample& s) { return static_cast<double>(s.cpu.physics); } },
+            { "cpu_submit_ms", [](const Sample& s) { return static_cast<double>(s.cpu.submit); } },
+            { "cpu_ui_ms", [](const Sample& s) { return static_cast<double>(s.cpu.ui); } },
+            { "cpu_update_ms", [](const Sample& s) { return static_cast<double>(s.cpu.update); } },
+            { "cpu_total_ms", [](const Sample& s) { return static_cast<double>(s.cpu.total); } },
+            { "draw_calls", [](const Sample& s) { return static_cast<double>(s.drawCalls); } },
+            { "triangles", [](const Sample& s) { return static_cast<double>(s.triangles); } },
+            { "device_memory_mb", [](const Sample& s) { return s.deviceMemory / 1048576.0; } },
+            { "texture_memory_mb", [](const Sample& s) { return s.textureMemory / 1048576.0; } },
+        };
+        for (uint32_t pass = 0; pass < GpuProfiler::PASS_COUNT; pass++)
+        {
+            std::string name = GpuProfiler::GetPassName(static_cast<GpuPass>(pass));
+            std::transform(name.begin(), name.end(), name.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+            metrics.push_back({ fmt::format("gpu_{}_ms", name), [pass](const Sample& s) { return static_cast<double>(s.gpu[pass].ms); } });
+            if (!GpuProfiler::s_Settings.pipelineStatistics || static_cast<GpuPass>(pass) == GpuPass::World)
+                continue;
+            metrics.push_back({ fmt::format("gpu_{}_vertex_invocations", name), [pass](const Sample& s) { return static_cast<double>(s.gpu[pass].vertexInvocations); } });
+            metrics.push_back({ fmt::format("gpu_{}_fragment_invocations", name), [pass](const Sample& s) { return static_cast<double>(s.gpu[pass].fragmentInvocations); } });
+        }
+
+        const auto csvPath = settings.outputPath + ".csv";
+        std::ofstream csv(csvPath, std::ios::trunc);
+        if (!csv.is_open())
+        {
+            LOG_ERROR("[Core] Failed to write benchmark results {}", csvPath);
+            return false;
+        }
+        csv << "frame";
+        for (const auto& metric : metrics)
+            csv << "," << metric.name;
+        csv << "\n";
+        for (size_t frame = 0; frame < samples.size(); frame++)
+        {
+            csv << frame;
+            for (const auto& metric : metrics)
+                csv << "," << metric.value(samples[frame]);
+            csv << "\n";
+        }
+
+        const auto& properties = Device::Get().properties;
+        nlohmann::json json;
+        json["name"] = settings.name;
+        json["device"] = {
+            { "name", properties.deviceName },
+            { "driverVersion", properties.driverVersion },
+            { "apiVersion", fmt::format("{}.{}.{}", VK_VERSION_MAJOR(properties.apiVersion), VK_VERSION_MINOR(properties.apiVersion), VK_VERSION_PATCH(properties.apiVersion)) },
+        };
+        json["settings"] = {
+            { "project", settings.projectPath },
+            { "model", settings.modelPath },
+            { "modelCount", settings.projectPath.empty() ? settings.modelCount : 0 },
+            { "colliderCount", settings.colliderCount },
+            { "warmupFrames", settings.warmupFrames },
+            { "frameCount", settings.frameCount },
+            { "headless", settings.headless },
+            { "pipelineStatistics", GpuProfiler::s_Settings.pipelineStatistics },
+            { "width", Renderer::GetAspectRatio().width },
+            { "height", Renderer::GetAspectRatio().height },
+            { "timeStep", TIME_STEP },
+        };
+        json["recordedFrames"] = samples.size();
+        // prefiltering of the environment loaded at startup, not part of the frames
+        json["iblPrefilterMs"] = GpuProfiler::GetEnvironmentTime();
+
+        auto& statistics = json["metrics"];
+        for (const auto& metric : metrics)
+        {
+            if (samples.empty())
+                break;
+            std::vector<double> values;
+            values.reserve(samples.size());
+            for (const auto& sample : samples)
+                values.push_back(metric.value(sample));
+            std::sort(values.begin(), values.end());
+            const double mean = std::accumulate(values.begin(), values.end(), 0.0) / static_cast<double>(values.size());
+            statistics[metric.name] = {
+                { "min", values.front() },
+                { "mean", mean },
+                { "p50", Percentile(values, 50.0) },
+                { "p90", Percentile(values, 90.0) },
+                { "p95", Percentile(values, 95.0) },
+                { "p99", Percentile(values, 99.0) },
+                { "max", values.back() },
+            };
+        }
+
+        const auto jsonPath = settings.outputPath + ".json";
+        std::ofstream file(jsonPath, std::ios::trunc);
+        if (!file.is_open())
+        {
+            LOG_ERROR("[Core] Failed to write benchmark results {}", jsonPath);
+            return false;
+        }
+        file << json.dump(4) << "\n";
+        LOG_INFO("[Core] Benchmark results written to {} and {}", jsonPath, csvPath);
+        return true;
+    }
+}
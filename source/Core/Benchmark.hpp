@@ -0,0 +1,68 @@
+#pragma once
+#include "Core/Nyxispch.hpp"
+#include "Core/FrameInfo.hpp"
+#include "Core/GpuProfiler.hpp"
+
+namespace Nyxis
+{
+    struct BenchmarkSettings
+    {
+        std::string name = "benchmark";
+        // project whose scene is measured, the procedural scene below otherwise
+        std::string projectPath;
+        // asset relative, spawned modelCount times on a grid around the origin when no project is given
+        std::string modelPath = "/models/microphone/scene.gltf";
+        uint32_t modelCount = 1;
+        // spheres simulated by the physics engine, they have no mesh
+        uint32_t colliderCount = 0;
+        // rendered but not recorded, lets streaming and pipeline compilation settle
+        uint32_t warmupFrames = 60;
+        uint32_t frameCount = 600;
+        // only used headless, the window has the application's default size
+        uint32_t width = 1280;
+        uint32_t height = 720;
+        bool headless = true;
+        // vertex and fragment invocations per pass, if the device supports statistics queries
+        bool pipelineStatistics = false;
+        // the camera orbits the origin once over the recorded frames, a radius of 0 fits the model grid
+        float orbitRadius = 0.0f;
+        float orbitHeight = 1.0f;
+        // results go to <outputPath>.json and <outputPath>.csv
+        std::string outputPath = "benchmark";
+    };
+
+    /**
+     * \brief Deterministic scene benchmark
+     *
+     * Every frame advances by a fixed time step and the camera pose only depends on the frame index,
+     * so two runs render the same images. Per frame it records the CPU stage timings, the GPU time
+     * of every profiled pass, draw calls, triangles and memory, and writes percentiles for each of them.
+     */
+    class Benchmark
+    {
+    public:
+        static constexpr float TIME_STEP = 1.0f / 60.0f;
+
+        // creates the application, has to be called before anything else used it. Returns the exit code
+        static int Run(const BenchmarkSettings& settings);
+
+        // one recorded frame
+        struct Sample
+        {
+            CpuTimings cpu{};
+            // GPU profiler results of this frame, World is the whole world pass
+            GpuProfiler::FrameResults gpu{};
+            uint32_t drawCalls = 0;
+            uint64_t triangles = 0;
+            VkDeviceSize deviceMemory = 0;
+            VkDeviceSize textureMemory = 0;
+        };
+
+    private:
+        static void BuildScene(const BenchmarkSettings& settings);
+        static void PlaceCamera(const BenchmarkSettings& settings, uint32_t frame);
+        static bool WriteResults(const BenchmarkSettings& settings, const std::vector<Sample>& samples);
+
+        static inline float s_GridExtent = 0.0f;
+    };
+}
@@ -0,0 +1,61 @@
+#include "Core/DeletionQueue.hpp"
+#include "Core/Device.hpp"
+#include "Core/SwapChain.hpp"
+
+namespace Nyxis
+{
+    void DeletionQueue::Push(std::function<void()> release)
+    {
+        {
+            std::lock_guard<std::mutex> lock(s_Mutex);
+            if (!s_Shutdown)
+            {
+                s_Entries.push_back({s_Frame, std::move(release)});
+                return;
+            }
+        }
+        release();
+    }
+
+    void DeletionQueue::BeginFrame()
+    {
+        const uint64_t frame = ++s_Frame;
+
+        // the frames in flight can be changed at runtime, the upper bound keeps entries of a larger setting safe
+        std::vector<std::function<void()>> ready;
+        {
+            std::lock_guard<std::mutex> lock(s_Mutex);
+            while (!s_Entries.empty() && s_Entries.front().frame + SwapChain::MAX_FRAMES_IN_FLIGHT <= frame)
+            {
+                ready.push_back(std::move(s_Entries.front().release));
+                s_Entries.pop_front();
+            }
+            s_Released += ready.size();
+        }
+
+        // released outside the lock, a release may queue further objects
+        for (auto &release : ready)
+            release();
+    }
+
+    void DeletionQueue::Shutdown()
+    {
+        vkDeviceWaitIdle(Device::Get().device());
+
+        std::deque<Entry> entries;
+        {
+            std::lock_guard<std::mutex> lock(s_Mutex);
+            s_Shutdown = true;
+            entries.swap(s_Entries);
+            s_Released += entries.size();
+        }
+        for (auto &entry : entries)
+            entry.release();
+    }
+
+    DeletionQueue::Statistics DeletionQueue::GetStatistics()
+    {
+        std::lock_guard<std::mutex> lock(s_Mutex);
+        return {s_Entries.size(), s_Released};
+    }
+} // namespace Nyxis
@@ -0,0 +1,50 @@
+#pragma once
+#include "Core/Nyxispch.hpp"
+
+namespace Nyxis
+{
+    // Releases GPU objects that frames in flight may still reference once those frames completed, instead
+    // of draining the device. Entries queued while frame N is recorded run at the first BeginFrame after the
+    // fence of frame N was waited on.
+    class DeletionQueue
+    {
+    public:
+        struct Statistics
+        {
+            size_t pending = 0;
+            uint64_t released = 0;
+        };
+
+        // thread safe, runs the release immediately once the queue was shut down
+        static void Push(std::function<void()> release);
+
+        // keeps the owning objects alive until the frames in flight completed, e.g. Scope<Buffer>
+        template <typename... Ts>
+        static void Release(Ts &&...objects)
+        {
+            auto owned = std::make_shared<std::tuple<std::decay_t<Ts>...>>(std::forward<Ts>(objects)...);
+            Push([owned]() mutable { owned.reset(); });
+        }
+
+        // called by the renderer after the fence of the frame about to be recorded was waited on
+        static void BeginFrame();
+        // waits for the device and releases everything, later pushes run immediately
+        static void Shutdown();
+
+        static uint64_t GetFrame() { return s_Frame; }
+        static Statistics GetStatistics();
+
+    private:
+        struct Entry
+        {
+            uint64_t frame;
+            std::function<void()> release;
+        };
+
+        static inline std::deque<Entry> s_Entries{};
+        static inline std::atomic<uint64_t> s_Frame = 0;
+        static inline uint64_t s_Released = 0;
+        static inline bool s_Shutdown = false;
+        static inline std::mutex s_Mutex{};
+    };
+} // namespace Nyxis
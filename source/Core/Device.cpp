@@ -3,6 +3,8 @@
 #include "Core/Log.hpp"
 #include "Core/Nyxispch.hpp"
 
+#include <cstdlib>
+
 namespace Nyxis
 {
     // local callback functions
@@ -53,17 +55,28 @@ namespace Nyxis
     // class member functions
     Device::Device()
     {
+        if (s_Headless)
+        {
+            LOG_INFO("[Core] Creating headless device");
+            deviceExtensions.erase(std::remove_if(deviceExtensions.begin(), deviceExtensions.end(), [](const char *name) {
+                return strcmp(name, VK_KHR_SWAPCHAIN_EXTENSION_NAME) == 0;
+            }), deviceExtensions.end());
+        }
         createInstance();
         setupDebugMessenger();
         createSurface();
         pickPhysicalDevice();
         createLogicalDevice();
         createCommandPool();
+        createPipelineCache();
 	}
 
         Device::~Device()
     {
         vkDestroyCommandPool(device_, mainCommandPool, nullptr);
+        if (computeCommandPool != mainCommandPool)
+            vkDestroyCommandPool(device_, computeCommandPool, nullptr);
+        vkDestroyPipelineCache(device_, pipelineCache_, nullptr);
         vkDestroyDevice(device_, nullptr);
 
         if (enableValidationLayers)
@@ -71,7 +84,8 @@ namespace Nyxis
             DestroyDebugUtilsMessengerEXT(instance, debugMessenger, nullptr);
         }
 
-        vkDestroySurfaceKHR(instance, surface_, nullptr);
+        if (surface_ != VK_NULL_HANDLE)
+            vkDestroySurfaceKHR(instance, surface_, nullptr);
         vkDestroyInstance(instance, nullptr);
     }
 
@@ -101,8 +115,22 @@ namespace Nyxis
         auto extensions = getRequiredExtensions();
         #ifdef __APPLE__
         extensions.push_back(VK_KHR_PORTABILITY_ENUMERATION_EXTENSION_NAME);
-        extensions.push_back("VK_KHR_get_physical_device_properties2");
         #endif
+
+        // needed on 1.0 to query VK_EXT_memory_budget
+        uint32_t instanceExtensionCount = 0;
+        vkEnumerateInstanceExtensionProperties(nullptr, &instanceExtensionCount, nullptr);
+        std::vector<VkExtensionProperties> instanceExtensions(instanceExtensionCount);
+        vkEnumerateInstanceExtensionProperties(nullptr, &instanceExtensionCount, instanceExtensions.data());
+        for (const auto &extension : instanceExtensions)
+        {
+            if (strcmp(extension.extensionName, VK_KHR_GET_PHYSICAL_DEVICE_PROPERTIES_2_EXTENSION_NAME) == 0)
+            {
+                extensions.push_back(VK_KHR_GET_PHYSICAL_DEVICE_PROPERTIES_2_EXTENSION_NAME);
+                physicalDeviceProperties2Supported = true;
+                break;
+            }
+        }
         createInfo.enabledExtensionCount = static_cast<uint32_t>(extensions.size());
         createInfo.ppEnabledExtensionNames = extensions.data();
 
@@ -127,6 +155,14 @@ namespace Nyxis
         }
 
         hasGflwRequiredInstanceExtensions();
+
+        if (physicalDeviceProperties2Supported)
+        {
+            vkGetPhysicalDeviceMemoryProperties2KHR_ = reinterpret_cast<PFN_vkGetPhysicalDeviceMemoryProperties2KHR>(
+                vkGetInstanceProcAddr(instance, "vkGetPhysicalDeviceMemoryProperties2KHR"));
+            vkGetPhysicalDeviceFeatures2KHR_ = reinterpret_cast<PFN_vkGetPhysicalDeviceFeatures2KHR>(
+                vkGetInstanceProcAddr(instance, "vkGetPhysicalDeviceFeatures2KHR"));
+        }
     }
 
     void Device::pickPhysicalDevice()
@@ -165,6 +201,9 @@ namespace Nyxis
 
         std::vector<VkDeviceQueueCreateInfo> queueCreateInfos;
         std::set<uint32_t> uniqueQueueFamilies = {indices.graphicsFamily, indices.presentFamily};
+        graphicsFamily = indices.graphicsFamily;
+        computeFamily = indices.computeFamilyHasValue ? indices.computeFamily : indices.graphicsFamily;
+        uniqueQueueFamilies.insert(computeFamily);
 
         float queuePriority = 1.0f;
         for (uint32_t queueFamily : uniqueQueueFamilies)
@@ -183,15 +222,64 @@ namespace Nyxis
         deviceFeatures.logicOp = VK_TRUE; // To enable logical operations in the fragment shader
 		deviceFeatures.independentBlend = VK_TRUE; // To enable independent blending in the fragment shader
 
+        // optional, the GPU profiler counts shader invocations per pass with it
+        VkPhysicalDeviceFeatures supportedFeatures = {};
+        vkGetPhysicalDeviceFeatures(physicalDevice, &supportedFeatures);
+        pipelineStatisticsSupported = supportedFeatures.pipelineStatisticsQuery == VK_TRUE;
+        deviceFeatures.pipelineStatisticsQuery = supportedFeatures.pipelineStatisticsQuery;
+
         VkDeviceCreateInfo createInfo = {};
         createInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
 
         createInfo.queueCreateInfoCount = static_cast<uint32_t>(queueCreateInfos.size());
         createInfo.pQueueCreateInfos = queueCreateInfos.data();
 
+        std::vector<const char *> enabledExtensions = deviceExtensions;
+
+        uint32_t extensionCount = 0;
+        vkEnumerateDeviceExtensionProperties(physicalDevice, nullptr, &extensionCount, nullptr);
+        std::vector<VkExtensionProperties> availableExtensions(extensionCount);
+        vkEnumerateDeviceExtensionProperties(physicalDevice, nullptr, &extensionCount, availableExtensions.data());
+        auto extensionAvailable = [&](const char *name) {
+            for (const auto &extension : availableExtensions)
+            {
+                if (strcmp(extension.extensionName, name) == 0)
+                    return true;
+            }
+            return false;
+        };
+
+        if (vkGetPhysicalDeviceMemoryProperties2KHR_ && extensionAvailable(VK_EXT_MEMORY_BUDGET_EXTENSION_NAME))
+        {
+            enabledExtensions.push_back(VK_EXT_MEMORY_BUDGET_EXTENSION_NAME);
+            memoryBudgetSupported = true;
+        }
+        LOG_INFO("[Core] Memory budget extension: {}", memoryBudgetSupported ? "enabled" : "not supported");
+
+        VkPhysicalDeviceGraphicsPipelineLibraryFeaturesEXT graphicsPipelineLibraryFeatures{};
+        graphicsPipelineLibraryFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_GRAPHICS_PIPELINE_LIBRARY_FEATURES_EXT;
+        if (vkGetPhysicalDeviceFeatures2KHR_ &&
+            extensionAvailable(VK_KHR_PIPELINE_LIBRARY_EXTENSION_NAME) &&
+            extensionAvailable(VK_EXT_GRAPHICS_PIPELINE_LIBRARY_EXTENSION_NAME))
+        {
+            VkPhysicalDeviceFeatures2 features2{};
+            features2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+            features2.pNext = &graphicsPipelineLibraryFeatures;
+            vkGetPhysicalDeviceFeatures2KHR_(physicalDevice, &features2);
+            graphicsPipelineLibrarySupported = graphicsPipelineLibraryFeatures.graphicsPipelineLibrary == VK_TRUE;
+        }
+        if (graphicsPipelineLibrarySupported)
+        {
+            enabledExtensions.push_back(VK_KHR_PIPELINE_LIBRARY_EXTENSION_NAME);
+            enabledExtensions.push_back(VK_EXT_GRAPHICS_PIPELINE_LIBRARY_EXTENSION_NAME);
+            createInfo.pNext = &graphicsPipelineLibraryFeatures;
+        }
+        LOG_INFO("[Core] Graphics pipeline library: {}", graphicsPipelineLibrarySupported ? "enabled" : "not supported");
+        LOG_INFO("[Core] Pipeline statistics queries: {}", pipelineStatisticsSupported ? "enabled" : "not supported");
+
         createInfo.pEnabledFeatures = &deviceFeatures;
-        createInfo.enabledExtensionCount = static_cast<uint32_t>(deviceExtensions.size());
-        createInfo.ppEnabledExtensionNames = deviceExtensions.data();
+        createInfo.enabledExtensionCount = static_cast<uint32_t>(enabledExtensions.size());
+        createInfo.ppEnabledExtensionNames = enabledExtensions.data();
 
         // might not really be necessary anymore because device specific validation layers
         // have been deprecated
@@ -212,6 +300,43 @@ namespace Nyxis
 
         vkGetDeviceQueue(device_, indices.graphicsFamily, 0, &graphicsQueue_);
         vkGetDeviceQueue(device_, indices.presentFamily, 0, &presentQueue_);
+        vkGetDeviceQueue(device_, computeFamily, 0, &computeQueue_);
+        LOG_INFO("[Core] Async compute queue: {}", hasAsyncCompute() ? "available" : "not available");
+    }
+
+    MemoryBudget Device::getMemoryBudget()
+    {
+        MemoryBudget result{};
+
+        VkPhysicalDeviceMemoryBudgetPropertiesEXT budgetProperties{};
+        budgetProperties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_BUDGET_PROPERTIES_EXT;
+
+        VkPhysicalDeviceMemoryProperties2 memoryProperties2{};
+        memoryProperties2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_PROPERTIES_2;
+        memoryProperties2.pNext = memoryBudgetSupported ? &budgetProperties : nullptr;
+
+        if (vkGetPhysicalDeviceMemoryProperties2KHR_)
+            vkGetPhysicalDeviceMemoryProperties2KHR_(physicalDevice, &memoryProperties2);
+        else
+            vkGetPhysicalDeviceMemoryProperties(physicalDevice, &memoryProperties2.memoryProperties);
+
+        const auto &memoryProperties = memoryProperties2.memoryProperties;
+        for (uint32_t i = 0; i < memoryProperties.memoryHeapCount; i++)
+        {
+            if (!(memoryProperties.memoryHeaps[i].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT))
+                continue;
+
+            if (memoryBudgetSupported)
+            {
+                result.budget += budgetProperties.heapBudget[i];
+                result.usage += budgetProperties.heapUsage[i];
+            }
+            else
+            {
+                result.budget += memoryProperties.memoryHeaps[i].size;
+            }
+        }
+        return result;
     }
 
     void Device::createCommandPool()
@@ -233,9 +358,111 @@ namespace Nyxis
         {
             throw std::runtime_error("failed to create command pool!");
         }
+
+        computeCommandPool = mainCommandPool;
+        if (hasAsyncCompute())
+        {
+            poolInfo.queueFamilyIndex = computeFamily;
+            if (vkCreateCommandPool(device_, &poolInfo, nullptr, &computeCommandPool) != VK_SUCCESS)
+            {
+                throw std::runtime_error("failed to create command pool!");
+            }
+        }
     }
 
-    void Device::createSurface() { pWindow.CreateWindowSurface(instance, &surface_); }
+    // the cache does not depend on the working directory the application was started from
+    static std::filesystem::path defaultPipelineCachePath()
+    {
+        std::filesystem::path directory;
+#if defined(_WIN32)
+        if (const char* localAppData = std::getenv("LOCALAPPDATA"))
+            directory = localAppData;
+#elif defined(__APPLE__)
+        if (const char* home = std::getenv("HOME"))
+            directory = std::filesystem::path(home) / "Library" / "Caches";
+#else
+        if (const char* cacheHome = std::getenv("XDG_CACHE_HOME"); cacheHome && *cacheHome)
+            directory = cacheHome;
+        else if (const char* home = std::getenv("HOME"))
+            directory = std::filesystem::path(home) / ".cache";
+#endif
+        if (directory.empty())
+        {
+            std::error_code error;
+            directory = std::filesystem::temp_directory_path(error);
+        }
+        return directory / "Nyxis" / "pipeline_cache.bin";
+    }
+
+    void Device::createPipelineCache()
+    {
+        pipelineCacheFile = s_PipelineCachePath.empty() ? defaultPipelineCachePath() : s_PipelineCachePath;
+
+        std::vector<char> cacheData;
+        std::ifstream file(pipelineCacheFile, std::ios::binary);
+        if (file.is_open())
+            cacheData.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+
+        // data written by another driver or device is not guaranteed to be rejected by the driver, check the header first
+        if (!cacheData.empty())
+        {
+            VkPipelineCacheHeaderVersionOne header{};
+            bool valid = cacheData.size() >= sizeof(header);
+            if (valid)
+            {
+                memcpy(&header, cacheData.data(), sizeof(header));
+                valid = header.headerSize >= sizeof(header) &&
+                        header.headerVersion == VK_PIPELINE_CACHE_HEADER_VERSION_ONE &&
+                        header.vendorID == properties.vendorID &&
+                        header.deviceID == properties.deviceID &&
+                        memcmp(header.pipelineCacheUUID, properties.pipelineCacheUUID, VK_UUID_SIZE) == 0;
+            }
+            if (!valid)
+            {
+                LOG_INFO("[Core] Discarding pipeline cache created by a different device or driver");
+                cacheData.clear();
+            }
+        }
+
+        VkPipelineCacheCreateInfo createInfo = {};
+        createInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+        createInfo.initialDataSize = cacheData.size();
+        createInfo.pInitialData = cacheData.empty() ? nullptr : cacheData.data();
+
+        if (vkCreatePipelineCache(device_, &createInfo, nullptr, &pipelineCache_) != VK_SUCCESS)
+        {
+            throw std::runtime_error("failed to create pipeline cache!");
+        }
+        LOG_INFO("[Core] Pipeline cache: {} bytes loaded from {}", cacheData.size(), pipelineCacheFile.string());
+    }
+
+    void Device::savePipelineCache()
+    {
+        size_t dataSize = 0;
+        if (vkGetPipelineCacheData(device_, pipelineCache_, &dataSize, nullptr) != VK_SUCCESS || dataSize == 0)
+            return;
+
+        std::vector<char> cacheData(dataSize);
+        if (vkGetPipelineCacheData(device_, pipelineCache_, &dataSize, cacheData.data()) != VK_SUCCESS)
+            return;
+
+        std::error_code error;
+        if (pipelineCacheFile.has_parent_path())
+            std::filesystem::create_directories(pipelineCacheFile.parent_path(), error);
+        std::ofstream file(pipelineCacheFile, std::ios::binary | std::ios::trunc);
+        if (!file.write(cacheData.data(), static_cast<std::streamsize>(dataSize)))
+        {
+            LOG_WARN("[Core] Failed to write pipeline cache {}", pipelineCacheFile.string());
+            return;
+        }
+        LOG_INFO("[Core] Pipeline cache: {} bytes saved to {}", dataSize, pipelineCacheFile.string());
+    }
+
+    void Device::createSurface()
+    {
+        if (!s_Headless)
+            Window::Get().CreateWindowSurface(instance, &surface_);
+    }
 
     bool Device::isDeviceSuitable(VkPhysicalDevice device)
     {
@@ -243,8 +470,8 @@ namespace Nyxis
 
         bool extensionsSupported = checkDeviceExtensionSupport(device);
 
-        bool swapChainAdequate = false;
-        if (extensionsSupported)
+        bool swapChainAdequate = s_Headless;
+        if (extensionsSupported && !s_Headless)
         {
             SwapChainSupportDetails swapChainSupport = querySwapChainSupport(device);
             swapChainAdequate = !swapChainSupport.formats.empty() && !swapChainSupport.presentModes.empty();
@@ -315,11 +542,14 @@ namespace Nyxis
 
     std::vector<const char *> Device::getRequiredExtensions()
     {
-        uint32_t glfwExtensionCount = 0;
-        const char **glfwExtensions;
-        glfwExtensions = glfwGetRequiredInstanceExtensions(&glfwExtensionCount);
-
-        std::vector<const char *> extensions(glfwExtensions, glfwExtensions + glfwExtensionCount);
+        std::vector<const char *> extensions;
+        if (!s_Headless)
+        {
+            uint32_t glfwExtensionCount = 0;
+            const char **glfwExtensions;
+            glfwExtensions = glfwGetRequiredInstanceExtensions(&glfwExtensionCount);
+            extensions.assign(glfwExtensions, glfwExtensions + glfwExtensionCount);
+        }
 
         if (enableValidationLayers)
         {
@@ -392,8 +622,10 @@ namespace Nyxis
                 indices.graphicsFamily = i;
                 indices.graphicsFamilyHasValue = true;
             }
-            VkBool32 presentSupport = false;
-            vkGetPhysicalDeviceSurfaceSupportKHR(device, i, surface_, &presentSupport);
+            // without a surface nothing is presented, the graphics queue stands in for the present queue
+            VkBool32 presentSupport = s_Headless && indices.graphicsFamilyHasValue && indices.graphicsFamily == i;
+            if (!s_Headless)
+                vkGetPhysicalDeviceSurfaceSupportKHR(device, i, surface_, &presentSupport);
             if (queueFamily.queueCount > 0 && presentSupport)
             {
                 indices.presentFamily = i;
@@ -407,6 +639,17 @@ namespace Nyxis
             i++;
         }
 
+        for (uint32_t family = 0; family < queueFamilyCount; family++)
+        {
+            const auto flags = queueFamilies[family].queueFlags;
+            if (queueFamilies[family].queueCount > 0 && (flags & VK_QUEUE_COMPUTE_BIT) && !(flags & VK_QUEUE_GRAPHICS_BIT))
+            {
+                indices.computeFamily = family;
+                indices.computeFamilyHasValue = true;
+                break;
+            }
+        }
+
         return indices;
     }
 
@@ -716,6 +959,7 @@ namespace Nyxis
         init_info.PhysicalDevice = physicalDevice;
         init_info.Device = device_;
         init_info.Queue = graphicsQueue_;
+        init_info.PipelineCache = pipelineCache_;
         init_info.MinImageCount = 3;
         init_info.ImageCount = 3;
         init_info.MSAASamples = VK_SAMPLE_COUNT_1_BIT;
@@ -2,6 +2,8 @@
 #include "Core/Nyxispch.hpp"
 #include "Core/Window.hpp"
 
+#include <filesystem>
+
 namespace Nyxis
 {
     struct SwapChainSupportDetails
@@ -15,11 +17,19 @@ namespace Nyxis
     {
         uint32_t graphicsFamily;
         uint32_t presentFamily;
+        uint32_t computeFamily; // compute without graphics, for async compute work
         bool graphicsFamilyHasValue = false;
         bool presentFamilyHasValue = false;
+        bool computeFamilyHasValue = false;
         bool isComplete() { return graphicsFamilyHasValue && presentFamilyHasValue; }
     };
 
+    struct MemoryBudget
+    {
+        VkDeviceSize budget = 0; // what the process may allocate from device local heaps
+        VkDeviceSize usage = 0;  // what the process currently has allocated, 0 without VK_EXT_memory_budget
+    };
+
     enum CommandPoolType
     {
         World,
@@ -40,6 +50,11 @@ namespace Nyxis
 				s_Instance = new Device();
 			return *s_Instance;
 		}
+		// no surface, present queue or swap chain extension, has to be set before the first Get()
+		static void SetHeadless(bool headless) { s_Headless = headless; }
+		static bool IsHeadless() { return s_Headless; }
+		// file the pipeline cache is loaded from and saved to, defaults to the user cache directory, has to be set before the first Get()
+		static void SetPipelineCachePath(std::filesystem::path path) { s_PipelineCachePath = std::move(path); }
 
         Device();
         ~Device();
@@ -55,6 +70,12 @@ namespace Nyxis
         VkSurfaceKHR surface() { return surface_; }
         VkQueue graphicsQueue() { return graphicsQueue_; }
         VkQueue presentQueue() { return presentQueue_; }
+        // the graphics queue and pool when the device has no separate compute family
+        VkQueue computeQueue() { return computeQueue_; }
+        VkCommandPool getComputeCommandPool() { return computeCommandPool; }
+        uint32_t computeQueueFamily() const { return computeFamily; }
+        uint32_t graphicsQueueFamily() const { return graphicsFamily; }
+        bool hasAsyncCompute() const { return computeFamily != graphicsFamily; }
         SwapChainSupportDetails getSwapChainSupport() { return querySwapChainSupport(physicalDevice); }
         uint32_t findMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties);
         QueueFamilyIndices findPhysicalQueueFamilies() { return findQueueFamilies(physicalDevice); }
@@ -82,6 +103,17 @@ namespace Nyxis
             VkImage &image,
             VkDeviceMemory &imageMemory);
 
+        // device local heaps, reported by VK_EXT_memory_budget if available, otherwise the heap sizes
+        MemoryBudget getMemoryBudget();
+        bool hasMemoryBudget() const { return memoryBudgetSupported; }
+
+        // shared by every pipeline, loaded from disk at construction and written back by savePipelineCache()
+        VkPipelineCache pipelineCache() { return pipelineCache_; }
+        void savePipelineCache();
+        // VK_EXT_graphics_pipeline_library, pipelines can be linked from separately compiled parts
+        bool hasGraphicsPipelineLibrary() const { return graphicsPipelineLibrarySupported; }
+        bool hasPipelineStatistics() const { return pipelineStatisticsSupported; }
+
         VkPhysicalDeviceProperties properties;
 
 		void generateMipmaps(VkImage& image, VkFormat& imageFormat, uint32_t& texWidth, uint32_t& texHeight, uint32_t& mipLevels);
@@ -89,12 +121,15 @@ namespace Nyxis
 
     private:
 		static inline Device* s_Instance = nullptr;
+		static inline bool s_Headless = false;
+		static inline std::filesystem::path s_PipelineCachePath{};
         void createInstance();
         void setupDebugMessenger();
         void createSurface();
         void pickPhysicalDevice();
         void createLogicalDevice();
         void createCommandPool();
+        void createPipelineCache();
         // helper functions
         bool isDeviceSuitable(VkPhysicalDevice device);
         std::vector<const char *> getRequiredExtensions();
@@ -108,20 +143,32 @@ namespace Nyxis
         VkDebugUtilsMessengerEXT debugMessenger;
         VkPhysicalDevice physicalDevice = VK_NULL_HANDLE;
 
+        bool physicalDeviceProperties2Supported = false;
+        bool memoryBudgetSupported = false;
+        bool graphicsPipelineLibrarySupported = false;
+        bool pipelineStatisticsSupported = false;
+        PFN_vkGetPhysicalDeviceMemoryProperties2KHR vkGetPhysicalDeviceMemoryProperties2KHR_ = nullptr;
+        PFN_vkGetPhysicalDeviceFeatures2KHR vkGetPhysicalDeviceFeatures2KHR_ = nullptr;
+
 		std::mutex deviceGuard;
 
-        Window &pWindow = Window::Get();
         VkCommandPool mainCommandPool;
         VkCommandPool finalCommandPool;
+        VkCommandPool computeCommandPool;
         VkDevice device_;
-        VkSurfaceKHR surface_;
+        VkSurfaceKHR surface_ = VK_NULL_HANDLE;
         VkQueue graphicsQueue_;
         VkQueue presentQueue_;
+        VkQueue computeQueue_;
+        uint32_t graphicsFamily = 0;
+        uint32_t computeFamily = 0;
+        VkPipelineCache pipelineCache_ = VK_NULL_HANDLE;
+        std::filesystem::path pipelineCacheFile;
         const std::vector<const char *> validationLayers = {"VK_LAYER_KHRONOS_validation"};
         #ifdef __APPLE__
-        const std::vector<const char *> deviceExtensions = {VK_KHR_SWAPCHAIN_EXTENSION_NAME, "VK_KHR_portability_subset"};
+        std::vector<const char *> deviceExtensions = {VK_KHR_SWAPCHAIN_EXTENSION_NAME, "VK_KHR_portability_subset"};
         #else
-        const std::vector<const char *> deviceExtensions = {VK_KHR_SWAPCHAIN_EXTENSION_NAME};
+        std::vector<const char *> deviceExtensions = {VK_KHR_SWAPCHAIN_EXTENSION_NAME};
         #endif
   };
 } // namespace Nyxis
\ No newline at end of file
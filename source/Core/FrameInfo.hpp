@@ -24,6 +24,20 @@ namespace Nyxis
         }
     };
 
+    // CPU milliseconds spent in every stage of the last frame
+    struct CpuTimings
+    {
+        float acquire = 0.0f; // includes the wait for the frame slot
+        float transforms = 0.0f;
+        float compute = 0.0f; // skinning and meshlet culling
+        float render = 0.0f;
+        float physics = 0.0f;
+        float submit = 0.0f;
+        float ui = 0.0f;
+        float update = 0.0f; // scene, picking, animation and pipeline updates
+        float total = 0.0f;
+    };
+
     struct FrameInfo
     {
         int frameIndex = 0;
@@ -32,5 +46,6 @@ namespace Nyxis
 		VkCommandBuffer commandBuffer = VK_NULL_HANDLE;
 		VkDescriptorSet globalDescriptorSet = VK_NULL_HANDLE;
         GameObject::Map gameObjects;
+        CpuTimings cpuTimings;
     };
 }
\ No newline at end of file
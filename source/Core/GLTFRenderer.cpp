@@ -1,18 +1,27 @@
 #include "Core/GLTFRenderer.hpp"
 
 #include "Core/Application.hpp"
+#include "Core/DeletionQueue.hpp"
+#include "Core/GpuProfiler.hpp"
 #include "Core/Pipeline.hpp"
 #include "Core/Log.hpp"
 #include "Core/SwapChain.hpp"
 #include "Core/Renderer.hpp"
+#include "Core/ShaderModuleCache.hpp"
+#include "Graphics/MarqueeSelection.hpp"
 #include "Scene/Components.hpp"
 #include "Scene/NyxisProject.hpp"
+#include "Utils/Utils.hpp"
+
+#include <filesystem>
+#include <gli/texture_cube.hpp>
 
 namespace Nyxis
 {
 	void GLTFRenderer::Init(VkRenderPass renderPass)
 	{
 		device = &Device::Get();
+		UniformArena::Init();
 		s_SceneInfo.shaderValuesParams.lightDir = { 1.0f, 1.0f, 1.0f, 0.5f };
 		s_SceneInfo.shaderValuesParams.exposure = 4.5f;
 		s_SceneInfo.shaderValuesParams.gamma = 2.2f;
@@ -25,136 +34,194 @@ namespace Nyxis
 		for (int i = 0; i < DEPTH_ARRAY_SCALE; i++)
 			objectPicking.depthBufferObject[i] = 0;
 
+		PrepareIBLPipelines();
 		LoadAssets();
+		UploadEnvironment(true);
+		FinishEnvironment(true);
 		GenerateBRDFLUT();
 		PrepareUniformBuffers();
 		SetupDescriptorPool();
 		SetupDescriptorSets();
 		PreparePipelines(renderPass);
+		PrepareMeshletPipeline();
+		PrepareSkinningPipeline();
+		MarqueeSelection::Init();
 	}
 
 	void GLTFRenderer::Shutdown()
 	{
 		LOG_INFO("[Core] Shutting down GLTF Renderer");
-		if(animationThread.joinable())
-			animationThread.join();
+		DeletionQueue::Shutdown();
+		s_AnimationJobs.reset();
+		// the workers are joined, a file read that was still queued is simply dropped
+		s_EnvironmentFile.reset();
+		FinishEnvironment(true);
+		// pending cache files are written before the device goes away
+		s_CacheWriter.reset();
+		s_PickingReadbacks.clear();
+		MarqueeSelection::Shutdown();
+		UniformArena::Shutdown();
 	}
 
 	void GLTFRenderer::OnUpdate()
 	{
-		auto scene = Application::GetScene();
-		auto frameInfo = Application::GetFrameInfo();
-
-		if(s_ShaderValuesScene.isMouseClicked)
-		{
-			auto commandBuffer = device->beginSingleTimeCommands();
-
-			// change the layout of the image to a redeable format
-			VkImageMemoryBarrier barrier = {};
-			barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
-			barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-			barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
-			barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-			barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-			barrier.image = Renderer::GetIDImage();
-			barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-			barrier.subresourceRange.baseMipLevel = 0;
-			barrier.subresourceRange.levelCount = 1;
-			barrier.subresourceRange.baseArrayLayer = 0;
-			barrier.subresourceRange.layerCount = 1;
-
-			// change the layout of the image to a redeable format
-			vkCmdPipelineBarrier(
-				commandBuffer,
-				VK_PIPELINE_STAGE_TRANSFER_BIT,
-				VK_PIPELINE_STAGE_TRANSFER_BIT,
-				0,
-				0, nullptr,
-				0, nullptr,
-				1, &barrier
-			);
-
-			// copy the image to the buffer
-			VkBufferImageCopy region = {};
-			region.bufferOffset = 0;
-			region.bufferRowLength = 0;
-			region.bufferImageHeight = 0;
-			region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-			region.imageSubresource.mipLevel = 0;
-			region.imageSubresource.baseArrayLayer = 0;
-			region.imageSubresource.layerCount = 1;
-			region.imageOffset = { 0, 0, 0 };
-			region.imageExtent = { Viewport::GetExtent().width, Viewport::GetExtent().height, 1 };
-
-			Buffer stagingBuffer(Viewport::GetExtent().width * Viewport::GetExtent().height * 4,
-								 1,
-								 VK_BUFFER_USAGE_TRANSFER_DST_BIT,
-								 VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
-
-			vkCmdCopyImageToBuffer(
-				commandBuffer,
-				Renderer::GetIDImage(),
-				VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
-				stagingBuffer.getBuffer(),
-				1,
-				&region
-			);
-
-			device->endSingleTimeCommands(commandBuffer);
-
-			stagingBuffer.map();
-			void* mappedData = stagingBuffer.getMappedMemory();
-
-			auto mousePos = Input::GetMousePosition();
-			auto viewportPosition = Viewport::GetWindowPos();
-			auto x = mousePos.x - viewportPosition.x;
-			auto y = mousePos.y - viewportPosition.y;
-
-			uint32_t* pixels = static_cast<uint32_t*>(mappedData);
-			uint32_t pixel = pixels[static_cast<size_t>(Viewport::GetExtent().width * y + x)];
-			if(pixel != 0)
-				EditorLayer::SetSelectedEntity(static_cast<Entity>(pixel));
-			else
-				EditorLayer::DeselectEntity();
-
-			LOG_TRACE("Pixel {}", pixel);
-			LOG_TRACE("Mouse Position: {} {}", x, y);
-		}
+		// selections arrive as soon as the frame that copied the id texels completed
+		PollPicking();
+		MarqueeSelection::Poll();
 
 		if (s_SceneUpdated)
 		{
-			vkDeviceWaitIdle(device->device());
 			LoadEnvironment(s_EnvMapFile);
-			FreeDescriptorSets();
-			SetupDescriptorSets();
-
-			auto modelView = scene->GetComponentView<Model>();
-			for(auto entity : modelView)
-			{
-				auto& model = scene->GetComponent<Model>(entity);
-				model.setupDescriptorSet(s_SceneInfo, s_UniformBuffersParams);
-			}
-
 			s_SceneUpdated = false;
 		}
 
-        if (s_Animate) {
-            animationThread = std::thread([&]{
-				UpdateAnimation(Application::GetFrameInfo()->frameTime);
-                });
-            animationThread.detach();
-        }
+		// the file is read and hashed on a worker, its upload starts the prefiltering of the new environment
+		UploadEnvironment(false);
+
+		// the new environment is swapped in once its cubes are prefiltered, rendering continues with the old one until then
+		FinishEnvironment(false);
+
+		// animation runs between frames, the next Render uploads the results into the buffers of its frame
+		if (s_Animate)
+			UpdateAnimation(Application::GetFrameInfo()->frameTime);
 
 		if(s_PBRPipelineUpdate)
 		{
-			Pipes.pbr->Recreate();
+			Pipes.pbr->RecreateAsync();
+			for (auto& [features, variant] : s_PBRVariants)
+			{
+				ConfigurePBRVariant(*variant, features);
+				variant->RecreateAsync();
+			}
 			s_PBRPipelineUpdate = false;
 		}
 		if(s_SkyboxPipelineUpdate)
 		{
-			Pipes.skybox->Recreate();
+			Pipes.skybox->RecreateAsync();
 			s_SkyboxPipelineUpdate = false;
 		}
+
+		// rebuilt pipelines are swapped in at the frame boundary
+		Pipes.pbr->Update();
+		Pipes.skybox->Update();
+		for (auto& [features, variant] : s_PBRVariants)
+			variant->Update();
+	}
+
+	void GLTFRenderer::RecordPicking()
+	{
+		auto frameInfo = Application::GetFrameInfo();
+		MarqueeSelection::Record(frameInfo->commandBuffer);
+		if (!s_ShaderValuesScene.isMouseClicked)
+			return;
+
+		const auto extent = Renderer::GetWorldExtent();
+		const auto mousePos = Input::GetMousePosition();
+		const auto viewportPosition = Viewport::GetWindowPos();
+		const auto x = static_cast<int32_t>(mousePos.x - viewportPosition.x);
+		const auto y = static_cast<int32_t>(mousePos.y - viewportPosition.y);
+		if (x < 0 || y < 0 || x >= static_cast<int32_t>(extent.width) || y >= static_cast<int32_t>(extent.height))
+			return;
+
+		// a slot still in flight is only reused once its frame completed, the click is dropped otherwise
+		auto& readback = s_PickingReadbacks[s_PickingSlot];
+		if (readback.pending) {
+			if (!Renderer::IsFrameComplete(readback.fence, readback.swapChainVersion)) {
+				LOG_WARN("[Renderer] Picking readbacks are all in flight, click ignored");
+				return;
+			}
+			ResolvePicking(readback);
+		}
+		s_PickingSlot = (s_PickingSlot + 1) % static_cast<uint32_t>(s_PickingReadbacks.size());
+
+		const int32_t x0 = std::max(x - PICKING_RADIUS, 0);
+		const int32_t y0 = std::max(y - PICKING_RADIUS, 0);
+		const int32_t x1 = std::min(x + PICKING_RADIUS, static_cast<int32_t>(extent.width) - 1);
+		const int32_t y1 = std::min(y + PICKING_RADIUS, static_cast<int32_t>(extent.height) - 1);
+		readback.extent = { static_cast<uint32_t>(x1 - x0 + 1), static_cast<uint32_t>(y1 - y0 + 1) };
+		readback.cursorX = static_cast<uint32_t>(x - x0);
+		readback.cursorY = static_cast<uint32_t>(y - y0);
+
+		VkImageMemoryBarrier barrier{};
+		barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+		barrier.srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+		barrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+		barrier.oldLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+		barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+		barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.image = Renderer::GetIDImage();
+		barrier.subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1 };
+		vkCmdPipelineBarrier(frameInfo->commandBuffer, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT,
+			0, 0, nullptr, 0, nullptr, 1, &barrier);
+
+		VkBufferImageCopy region{};
+		region.imageSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1 };
+		region.imageOffset = { x0, y0, 0 };
+		region.imageExtent = { readback.extent.width, readback.extent.height, 1 };
+		vkCmdCopyImageToBuffer(frameInfo->commandBuffer, Renderer::GetIDImage(), VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+			readback.buffer->getBuffer(), 1, &region);
+
+		// back to the layout the render pass left it in, the viewport may sample it
+		barrier.srcAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+		barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+		barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+		barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+		vkCmdPipelineBarrier(frameInfo->commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+			0, 0, nullptr, 0, nullptr, 1, &barrier);
+
+		VkBufferMemoryBarrier hostBarrier{};
+		hostBarrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+		hostBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		hostBarrier.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+		hostBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		hostBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		hostBarrier.buffer = readback.buffer->getBuffer();
+		hostBarrier.size = VK_WHOLE_SIZE;
+		vkCmdPipelineBarrier(frameInfo->commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_HOST_BIT,
+			0, 0, nullptr, 1, &hostBarrier, 0, nullptr);
+
+		readback.fence = Renderer::GetFrameFence();
+		readback.swapChainVersion = Renderer::GetSwapChainVersion();
+		readback.pending = true;
+	}
+
+	void GLTFRenderer::PollPicking()
+	{
+		// in submission order, so an older click never overrides a newer one
+		const auto count = static_cast<uint32_t>(s_PickingReadbacks.size());
+		for (uint32_t i = 0; i < count; i++) {
+			auto& readback = s_PickingReadbacks[(s_PickingSlot + i) % count];
+			if (readback.pending && Renderer::IsFrameComplete(readback.fence, readback.swapChainVersion))
+				ResolvePicking(readback);
+		}
+	}
+
+	void GLTFRenderer::ResolvePicking(PickingReadback& readback)
+	{
+		readback.pending = false;
+		const auto* pixels = static_cast<const uint32_t*>(readback.buffer->getMappedMemory());
+
+		// the texel under the cursor wins, otherwise the closest object within the radius
+		uint32_t pixel = 0;
+		int32_t closest = std::numeric_limits<int32_t>::max();
+		for (uint32_t py = 0; py < readback.extent.height; py++) {
+			for (uint32_t px = 0; px < readback.extent.width; px++) {
+				const uint32_t id = pixels[py * readback.extent.width + px];
+				const int32_t dx = static_cast<int32_t>(px) - static_cast<int32_t>(readback.cursorX);
+				const int32_t dy = static_cast<int32_t>(py) - static_cast<int32_t>(readback.cursorY);
+				if (id != 0 && dx * dx + dy * dy < closest) {
+					closest = dx * dx + dy * dy;
+					pixel = id;
+				}
+			}
+		}
+
+		if (pixel != 0)
+			EditorLayer::SetSelectedEntity(static_cast<Entity>(pixel));
+		else
+			EditorLayer::DeselectEntity();
+		LOG_TRACE("Pixel {}", pixel);
 	}
 
 	void GLTFRenderer::Render()
@@ -162,52 +229,110 @@ namespace Nyxis
 		auto frameInfo = Application::GetFrameInfo();
 		auto scene = Application::GetScene();
 
+		if (UniformArena::BeginFrame(frameInfo->frameIndex))
+		{
+			// a frame in flight may still have the sets of the old buffer bound, so they are replaced instead of rewritten
+			DeletionQueue::Push([objectSet = objectDescriptorSets[frameInfo->frameIndex], nodeSet = nodeDescriptorSets[frameInfo->frameIndex]]() {
+				std::vector<VkDescriptorSet> sets = { objectSet, nodeSet };
+				ModelDescriptorManager::GetDescriptorPool()->freeDescriptors(sets);
+			});
+			objectDescriptorSets[frameInfo->frameIndex] = VK_NULL_HANDLE;
+			nodeDescriptorSets[frameInfo->frameIndex] = VK_NULL_HANDLE;
+			WriteObjectDescriptorSets(frameInfo->frameIndex);
+		}
+		const VkDeviceSize arenaSize = UniformArena::GetBuffer(frameInfo->frameIndex).getBufferSize();
+
 		UpdateBuffers();
-		vkCmdBindDescriptorSets(frameInfo->commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout, 0, 1, &skyboxDescriptorSets[frameInfo->frameIndex], 0, nullptr);
+		CollectChangedModels();
+		const uint32_t skyboxOffset = 0;
+		GpuProfiler::BeginPass(frameInfo->commandBuffer, GpuPass::Skybox);
+		vkCmdBindDescriptorSets(frameInfo->commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout, 0, 1, &skyboxDescriptorSets[frameInfo->frameIndex], 1, &skyboxOffset);
 		Pipes.skybox->Bind(frameInfo->commandBuffer);
 		skybox->draw(frameInfo->commandBuffer);
+		GpuProfiler::EndPass(frameInfo->commandBuffer, GpuPass::Skybox);
 
+		s_RenderedModels.clear();
 		auto modelView = scene->GetComponentView<Model>();
 		for (auto& model : modelView)
 		{
 			auto& gltfModel = scene->GetComponent<Model>(model);
-			if (!gltfModel.ready)
+			// models loaded after BeginFrame may own slots beyond this frame's arena buffer
+			if (!gltfModel.ready || gltfModel.uniformEnd > arenaSize)
 				continue;
-			auto& transform = scene->GetComponent<TransformComponent>(model);
+			const auto& world = scene->GetComponent<WorldTransform>(model);
 
-			s_ShaderValuesScene.model = transform.mat4();
+			s_ShaderValuesScene.model = world.matrix;
 			s_ShaderValuesScene.entityID = static_cast<int>(model);
-			s_ShaderValuesScene.isMouseClicked = Viewport::IsClicked() && !Viewport::IsHoveredOverGizmo();
-			s_ShaderValuesScene.selectedEntityID = static_cast<uint32_t>(EditorLayer::GetSelectedEntity());
-
-			gltfModel.updateUniformBuffer(frameInfo->frameIndex, &s_ShaderValuesScene);
-			gltfModel.bind(frameInfo->commandBuffer);
-
-			boundPipeline = VK_NULL_HANDLE;
-
-			for (auto node : gltfModel.nodes)
-				RenderNode(node, Material::ALPHAMODE_OPAQUE, gltfModel);
-			// Alpha masked primitives
-			for (auto node : gltfModel.nodes)
-				RenderNode(node, Material::ALPHAMODE_MASK, gltfModel);
-			// Transparent primitives
-			// TODO: Correct depth sorting
-			for (auto node : gltfModel.nodes)
-				RenderNode(node, Material::ALPHAMODE_BLEND, gltfModel);
+			s_ShaderValuesScene.jointOffset = gltfModel.skinning.preSkinned ? -1 : static_cast<int32_t>(gltfModel.jointOffset);
+
+			if (gltfModel.updateUniformBuffer(frameInfo->frameIndex, &s_ShaderValuesScene))
+			{
+				s_UploadStatistics.bytes += sizeof(UBOMatrix);
+				s_UploadStatistics.modelsUpdated++;
+			}
+			else
+				s_UploadStatistics.modelsSkipped++;
+			s_UploadStatistics.bytes += gltfModel.uploadMeshUniforms(frameInfo->frameIndex);
+			SelectLods(gltfModel, s_ShaderValuesScene.model);
+			RequestTextureMips(gltfModel, s_ShaderValuesScene.model);
+			gltfModel.updateStreamedTextures(s_SceneInfo);
+			s_RenderedModels.push_back(&gltfModel);
+		}
+
+		// one pass per alpha mode over all models, so every blended primitive is drawn after the opaque ones
+		// TODO: Correct depth sorting
+		constexpr std::array<std::pair<Material::AlphaMode, GpuPass>, 3> passes = { {
+			{ Material::ALPHAMODE_OPAQUE, GpuPass::Opaque },
+			{ Material::ALPHAMODE_MASK, GpuPass::Mask },
+			{ Material::ALPHAMODE_BLEND, GpuPass::Blend }
+		} };
+		for (const auto& [alphaMode, pass] : passes) {
+			GpuProfiler::BeginPass(frameInfo->commandBuffer, pass);
+			for (auto* gltfModel : s_RenderedModels) {
+				gltfModel->bind(frameInfo->commandBuffer);
+				if (gltfModel->skinning.preSkinned) {
+					const VkDeviceSize offsets[1] = { 0 };
+					const auto buffer = gltfModel->skinning.vertexBuffers[frameInfo->frameIndex]->getBuffer();
+					vkCmdBindVertexBuffers(frameInfo->commandBuffer, 0, 1, &buffer, offsets);
+				}
+				// culled meshlets were expanded into a per-frame 32 bit index buffer by CullMeshlets
+				if (s_MeshletSettings.enabled && gltfModel->meshlets.available)
+					vkCmdBindIndexBuffer(frameInfo->commandBuffer, gltfModel->meshlets.indexBuffers[frameInfo->frameIndex]->getBuffer(), 0, VK_INDEX_TYPE_UINT32);
+
+				boundPipeline = VK_NULL_HANDLE;
+				for (auto node : gltfModel->nodes)
+					RenderNode(node, alphaMode, *gltfModel);
+			}
+			GpuProfiler::EndPass(frameInfo->commandBuffer, pass);
 		}
 	}
 	
 	void GLTFRenderer::UpdateAnimation(float dt)
 	{
 		auto scene = Application::GetScene();
+		if (!s_AnimationJobs)
+			s_AnimationJobs = std::make_unique<ThreadPool>(std::max(2u, std::thread::hardware_concurrency()) - 1);
+
+		// models only touch their own nodes, so each one is a job; all of them are joined before returning
+		std::vector<std::future<void>> jobs;
+		auto view = scene->GetComponentView<Model>();
+		for (auto model : view)
+		{
+			auto& gltfModel = scene->GetComponent<Model>(model);
+			if (!gltfModel.ready || !gltfModel.animate || gltfModel.animations.empty())
+				continue;
+			jobs.push_back(s_AnimationJobs->submit([&gltfModel, dt] { gltfModel.updateAnimation(dt); }));
+		}
 
-		if (s_Animate) 
+		for (auto& job : jobs)
 		{
-			auto view = scene->GetComponentView<Model>();
-			for (auto model : view)
+			try
 			{
-				auto& gltfModel = scene->GetComponent<Model>(model);
-				gltfModel.updateAnimation(dt);
+				job.get();
+			}
+			catch (const std::exception& e)
+			{
+				LOG_ERROR("[Renderer] Animation update failed: {}", e.what());
 			}
 		}
 	}
@@ -219,6 +344,9 @@ namespace Nyxis
 		case PipelineType::PBR:
 			s_PBRPipelineUpdate = true;
 			break;
+		case PipelineType::SKYBOX:
+			s_SkyboxPipelineUpdate = true;
+			break;
 		default:
 			break;
 		}
@@ -230,6 +358,9 @@ namespace Nyxis
 		s_SkyboxBuffers.resize(SwapChain::MAX_FRAMES_IN_FLIGHT);
 		s_UniformBuffersParams.resize(SwapChain::MAX_FRAMES_IN_FLIGHT);
 		s_ObjectPickingBuffer.resize(SwapChain::MAX_FRAMES_IN_FLIGHT);
+		s_JointBuffers.resize(SwapChain::MAX_FRAMES_IN_FLIGHT);
+		s_JointBufferVersions.resize(SwapChain::MAX_FRAMES_IN_FLIGHT, 0);
+		s_PickingReadbacks.resize(SwapChain::MAX_FRAMES_IN_FLIGHT);
 
 		for (int i = 0; i < SwapChain::MAX_FRAMES_IN_FLIGHT; i++)
 		{
@@ -241,6 +372,15 @@ namespace Nyxis
 
 			s_ObjectPickingBuffer[i] = std::make_shared<Buffer>(sizeof(ObjectPicking), 1, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
 			s_ObjectPickingBuffer[i]->map();
+
+			s_PickingReadbacks[i].buffer = std::make_unique<Buffer>(PICKING_REGION * PICKING_REGION * sizeof(uint32_t), 1, VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+				VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+			s_PickingReadbacks[i].buffer->map();
+			// only the selection is written after this
+			s_ObjectPickingBuffer[i]->writeToBuffer(&objectPicking);
+
+			s_JointBuffers[i] = std::make_shared<Buffer>(sizeof(glm::mat4), 256, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+			s_JointBuffers[i]->map();
 		}
 	}
 
@@ -265,22 +405,137 @@ namespace Nyxis
 		s_ShaderValuesSkybox.view = scene->m_Camera->getViewMatrix();
 		s_ShaderValuesSkybox.model = glm::mat4(glm::mat3(s_ShaderValuesSkybox.view));
 
-		s_UniformBuffersParams[frameInfo->frameIndex]->writeToBuffer(&s_SceneInfo.shaderValuesParams);
-		s_SkyboxBuffers[frameInfo->frameIndex]->writeToBuffer(&s_ShaderValuesSkybox);
-
-		s_UniformBuffersParams[frameInfo->frameIndex]->flush();
-		s_SkyboxBuffers[frameInfo->frameIndex]->flush();
+		// buffers are only rewritten when their contents changed since this frame's copy was written
+		if (s_ParamsUpload.Update(s_SceneInfo.shaderValuesParams, frameInfo->frameIndex))
+		{
+			s_UniformBuffersParams[frameInfo->frameIndex]->writeToBuffer(&s_SceneInfo.shaderValuesParams);
+			s_UniformBuffersParams[frameInfo->frameIndex]->flush();
+			s_UploadStatistics.bytes += sizeof(s_SceneInfo.shaderValuesParams);
+		}
+		if (s_SkyboxUpload.Update(s_ShaderValuesSkybox, frameInfo->frameIndex))
+		{
+			s_SkyboxBuffers[frameInfo->frameIndex]->writeToBuffer(&s_ShaderValuesSkybox);
+			s_SkyboxBuffers[frameInfo->frameIndex]->flush();
+			s_UploadStatistics.bytes += sizeof(s_ShaderValuesSkybox);
+		}
 
+		// the picking array itself is never written by the host
 		objectPicking.selectedEntity = static_cast<uint32_t>(EditorLayer::GetSelectedEntity());
-		s_ObjectPickingBuffer[frameInfo->frameIndex]->writeToBuffer(&objectPicking);
-		s_ObjectPickingBuffer[frameInfo->frameIndex]->flush();
+		if (s_SelectionUpload.Update(objectPicking.selectedEntity, frameInfo->frameIndex))
+		{
+			s_ObjectPickingBuffer[frameInfo->frameIndex]->writeToBuffer(&objectPicking.selectedEntity, sizeof(uint32_t), offsetof(ObjectPicking, selectedEntity));
+			s_UploadStatistics.bytes += sizeof(uint32_t);
+		}
+	}
+
+	void GLTFRenderer::CollectChangedModels()
+	{
+		auto scene = Application::GetScene();
+
+		s_ShaderValuesScene.isMouseClicked = Viewport::IsClicked() && !Viewport::IsHoveredOverGizmo();
+		s_ShaderValuesScene.selectedEntityID = static_cast<uint32_t>(EditorLayer::GetSelectedEntity());
+
+		SceneUniforms sceneUniforms{};
+		sceneUniforms.projection = s_ShaderValuesScene.projection;
+		sceneUniforms.view = s_ShaderValuesScene.view;
+		sceneUniforms.camPos = s_ShaderValuesScene.camPos;
+		sceneUniforms.selectedEntityID = s_ShaderValuesScene.selectedEntityID;
+		sceneUniforms.isMouseClicked = s_ShaderValuesScene.isMouseClicked;
+		if (std::memcmp(&sceneUniforms, &s_SceneUniforms, sizeof(SceneUniforms)) != 0)
+		{
+			s_SceneUniforms = sceneUniforms;
+			for (auto entity : scene->GetComponentView<Model>())
+				scene->GetComponent<Model>(entity).markUniformsOutdated();
+		}
+
+		// entities whose world transform was rebuilt since the last frame
+		auto& observer = scene->GetTransformObserver();
+		for (auto entity : observer)
+		{
+			if (auto* model = scene->m_Registry.try_get<Model>(entity))
+				model->markUniformsOutdated();
+		}
+		observer.clear();
+	}
+
+	// bump when the IBL generator shaders change so stale cache entries are not picked up
+	static constexpr uint32_t IBL_CACHE_VERSION = 2;
+
+	static uint64_t hashFile(const std::string& filename)
+	{
+		std::ifstream file(filename, std::ios::binary);
+		const std::vector<char> contents((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+		return hashBytes(contents.data(), contents.size());
+	}
+
+	// precomputed IBL textures are cached in the project's asset directory, named by their cache key
+	static std::filesystem::path iblCachePath(const char* name, uint64_t key)
+	{
+		char keyString[17];
+		snprintf(keyString, sizeof(keyString), "%016llx", static_cast<unsigned long long>(key));
+		return std::filesystem::path(Application::GetProject()->GetAssetPath()) / ".cache" / "ibl" /
+			(std::string(name) + "_" + keyString + ".ktx");
+	}
+
+	// writes to a temporary file first so an interrupted run never leaves a truncated cache entry behind
+	static void saveToIBLCache(const std::filesystem::path& path, const std::function<bool(const std::string&)>& write)
+	{
+		std::error_code error;
+		std::filesystem::create_directories(path.parent_path(), error);
+
+		const auto tempPath = std::filesystem::path(path).concat(".tmp");
+		if (write(tempPath.string()))
+			std::filesystem::rename(tempPath, path, error);
+		else
+			error = std::make_error_code(std::errc::io_error);
+
+		if (error)
+		{
+			std::filesystem::remove(tempPath, error);
+			LOG_WARN("[Renderer] Failed to write IBL cache {}", path.string());
+		}
 	}
 
 	void GLTFRenderer::LoadEnvironment(std::string& filename)
 	{
 		LOG_INFO("[Renderer] Loading environment from {}", filename);
-		s_SceneInfo.textures.environmentCube.LoadFromFile(filename, VK_FORMAT_R16G16B16A16_SFLOAT);
+		if (!s_AnimationJobs)
+			s_AnimationJobs = std::make_unique<ThreadPool>(std::max(2u, std::thread::hardware_concurrency()) - 1);
+
+		// a read that is still running is superseded, it finishes into its own state which is then dropped
+		auto file = std::make_shared<EnvironmentFile>();
+		file->filename = filename;
+		file->reading = s_AnimationJobs->submit([file]() {
+			file->texture = TextureCubeMap::ReadFile(file->filename);
+			file->hash = hashFile(file->filename);
+		});
+		s_EnvironmentFile = std::move(file);
+	}
+
+	bool GLTFRenderer::UploadEnvironment(bool wait)
+	{
+		if (!s_EnvironmentFile)
+			return false;
+		auto& file = *s_EnvironmentFile;
+		if (!wait && file.reading.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+			return false;
+
+		const auto loaded = std::move(s_EnvironmentFile);
+		file.reading.get();
+		if (!file.texture || file.texture->empty())
+		{
+			LOG_ERROR("[Renderer] Failed to load environment {}", file.filename);
+			return false;
+		}
+
+		// a switch that is still being prefiltered is completed first, the new one replaces its textures
+		FinishEnvironment(true);
+
+		s_EnvironmentJob.environment = TextureCubeMap{};
+		s_EnvironmentJob.environment.LoadFromTexture(*file.texture, VK_FORMAT_R16G16B16A16_SFLOAT);
+		s_EnvMapHash = file.hash;
 		GenerateCubemaps();
+		return true;
 	}
 
 	void GLTFRenderer::LoadAssets()
@@ -309,12 +564,13 @@ namespace Nyxis
 
 		std::vector<VkDescriptorPoolSize> poolSizes = {
 			{ VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, (4 + meshCount) * SwapChain::MAX_FRAMES_IN_FLIGHT},
+			{ VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, 4 * SwapChain::MAX_FRAMES_IN_FLIGHT},
 			{ VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, imageSamplerCount * SwapChain::MAX_FRAMES_IN_FLIGHT},
 			{ VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 100 * SwapChain::MAX_FRAMES_IN_FLIGHT}
 		};
 		VkDescriptorPoolCreateInfo descriptorPoolCI{};
 		descriptorPoolCI.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
-		descriptorPoolCI.poolSizeCount = 3;
+		descriptorPoolCI.poolSizeCount = static_cast<uint32_t>(poolSizes.size());
 		descriptorPoolCI.pPoolSizes = poolSizes.data();
 		descriptorPoolCI.maxSets = (2 + materialCount + meshCount + 100) * SwapChain::MAX_FRAMES_IN_FLIGHT;
 		descriptorPoolCI.flags = VK_DESCRIPTOR_POOL_CREATE_FREE_DESCRIPTOR_SET_BIT;
@@ -326,7 +582,9 @@ namespace Nyxis
 		// Mouse Map descriptor layout
 		{
 			std::vector<VkDescriptorSetLayoutBinding> setLayoutBindings = {
-				{ 0, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1, VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT, nullptr }
+				{ 0, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1, VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT, nullptr },
+				// joint palette
+				{ 1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1, VK_SHADER_STAGE_VERTEX_BIT, nullptr }
 			};
 
 			VkDescriptorSetLayoutCreateInfo descriptorSetLayoutCI{};
@@ -356,16 +614,70 @@ namespace Nyxis
 			writeDescriptor.pBufferInfo = s_ObjectPickingBuffer[i]->getDescriptorInfo();
 
 			vkUpdateDescriptorSets(device->device(), 1, &writeDescriptor, 0, nullptr);
+			WriteJointBufferDescriptor(i);
 		}
 
 		UpdateSkyboxDescriptorSets();
+
+		objectDescriptorSets.assign(SwapChain::MAX_FRAMES_IN_FLIGHT, VK_NULL_HANDLE);
+		nodeDescriptorSets.assign(SwapChain::MAX_FRAMES_IN_FLIGHT, VK_NULL_HANDLE);
+		for (uint32_t i = 0; i < SwapChain::MAX_FRAMES_IN_FLIGHT; i++)
+			WriteObjectDescriptorSets(i);
+	}
+
+	void GLTFRenderer::WriteObjectDescriptorSets(uint32_t frameIndex)
+	{
+		auto pool = ModelDescriptorManager::GetDescriptorPool();
+		const VkBuffer arena = UniformArena::GetBuffer(frameIndex).getBuffer();
+		VkDescriptorBufferInfo objectInfo{ arena, 0, sizeof(UBOMatrix) };
+		VkDescriptorBufferInfo nodeInfo{ arena, 0, sizeof(Mesh::UniformBlock) };
+
+		// scene (matrices and environment maps)
+		DescriptorWriter objectWriter(ModelDescriptorManager::GetModelDescriptorSetLayout(), pool);
+		objectWriter.writeBuffer(0, &objectInfo)
+			.writeBuffer(1, s_UniformBuffersParams[frameIndex]->getDescriptorInfo())
+			.writeImage(2, &s_SceneInfo.textures.irradianceCube.m_Descriptor)
+			.writeImage(3, &s_SceneInfo.textures.prefilteredCube.m_Descriptor)
+			.writeImage(4, &s_SceneInfo.textures.lutBrdf.m_Descriptor);
+		if (objectDescriptorSets[frameIndex] == VK_NULL_HANDLE)
+			objectWriter.build(objectDescriptorSets[frameIndex]);
+		else
+			objectWriter.overwrite(objectDescriptorSets[frameIndex]);
+
+		// node (mesh matrices)
+		DescriptorWriter nodeWriter(ModelDescriptorManager::GetNodeDescriptorSetLayout(), pool);
+		nodeWriter.writeBuffer(0, &nodeInfo);
+		if (nodeDescriptorSets[frameIndex] == VK_NULL_HANDLE)
+			nodeWriter.build(nodeDescriptorSets[frameIndex]);
+		else
+			nodeWriter.overwrite(nodeDescriptorSets[frameIndex]);
+	}
+
+	void GLTFRenderer::WriteJointBufferDescriptor(uint32_t frameIndex)
+	{
+		VkWriteDescriptorSet writeDescriptor{};
+		writeDescriptor.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+		writeDescriptor.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+		writeDescriptor.descriptorCount = 1;
+		writeDescriptor.dstSet = depthBufferDescriptorSets[frameIndex];
+		writeDescriptor.dstBinding = 1;
+		writeDescriptor.pBufferInfo = s_JointBuffers[frameIndex]->getDescriptorInfo();
+
+		vkUpdateDescriptorSets(device->device(), 1, &writeDescriptor, 0, nullptr);
 	}
 
 	void GLTFRenderer::FreeDescriptorSets()
 	{
-		for (auto descriptorSet : skyboxDescriptorSets) {
+		// frames in flight may still have the sets bound
+		DeletionQueue::Push([skyboxSets = skyboxDescriptorSets, objectSets = objectDescriptorSets, nodeSets = nodeDescriptorSets]() mutable {
+			for (auto descriptorSet : skyboxSets) {
 				vkFreeDescriptorSets(device->device(), descriptorPool, 1, &descriptorSet);
-		}
+			}
+			if (!objectSets.empty()) {
+				ModelDescriptorManager::GetDescriptorPool()->freeDescriptors(objectSets);
+				ModelDescriptorManager::GetDescriptorPool()->freeDescriptors(nodeSets);
+			}
+		});
 	}
 
 
@@ -383,7 +695,7 @@ namespace Nyxis
 			std::array<VkWriteDescriptorSet, 3> writeDescriptorSets{};
 
 			writeDescriptorSets[0].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-			writeDescriptorSets[0].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+			writeDescriptorSets[0].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
 			writeDescriptorSets[0].descriptorCount = 1;
 			writeDescriptorSets[0].dstSet = skyboxDescriptorSets[i];
 			writeDescriptorSets[0].dstBinding = 0;
@@ -424,37 +736,316 @@ namespace Nyxis
 		}
 	}
 
-	void GLTFRenderer::RenderNode(Node* node, Material::AlphaMode alphaMode, Model& model)
+	// pixels per object space unit at the near side of the node's projected bounding sphere,
+	// infinity if the camera is inside of it
+	static float projectedPixelsPerUnit(Node* node, const glm::mat4& modelMatrix, const glm::mat4& view, float projectionScale, float viewportHeight)
 	{
-		auto frameInfo = Application::GetFrameInfo();
-		if (node->mesh) {
-			// Render mesh primitives
-			for (Primitive* primitive : node->mesh->primitives) {
-				if (primitive->material.alphaMode == alphaMode) {
+		// same space pbr.vert outputs world positions in, including its y flip
+		const glm::mat4 flipY = glm::scale(glm::mat4(1.0f), glm::vec3(1.0f, -1.0f, 1.0f));
+		const glm::mat4 world = flipY * modelMatrix * node->getMatrix();
+		const float worldScale = std::max({ glm::length(glm::vec3(world[0])), glm::length(glm::vec3(world[1])), glm::length(glm::vec3(world[2])) });
+		const BoundingBox& bb = node->mesh->bb;
+		const glm::vec3 center = glm::vec3(view * world * glm::vec4((bb.min + bb.max) * 0.5f, 1.0f));
+		const float radius = glm::length(bb.max - bb.min) * 0.5f * worldScale;
+		const float distance = -center.z;
+
+		if (distance <= radius)
+			return std::numeric_limits<float>::infinity();
+		return worldScale * projectionScale * viewportHeight * 0.5f / (distance - radius);
+	}
 
-					VkPipeline pipeline = VK_NULL_HANDLE;
-					switch (alphaMode) {
-					case Material::ALPHAMODE_OPAQUE:
-					case Material::ALPHAMODE_MASK:
-						pipeline = primitive->material.doubleSided ? pipelines.pbrDoubleSided : pipelines.pbr;
-						break;
-					case Material::ALPHAMODE_BLEND:
-						pipeline = pipelines.pbrAlphaBlend;
-						break;
+	void GLTFRenderer::SelectLods(Model& model, const glm::mat4& modelMatrix)
+	{
+		auto camera = Application::GetScene()->GetCamera();
+		const glm::mat4& view = camera->getViewMatrix();
+		const float projectionScale = camera->getProjectionMatrix()[1][1];
+		const float viewportHeight = static_cast<float>(Renderer::GetAspectRatio().height);
+
+		for (auto node : model.linearNodes) {
+			if (!node->mesh || node->mesh->lodErrors.size() < 2) {
+				continue;
+			}
+			if (!s_LodSettings.enabled) {
+				node->lodLevel = 0;
+				continue;
+			}
+
+			const float pixelsPerUnit = projectedPixelsPerUnit(node, modelMatrix, view, projectionScale, viewportHeight);
+
+			// camera inside the bounds, always full detail
+			if (std::isinf(pixelsPerUnit)) {
+				node->lodLevel = 0;
+				continue;
+			}
+
+			const auto& errors = node->mesh->lodErrors;
+			auto pixelError = [&](uint32_t level) { return errors[level] * pixelsPerUnit; };
+
+			uint32_t level = 0;
+			while (level + 1 < errors.size() && pixelError(level + 1) <= s_LodSettings.pixelError) {
+				level++;
+			}
+
+			// hysteresis: only go coarser with some headroom and only go finer once the current level is clearly too coarse
+			const uint32_t current = std::min<uint32_t>(node->lodLevel, static_cast<uint32_t>(errors.size() - 1));
+			if (level > current) {
+				while (level > current && pixelError(level) > s_LodSettings.pixelError * (1.0f - s_LodSettings.hysteresis)) {
+					level--;
+				}
+			}
+			else if (level < current && pixelError(current) <= s_LodSettings.pixelError * (1.0f + s_LodSettings.hysteresis)) {
+				level = current;
+			}
+			node->lodLevel = level;
+		}
+	}
+
+	void GLTFRenderer::RequestTextureMips(Model& model, const glm::mat4& modelMatrix)
+	{
+		if (!TextureStreamer::s_Settings.enabled)
+			return;
+
+		auto camera = Application::GetScene()->GetCamera();
+		const glm::mat4& view = camera->getViewMatrix();
+		const float projectionScale = camera->getProjectionMatrix()[1][1];
+		const float viewportHeight = static_cast<float>(Renderer::GetAspectRatio().height);
+
+		for (auto node : model.linearNodes) {
+			if (!node->mesh) {
+				continue;
+			}
+
+			const float pixelsPerUnit = projectedPixelsPerUnit(node, modelMatrix, view, projectionScale, viewportHeight);
+			for (auto primitive : node->mesh->primitives) {
+				const Material& material = primitive->material;
+				for (const ModelTexture* texture : { material.baseColorTexture, material.metallicRoughnessTexture, material.normalTexture,
+					material.occlusionTexture, material.emissiveTexture, material.extension.diffuseTexture, material.extension.specularGlossinessTexture }) {
+					if (!texture || texture->streamHandle == TextureStreamer::INVALID_HANDLE) {
+						continue;
 					}
 
-					if (pipeline != boundPipeline) {
+					// one texel per pixel: mip = log2(texels per pixel)
+					uint32_t mip = 0;
+					if (!std::isinf(pixelsPerUnit) && primitive->uvDensity > 0.0f) {
+						const float texelsPerPixel = std::max(texture->width, texture->height) * primitive->uvDensity / pixelsPerUnit;
+						mip = texelsPerPixel > 1.0f ? static_cast<uint32_t>(std::floor(std::log2(texelsPerPixel))) : 0;
 					}
+					TextureStreamer::Request(texture->streamHandle, mip);
+				}
+			}
+		}
+	}
 
-					Pipes.pbr->Bind(frameInfo->commandBuffer);
+	void GLTFRenderer::CullMeshlets()
+	{
+		if (!s_MeshletSettings.enabled)
+			return;
 
-					const std::vector<VkDescriptorSet> descriptorsets = {
-						model.getDescriptorSet(frameInfo->frameIndex),
-						primitive->material.descriptorSet,
-						node->mesh->uniformBuffer.descriptorSet,
-						depthBufferDescriptorSets[frameInfo->frameIndex]
-					};
-					vkCmdBindDescriptorSets(frameInfo->commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout, 0, static_cast<uint32_t>(descriptorsets.size()), descriptorsets.data(), 0, NULL);
+		auto frameInfo = Application::GetFrameInfo();
+		auto scene = Application::GetScene();
+		auto camera = scene->GetCamera();
+
+		struct PushConstants {
+			glm::vec4 frustumPlanes[6];
+			glm::vec4 cameraPosition;
+			uint32_t meshletCount;
+		} pushConstants{};
+
+		// Gribb-Hartmann plane extraction for a 0..1 depth range, normalized so the shader can compare against radii
+		const glm::mat4 viewProjection = camera->getProjectionMatrix() * camera->getViewMatrix();
+		const glm::mat4 rows = glm::transpose(viewProjection);
+		pushConstants.frustumPlanes[0] = rows[3] + rows[0];
+		pushConstants.frustumPlanes[1] = rows[3] - rows[0];
+		pushConstants.frustumPlanes[2] = rows[3] + rows[1];
+		pushConstants.frustumPlanes[3] = rows[3] - rows[1];
+		pushConstants.frustumPlanes[4] = rows[2];
+		pushConstants.frustumPlanes[5] = rows[3] - rows[2];
+		for (auto& plane : pushConstants.frustumPlanes)
+			plane /= glm::length(glm::vec3(plane));
+
+		const glm::vec3 cameraPosition = glm::inverse(camera->getViewMatrix())[3];
+		pushConstants.cameraPosition = glm::vec4(cameraPosition, s_MeshletSettings.coneCulling ? 1.0f : 0.0f);
+
+		s_CulledModels.clear();
+		auto modelView = scene->GetComponentView<Model>();
+		for (auto entity : modelView)
+		{
+			auto& model = scene->GetComponent<Model>(entity);
+			if (!model.ready || !model.meshlets.available)
+				continue;
+			const auto& world = scene->GetComponent<WorldTransform>(entity);
+
+			// the slot's previous frame has completed, its counts are final
+			model.collectVisibleTriangles(frameInfo->frameIndex);
+			s_DrawStatistics.triangles += model.meshlets.visibleTriangles;
+			model.updateMeshletDraws(frameInfo->frameIndex, world.matrix);
+
+			// reset the index counts of this frame's indirect commands
+			const auto& drawCommands = model.meshlets.drawCommandBuffers[frameInfo->frameIndex];
+			VkBufferCopy copyRegion{};
+			copyRegion.size = model.meshlets.draws.size() * sizeof(VkDrawIndexedIndirectCommand);
+			vkCmdCopyBuffer(frameInfo->commandBuffer, model.meshlets.drawTemplateBuffer->getBuffer(), drawCommands->getBuffer(), 1, &copyRegion);
+
+			VkBufferMemoryBarrier barrier{};
+			barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+			barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+			barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+			barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+			barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+			barrier.buffer = drawCommands->getBuffer();
+			barrier.size = VK_WHOLE_SIZE;
+			vkCmdPipelineBarrier(frameInfo->commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+				0, 0, nullptr, 1, &barrier, 0, nullptr);
+
+			vkCmdBindPipeline(frameInfo->commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, meshletPipeline);
+			vkCmdBindDescriptorSets(frameInfo->commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, meshletPipelineLayout, 0, 1,
+				&model.meshlets.descriptorSets[frameInfo->frameIndex], 0, nullptr);
+
+			pushConstants.meshletCount = model.meshlets.meshletCount;
+			vkCmdPushConstants(frameInfo->commandBuffer, meshletPipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(PushConstants), &pushConstants);
+			vkCmdDispatch(frameInfo->commandBuffer, (model.meshlets.meshletCount + 63) / 64, 1, 1);
+			s_CulledModels.push_back(&model);
+		}
+
+		if (s_CulledModels.empty())
+			return;
+
+		// indirect commands and expanded indices are consumed by the main pass, the index counts are also read back
+		VkMemoryBarrier barrier{};
+		barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+		barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+		barrier.dstAccessMask = VK_ACCESS_INDIRECT_COMMAND_READ_BIT | VK_ACCESS_INDEX_READ_BIT | VK_ACCESS_TRANSFER_READ_BIT;
+		vkCmdPipelineBarrier(frameInfo->commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+			VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_VERTEX_INPUT_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 1, &barrier, 0, nullptr, 0, nullptr);
+
+		for (auto* model : s_CulledModels)
+		{
+			VkBufferCopy copyRegion{};
+			copyRegion.size = model->meshlets.draws.size() * sizeof(VkDrawIndexedIndirectCommand);
+			vkCmdCopyBuffer(frameInfo->commandBuffer, model->meshlets.drawCommandBuffers[frameInfo->frameIndex]->getBuffer(),
+				model->meshlets.countBuffers[frameInfo->frameIndex]->getBuffer(), 1, &copyRegion);
+			model->meshlets.countsWritten[frameInfo->frameIndex] = true;
+		}
+
+		VkMemoryBarrier hostBarrier{};
+		hostBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+		hostBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		hostBarrier.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+		vkCmdPipelineBarrier(frameInfo->commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_HOST_BIT, 0, 1, &hostBarrier, 0, nullptr, 0, nullptr);
+	}
+
+	void GLTFRenderer::UpdateSkinning()
+	{
+		auto frameInfo = Application::GetFrameInfo();
+		auto scene = Application::GetScene();
+		const uint32_t frameIndex = frameInfo->frameIndex;
+		const uint32_t frameBit = 1u << frameIndex;
+
+		// first renderer work of the frame
+		s_UploadStatistics = {};
+		s_DrawStatistics = {};
+
+		// models are packed back to back into this frame's palette, moved models rewrite their uniforms and joints
+		uint32_t jointCount = 0;
+		auto modelView = scene->GetComponentView<Model>();
+		for (auto entity : modelView)
+		{
+			auto& model = scene->GetComponent<Model>(entity);
+			if (!model.ready)
+				continue;
+			if (model.jointOffset != jointCount)
+			{
+				model.jointOffset = jointCount;
+				model.markUniformsOutdated();
+				model.markJointsOutdated();
+			}
+			jointCount += static_cast<uint32_t>(model.jointMatrices.size());
+		}
+
+		// the previous user of this frame's buffer completed, so it can be replaced in place
+		auto& jointBuffer = s_JointBuffers[frameIndex];
+		bool reallocated = false;
+		if (jointBuffer->getInstanceCount() < jointCount)
+		{
+			reallocated = true;
+			const uint32_t capacity = std::max(jointCount, jointBuffer->getInstanceCount() * 2);
+			jointBuffer = std::make_shared<Buffer>(sizeof(glm::mat4), capacity, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+			jointBuffer->map();
+			WriteJointBufferDescriptor(frameIndex);
+			s_JointBufferVersions[frameIndex]++;
+		}
+
+		bool dispatched = false;
+		for (auto entity : modelView)
+		{
+			auto& model = scene->GetComponent<Model>(entity);
+			if (!model.ready || model.jointMatrices.empty())
+				continue;
+
+			if ((model.outdatedJointFrames & frameBit) || reallocated)
+			{
+				const VkDeviceSize size = model.jointMatrices.size() * sizeof(glm::mat4);
+				jointBuffer->writeToBuffer(model.jointMatrices.data(), size, model.jointOffset * sizeof(glm::mat4));
+				model.outdatedJointFrames &= ~frameBit;
+				s_UploadStatistics.bytes += size;
+			}
+
+			// the vertex shader skips skinning for pre-skinned models, which is part of the model uniforms
+			if (model.skinning.preSkinned != s_SkinningSettings.computePreSkin)
+			{
+				model.skinning.preSkinned = s_SkinningSettings.computePreSkin;
+				model.markUniformsOutdated();
+			}
+			if (!s_SkinningSettings.computePreSkin)
+				continue;
+
+			if (model.skinning.vertexBuffers.empty())
+				model.setupSkinning();
+			if (model.skinning.paletteVersions[frameIndex] != s_JointBufferVersions[frameIndex])
+				model.writeSkinningDescriptorSet(frameIndex, jointBuffer->getDescriptorInfo(), s_JointBufferVersions[frameIndex]);
+
+			vkCmdBindPipeline(frameInfo->commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, skinningPipeline);
+			vkCmdBindDescriptorSets(frameInfo->commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, skinningPipelineLayout, 0, 1,
+				&model.skinning.descriptorSets[frameIndex], 0, nullptr);
+
+			for (auto node : model.linearNodes)
+			{
+				if (!node->mesh || !node->skin)
+					continue;
+				for (auto primitive : node->mesh->primitives)
+				{
+					struct PushConstants {
+						uint32_t firstVertex;
+						uint32_t vertexCount;
+						uint32_t jointOffset;
+					} pushConstants{ primitive->vertexOffset, primitive->vertexCount, model.jointOffset + node->mesh->uniformBlock.jointOffset };
+
+					vkCmdPushConstants(frameInfo->commandBuffer, skinningPipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(PushConstants), &pushConstants);
+					vkCmdDispatch(frameInfo->commandBuffer, (primitive->vertexCount + 63) / 64, 1, 1);
+				}
+			}
+			dispatched = true;
+		}
+
+		if (!dispatched)
+			return;
+
+		// skinned vertices are read as vertex attributes by every pass of this frame
+		VkMemoryBarrier barrier{};
+		barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+		barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+		barrier.dstAccessMask = VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT;
+		vkCmdPipelineBarrier(frameInfo->commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_VERTEX_INPUT_BIT,
+			0, 1, &barrier, 0, nullptr, 0, nullptr);
+	}
+
+	void GLTFRenderer::RenderNode(Node* node, Material::AlphaMode alphaMode, Model& model)
+	{
+		auto frameInfo = Application::GetFrameInfo();
+		if (node->mesh) {
+			// Render mesh primitives
+			for (Primitive* primitive : node->mesh->primitives) {
+				if (primitive->material.alphaMode == alphaMode) {
 
 					// Pass material parameters as push constants
 					PushConstBlockMaterial pushConstBlockMaterial{};
@@ -490,13 +1081,44 @@ namespace Nyxis
 						pushConstBlockMaterial.specularFactor = glm::vec4(primitive->material.extension.specularFactor, 1.0f);
 					}
 
+					// debug views are compiled out of the specialized variants
+					const auto& params = s_SceneInfo.shaderValuesParams;
+					const bool debugView = params.debugViewInputs > 0.0f || params.debugViewEquation > 0.0f;
+					Pipeline* pipeline = s_ShaderVariants && !debugView ? GetPBRVariant(GetMaterialFeatures(pushConstBlockMaterial)) : Pipes.pbr.get();
+					if (pipeline->GetPipeline() != boundPipeline) {
+						pipeline->Bind(frameInfo->commandBuffer);
+						boundPipeline = pipeline->GetPipeline();
+					}
+
+					const std::array<VkDescriptorSet, 4> descriptorsets = {
+						objectDescriptorSets[frameInfo->frameIndex],
+						primitive->material.descriptorSet,
+						nodeDescriptorSets[frameInfo->frameIndex],
+						depthBufferDescriptorSets[frameInfo->frameIndex]
+					};
+					// model slot for set 0, mesh slot for set 2
+					const std::array<uint32_t, 2> dynamicOffsets = {
+						static_cast<uint32_t>(model.uniformOffset),
+						static_cast<uint32_t>(node->mesh->uniformOffset)
+					};
+					vkCmdBindDescriptorSets(frameInfo->commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout, 0, static_cast<uint32_t>(descriptorsets.size()), descriptorsets.data(),
+						static_cast<uint32_t>(dynamicOffsets.size()), dynamicOffsets.data());
+
 					vkCmdPushConstants(frameInfo->commandBuffer, pipelineLayout, VK_SHADER_STAGE_FRAGMENT_BIT, 0, sizeof(PushConstBlockMaterial), &pushConstBlockMaterial);
 
-					if (primitive->hasIndices) {
-						vkCmdDrawIndexed(frameInfo->commandBuffer, primitive->indexCount, 1, primitive->firstIndex, 0, 0);
+					s_DrawStatistics.drawCalls++;
+					if (primitive->hasIndices && s_MeshletSettings.enabled && model.meshlets.available) {
+						vkCmdDrawIndexedIndirect(frameInfo->commandBuffer, model.meshlets.drawCommandBuffers[frameInfo->frameIndex]->getBuffer(),
+							primitive->meshletDraw * sizeof(VkDrawIndexedIndirectCommand), 1, sizeof(VkDrawIndexedIndirectCommand));
+					}
+					else if (primitive->hasIndices) {
+						const auto& lod = primitive->getLod(node->lodLevel);
+						vkCmdDrawIndexed(frameInfo->commandBuffer, lod.indexCount, 1, lod.firstIndex, primitive->vertexOffset, 0);
+						s_DrawStatistics.triangles += lod.indexCount / 3;
 					}
 					else {
-						vkCmdDraw(frameInfo->commandBuffer, primitive->vertexCount, 1, 0, 0);
+						vkCmdDraw(frameInfo->commandBuffer, primitive->vertexCount, 1, primitive->vertexOffset, 0);
+						s_DrawStatistics.triangles += primitive->vertexCount / 3;
 					}
 				}
 			}
@@ -507,33 +1129,61 @@ namespace Nyxis
 		}
 	}
 
+	uint32_t GLTFRenderer::GetMaterialFeatures(const PushConstBlockMaterial& material)
+	{
+		uint32_t features = 0;
+		if (material.colorTextureSet > -1)
+			features |= MATERIAL_FEATURE_BASE_COLOR_MAP;
+		if (material.PhysicalDescriptorTextureSet > -1)
+			features |= MATERIAL_FEATURE_PHYSICAL_DESCRIPTOR_MAP;
+		if (material.normalTextureSet > -1)
+			features |= MATERIAL_FEATURE_NORMAL_MAP;
+		if (material.occlusionTextureSet > -1)
+			features |= MATERIAL_FEATURE_OCCLUSION_MAP;
+		if (material.emissiveTextureSet > -1)
+			features |= MATERIAL_FEATURE_EMISSIVE_MAP;
+		if (material.workflow == static_cast<float>(PBR_WORKFLOW_SPECULAR_GLOSINESS))
+			features |= MATERIAL_FEATURE_SPECULAR_GLOSSINESS;
+		if (material.alphaMask == 1.0f)
+			features |= MATERIAL_FEATURE_ALPHA_MASK;
+		return features;
+	}
+
+	void GLTFRenderer::ConfigurePBRVariant(Pipeline& variant, uint32_t features)
+	{
+		// variants follow the config tweaks made to the generic PBR pipeline
+		auto& config = variant.GetConfig();
+		config = Pipes.pbr->GetConfig();
+		config.fragmentSpecialization.SetConstant<VkBool32>(0, VK_TRUE);		// SPECIALIZED
+		config.fragmentSpecialization.SetConstant<uint32_t>(1, features);		// MATERIAL_FEATURES
+		config.fragmentSpecialization.SetConstant<VkBool32>(2, VK_FALSE);		// DEBUG_VIEWS
+	}
+
+	Pipeline* GLTFRenderer::GetPBRVariant(uint32_t features)
+	{
+		auto it = s_PBRVariants.find(features);
+		if (it == s_PBRVariants.end())
+		{
+			auto variant = std::make_shared<Pipeline>(
+				"../shaders/pbr/pbr.vert.spv",
+				"../shaders/pbr/pbr.frag.spv");
+			ConfigurePBRVariant(*variant, features);
+			variant->RecreateAsync();
+			it = s_PBRVariants.emplace(features, variant).first;
+		}
+
+		// the generic pipeline is drawn with until the variant finished compiling
+		return it->second->IsReady() ? it->second.get() : Pipes.pbr.get();
+	}
+
 	VkPipelineShaderStageCreateInfo loadShader(VkDevice device, std::string filename, VkShaderStageFlagBits stage)
 	{
 		VkPipelineShaderStageCreateInfo shaderStage{};
 		shaderStage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
 		shaderStage.stage = stage;
 		shaderStage.pName = "main";
-		std::ifstream is(filename, std::ios::binary | std::ios::in | std::ios::ate);
-
-		if (is.is_open()) {
-			size_t size = is.tellg();
-			is.seekg(0, std::ios::beg);
-			char* shaderCode = new char[size];
-			is.read(shaderCode, size);
-			is.close();
-			assert(size > 0);
-			VkShaderModuleCreateInfo moduleCreateInfo{};
-			moduleCreateInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
-			moduleCreateInfo.codeSize = size;
-			moduleCreateInfo.pCode = (uint32_t*)shaderCode;
-			vkCreateShaderModule(device, &moduleCreateInfo, NULL, &shaderStage.module);
-			delete[] shaderCode;
-		}
-		else {
-			std::cerr << "Error: Could not open shader file \"" << filename << "\"" << std::endl;
-			shaderStage.module = VK_NULL_HANDLE;
-		}
-		assert(shaderStage.module != VK_NULL_HANDLE);
+		// released with ShaderModuleCache::Release once the pipeline is created
+		shaderStage.module = ShaderModuleCache::Acquire(filename).module;
 		return shaderStage;
 	}
 
@@ -631,6 +1281,56 @@ namespace Nyxis
 		Pipes.pbr->Create();
 	}
 
+	void GLTFRenderer::PrepareMeshletPipeline()
+	{
+		VkDescriptorSetLayout setLayout = ModelDescriptorManager::GetMeshletDescriptorSetLayout()->getDescriptorSetLayout();
+
+		VkPushConstantRange pushConstantRange{};
+		pushConstantRange.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+		pushConstantRange.size = sizeof(glm::vec4) * 7 + sizeof(uint32_t);
+
+		VkPipelineLayoutCreateInfo pipelineLayoutCI{};
+		pipelineLayoutCI.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+		pipelineLayoutCI.setLayoutCount = 1;
+		pipelineLayoutCI.pSetLayouts = &setLayout;
+		pipelineLayoutCI.pushConstantRangeCount = 1;
+		pipelineLayoutCI.pPushConstantRanges = &pushConstantRange;
+		vkCreatePipelineLayout(device->device(), &pipelineLayoutCI, nullptr, &meshletPipelineLayout);
+
+		VkComputePipelineCreateInfo pipelineCI{};
+		pipelineCI.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+		pipelineCI.layout = meshletPipelineLayout;
+		pipelineCI.stage = loadShader(device->device(), "../shaders/pbr/meshlet_cull.comp.spv", VK_SHADER_STAGE_COMPUTE_BIT);
+		vkCreateComputePipelines(device->device(), device->pipelineCache(), 1, &pipelineCI, nullptr, &meshletPipeline);
+
+		ShaderModuleCache::Release(pipelineCI.stage.module);
+	}
+
+	void GLTFRenderer::PrepareSkinningPipeline()
+	{
+		VkDescriptorSetLayout setLayout = ModelDescriptorManager::GetSkinningDescriptorSetLayout()->getDescriptorSetLayout();
+
+		VkPushConstantRange pushConstantRange{};
+		pushConstantRange.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+		pushConstantRange.size = sizeof(uint32_t) * 3;
+
+		VkPipelineLayoutCreateInfo pipelineLayoutCI{};
+		pipelineLayoutCI.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+		pipelineLayoutCI.setLayoutCount = 1;
+		pipelineLayoutCI.pSetLayouts = &setLayout;
+		pipelineLayoutCI.pushConstantRangeCount = 1;
+		pipelineLayoutCI.pPushConstantRanges = &pushConstantRange;
+		vkCreatePipelineLayout(device->device(), &pipelineLayoutCI, nullptr, &skinningPipelineLayout);
+
+		VkComputePipelineCreateInfo pipelineCI{};
+		pipelineCI.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+		pipelineCI.layout = skinningPipelineLayout;
+		pipelineCI.stage = loadShader(device->device(), "../shaders/pbr/skin.comp.spv", VK_SHADER_STAGE_COMPUTE_BIT);
+		vkCreateComputePipelines(device->device(), device->pipelineCache(), 1, &pipelineCI, nullptr, &skinningPipeline);
+
+		ShaderModuleCache::Release(pipelineCI.stage.module);
+	}
+
 	void GLTFRenderer::GenerateBRDFLUT()
 	{
 		auto tStart = std::chrono::high_resolution_clock::now();
@@ -638,6 +1338,22 @@ namespace Nyxis
 		const VkFormat format = VK_FORMAT_R16G16_SFLOAT;
 		const int32_t dim = 1024;
 
+		uint64_t cacheKey = hashValue(IBL_CACHE_VERSION, hashBytes("brdflut", 7));
+		cacheKey = hashValue(format, cacheKey);
+		cacheKey = hashValue(dim, cacheKey);
+		const auto cachePath = iblCachePath("brdflut", cacheKey);
+
+		if (s_CacheIBL && std::filesystem::exists(cachePath))
+		{
+			s_SceneInfo.textures.lutBrdf.LoadFromFile(cachePath.string(), format, VK_IMAGE_USAGE_SAMPLED_BIT,
+				VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE);
+
+			auto tEnd = std::chrono::high_resolution_clock::now();
+			auto tDiff = std::chrono::duration<double, std::milli>(tEnd - tStart).count();
+			LOG_INFO("[Renderer] Loading cached BRDF LUT took {} ms", tDiff);
+			return;
+		}
+
 		// Image
 		VkImageCreateInfo imageCI{};
 		imageCI.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
@@ -650,7 +1366,7 @@ namespace Nyxis
 		imageCI.arrayLayers = 1;
 		imageCI.samples = VK_SAMPLE_COUNT_1_BIT;
 		imageCI.tiling = VK_IMAGE_TILING_OPTIMAL;
-		imageCI.usage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+		imageCI.usage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
 		vkCreateImage(device->device(), &imageCI, nullptr, &s_SceneInfo.textures.lutBrdf.m_Image);
 		VkMemoryRequirements memReqs;
 		vkGetImageMemoryRequirements(device->device(), s_SceneInfo.textures.lutBrdf.m_Image, &memReqs);
@@ -832,9 +1548,9 @@ namespace Nyxis
 			loadShader(device->device(), "../shaders/pbr/genbrdflut.frag.spv", VK_SHADER_STAGE_FRAGMENT_BIT)
 		};
 		VkPipeline pipeline;
-		vkCreateGraphicsPipelines(device->device(), pipelineCache, 1, &pipelineCI, nullptr, &pipeline);
+		vkCreateGraphicsPipelines(device->device(), device->pipelineCache(), 1, &pipelineCI, nullptr, &pipeline);
 		for (auto shaderStage : shaderStages) {
-			vkDestroyShaderModule(device->device(), shaderStage.module, nullptr);
+			ShaderModuleCache::Release(shaderStage.module);
 		}
 
 		// Render
@@ -879,21 +1595,136 @@ namespace Nyxis
 		s_SceneInfo.textures.lutBrdf.m_Descriptor.imageView = s_SceneInfo.textures.lutBrdf.m_View;
 		s_SceneInfo.textures.lutBrdf.m_Descriptor.sampler = s_SceneInfo.textures.lutBrdf.m_Sampler;
 		s_SceneInfo.textures.lutBrdf.m_Descriptor.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+		s_SceneInfo.textures.lutBrdf.m_ImageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+		s_SceneInfo.textures.lutBrdf.m_Width = dim;
+		s_SceneInfo.textures.lutBrdf.m_Height = dim;
+		s_SceneInfo.textures.lutBrdf.m_MipLevels = 1;
+		s_SceneInfo.textures.lutBrdf.m_LayerCount = 1;
+
+		if (s_CacheIBL)
+			saveToIBLCache(cachePath, [format](const std::string& path) { return s_SceneInfo.textures.lutBrdf.SaveToFile(path, format); });
 
 		auto tEnd = std::chrono::high_resolution_clock::now();
 		auto tDiff = std::chrono::duration<double, std::milli>(tEnd - tStart).count();
 		LOG_INFO("[Renderer] Generating BRDF LUT took {} ms", tDiff);
 	}
 
+	void GLTFRenderer::PrepareIBLPipelines()
+	{
+		std::array<VkDescriptorSetLayoutBinding, 2> setLayoutBindings{};
+		setLayoutBindings[0] = { 0, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1, VK_SHADER_STAGE_COMPUTE_BIT, nullptr };
+		setLayoutBindings[1] = { 1, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, 1, VK_SHADER_STAGE_COMPUTE_BIT, nullptr };
+
+		VkDescriptorSetLayoutCreateInfo descriptorSetLayoutCI{};
+		descriptorSetLayoutCI.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+		descriptorSetLayoutCI.pBindings = setLayoutBindings.data();
+		descriptorSetLayoutCI.bindingCount = static_cast<uint32_t>(setLayoutBindings.size());
+		vkCreateDescriptorSetLayout(device->device(), &descriptorSetLayoutCI, nullptr, &iblDescriptorSetLayout);
+
+		// both filters take two 32 bit parameters
+		VkPushConstantRange pushConstantRange{};
+		pushConstantRange.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+		pushConstantRange.size = 2 * sizeof(uint32_t);
+
+		VkPipelineLayoutCreateInfo pipelineLayoutCI{};
+		pipelineLayoutCI.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+		pipelineLayoutCI.setLayoutCount = 1;
+		pipelineLayoutCI.pSetLayouts = &iblDescriptorSetLayout;
+		pipelineLayoutCI.pushConstantRangeCount = 1;
+		pipelineLayoutCI.pPushConstantRanges = &pushConstantRange;
+		vkCreatePipelineLayout(device->device(), &pipelineLayoutCI, nullptr, &iblPipelineLayout);
+
+		VkComputePipelineCreateInfo pipelineCI{};
+		pipelineCI.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+		pipelineCI.layout = iblPipelineLayout;
+
+		pipelineCI.stage = loadShader(device->device(), "../shaders/pbr/irradiancecube.comp.spv", VK_SHADER_STAGE_COMPUTE_BIT);
+		vkCreateComputePipelines(device->device(), device->pipelineCache(), 1, &pipelineCI, nullptr, &irradiancePipeline);
+		ShaderModuleCache::Release(pipelineCI.stage.module);
+
+		pipelineCI.stage = loadShader(device->device(), "../shaders/pbr/prefilterenvmap.comp.spv", VK_SHADER_STAGE_COMPUTE_BIT);
+		vkCreateComputePipelines(device->device(), device->pipelineCache(), 1, &pipelineCI, nullptr, &prefilterPipeline);
+		ShaderModuleCache::Release(pipelineCI.stage.module);
+	}
+
+	// queue family ownership transfer of a whole image, recorded once on the releasing and once on the acquiring queue
+	static void transferImageOwnership(VkCommandBuffer cmdBuf, const Texture& texture, VkImageLayout oldLayout, VkImageLayout newLayout,
+		uint32_t srcQueueFamily, uint32_t dstQueueFamily, bool release)
+	{
+		VkImageMemoryBarrier imageMemoryBarrier{};
+		imageMemoryBarrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+		imageMemoryBarrier.image = texture.m_Image;
+		imageMemoryBarrier.oldLayout = oldLayout;
+		imageMemoryBarrier.newLayout = newLayout;
+		imageMemoryBarrier.srcAccessMask = release ? VK_ACCESS_SHADER_WRITE_BIT : 0;
+		imageMemoryBarrier.dstAccessMask = release ? 0 : VK_ACCESS_SHADER_READ_BIT;
+		imageMemoryBarrier.srcQueueFamilyIndex = srcQueueFamily;
+		imageMemoryBarrier.dstQueueFamilyIndex = dstQueueFamily;
+		imageMemoryBarrier.subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, 0, texture.m_MipLevels, 0, 6 };
+		vkCmdPipelineBarrier(cmdBuf,
+			release ? VK_PIPELINE_STAGE_ALL_COMMANDS_BIT : VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+			release ? VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT : VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
+			0, 0, nullptr, 0, nullptr, 1, &imageMemoryBarrier);
+	}
+
 	void GLTFRenderer::GenerateCubemaps()
 	{
 		enum Target { IRRADIANCE = 0, PREFILTEREDENV = 1 };
 
-		for (uint32_t target = 0; target < PREFILTEREDENV + 1; target++) {
+		struct PushBlockIrradiance {
+			float deltaPhi = (2.0f * float(3.14159265358979323846)) / 180.0f;
+			float deltaTheta = (0.5f * float(3.14159265358979323846)) / 64.0f;
+		} pushBlockIrradiance;
+
+		struct PushBlockPrefilterEnv {
+			float roughness;
+			uint32_t numSamples = 32u;
+		} pushBlockPrefilterEnv;
 
-			TextureCubeMap cubemap{};
+		auto& job = s_EnvironmentJob;
+		job.startTime = std::chrono::high_resolution_clock::now();
 
-			auto tStart = std::chrono::high_resolution_clock::now();
+		const bool asyncCompute = device->hasAsyncCompute();
+		const uint32_t graphicsFamily = device->graphicsQueueFamily();
+		const uint32_t computeFamily = device->computeQueueFamily();
+
+		// one set per mip level of both targets
+		std::array<VkDescriptorPoolSize, 2> poolSizes = { {
+			{ VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 32 },
+			{ VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, 32 }
+		} };
+		VkDescriptorPoolCreateInfo descriptorPoolCI{};
+		descriptorPoolCI.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+		descriptorPoolCI.poolSizeCount = static_cast<uint32_t>(poolSizes.size());
+		descriptorPoolCI.pPoolSizes = poolSizes.data();
+		descriptorPoolCI.maxSets = 32;
+		vkCreateDescriptorPool(device->device(), &descriptorPoolCI, nullptr, &job.descriptorPool);
+
+		VkCommandBufferAllocateInfo cmdBufAllocateInfo{};
+		cmdBufAllocateInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+		cmdBufAllocateInfo.commandPool = device->getComputeCommandPool();
+		cmdBufAllocateInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+		cmdBufAllocateInfo.commandBufferCount = 1;
+		vkAllocateCommandBuffers(device->device(), &cmdBufAllocateInfo, &job.commandBuffer);
+
+		VkCommandBufferBeginInfo beginInfo{};
+		beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+		beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+		vkBeginCommandBuffer(job.commandBuffer, &beginInfo);
+		GpuProfiler::BeginEnvironment(job.commandBuffer);
+
+		// the environment was uploaded on the graphics queue, the next frame releases it to the compute queue
+		if (asyncCompute) {
+			transferImageOwnership(job.commandBuffer, job.environment, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+				VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, graphicsFamily, computeFamily, false);
+		}
+
+		for (uint32_t target = 0; target < PREFILTEREDENV + 1; target++) {
+
+			TextureCubeMap& cubemap = job.cubemaps[target];
+			cubemap = TextureCubeMap{};
+			job.generated[target] = false;
+			job.readbacks[target] = nullptr;
 
 			VkFormat format;
 			int32_t dim;
@@ -911,6 +1742,31 @@ namespace Nyxis
 
 			const uint32_t numMips = static_cast<uint32_t>(floor(log2(dim))) + 1;
 
+			uint64_t cacheKey = hashValue(IBL_CACHE_VERSION, s_EnvMapHash);
+			cacheKey = hashValue(target, cacheKey);
+			cacheKey = hashValue(format, cacheKey);
+			cacheKey = hashValue(dim, cacheKey);
+			cacheKey = hashValue(numMips, cacheKey);
+			if (target == IRRADIANCE) {
+				cacheKey = hashValue(pushBlockIrradiance.deltaPhi, cacheKey);
+				cacheKey = hashValue(pushBlockIrradiance.deltaTheta, cacheKey);
+			}
+			else {
+				cacheKey = hashValue(pushBlockPrefilterEnv.numSamples, cacheKey);
+			}
+			const auto cachePath = iblCachePath(target == IRRADIANCE ? "irradiance" : "prefiltered", cacheKey);
+			job.cachePaths[target] = cachePath.string();
+
+			if (s_CacheIBL && std::filesystem::exists(cachePath)) {
+				auto tStart = std::chrono::high_resolution_clock::now();
+				cubemap.LoadFromFile(cachePath.string(), format);
+
+				auto tEnd = std::chrono::high_resolution_clock::now();
+				auto tDiff = std::chrono::duration<double, std::milli>(tEnd - tStart).count();
+				LOG_INFO("[Renderer] Loading cached cube map with {} mip levels took {} ms", cubemap.m_MipLevels, tDiff);
+				continue;
+			}
+
 			// Create target cubemap
 			{
 				// Image
@@ -925,7 +1781,7 @@ namespace Nyxis
 				imageCI.arrayLayers = 6;
 				imageCI.samples = VK_SAMPLE_COUNT_1_BIT;
 				imageCI.tiling = VK_IMAGE_TILING_OPTIMAL;
-				imageCI.usage = VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+				imageCI.usage = VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
 				imageCI.flags = VK_IMAGE_CREATE_CUBE_COMPATIBLE_BIT;
 				NYXIS_ASSERT(vkCreateImage(device->device(), &imageCI, nullptr, &cubemap.m_Image) == VK_SUCCESS, "Failed to create cubemap m_Image!");
 
@@ -966,317 +1822,12 @@ namespace Nyxis
 				vkCreateSampler(device->device(), &samplerCI, nullptr, &cubemap.m_Sampler);
 			}
 
-			// FB, Att, RP, Pipe, etc.
-			VkAttachmentDescription attDesc{};
-			// Color attachment
-			attDesc.format = format;
-			attDesc.samples = VK_SAMPLE_COUNT_1_BIT;
-			attDesc.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
-			attDesc.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
-			attDesc.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
-			attDesc.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
-			attDesc.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-			attDesc.finalLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
-			VkAttachmentReference colorReference = { 0, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL };
-
-			VkSubpassDescription subpassDescription{};
-			subpassDescription.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
-			subpassDescription.colorAttachmentCount = 1;
-			subpassDescription.pColorAttachments = &colorReference;
-
-			// Use subpass dependencies for layout transitions
-			std::array<VkSubpassDependency, 2> dependencies;
-			dependencies[0].srcSubpass = VK_SUBPASS_EXTERNAL;
-			dependencies[0].dstSubpass = 0;
-			dependencies[0].srcStageMask = VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT;
-			dependencies[0].dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
-			dependencies[0].srcAccessMask = VK_ACCESS_MEMORY_READ_BIT;
-			dependencies[0].dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
-			dependencies[0].dependencyFlags = VK_DEPENDENCY_BY_REGION_BIT;
-			dependencies[1].srcSubpass = 0;
-			dependencies[1].dstSubpass = VK_SUBPASS_EXTERNAL;
-			dependencies[1].srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
-			dependencies[1].dstStageMask = VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT;
-			dependencies[1].srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
-			dependencies[1].dstAccessMask = VK_ACCESS_MEMORY_READ_BIT;
-			dependencies[1].dependencyFlags = VK_DEPENDENCY_BY_REGION_BIT;
-
-			// Renderpass
-			VkRenderPassCreateInfo renderPassCI{};
-			renderPassCI.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
-			renderPassCI.attachmentCount = 1;
-			renderPassCI.pAttachments = &attDesc;
-			renderPassCI.subpassCount = 1;
-			renderPassCI.pSubpasses = &subpassDescription;
-			renderPassCI.dependencyCount = 2;
-			renderPassCI.pDependencies = dependencies.data();
-			VkRenderPass renderpass;
-			vkCreateRenderPass(device->device(), &renderPassCI, nullptr, &renderpass);
-
-			struct Offscreen {
-				VkImage image;
-				VkImageView view;
-				VkDeviceMemory memory;
-				VkFramebuffer framebuffer;
-			} offscreen;
-
-			// Create offscreen framebuffer
-			{
-				// Image
-				VkImageCreateInfo imageCI{};
-				imageCI.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
-				imageCI.imageType = VK_IMAGE_TYPE_2D;
-				imageCI.format = format;
-				imageCI.extent.width = dim;
-				imageCI.extent.height = dim;
-				imageCI.extent.depth = 1;
-				imageCI.mipLevels = 1;
-				imageCI.arrayLayers = 1;
-				imageCI.samples = VK_SAMPLE_COUNT_1_BIT;
-				imageCI.tiling = VK_IMAGE_TILING_OPTIMAL;
-				imageCI.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-				imageCI.usage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
-				imageCI.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
-				vkCreateImage(device->device(), &imageCI, nullptr, &offscreen.image);
-				VkMemoryRequirements memReqs;
-				vkGetImageMemoryRequirements(device->device(), offscreen.image, &memReqs);
-				VkMemoryAllocateInfo memAllocInfo{};
-				memAllocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-				memAllocInfo.allocationSize = memReqs.size;
-				memAllocInfo.memoryTypeIndex = device->findMemoryType(memReqs.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
-				vkAllocateMemory(device->device(), &memAllocInfo, nullptr, &offscreen.memory);
-				vkBindImageMemory(device->device(), offscreen.image, offscreen.memory, 0);
-
-				// View
-				VkImageViewCreateInfo viewCI{};
-				viewCI.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
-				viewCI.viewType = VK_IMAGE_VIEW_TYPE_2D;
-				viewCI.format = format;
-				viewCI.flags = 0;
-				viewCI.subresourceRange = {};
-				viewCI.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-				viewCI.subresourceRange.baseMipLevel = 0;
-				viewCI.subresourceRange.levelCount = 1;
-				viewCI.subresourceRange.baseArrayLayer = 0;
-				viewCI.subresourceRange.layerCount = 1;
-				viewCI.image = offscreen.image;
-				vkCreateImageView(device->device(), &viewCI, nullptr, &offscreen.view);
-
-				// Framebuffer
-				VkFramebufferCreateInfo framebufferCI{};
-				framebufferCI.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
-				framebufferCI.renderPass = renderpass;
-				framebufferCI.attachmentCount = 1;
-				framebufferCI.pAttachments = &offscreen.view;
-				framebufferCI.width = dim;
-				framebufferCI.height = dim;
-				framebufferCI.layers = 1;
-				vkCreateFramebuffer(device->device(), &framebufferCI, nullptr, &offscreen.framebuffer);
-
-				VkCommandBuffer layoutCmd = device->beginSingleTimeCommands();
-				VkImageMemoryBarrier imageMemoryBarrier{};
-				imageMemoryBarrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
-				imageMemoryBarrier.image = offscreen.image;
-				imageMemoryBarrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-				imageMemoryBarrier.newLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
-				imageMemoryBarrier.srcAccessMask = 0;
-				imageMemoryBarrier.dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
-				imageMemoryBarrier.subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1 };
-				vkCmdPipelineBarrier(layoutCmd, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, 0, 0, nullptr, 0, nullptr, 1, &imageMemoryBarrier);
-				device->endSingleTimeCommands(layoutCmd);
-			}
-
-			// Descriptors
-			VkDescriptorSetLayout descriptorsetlayout;
-			VkDescriptorSetLayoutBinding setLayoutBinding = { 0, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1, VK_SHADER_STAGE_FRAGMENT_BIT, nullptr };
-			VkDescriptorSetLayoutCreateInfo descriptorSetLayoutCI{};
-			descriptorSetLayoutCI.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
-			descriptorSetLayoutCI.pBindings = &setLayoutBinding;
-			descriptorSetLayoutCI.bindingCount = 1;
-			vkCreateDescriptorSetLayout(device->device(), &descriptorSetLayoutCI, nullptr, &descriptorsetlayout);
-
-			// Descriptor Pool
-			VkDescriptorPoolSize poolSize = { VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1 };
-			VkDescriptorPoolCreateInfo descriptorPoolCI{};
-			descriptorPoolCI.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
-			descriptorPoolCI.poolSizeCount = 1;
-			descriptorPoolCI.pPoolSizes = &poolSize;
-			descriptorPoolCI.maxSets = 2;
-			VkDescriptorPool descriptorpool;
-			vkCreateDescriptorPool(device->device(), &descriptorPoolCI, nullptr, &descriptorpool);
-
-			// Descriptor sets
-			VkDescriptorSet descriptorset;
-			VkDescriptorSetAllocateInfo descriptorSetAllocInfo{};
-			descriptorSetAllocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
-			descriptorSetAllocInfo.descriptorPool = descriptorpool;
-			descriptorSetAllocInfo.pSetLayouts = &descriptorsetlayout;
-			descriptorSetAllocInfo.descriptorSetCount = 1;
-			vkAllocateDescriptorSets(device->device(), &descriptorSetAllocInfo, &descriptorset);
-			VkWriteDescriptorSet writeDescriptorSet{};
-			writeDescriptorSet.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-			writeDescriptorSet.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-			writeDescriptorSet.descriptorCount = 1;
-			writeDescriptorSet.dstSet = descriptorset;
-			writeDescriptorSet.dstBinding = 0;
-			writeDescriptorSet.pImageInfo = &s_SceneInfo.textures.environmentCube.m_Descriptor;
-			vkUpdateDescriptorSets(device->device(), 1, &writeDescriptorSet, 0, nullptr);
-
-			struct PushBlockIrradiance {
-				glm::mat4 mvp;
-				float deltaPhi = (2.0f * float(3.14159265358979323846)) / 180.0f;
-				float deltaTheta = (0.5f * float(3.14159265358979323846)) / 64.0f;
-			} pushBlockIrradiance;
-
-			struct PushBlockPrefilterEnv {
-				glm::mat4 mvp;
-				float roughness;
-				uint32_t numSamples = 32u;
-			} pushBlockPrefilterEnv;
-
-			// Pipeline layout
-			VkPipelineLayout pipelinelayout;
-			VkPushConstantRange pushConstantRange{};
-			pushConstantRange.stageFlags = VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT;
-
-			switch (target) {
-			case IRRADIANCE:
-				pushConstantRange.size = sizeof(PushBlockIrradiance);
-				break;
-			case PREFILTEREDENV:
-				pushConstantRange.size = sizeof(PushBlockPrefilterEnv);
-				break;
-			};
-
-			VkPipelineLayoutCreateInfo pipelineLayoutCI{};
-			pipelineLayoutCI.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
-			pipelineLayoutCI.setLayoutCount = 1;
-			pipelineLayoutCI.pSetLayouts = &descriptorsetlayout;
-			pipelineLayoutCI.pushConstantRangeCount = 1;
-			pipelineLayoutCI.pPushConstantRanges = &pushConstantRange;
-			vkCreatePipelineLayout(device->device(), &pipelineLayoutCI, nullptr, &pipelinelayout);
-
-			// Pipeline
-			VkPipelineInputAssemblyStateCreateInfo inputAssemblyStateCI{};
-			inputAssemblyStateCI.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
-			inputAssemblyStateCI.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
-
-			VkPipelineRasterizationStateCreateInfo rasterizationStateCI{};
-			rasterizationStateCI.sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
-			rasterizationStateCI.polygonMode = VK_POLYGON_MODE_FILL;
-			rasterizationStateCI.cullMode = VK_CULL_MODE_NONE;
-			rasterizationStateCI.frontFace = VK_FRONT_FACE_COUNTER_CLOCKWISE;
-			rasterizationStateCI.lineWidth = 1.0f;
-
-			VkPipelineColorBlendAttachmentState blendAttachmentState{};
-			blendAttachmentState.colorWriteMask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
-			blendAttachmentState.blendEnable = VK_FALSE;
-
-			VkPipelineColorBlendStateCreateInfo colorBlendStateCI{};
-			colorBlendStateCI.sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
-			colorBlendStateCI.attachmentCount = 1;
-			colorBlendStateCI.pAttachments = &blendAttachmentState;
-
-			VkPipelineDepthStencilStateCreateInfo depthStencilStateCI{};
-			depthStencilStateCI.sType = VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO;
-			depthStencilStateCI.depthTestEnable = VK_FALSE;
-			depthStencilStateCI.depthWriteEnable = VK_FALSE;
-			depthStencilStateCI.depthCompareOp = VK_COMPARE_OP_LESS_OR_EQUAL;
-			depthStencilStateCI.front = depthStencilStateCI.back;
-			depthStencilStateCI.back.compareOp = VK_COMPARE_OP_ALWAYS;
-
-			VkPipelineViewportStateCreateInfo viewportStateCI{};
-			viewportStateCI.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
-			viewportStateCI.viewportCount = 1;
-			viewportStateCI.scissorCount = 1;
-
-			VkPipelineMultisampleStateCreateInfo multisampleStateCI{};
-			multisampleStateCI.sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO;
-			multisampleStateCI.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT;
-
-			std::vector<VkDynamicState> dynamicStateEnables = { VK_DYNAMIC_STATE_VIEWPORT, VK_DYNAMIC_STATE_SCISSOR };
-			VkPipelineDynamicStateCreateInfo dynamicStateCI{};
-			dynamicStateCI.sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
-			dynamicStateCI.pDynamicStates = dynamicStateEnables.data();
-			dynamicStateCI.dynamicStateCount = static_cast<uint32_t>(dynamicStateEnables.size());
-
-			// Vertex input state
-			VkVertexInputBindingDescription vertexInputBinding = { 0, sizeof(Model::Vertex), VK_VERTEX_INPUT_RATE_VERTEX };
-			VkVertexInputAttributeDescription vertexInputAttribute = { 0, 0, VK_FORMAT_R32G32B32_SFLOAT, 0 };
-
-			VkPipelineVertexInputStateCreateInfo vertexInputStateCI{};
-			vertexInputStateCI.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
-			vertexInputStateCI.vertexBindingDescriptionCount = 1;
-			vertexInputStateCI.pVertexBindingDescriptions = &vertexInputBinding;
-			vertexInputStateCI.vertexAttributeDescriptionCount = 1;
-			vertexInputStateCI.pVertexAttributeDescriptions = &vertexInputAttribute;
-
-			std::array<VkPipelineShaderStageCreateInfo, 2> shaderStages;
-
-			VkGraphicsPipelineCreateInfo pipelineCI{};
-			pipelineCI.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
-			pipelineCI.layout = pipelinelayout;
-			pipelineCI.renderPass = renderpass;
-			pipelineCI.pInputAssemblyState = &inputAssemblyStateCI;
-			pipelineCI.pVertexInputState = &vertexInputStateCI;
-			pipelineCI.pRasterizationState = &rasterizationStateCI;
-			pipelineCI.pColorBlendState = &colorBlendStateCI;
-			pipelineCI.pMultisampleState = &multisampleStateCI;
-			pipelineCI.pViewportState = &viewportStateCI;
-			pipelineCI.pDepthStencilState = &depthStencilStateCI;
-			pipelineCI.pDynamicState = &dynamicStateCI;
-			pipelineCI.stageCount = 2;
-			pipelineCI.pStages = shaderStages.data();
-			pipelineCI.renderPass = renderpass;
-
-			shaderStages[0] = loadShader(device->device(), "../shaders/pbr/filtercube.vert.spv", VK_SHADER_STAGE_VERTEX_BIT);
-			switch (target) {
-			case IRRADIANCE:
-				shaderStages[1] = loadShader(device->device(), "../shaders/pbr/irradiancecube.frag.spv", VK_SHADER_STAGE_FRAGMENT_BIT);
-				break;
-			case PREFILTEREDENV:
-				shaderStages[1] = loadShader(device->device(), "../shaders/pbr/prefilterenvmap.frag.spv", VK_SHADER_STAGE_FRAGMENT_BIT);
-				break;
-			};
-			VkPipeline pipeline;
-			vkCreateGraphicsPipelines(device->device(), pipelineCache, 1, &pipelineCI, nullptr, &pipeline);
-			for (auto shaderStage : shaderStages) {
-				vkDestroyShaderModule(device->device(), shaderStage.module, nullptr);
-			}
-
-			// Render cubemap
-			VkClearValue clearValues[1];
-			clearValues[0].color = { { 0.0f, 0.0f, 0.2f, 0.0f } };
-
-			VkRenderPassBeginInfo renderPassBeginInfo{};
-			renderPassBeginInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
-			renderPassBeginInfo.renderPass = renderpass;
-			renderPassBeginInfo.framebuffer = offscreen.framebuffer;
-			renderPassBeginInfo.renderArea.extent.width = dim;
-			renderPassBeginInfo.renderArea.extent.height = dim;
-			renderPassBeginInfo.clearValueCount = 1;
-			renderPassBeginInfo.pClearValues = clearValues;
-
-			std::vector<glm::mat4> matrices = {
-				glm::rotate(glm::rotate(glm::mat4(1.0f), glm::radians(90.0f), glm::vec3(0.0f, 1.0f, 0.0f)), glm::radians(180.0f), glm::vec3(1.0f, 0.0f, 0.0f)),
-				glm::rotate(glm::rotate(glm::mat4(1.0f), glm::radians(-90.0f), glm::vec3(0.0f, 1.0f, 0.0f)), glm::radians(180.0f), glm::vec3(1.0f, 0.0f, 0.0f)),
-				glm::rotate(glm::mat4(1.0f), glm::radians(-90.0f), glm::vec3(1.0f, 0.0f, 0.0f)),
-				glm::rotate(glm::mat4(1.0f), glm::radians(90.0f), glm::vec3(1.0f, 0.0f, 0.0f)),
-				glm::rotate(glm::mat4(1.0f), glm::radians(180.0f), glm::vec3(1.0f, 0.0f, 0.0f)),
-				glm::rotate(glm::mat4(1.0f), glm::radians(180.0f), glm::vec3(0.0f, 0.0f, 1.0f)),
-			};
-
-			VkCommandBuffer cmdBuf = device->beginSingleTimeCommands();
-
-			VkViewport viewport{};
-			viewport.width = (float)dim;
-			viewport.height = (float)dim;
-			viewport.minDepth = 0.0f;
-			viewport.maxDepth = 1.0f;
-
-			VkRect2D scissor{};
-			scissor.extent.width = dim;
-			scissor.extent.height = dim;
+			cubemap.m_Width = dim;
+			cubemap.m_Height = dim;
+			cubemap.m_MipLevels = numMips;
+			cubemap.m_LayerCount = 6;
+			cubemap.m_ImageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+			cubemap.UpdateDescriptor();
 
 			VkImageSubresourceRange subresourceRange{};
 			subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
@@ -1284,161 +1835,267 @@ namespace Nyxis
 			subresourceRange.levelCount = numMips;
 			subresourceRange.layerCount = 6;
 
-			// Change image layout for all cubemap faces to transfer destination
 			{
 				VkImageMemoryBarrier imageMemoryBarrier{};
 				imageMemoryBarrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
 				imageMemoryBarrier.image = cubemap.m_Image;
 				imageMemoryBarrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-				imageMemoryBarrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+				imageMemoryBarrier.newLayout = VK_IMAGE_LAYOUT_GENERAL;
 				imageMemoryBarrier.srcAccessMask = 0;
-				imageMemoryBarrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+				imageMemoryBarrier.dstAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+				imageMemoryBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+				imageMemoryBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
 				imageMemoryBarrier.subresourceRange = subresourceRange;
-				vkCmdPipelineBarrier(cmdBuf, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, 0, 0, nullptr, 0, nullptr, 1, &imageMemoryBarrier);
+				vkCmdPipelineBarrier(job.commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 0, nullptr, 0, nullptr, 1, &imageMemoryBarrier);
 			}
 
-			device->endSingleTimeCommands(cmdBuf);
+			vkCmdBindPipeline(job.commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, target == IRRADIANCE ? irradiancePipeline : prefilterPipeline);
 
+			// every mip level is written through its own storage view, the dispatch covers all six faces
 			for (uint32_t m = 0; m < numMips; m++) {
-				for (uint32_t f = 0; f < 6; f++) {
-
-					auto cmdBuf = device->beginSingleTimeCommands();
-
-					viewport.width = static_cast<float>(dim * std::pow(0.5f, m));
-					viewport.height = static_cast<float>(dim * std::pow(0.5f, m));
-					vkCmdSetViewport(cmdBuf, 0, 1, &viewport);
-					vkCmdSetScissor(cmdBuf, 0, 1, &scissor);
-
-					// Render scene from cube face's point of view
-					vkCmdBeginRenderPass(cmdBuf, &renderPassBeginInfo, VK_SUBPASS_CONTENTS_INLINE);
-
-					// Pass parameters for current pass using a push constant block
-					switch (target) {
-					case IRRADIANCE:
-						pushBlockIrradiance.mvp = glm::perspective((float)(3.14159265358979323846 / 2.0), 1.0f, 0.1f, 1024.0f) * matrices[f];
-						vkCmdPushConstants(cmdBuf, pipelinelayout, VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT, 0, sizeof(PushBlockIrradiance), &pushBlockIrradiance);
-						break;
-					case PREFILTEREDENV:
-						pushBlockPrefilterEnv.mvp = glm::perspective((float)(3.14159265358979323846 / 2.0), 1.0f, 0.1f, 1024.0f) * matrices[f];
-						pushBlockPrefilterEnv.roughness = (float)m / (float)(numMips - 1);
-						vkCmdPushConstants(cmdBuf, pipelinelayout, VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT, 0, sizeof(PushBlockPrefilterEnv), &pushBlockPrefilterEnv);
-						break;
-					}
-
-					vkCmdBindPipeline(cmdBuf, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline);
-					vkCmdBindDescriptorSets(cmdBuf, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelinelayout, 0, 1, &descriptorset, 0, NULL);
-
-					VkDeviceSize offsets[1] = { 0 };
-
-					skybox->draw(cmdBuf);
-
-					vkCmdEndRenderPass(cmdBuf);
+				VkImageViewCreateInfo viewCI{};
+				viewCI.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+				viewCI.viewType = VK_IMAGE_VIEW_TYPE_2D_ARRAY;
+				viewCI.format = format;
+				viewCI.subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, m, 1, 0, 6 };
+				viewCI.image = cubemap.m_Image;
+				VkImageView mipView;
+				vkCreateImageView(device->device(), &viewCI, nullptr, &mipView);
+				job.mipViews.push_back(mipView);
+
+				VkDescriptorSet descriptorSet;
+				VkDescriptorSetAllocateInfo descriptorSetAllocInfo{};
+				descriptorSetAllocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+				descriptorSetAllocInfo.descriptorPool = job.descriptorPool;
+				descriptorSetAllocInfo.pSetLayouts = &iblDescriptorSetLayout;
+				descriptorSetAllocInfo.descriptorSetCount = 1;
+				vkAllocateDescriptorSets(device->device(), &descriptorSetAllocInfo, &descriptorSet);
+
+				VkDescriptorImageInfo storageImageInfo{ VK_NULL_HANDLE, mipView, VK_IMAGE_LAYOUT_GENERAL };
+
+				std::array<VkWriteDescriptorSet, 2> writeDescriptorSets{};
+				writeDescriptorSets[0].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+				writeDescriptorSets[0].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+				writeDescriptorSets[0].descriptorCount = 1;
+				writeDescriptorSets[0].dstSet = descriptorSet;
+				writeDescriptorSets[0].dstBinding = 0;
+				writeDescriptorSets[0].pImageInfo = &job.environment.m_Descriptor;
+				writeDescriptorSets[1].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+				writeDescriptorSets[1].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+				writeDescriptorSets[1].descriptorCount = 1;
+				writeDescriptorSets[1].dstSet = descriptorSet;
+				writeDescriptorSets[1].dstBinding = 1;
+				writeDescriptorSets[1].pImageInfo = &storageImageInfo;
+				vkUpdateDescriptorSets(device->device(), static_cast<uint32_t>(writeDescriptorSets.size()), writeDescriptorSets.data(), 0, nullptr);
+
+				vkCmdBindDescriptorSets(job.commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, iblPipelineLayout, 0, 1, &descriptorSet, 0, nullptr);
+
+				switch (target) {
+				case IRRADIANCE:
+					vkCmdPushConstants(job.commandBuffer, iblPipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(PushBlockIrradiance), &pushBlockIrradiance);
+					break;
+				case PREFILTEREDENV:
+					pushBlockPrefilterEnv.roughness = (float)m / (float)(numMips - 1);
+					vkCmdPushConstants(job.commandBuffer, iblPipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(PushBlockPrefilterEnv), &pushBlockPrefilterEnv);
+					break;
+				};
 
-					VkImageSubresourceRange subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1 };
-					subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-					subresourceRange.baseMipLevel = 0;
-					subresourceRange.levelCount = numMips;
-					subresourceRange.layerCount = 6;
+				const uint32_t mipDim = std::max(1u, static_cast<uint32_t>(dim) >> m);
+				vkCmdDispatch(job.commandBuffer, (mipDim + 7) / 8, (mipDim + 7) / 8, 6);
+			}
 
-					{
-						VkImageMemoryBarrier imageMemoryBarrier{};
-						imageMemoryBarrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
-						imageMemoryBarrier.image = offscreen.image;
-						imageMemoryBarrier.oldLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
-						imageMemoryBarrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
-						imageMemoryBarrier.srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
-						imageMemoryBarrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
-						imageMemoryBarrier.subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1 };
-						vkCmdPipelineBarrier(cmdBuf, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, 0, 0, nullptr, 0, nullptr, 1, &imageMemoryBarrier);
-					}
+			// the job copies the cube out for the cache itself, the file is written by a worker once it completed
+			if (s_CacheIBL)
+				job.readbacks[target] = cubemap.RecordReadback(job.commandBuffer, VK_IMAGE_LAYOUT_GENERAL, format);
 
-					// Copy region for transfer from framebuffer to cube face
-					VkImageCopy copyRegion{};
-
-					copyRegion.srcSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-					copyRegion.srcSubresource.baseArrayLayer = 0;
-					copyRegion.srcSubresource.mipLevel = 0;
-					copyRegion.srcSubresource.layerCount = 1;
-					copyRegion.srcOffset = { 0, 0, 0 };
-
-					copyRegion.dstSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-					copyRegion.dstSubresource.baseArrayLayer = f;
-					copyRegion.dstSubresource.mipLevel = m;
-					copyRegion.dstSubresource.layerCount = 1;
-					copyRegion.dstOffset = { 0, 0, 0 };
-
-					copyRegion.extent.width = static_cast<uint32_t>(viewport.width);
-					copyRegion.extent.height = static_cast<uint32_t>(viewport.height);
-					copyRegion.extent.depth = 1;
-
-					vkCmdCopyImage(
-						cmdBuf,
-						offscreen.image,
-						VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
-						cubemap.m_Image,
-						VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-						1,
-						&copyRegion);
-
-					{
-						VkImageMemoryBarrier imageMemoryBarrier{};
-						imageMemoryBarrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
-						imageMemoryBarrier.image = offscreen.image;
-						imageMemoryBarrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
-						imageMemoryBarrier.newLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
-						imageMemoryBarrier.srcAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
-						imageMemoryBarrier.dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
-						imageMemoryBarrier.subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1 };
-						vkCmdPipelineBarrier(cmdBuf, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, 0, 0, nullptr, 0, nullptr, 1, &imageMemoryBarrier);
-					}
-
-					device->endSingleTimeCommands(cmdBuf);
-				}
+			// finished cubes are read by the graphics queue, on a separate family this releases them to it
+			if (asyncCompute) {
+				transferImageOwnership(job.commandBuffer, cubemap, VK_IMAGE_LAYOUT_GENERAL,
+					VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, computeFamily, graphicsFamily, true);
 			}
-
-			{
-				cmdBuf = device->beginSingleTimeCommands();
+			else {
 				VkImageMemoryBarrier imageMemoryBarrier{};
 				imageMemoryBarrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
 				imageMemoryBarrier.image = cubemap.m_Image;
-				imageMemoryBarrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+				imageMemoryBarrier.oldLayout = VK_IMAGE_LAYOUT_GENERAL;
 				imageMemoryBarrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-				imageMemoryBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
-				imageMemoryBarrier.dstAccessMask = VK_ACCESS_HOST_WRITE_BIT | VK_ACCESS_TRANSFER_WRITE_BIT;
+				imageMemoryBarrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+				imageMemoryBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+				imageMemoryBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+				imageMemoryBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
 				imageMemoryBarrier.subresourceRange = subresourceRange;
-				vkCmdPipelineBarrier(cmdBuf, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, 0, 0, nullptr, 0, nullptr, 1, &imageMemoryBarrier);
-				device->endSingleTimeCommands(cmdBuf);
+				vkCmdPipelineBarrier(job.commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+					0, 0, nullptr, 0, nullptr, 1, &imageMemoryBarrier);
 			}
 
+			job.generated[target] = true;
+		}
 
-			vkDestroyRenderPass(device->device(), renderpass, nullptr);
-			vkDestroyFramebuffer(device->device(), offscreen.framebuffer, nullptr);
-			vkFreeMemory(device->device(), offscreen.memory, nullptr);
-			vkDestroyImageView(device->device(), offscreen.view, nullptr);
-			vkDestroyImage(device->device(), offscreen.image, nullptr);
-			vkDestroyDescriptorPool(device->device(), descriptorpool, nullptr);
-			vkDestroyDescriptorSetLayout(device->device(), descriptorsetlayout, nullptr);
-			vkDestroyPipeline(device->device(), pipeline, nullptr);
-			vkDestroyPipelineLayout(device->device(), pipelinelayout, nullptr);
+		if (asyncCompute) {
+			transferImageOwnership(job.commandBuffer, job.environment, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+				VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, computeFamily, graphicsFamily, true);
+		}
 
-			cubemap.m_Descriptor.imageView = cubemap.m_View;
-			cubemap.m_Descriptor.sampler = cubemap.m_Sampler;
-			cubemap.m_Descriptor.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+		GpuProfiler::EndEnvironment(job.commandBuffer);
+		vkEndCommandBuffer(job.commandBuffer);
 
-			switch (target) {
-			case IRRADIANCE:
-				s_SceneInfo.textures.irradianceCube = cubemap;
-				break;
-			case PREFILTEREDENV:
-				s_SceneInfo.textures.prefilteredCube = cubemap;
-				s_SceneInfo.shaderValuesParams.prefilteredCubeMipLevels = static_cast<float>(numMips);
-				break;
+		VkFenceCreateInfo fenceCI{};
+		fenceCI.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+		vkCreateFence(device->device(), &fenceCI, nullptr, &job.fence);
+
+		job.active = true;
+		job.stage = EnvironmentJob::Stage::Release;
+		if (!asyncCompute)
+			SubmitEnvironment();
+	}
+
+	void GLTFRenderer::SubmitEnvironment()
+	{
+		auto& job = s_EnvironmentJob;
+		VkSubmitInfo submitInfo{};
+		submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+		submitInfo.commandBufferCount = 1;
+		submitInfo.pCommandBuffers = &job.commandBuffer;
+		vkQueueSubmit(device->computeQueue(), 1, &submitInfo, job.fence);
+		job.stage = EnvironmentJob::Stage::Compute;
+	}
+
+	// the queue family ownership transfers between the graphics and the compute queue, one side each
+	static void releaseEnvironment(VkCommandBuffer cmdBuf, const Texture& environment, uint32_t graphicsFamily, uint32_t computeFamily)
+	{
+		transferImageOwnership(cmdBuf, environment, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+			VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, graphicsFamily, computeFamily, true);
+	}
+
+	template <typename Job>
+	static void acquireEnvironment(VkCommandBuffer cmdBuf, const Job& job, uint32_t graphicsFamily, uint32_t computeFamily)
+	{
+		transferImageOwnership(cmdBuf, job.environment, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+			VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, computeFamily, graphicsFamily, false);
+		for (uint32_t target = 0; target < job.cubemaps.size(); target++) {
+			if (job.generated[target]) {
+				transferImageOwnership(cmdBuf, job.cubemaps[target], VK_IMAGE_LAYOUT_GENERAL,
+					VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, computeFamily, graphicsFamily, false);
 			}
+		}
+	}
 
-			auto tEnd = std::chrono::high_resolution_clock::now();
-			auto tDiff = std::chrono::duration<double, std::milli>(tEnd - tStart).count();
-			LOG_INFO("[Renderer] Generating cube map with {} mip levels took {} ms", numMips, tDiff);
+	void GLTFRenderer::RecordEnvironmentTransfer()
+	{
+		auto& job = s_EnvironmentJob;
+		if (!job.active || !device->hasAsyncCompute())
+			return;
+
+		const auto commandBuffer = Application::GetFrameInfo()->commandBuffer;
+		const uint32_t graphicsFamily = device->graphicsQueueFamily();
+		const uint32_t computeFamily = device->computeQueueFamily();
+		switch (job.stage) {
+		case EnvironmentJob::Stage::Release:
+			releaseEnvironment(commandBuffer, job.environment, graphicsFamily, computeFamily);
+			job.releasedFrames = 0;
+			job.stage = EnvironmentJob::Stage::Released;
+			break;
+		case EnvironmentJob::Stage::Released:
+			// the compute queue acquires the environment, so the frame releasing it has to be complete
+			if (++job.releasedFrames >= SwapChain::MAX_FRAMES_IN_FLIGHT)
+				SubmitEnvironment();
+			break;
+		case EnvironmentJob::Stage::Compute:
+			// acquired before this frame samples the new cubes
+			if (vkGetFenceStatus(device->device(), job.fence) == VK_SUCCESS) {
+				acquireEnvironment(commandBuffer, job, graphicsFamily, computeFamily);
+				CompleteEnvironment();
+			}
+			break;
+		}
+	}
+
+	bool GLTFRenderer::FinishEnvironment(bool wait)
+	{
+		auto& job = s_EnvironmentJob;
+		if (!job.active)
+			return false;
+
+		const bool asyncCompute = device->hasAsyncCompute();
+		if (!wait) {
+			// with async compute the frames record the ownership transfers and complete the job
+			if (asyncCompute || vkGetFenceStatus(device->device(), job.fence) != VK_SUCCESS)
+				return false;
+			CompleteEnvironment();
+			return true;
+		}
+
+		// callers waiting for the job block anyway, the transfers the frames did not record yet are submitted directly
+		const uint32_t graphicsFamily = device->graphicsQueueFamily();
+		const uint32_t computeFamily = device->computeQueueFamily();
+		if (job.stage == EnvironmentJob::Stage::Release) {
+			VkCommandBuffer releaseCmd = device->beginSingleTimeCommands();
+			releaseEnvironment(releaseCmd, job.environment, graphicsFamily, computeFamily);
+			device->endSingleTimeCommands(releaseCmd);
+			SubmitEnvironment();
+		}
+		else if (job.stage == EnvironmentJob::Stage::Released) {
+			vkQueueWaitIdle(device->graphicsQueue());
+			SubmitEnvironment();
+		}
+		vkWaitForFences(device->device(), 1, &job.fence, VK_TRUE, UINT64_MAX);
+
+		if (asyncCompute) {
+			VkCommandBuffer acquireCmd = device->beginSingleTimeCommands();
+			acquireEnvironment(acquireCmd, job, graphicsFamily, computeFamily);
+			device->endSingleTimeCommands(acquireCmd);
 		}
+		CompleteEnvironment();
+		return true;
+	}
+
+	void GLTFRenderer::CompleteEnvironment()
+	{
+		auto& job = s_EnvironmentJob;
+		GpuProfiler::CollectEnvironment();
+
+		// encoding and writing the KTX files does not hold up the frame
+		for (uint32_t target = 0; target < job.readbacks.size(); target++) {
+			if (!job.readbacks[target])
+				continue;
+			if (!s_CacheWriter)
+				s_CacheWriter = std::make_unique<ThreadPool>(1);
+			s_CacheWriter->enqueue([readback = job.readbacks[target], path = std::filesystem::path(job.cachePaths[target])]() {
+				saveToIBLCache(path, [&readback](const std::string& tempPath) { return TextureCubeMap::SaveReadback(*readback, tempPath); });
+			});
+			job.readbacks[target] = nullptr;
+		}
+
+		for (auto mipView : job.mipViews)
+			vkDestroyImageView(device->device(), mipView, nullptr);
+		job.mipViews.clear();
+		vkDestroyDescriptorPool(device->device(), job.descriptorPool, nullptr);
+		vkFreeCommandBuffers(device->device(), device->getComputeCommandPool(), 1, &job.commandBuffer);
+		vkDestroyFence(device->device(), job.fence, nullptr);
+		job.active = false;
+
+		// the textures being replaced may still be referenced by frames in flight
+		auto& textures = s_SceneInfo.textures;
+		for (auto* texture : { &textures.environmentCube, &textures.irradianceCube, &textures.prefilteredCube }) {
+			if (texture->m_Image != VK_NULL_HANDLE)
+				DeletionQueue::Push([retired = *texture]() mutable { retired.Destroy(); });
+		}
+		textures.environmentCube = job.environment;
+		textures.irradianceCube = job.cubemaps[0];
+		textures.prefilteredCube = job.cubemaps[1];
+		s_SceneInfo.shaderValuesParams.prefilteredCubeMipLevels = static_cast<float>(textures.prefilteredCube.m_MipLevels);
+
+		// descriptor sets only exist once Init has set them up
+		if (!skyboxDescriptorSets.empty()) {
+			// the environment maps live in the shared object sets, material sets are unaffected
+			FreeDescriptorSets();
+			SetupDescriptorSets();
+		}
+
+		auto tEnd = std::chrono::high_resolution_clock::now();
+		auto tDiff = std::chrono::duration<double, std::milli>(tEnd - job.startTime).count();
+		LOG_INFO("[Renderer] Prefiltering environment cube maps on the {} queue took {} ms, {} ms on the GPU",
+			device->hasAsyncCompute() ? "compute" : "graphics", tDiff, GpuProfiler::GetEnvironmentTime());
 	}
 
 
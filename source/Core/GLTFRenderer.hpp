@@ -2,6 +2,10 @@
 #include "Core/Nyxis.hpp"
 #include "Core/Nyxispch.hpp"
 #include "Graphics/GLTFModel.hpp"
+#include "Core/UniformArena.hpp"
+#include "Utils/ThreadPool.hpp"
+
+#include <cstring>
 
 constexpr auto DEPTH_ARRAY_SCALE = 2048; // will be used fir object picking buffer;
 
@@ -31,6 +35,36 @@ namespace Nyxis
         Ref<Pipeline> pbrAlphaBlend;
     };
 
+    struct LodSettings {
+        bool enabled = true;
+        float pixelError = 1.0f; // largest acceptable screen space simplification error
+        float hysteresis = 0.25f;
+    };
+
+    struct MeshletSettings {
+        bool enabled = true;
+        bool coneCulling = true;
+    };
+
+    struct SkinningSettings {
+        // skin vertices once per frame in a compute pass instead of in every vertex shader invocation
+        bool computePreSkin = false;
+    };
+
+    struct UploadStatistics {
+        // bytes written into per-frame buffers by the last Render
+        VkDeviceSize bytes = 0;
+        uint32_t modelsUpdated = 0;
+        uint32_t modelsSkipped = 0;
+    };
+
+    struct DrawStatistics {
+        // scene primitives recorded by the last Render, the skybox is not counted
+        uint32_t drawCalls = 0;
+        // meshlet culled models count what survived culling in their frame slot's previous frame
+        uint64_t triangles = 0;
+    };
+
     struct LightSource {
         glm::vec3 color = glm::vec3(1.0f, 0.2f, 0.5f);
         glm::vec3 rotation = glm::vec3(75.0f, 40.0f, 0.0f);
@@ -51,6 +85,13 @@ namespace Nyxis
 
 		static void OnUpdate();
 		static void Render();
+		static void CullMeshlets();
+		// queue family ownership transfers of the environment job, outside of a render pass
+		static void RecordEnvironmentTransfer();
+		// records the id image readbacks of clicks and marquee selections, called after the main render pass ended
+		static void RecordPicking();
+		// uploads the joint palettes of this frame and runs the compute pre-skinning pass, outside of the render pass
+		static void UpdateSkinning();
 		static void UpdateAnimation(float dt);
 		static void UpdatePipeline(PipelineType type);
 		static void LoadEnvironment(std::string& filename);
@@ -61,41 +102,189 @@ namespace Nyxis
 		static inline std::string s_EnvMapFile = "";
 		static inline bool s_SceneUpdated = false;
 		static inline bool s_Animate = false;
+		// load the BRDF LUT and environment cubes from the on-disk cache instead of regenerating them
+		static inline bool s_CacheIBL = true;
+		// draw with PBR pipelines specialized for the feature set of each material
+		static inline bool s_ShaderVariants = true;
 
 		static inline std::vector<Ref<Buffer>> s_SkyboxBuffers{};
 		static inline std::vector<Ref<Buffer>> s_UniformBuffersParams{};
 		static inline std::vector<Ref<Buffer>> s_ObjectPickingBuffer{};
+		// joint matrices of all skinned models, grown on demand
+		static inline std::vector<Ref<Buffer>> s_JointBuffers{};
 
         static inline LightSource lightSource{};
+        static inline LodSettings s_LodSettings{};
+        static inline MeshletSettings s_MeshletSettings{};
+        static inline SkinningSettings s_SkinningSettings{};
+        static inline UploadStatistics s_UploadStatistics{};
+        static inline DrawStatistics s_DrawStatistics{};
 		static inline ObjectPicking objectPicking{};
         static inline Pipelines Pipes{};
 
 	private:
 		static void PrepareUniformBuffers();
 		static void UpdateBuffers();
+		// flags the models whose uniforms changed since the last frame
+		static void CollectChangedModels();
 		static void LoadAssets();
 		static void GenerateBRDFLUT();
+		static void PrepareIBLPipelines();
 		static void GenerateCubemaps();
+		// swaps in the prefiltered environment once the compute work completed, returns true if it did
+		static void SubmitEnvironment();
+		static bool FinishEnvironment(bool wait);
+		// uploads the environment file once its read completed and starts prefiltering it, returns true if it did
+		static bool UploadEnvironment(bool wait);
+		static void CompleteEnvironment();
 		static void PreparePipelines(VkRenderPass renderPass);
+		static void PrepareMeshletPipeline();
+		static void PrepareSkinningPipeline();
+		static void WriteJointBufferDescriptor(uint32_t frameIndex);
+		static void WriteObjectDescriptorSets(uint32_t frameIndex);
 		static void SetupDescriptorPool();
 		static void SetupDescriptorSets();
 		static void FreeDescriptorSets();
+		static void SelectLods(Model& model, const glm::mat4& modelMatrix);
+		static void RequestTextureMips(Model& model, const glm::mat4& modelMatrix);
 		static void RenderNode(Node* node, Material::AlphaMode alphaMode, Model& model);
+		static uint32_t GetMaterialFeatures(const PushConstBlockMaterial& material);
+		static void ConfigurePBRVariant(Pipeline& variant, uint32_t features);
+		static Pipeline* GetPBRVariant(uint32_t features);
 
 		static inline Device* device{};
 
 		enum PBRWorkflows { PBR_WORKFLOW_METALLIC_ROUGHNESS = 0, PBR_WORKFLOW_SPECULAR_GLOSINESS = 1 };
 
-		static inline struct Pipelines2
+		// material feature set the PBR variants are specialized for, mirrored in pbr.frag
+		enum MaterialFeature : uint32_t
+		{
+			MATERIAL_FEATURE_BASE_COLOR_MAP = 1 << 0,
+			MATERIAL_FEATURE_PHYSICAL_DESCRIPTOR_MAP = 1 << 1,
+			MATERIAL_FEATURE_NORMAL_MAP = 1 << 2,
+			MATERIAL_FEATURE_OCCLUSION_MAP = 1 << 3,
+			MATERIAL_FEATURE_EMISSIVE_MAP = 1 << 4,
+			MATERIAL_FEATURE_SPECULAR_GLOSSINESS = 1 << 5,
+			MATERIAL_FEATURE_ALPHA_MASK = 1 << 6
+		};
+
+		// last contents written to a set of per-frame buffers, each frame in flight catches up once after a change
+		template<typename T>
+		struct TrackedUpload
+		{
+			T contents{};
+			uint32_t outdatedFrames = ~0u;
+
+			// returns true if the buffer of this frame has to be written
+			bool Update(const T& value, uint32_t frameIndex)
+			{
+				if (std::memcmp(&contents, &value, sizeof(T)) != 0)
+				{
+					contents = value;
+					outdatedFrames = ~0u;
+				}
+				const uint32_t frameBit = 1u << frameIndex;
+				if ((outdatedFrames & frameBit) == 0)
+					return false;
+				outdatedFrames &= ~frameBit;
+				return true;
+			}
+		};
+
+		// the part of the model uniforms shared by every model, a change outdates all of them
+		struct SceneUniforms
 		{
-			VkPipeline pbr;
-			VkPipeline pbrDoubleSided;
-			VkPipeline pbrAlphaBlend;
-		} pipelines;
+			glm::mat4 projection;
+			glm::mat4 view;
+			glm::vec3 camPos;
+			uint32_t selectedEntityID;
+			uint32_t isMouseClicked;
+		};
+
+		static inline TrackedUpload<ShaderValuesParams> s_ParamsUpload{};
+		static inline TrackedUpload<UBOMatrix> s_SkyboxUpload{};
+		static inline TrackedUpload<uint32_t> s_SelectionUpload{};
+		static inline SceneUniforms s_SceneUniforms{};
+
+		// a click reads back the id image texels within this radius of the cursor
+		static constexpr int32_t PICKING_RADIUS = 2;
+		static constexpr uint32_t PICKING_REGION = 2 * PICKING_RADIUS + 1;
+
+		// readback slot, resolved once the fence of the frame that recorded the copy is signaled
+		struct PickingReadback
+		{
+			Scope<Buffer> buffer;
+			VkFence fence = VK_NULL_HANDLE;
+			uint32_t swapChainVersion = 0;
+			bool pending = false;
+			VkExtent2D extent{};
+			// cursor position within the copied region
+			uint32_t cursorX = 0;
+			uint32_t cursorY = 0;
+		};
+
+		static void ResolvePicking(PickingReadback& readback);
+		static void PollPicking();
+
+		static inline std::vector<PickingReadback> s_PickingReadbacks{};
+		static inline uint32_t s_PickingSlot = 0;
+
+		// PBR pipelines keyed by material features, compiled in the background on first use
+		static inline std::unordered_map<uint32_t, Ref<Pipeline>> s_PBRVariants{};
 
 		static inline VkPipeline boundPipeline = VK_NULL_HANDLE;
+		// models whose meshlets were culled this frame
+		static inline std::vector<Model*> s_CulledModels{};
+		// ready models of the current frame, drawn once per alpha mode
+		static inline std::vector<Model*> s_RenderedModels{};
 		static inline VkPipelineLayout pipelineLayout;
-		static inline VkPipelineCache pipelineCache = VK_NULL_HANDLE;
+
+		static inline VkPipeline meshletPipeline = VK_NULL_HANDLE;
+		static inline VkPipelineLayout meshletPipelineLayout = VK_NULL_HANDLE;
+
+		static inline VkPipeline skinningPipeline = VK_NULL_HANDLE;
+		static inline VkPipelineLayout skinningPipelineLayout = VK_NULL_HANDLE;
+		// bumped whenever a joint buffer is reallocated so models rewrite their pre-skinning sets
+		static inline std::vector<uint32_t> s_JointBufferVersions{};
+
+		static inline VkPipeline irradiancePipeline = VK_NULL_HANDLE;
+		static inline VkPipeline prefilterPipeline = VK_NULL_HANDLE;
+		static inline VkPipelineLayout iblPipelineLayout = VK_NULL_HANDLE;
+		static inline VkDescriptorSetLayout iblDescriptorSetLayout = VK_NULL_HANDLE;
+
+		// environment whose IBL cubes are being prefiltered, on the async compute queue if the device has one
+		struct EnvironmentJob
+		{
+			// on a separate compute family a frame releases the environment before the job is submitted
+			enum class Stage { Release, Released, Compute };
+
+			bool active = false;
+			Stage stage = Stage::Release;
+			// frames begun since the release was recorded, it completed once all frames in flight came around
+			uint32_t releasedFrames = 0;
+			VkFence fence = VK_NULL_HANDLE;
+			VkCommandBuffer commandBuffer = VK_NULL_HANDLE;
+			VkDescriptorPool descriptorPool = VK_NULL_HANDLE;
+			std::vector<VkImageView> mipViews{};
+			TextureCubeMap environment{};
+			std::array<TextureCubeMap, 2> cubemaps{};
+			std::array<bool, 2> generated{};
+			std::array<std::string, 2> cachePaths{};
+			// generated cubes copied out by the job when they are cached
+			std::array<Ref<TextureReadback>, 2> readbacks{};
+			std::chrono::high_resolution_clock::time_point startTime{};
+		};
+		static inline EnvironmentJob s_EnvironmentJob{};
+
+		// environment file read and hashed on a worker, uploaded by the main thread once it is ready
+		struct EnvironmentFile
+		{
+			std::string filename;
+			std::future<void> reading;
+			Ref<gli::texture_cube> texture;
+			uint64_t hash = 0;
+		};
+		static inline Ref<EnvironmentFile> s_EnvironmentFile = nullptr;
 
 		static inline VkDescriptorPool descriptorPool;
 
@@ -103,8 +292,15 @@ namespace Nyxis
 
 		static inline std::vector<VkDescriptorSet> skyboxDescriptorSets;
 		static inline std::vector<VkDescriptorSet> depthBufferDescriptorSets;
+		// shared by all models, the UniformArena slot is selected through dynamic offsets
+		static inline std::vector<VkDescriptorSet> objectDescriptorSets;
+		static inline std::vector<VkDescriptorSet> nodeDescriptorSets;
 
 		static inline Ref<Model> skybox = nullptr;
-		static inline std::thread animationThread{};
+		static inline uint64_t s_EnvMapHash = 0;
+		// evaluates the animated models in parallel and reads environment files
+		static inline Scope<ThreadPool> s_AnimationJobs = nullptr;
+		// writes the IBL cache files, a single thread keeps writes of the same entry in order
+		static inline Scope<ThreadPool> s_CacheWriter = nullptr;
 	};
 }
@@ -0,0 +1,212 @@
+#include "Core/GpuProfiler.hpp"
+
+namespace Nyxis
+{
+    void GpuProfiler::Init(Device* device)
+    {
+        s_Device = device;
+        // the world and IBL passes run on graphics and compute queues, which then all support timestamps
+        if (!device->properties.limits.timestampComputeAndGraphics)
+        {
+            LOG_WARN("[Renderer] Timestamp queries not supported, GPU profiling unavailable");
+            return;
+        }
+        s_PipelineStatisticsSupported = device->hasPipelineStatistics();
+
+        VkQueryPoolCreateInfo timestampInfo{};
+        timestampInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+        timestampInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+        timestampInfo.queryCount = 2 * PASS_COUNT;
+
+        VkQueryPoolCreateInfo statisticsInfo{};
+        statisticsInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+        statisticsInfo.queryType = VK_QUERY_TYPE_PIPELINE_STATISTICS;
+        statisticsInfo.queryCount = PASS_COUNT;
+        statisticsInfo.pipelineStatistics = VK_QUERY_PIPELINE_STATISTIC_VERTEX_SHADER_INVOCATIONS_BIT |
+            VK_QUERY_PIPELINE_STATISTIC_FRAGMENT_SHADER_INVOCATIONS_BIT;
+
+        s_Slots.resize(SwapChain::MAX_FRAMES_IN_FLIGHT);
+        for (auto& slot : s_Slots)
+        {
+            if (vkCreateQueryPool(device->device(), &timestampInfo, nullptr, &slot.timestamps) != VK_SUCCESS)
+                throw std::runtime_error("failed to create timestamp query pool!");
+            if (s_PipelineStatisticsSupported && vkCreateQueryPool(device->device(), &statisticsInfo, nullptr, &slot.statistics) != VK_SUCCESS)
+                throw std::runtime_error("failed to create pipeline statistics query pool!");
+        }
+
+        timestampInfo.queryCount = 2;
+        if (vkCreateQueryPool(device->device(), &timestampInfo, nullptr, &s_EnvironmentPool) != VK_SUCCESS)
+            throw std::runtime_error("failed to create timestamp query pool!");
+    }
+
+    void GpuProfiler::Shutdown()
+    {
+        for (auto& slot : s_Slots)
+        {
+            vkDestroyQueryPool(s_Device->device(), slot.timestamps, nullptr);
+            if (slot.statistics != VK_NULL_HANDLE)
+                vkDestroyQueryPool(s_Device->device(), slot.statistics, nullptr);
+        }
+        s_Slots.clear();
+        s_Current = nullptr;
+        if (s_EnvironmentPool != VK_NULL_HANDLE)
+            vkDestroyQueryPool(s_Device->device(), s_EnvironmentPool, nullptr);
+        s_EnvironmentPool = VK_NULL_HANDLE;
+        s_EnvironmentWritten = false;
+    }
+
+    void GpuProfiler::BeginFrame(VkCommandBuffer commandBuffer, uint32_t slot)
+    {
+        s_Current = nullptr;
+        s_Frame++;
+        if (slot >= s_Slots.size())
+            return;
+
+        auto& current = s_Slots[slot];
+        Collect(current);
+        current.timestampsWritten = 0;
+        current.statisticsWritten = 0;
+        current.frame = s_Frame;
+        if (!s_Settings.enabled)
+            return;
+
+        current.pipelineStatistics = s_Settings.pipelineStatistics && current.statistics != VK_NULL_HANDLE;
+        vkCmdResetQueryPool(commandBuffer, current.timestamps, 0, 2 * PASS_COUNT);
+        if (current.pipelineStatistics)
+            vkCmdResetQueryPool(commandBuffer, current.statistics, 0, PASS_COUNT);
+        s_Current = &current;
+    }
+
+    void GpuProfiler::BeginPass(VkCommandBuffer commandBuffer, GpuPass pass)
+    {
+        if (!s_Current)
+            return;
+        const auto index = static_cast<uint32_t>(pass);
+        vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, s_Current->timestamps, 2 * index);
+        if (s_Current->pipelineStatistics && pass != GpuPass::World)
+            vkCmdBeginQuery(commandBuffer, s_Current->statistics, index, 0);
+    }
+
+    void GpuProfiler::EndPass(VkCommandBuffer commandBuffer, GpuPass pass)
+    {
+        if (!s_Current)
+            return;
+        const auto index = static_cast<uint32_t>(pass);
+        if (s_Current->pipelineStatistics && pass != GpuPass::World)
+        {
+            vkCmdEndQuery(commandBuffer, s_Current->statistics, index);
+            s_Current->statisticsWritten |= 1u << index;
+        }
+        vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, s_Current->timestamps, 2 * index + 1);
+        s_Current->timestampsWritten |= 1u << index;
+    }
+
+    void GpuProfiler::Collect(Slot& slot)
+    {
+        if (slot.timestampsWritten == 0)
+            return;
+
+        // value and availability per query, VK_NOT_READY only means some of them are not
+        std::array<uint64_t, 4 * PASS_COUNT> timestamps{};
+        const auto timestampResult = vkGetQueryPoolResults(s_Device->device(), slot.timestamps, 0, 2 * PASS_COUNT, sizeof(timestamps),
+            timestamps.data(), 2 * sizeof(uint64_t), VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WITH_AVAILABILITY_BIT);
+        if (timestampResult != VK_SUCCESS && timestampResult != VK_NOT_READY)
+            return;
+
+        // vertex and fragment invocations in bit order, then the availability
+        std::array<uint64_t, 3 * PASS_COUNT> statistics{};
+        bool statisticsRead = false;
+        if (slot.statisticsWritten != 0)
+        {
+            const auto statisticsResult = vkGetQueryPoolResults(s_Device->device(), slot.statistics, 0, PASS_COUNT, sizeof(statistics),
+                statistics.data(), 3 * sizeof(uint64_t), VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WITH_AVAILABILITY_BIT);
+            statisticsRead = statisticsResult == VK_SUCCESS || statisticsResult == VK_NOT_READY;
+        }
+
+        for (uint32_t pass = 0; pass < PASS_COUNT; pass++)
+        {
+            auto& result = s_Results[pass];
+            const uint64_t* begin = &timestamps[4 * pass];
+            if (!(slot.timestampsWritten & (1u << pass)))
+                result = {};
+            else if (begin[1] != 0 && begin[3] != 0)
+                result.ms = ToMilliseconds(begin[0], begin[2]);
+
+            if (!statisticsRead || !(slot.statisticsWritten & (1u << pass)))
+            {
+                result.vertexInvocations = 0;
+                result.fragmentInvocations = 0;
+            }
+            else if (statistics[3 * pass + 2] != 0)
+            {
+                result.vertexInvocations = statistics[3 * pass];
+                result.fragmentInvocations = statistics[3 * pass + 1];
+            }
+            s_History[pass][s_HistoryOffset] = result.ms;
+        }
+        s_HistoryOffset = (s_HistoryOffset + 1) % HISTORY_SIZE;
+
+        s_ResultFrame = slot.frame;
+        if (s_ResultCallback)
+            s_ResultCallback(slot.frame, s_Results);
+    }
+
+    void GpuProfiler::Flush()
+    {
+        s_Current = nullptr;
+        std::vector<Slot*> outstanding;
+        for (auto& slot : s_Slots)
+        {
+            if (slot.timestampsWritten != 0)
+                outstanding.push_back(&slot);
+        }
+        std::sort(outstanding.begin(), outstanding.end(), [](const Slot* a, const Slot* b) { return a->frame < b->frame; });
+        for (auto* slot : outstanding)
+        {
+            Collect(*slot);
+            slot->timestampsWritten = 0;
+            slot->statisticsWritten = 0;
+        }
+    }
+
+    void GpuProfiler::BeginEnvironment(VkCommandBuffer commandBuffer)
+    {
+        s_EnvironmentWritten = false;
+        if (s_EnvironmentPool == VK_NULL_HANDLE || !s_Settings.enabled)
+            return;
+        vkCmdResetQueryPool(commandBuffer, s_EnvironmentPool, 0, 2);
+        vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, s_EnvironmentPool, 0);
+    }
+
+    void GpuProfiler::EndEnvironment(VkCommandBuffer commandBuffer)
+    {
+        if (s_EnvironmentPool == VK_NULL_HANDLE || !s_Settings.enabled)
+            return;
+        vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, s_EnvironmentPool, 1);
+        s_EnvironmentWritten = true;
+    }
+
+    void GpuProfiler::CollectEnvironment()
+    {
+        if (!s_EnvironmentWritten)
+            return;
+        s_EnvironmentWritten = false;
+
+        std::array<uint64_t, 4> results{};
+        const auto result = vkGetQueryPoolResults(s_Device->device(), s_EnvironmentPool, 0, 2, sizeof(results), results.data(),
+            2 * sizeof(uint64_t), VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WITH_AVAILABILITY_BIT);
+        if (result == VK_SUCCESS && results[1] != 0 && results[3] != 0)
+            s_EnvironmentMs = ToMilliseconds(results[0], results[2]);
+    }
+
+    const char* GpuProfiler::GetPassName(GpuPass pass)
+    {
+        static constexpr std::array<const char*, PASS_COUNT> names = { "World", "Skybox", "Opaque", "Mask", "Blend", "UI" };
+        return names[static_cast<uint32_t>(pass)];
+    }
+
+    float GpuProfiler::ToMilliseconds(uint64_t begin, uint64_t end)
+    {
+        return static_cast<float>(static_cast<double>(end - begin) * s_Device->properties.limits.timestampPeriod * 1e-6);
+    }
+} // namespace Nyxis
@@ -0,0 +1,114 @@
+#pragma once
+#include "Core/Nyxispch.hpp"
+#include "Core/Device.hpp"
+#include "Core/SwapChain.hpp"
+
+namespace Nyxis
+{
+    // GPU scopes of a frame. World spans the whole world command buffer, the others are render passes or parts of them
+    enum class GpuPass : uint32_t
+    {
+        World,
+        Skybox,
+        Opaque,
+        Mask,
+        Blend,
+        UI,
+        Count
+    };
+
+    /**
+     * \brief Per pass GPU timings from timestamp queries
+     *
+     * Every frame slot owns a timestamp pool and, when the device supports it, a pipeline statistics pool.
+     * A slot's results are read when the slot is recorded again, its previous submission has completed by
+     * then, so nothing waits on the GPU. The IBL prefiltering runs outside the frame and is measured once per job.
+     */
+    class GpuProfiler
+    {
+    public:
+        static constexpr uint32_t PASS_COUNT = static_cast<uint32_t>(GpuPass::Count);
+        static constexpr uint32_t HISTORY_SIZE = 240;
+
+        struct Settings
+        {
+            bool enabled = true;
+            // vertex and fragment shader invocations per pass, not for World since statistics queries can't nest
+            bool pipelineStatistics = false;
+        };
+
+        struct PassResult
+        {
+            float ms = 0.0f;
+            uint64_t vertexInvocations = 0;
+            uint64_t fragmentInvocations = 0;
+        };
+        using FrameResults = std::array<PassResult, PASS_COUNT>;
+        // called whenever the results of a frame were collected, with the frame counter it was recorded with
+        using ResultCallback = std::function<void(uint64_t frame, const FrameResults& results)>;
+
+        static void Init(Device* device);
+        static void Shutdown();
+
+        // outside of a render pass at the start of the slot's first command buffer: collects and resets the slot
+        static void BeginFrame(VkCommandBuffer commandBuffer, uint32_t slot);
+        static void BeginPass(VkCommandBuffer commandBuffer, GpuPass pass);
+        static void EndPass(VkCommandBuffer commandBuffer, GpuPass pass);
+        // collects the slots whose frames were not followed by another frame in their slot, oldest first.
+        // Only valid once the device completed them, e.g. after Renderer::FlushFrames or vkDeviceWaitIdle
+        static void Flush();
+        static void SetResultCallback(ResultCallback callback) { s_ResultCallback = std::move(callback); }
+
+        // bracket the IBL prefiltering job, collected once its fence signaled
+        static void BeginEnvironment(VkCommandBuffer commandBuffer);
+        static void EndEnvironment(VkCommandBuffer commandBuffer);
+        static void CollectEnvironment();
+
+        [[nodiscard]] static bool IsSupported() { return !s_Slots.empty(); }
+        [[nodiscard]] static bool HasPipelineStatistics() { return s_PipelineStatisticsSupported; }
+        [[nodiscard]] static const char* GetPassName(GpuPass pass);
+        [[nodiscard]] static const PassResult& GetResult(GpuPass pass) { return s_Results[static_cast<uint32_t>(pass)]; }
+        // frame counter of the frame being recorded and of the frame GetResult belongs to, results lag behind
+        // by up to the frames in flight
+        [[nodiscard]] static uint64_t GetFrame() { return s_Frame; }
+        [[nodiscard]] static uint64_t GetResultFrame() { return s_ResultFrame; }
+        // ring buffer of frame times in ms, GetHistoryOffset is the oldest entry
+        [[nodiscard]] static const std::array<float, HISTORY_SIZE>& GetHistory(GpuPass pass) { return s_History[static_cast<uint32_t>(pass)]; }
+        [[nodiscard]] static uint32_t GetHistoryOffset() { return s_HistoryOffset; }
+        // GPU time of the last IBL prefiltering job
+        [[nodiscard]] static float GetEnvironmentTime() { return s_EnvironmentMs; }
+
+        static inline Settings s_Settings{};
+
+    private:
+        struct Slot
+        {
+            VkQueryPool timestamps = VK_NULL_HANDLE;
+            VkQueryPool statistics = VK_NULL_HANDLE;
+            // passes recorded in the slot's last frame
+            uint32_t timestampsWritten = 0;
+            uint32_t statisticsWritten = 0;
+            bool pipelineStatistics = false;
+            // frame counter of the slot's last frame
+            uint64_t frame = 0;
+        };
+        static void Collect(Slot& slot);
+        static float ToMilliseconds(uint64_t begin, uint64_t end);
+
+        static inline Device* s_Device = nullptr;
+        static inline std::vector<Slot> s_Slots{};
+        static inline Slot* s_Current = nullptr;
+        static inline bool s_PipelineStatisticsSupported = false;
+
+        static inline FrameResults s_Results{};
+        static inline uint64_t s_Frame = 0;
+        static inline uint64_t s_ResultFrame = 0;
+        static inline ResultCallback s_ResultCallback{};
+        static inline std::array<std::array<float, HISTORY_SIZE>, PASS_COUNT> s_History{};
+        static inline uint32_t s_HistoryOffset = 0;
+
+        static inline VkQueryPool s_EnvironmentPool = VK_NULL_HANDLE;
+        static inline bool s_EnvironmentWritten = false;
+        static inline float s_EnvironmentMs = 0.0f;
+    };
+} // namespace Nyxis
@@ -6,35 +6,44 @@ namespace Nyxis
 {
     Input* Input::pInstance = new Input();
 
+	// without a window (headless mode) nothing is ever pressed
 	bool Input::IsKeyPressedImpl(int key)
 	{
+		if (!Window::GetGLFWwindow())
+			return false;
 		auto state = glfwGetKey(Window::GetGLFWwindow(), key);
 		return state == GLFW_PRESS || state == GLFW_REPEAT;
 	}
 	
 	bool Input::IsMouseButtonPressedImpl(int button)
 	{
+		if (!Window::GetGLFWwindow())
+			return false;
 		auto state = glfwGetMouseButton(Window::GetGLFWwindow(), button);
 		return state == GLFW_PRESS;
 	}
 
 	bool Input::IsMouseButtonReleasedImpl(int button)
 	{
+		if (!Window::GetGLFWwindow())
+			return true;
 		return glfwGetMouseButton(Window::GetGLFWwindow(), button) == GLFW_RELEASE;
 	}
 
 	
 	glm::vec2 Input::GetMousePositionImpl()
 	{
-		double xpos, ypos;
-		glfwGetCursorPos(Window::GetGLFWwindow(), &xpos, &ypos);
+		double xpos = 0.0, ypos = 0.0;
+		if (Window::GetGLFWwindow())
+			glfwGetCursorPos(Window::GetGLFWwindow(), &xpos, &ypos);
 		return { xpos, ypos };
 	}
 
 	void Input::SetCursorModeImpl(int mode)
 	{
 		m_CursorMode = static_cast<CursorMode>(mode);
-		glfwSetInputMode(Window::GetGLFWwindow(), GLFW_CURSOR, GLFW_CURSOR_NORMAL + mode);
+		if (Window::GetGLFWwindow())
+			glfwSetInputMode(Window::GetGLFWwindow(), GLFW_CURSOR, GLFW_CURSOR_NORMAL + mode);
 	}
 
 	// float Input::getMouseXImpl()
@@ -8,6 +8,7 @@
 #include <memory>
 #include <utility>
 #include <algorithm>
+#include <numeric>
 #include <execution>
 #include <functional>
 #include <chrono>
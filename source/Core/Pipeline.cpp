@@ -1,6 +1,9 @@
 #include "Core/Pipeline.hpp"
+#include "Core/DeletionQueue.hpp"
 #include "Core/Device.hpp"
+#include "Core/ShaderModuleCache.hpp"
 #include "Graphics/OBJModel.hpp"
+#include "Utils/Utils.hpp"
 
 namespace Nyxis
 {
@@ -13,9 +16,16 @@ namespace Nyxis
 
     Pipeline::~Pipeline()
     {
-        vkDestroyShaderModule(device.device(), vertShaderModule, nullptr);
-        vkDestroyShaderModule(device.device(), fragShaderModule, nullptr);
-        vkDestroyPipeline(device.device(), graphicsPipeline, nullptr);
+        DiscardPendingBuild();
+        for (uint64_t key : libraryKeys)
+        {
+            if (key != 0)
+                ReleaseShared(key);
+        }
+
+        ShaderModuleCache::Release(vertShaderModule);
+        ShaderModuleCache::Release(fragShaderModule);
+        Release({graphicsPipeline, graphicsPipelineKey});
     }
 
 	std::vector<char> Pipeline::ReadFile(const std::string &filename)
@@ -34,91 +44,431 @@ namespace Nyxis
         return buffer;
     }
 
+    static VkPipelineShaderStageCreateInfo shaderStageInfo(VkShaderStageFlagBits stage, VkShaderModule module,
+                                                           const VkSpecializationInfo *specializationInfo)
+    {
+        VkPipelineShaderStageCreateInfo shaderStage{};
+        shaderStage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+        shaderStage.stage = stage;
+        shaderStage.module = module;
+        shaderStage.pName = "main";
+        shaderStage.pSpecializationInfo = specializationInfo->mapEntryCount > 0 ? specializationInfo : nullptr;
+        return shaderStage;
+    }
+
+    static VkPipelineVertexInputStateCreateInfo vertexInputInfo(const PipelineConfigInfo &config)
+    {
+        VkPipelineVertexInputStateCreateInfo vertexInputInfo{};
+        vertexInputInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
+        vertexInputInfo.vertexBindingDescriptionCount = static_cast<uint32_t>(config.bindingDescriptions.size());
+        vertexInputInfo.vertexAttributeDescriptionCount = static_cast<uint32_t>(config.attributeDescriptions.size());
+        vertexInputInfo.pVertexBindingDescriptions = config.bindingDescriptions.data();
+        vertexInputInfo.pVertexAttributeDescriptions = config.attributeDescriptions.data();
+        return vertexInputInfo;
+    }
+
+    // hashes a create info from its flags up to and including its last member, skipping sType, pNext and
+    // the padding around them; the tail padding after the last member is indeterminate
+    template <typename T, typename Last>
+    static uint64_t hashCreateInfo(const T &info, const Last &last, uint64_t seed)
+    {
+        const auto *begin = reinterpret_cast<const uint8_t *>(&info.flags);
+        const auto *end = reinterpret_cast<const uint8_t *>(&last) + sizeof(Last);
+        return hashBytes(begin, static_cast<size_t>(end - begin), seed);
+    }
+
+    template <typename T>
+    static uint64_t hashVector(const std::vector<T> &values, uint64_t seed)
+    {
+        return hashBytes(values.data(), values.size() * sizeof(T), seed);
+    }
+
     void Pipeline::Create()
     {
         assert(pipelineConfigInfo.pipelineLayout != VK_NULL_HANDLE && "Cannot create graphics pipeline: no pipelineLayout provided in config");
         assert(pipelineConfigInfo.renderPass != VK_NULL_HANDLE && "Cannot create graphics pipeline: no renderPass provided in config");
 
-        auto vertCode = ReadFile(vertPath);
-        auto fragCode = ReadFile(fragPath);
-
-        CreateShaderModule(vertCode, &vertShaderModule);
-        CreateShaderModule(fragCode, &fragShaderModule);
-
-        VkPipelineShaderStageCreateInfo shaderStages[2];
-        shaderStages[0].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
-        shaderStages[0].stage = VK_SHADER_STAGE_VERTEX_BIT;
-        shaderStages[0].module = vertShaderModule;
-        shaderStages[0].pName = "main";
-        shaderStages[0].flags = 0;
-        shaderStages[0].pNext = nullptr;
-        shaderStages[0].pSpecializationInfo = nullptr;
-        shaderStages[1].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
-        shaderStages[1].stage = VK_SHADER_STAGE_FRAGMENT_BIT;
-        shaderStages[1].module = fragShaderModule;
-        shaderStages[1].pName = "main";
-        shaderStages[1].flags = 0;
-        shaderStages[1].pNext = nullptr;
-        shaderStages[1].pSpecializationInfo = nullptr;
-
-        auto &bindingDescriptions = pipelineConfigInfo.bindingDescriptions;
-        auto &attributeDescriptions = pipelineConfigInfo.attributeDescriptions;
+        LoadShaderModules();
+        const auto result = Build(pipelineConfigInfo, LinkMode::Monolithic);
+        graphicsPipeline = result.pipeline;
+        graphicsPipelineKey = result.key;
+    }
 
-        VkPipelineVertexInputStateCreateInfo vertexInputInfo{};
-        vertexInputInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
-        vertexInputInfo.vertexBindingDescriptionCount = static_cast<uint32_t>(bindingDescriptions.size());
-        vertexInputInfo.vertexAttributeDescriptionCount = static_cast<uint32_t>(attributeDescriptions.size());
-        vertexInputInfo.pVertexBindingDescriptions = bindingDescriptions.data();
-        vertexInputInfo.pVertexAttributeDescriptions = attributeDescriptions.data();
-        
+    void Pipeline::LoadShaderModules()
+    {
+        // modules are only replaced when their code changed so unchanged stages keep hitting the library cache
+        auto load = [](const std::string &path, VkShaderModule &module, uint64_t &codeHash) {
+            const auto loaded = ShaderModuleCache::Acquire(path);
+            if (module != VK_NULL_HANDLE && loaded.codeHash == codeHash)
+            {
+                ShaderModuleCache::Release(loaded.module);
+                return;
+            }
+            ShaderModuleCache::Release(module);
+            module = loaded.module;
+            codeHash = loaded.codeHash;
+        };
+        load(vertPath, vertShaderModule, vertCodeHash);
+        load(fragPath, fragShaderModule, fragCodeHash);
+    }
+
+    Pipeline::BuildResult Pipeline::Build(const PipelineConfigInfo &config, LinkMode mode)
+    {
+        // identical pipelines are shared, whichever Pipeline built them first
+        const uint64_t key = HashConfig(config);
+        if (VkPipeline shared = FindShared(key, true))
+            return {shared, key};
+
+        // unoptimized links stay private, the optimized pipeline replacing them is shared
+        if (mode == LinkMode::FastLink)
+            return {BuildFromLibraries(config, false), 0};
+
+        VkPipeline pipeline = mode == LinkMode::Monolithic ? BuildMonolithic(config) : BuildFromLibraries(config, true);
+        return {AddShared(key, pipeline), key};
+    }
+
+    VkPipeline Pipeline::BuildMonolithic(const PipelineConfigInfo &config)
+    {
+        const auto vertSpecialization = config.vertexSpecialization.GetInfo();
+        const auto fragSpecialization = config.fragmentSpecialization.GetInfo();
+        VkPipelineShaderStageCreateInfo shaderStages[2] = {
+            shaderStageInfo(VK_SHADER_STAGE_VERTEX_BIT, vertShaderModule, &vertSpecialization),
+            shaderStageInfo(VK_SHADER_STAGE_FRAGMENT_BIT, fragShaderModule, &fragSpecialization)};
+
+        auto vertexInput = vertexInputInfo(config);
 
         VkGraphicsPipelineCreateInfo pipelineInfo{};
         pipelineInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
         pipelineInfo.stageCount = 2;
         pipelineInfo.pStages = shaderStages;
-        pipelineInfo.pVertexInputState = &vertexInputInfo;
-        pipelineInfo.pInputAssemblyState = &pipelineConfigInfo.inputAssemblyInfo;
-        pipelineInfo.pViewportState = &pipelineConfigInfo.viewportInfo;
-        pipelineInfo.pRasterizationState = &pipelineConfigInfo.rasterizationInfo;
-        pipelineInfo.pMultisampleState = &pipelineConfigInfo.multisamplingInfo;
-        pipelineInfo.pColorBlendState = &pipelineConfigInfo.colorBlendInfo;
-        pipelineInfo.pDepthStencilState = &pipelineConfigInfo.depthStencilInfo;
-        pipelineInfo.pDynamicState = &pipelineConfigInfo.dynamicStateInfo;
-
-        pipelineInfo.layout = pipelineConfigInfo.pipelineLayout;
-        pipelineInfo.renderPass = pipelineConfigInfo.renderPass;
-        pipelineInfo.subpass = pipelineConfigInfo.subpass;
+        pipelineInfo.pVertexInputState = &vertexInput;
+        pipelineInfo.pInputAssemblyState = &config.inputAssemblyInfo;
+        pipelineInfo.pViewportState = &config.viewportInfo;
+        pipelineInfo.pRasterizationState = &config.rasterizationInfo;
+        pipelineInfo.pMultisampleState = &config.multisamplingInfo;
+        pipelineInfo.pColorBlendState = &config.colorBlendInfo;
+        pipelineInfo.pDepthStencilState = &config.depthStencilInfo;
+        pipelineInfo.pDynamicState = &config.dynamicStateInfo;
+
+        pipelineInfo.layout = config.pipelineLayout;
+        pipelineInfo.renderPass = config.renderPass;
+        pipelineInfo.subpass = config.subpass;
 
         pipelineInfo.basePipelineIndex = -1;
         pipelineInfo.basePipelineHandle = VK_NULL_HANDLE;
 
-        if (vkCreateGraphicsPipelines(device.device(), VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &graphicsPipeline) != VK_SUCCESS)
+        VkPipeline pipeline;
+        if (vkCreateGraphicsPipelines(device.device(), device.pipelineCache(), 1, &pipelineInfo, nullptr, &pipeline) != VK_SUCCESS)
         {
             throw std::runtime_error("failed to create graphics pipeline");
         }
+        return pipeline;
+    }
+
+    VkPipeline Pipeline::BuildFromLibraries(const PipelineConfigInfo &config, bool optimized)
+    {
+        std::array<VkPipeline, LibraryPartCount> parts;
+        for (uint32_t part = 0; part < LibraryPartCount; part++)
+            parts[part] = GetLibrary(config, static_cast<LibraryPart>(part));
+
+        VkPipelineLibraryCreateInfoKHR libraryInfo{};
+        libraryInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LIBRARY_CREATE_INFO_KHR;
+        libraryInfo.libraryCount = static_cast<uint32_t>(parts.size());
+        libraryInfo.pLibraries = parts.data();
+
+        // without link time optimization linking is cheap, the optimized pipeline replaces it once built
+        VkGraphicsPipelineCreateInfo pipelineInfo{};
+        pipelineInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
+        pipelineInfo.pNext = &libraryInfo;
+        pipelineInfo.flags = optimized ? VK_PIPELINE_CREATE_LINK_TIME_OPTIMIZATION_BIT_EXT : 0;
+        pipelineInfo.layout = config.pipelineLayout;
+        pipelineInfo.basePipelineIndex = -1;
+
+        VkPipeline pipeline;
+        if (vkCreateGraphicsPipelines(device.device(), device.pipelineCache(), 1, &pipelineInfo, nullptr, &pipeline) != VK_SUCCESS)
+        {
+            throw std::runtime_error("failed to link graphics pipeline");
+        }
+        return pipeline;
+    }
+
+    uint64_t Pipeline::HashLibraryPart(const PipelineConfigInfo &config, LibraryPart part) const
+    {
+        uint64_t key = hashValue(part);
+        switch (part)
+        {
+        case VertexInput:
+            key = hashVector(config.bindingDescriptions, key);
+            key = hashVector(config.attributeDescriptions, key);
+            key = hashValue(config.inputAssemblyInfo.topology, key);
+            key = hashValue(config.inputAssemblyInfo.primitiveRestartEnable, key);
+            break;
+        case PreRasterization:
+            key = hashValue(vertCodeHash, key);
+            key = hashVector(config.vertexSpecialization.entries, key);
+            key = hashVector(config.vertexSpecialization.data, key);
+            key = hashCreateInfo(config.rasterizationInfo, config.rasterizationInfo.lineWidth, key);
+            key = hashValue(config.viewportInfo.viewportCount, key);
+            key = hashValue(config.viewportInfo.scissorCount, key);
+            key = hashVector(config.dynamicStateEnables, key);
+            break;
+        case FragmentShader:
+            key = hashValue(fragCodeHash, key);
+            key = hashVector(config.fragmentSpecialization.entries, key);
+            key = hashVector(config.fragmentSpecialization.data, key);
+            key = hashCreateInfo(config.depthStencilInfo, config.depthStencilInfo.maxDepthBounds, key);
+            key = hashValue(config.multisamplingInfo.sampleShadingEnable, key);
+            key = hashValue(config.multisamplingInfo.minSampleShading, key);
+            break;
+        case FragmentOutput:
+            key = hashVector(config.colorBlendAttachments, key);
+            key = hashValue(config.colorBlendInfo.logicOpEnable, key);
+            key = hashValue(config.colorBlendInfo.logicOp, key);
+            key = hashValue(config.colorBlendInfo.attachmentCount, key);
+            key = hashValue(config.colorBlendInfo.blendConstants, key);
+            key = hashValue(config.multisamplingInfo.alphaToCoverageEnable, key);
+            key = hashValue(config.multisamplingInfo.alphaToOneEnable, key);
+            break;
+        default:
+            break;
+        }
+        key = hashValue(config.multisamplingInfo.rasterizationSamples, key);
+        key = hashValue(config.pipelineLayout, key);
+        key = hashValue(config.renderPass, key);
+        key = hashValue(config.subpass, key);
+        return key;
+    }
+
+    uint64_t Pipeline::HashConfig(const PipelineConfigInfo &config) const
+    {
+        // complete pipelines are keyed by the keys of all their library parts
+        uint64_t key = hashValue(LibraryPartCount);
+        for (uint32_t part = 0; part < LibraryPartCount; part++)
+            key = hashValue(HashLibraryPart(config, static_cast<LibraryPart>(part)), key);
+        return key;
+    }
+
+    VkPipeline Pipeline::GetLibrary(const PipelineConfigInfo &config, LibraryPart part)
+    {
+        const uint64_t key = HashLibraryPart(config, part);
+        const uint64_t previous = libraryKeys[part];
+        VkPipeline library = FindShared(key, key != previous);
+        if (library == VK_NULL_HANDLE)
+            library = AddShared(key, CreateLibrary(config, part));
+
+        // the superseded part is released like a retired pipeline, once the frames in flight completed
+        if (key != previous)
+        {
+            libraryKeys[part] = key;
+            if (previous != 0)
+                DeletionQueue::Push([previous]() { ReleaseShared(previous); });
+        }
+        return library;
+    }
+
+    VkPipeline Pipeline::CreateLibrary(const PipelineConfigInfo &config, LibraryPart part)
+    {
+        VkGraphicsPipelineLibraryCreateInfoEXT libraryInfo{};
+        libraryInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_LIBRARY_CREATE_INFO_EXT;
+
+        VkGraphicsPipelineCreateInfo pipelineInfo{};
+        pipelineInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
+        pipelineInfo.pNext = &libraryInfo;
+        pipelineInfo.flags = VK_PIPELINE_CREATE_LIBRARY_BIT_KHR | VK_PIPELINE_CREATE_RETAIN_LINK_TIME_OPTIMIZATION_INFO_BIT_EXT;
+        pipelineInfo.basePipelineIndex = -1;
+
+        auto vertexInput = vertexInputInfo(config);
+        const auto vertSpecialization = config.vertexSpecialization.GetInfo();
+        const auto fragSpecialization = config.fragmentSpecialization.GetInfo();
+        VkPipelineShaderStageCreateInfo shaderStage{};
+
+        switch (part)
+        {
+        case VertexInput:
+            libraryInfo.flags = VK_GRAPHICS_PIPELINE_LIBRARY_VERTEX_INPUT_INTERFACE_BIT_EXT;
+            pipelineInfo.pVertexInputState = &vertexInput;
+            pipelineInfo.pInputAssemblyState = &config.inputAssemblyInfo;
+            break;
+        case PreRasterization:
+            libraryInfo.flags = VK_GRAPHICS_PIPELINE_LIBRARY_PRE_RASTERIZATION_SHADERS_BIT_EXT;
+            shaderStage = shaderStageInfo(VK_SHADER_STAGE_VERTEX_BIT, vertShaderModule, &vertSpecialization);
+            pipelineInfo.stageCount = 1;
+            pipelineInfo.pStages = &shaderStage;
+            pipelineInfo.pViewportState = &config.viewportInfo;
+            pipelineInfo.pRasterizationState = &config.rasterizationInfo;
+            pipelineInfo.pDynamicState = &config.dynamicStateInfo;
+            break;
+        case FragmentShader:
+            libraryInfo.flags = VK_GRAPHICS_PIPELINE_LIBRARY_FRAGMENT_SHADER_BIT_EXT;
+            shaderStage = shaderStageInfo(VK_SHADER_STAGE_FRAGMENT_BIT, fragShaderModule, &fragSpecialization);
+            pipelineInfo.stageCount = 1;
+            pipelineInfo.pStages = &shaderStage;
+            pipelineInfo.pDepthStencilState = &config.depthStencilInfo;
+            pipelineInfo.pMultisampleState = &config.multisamplingInfo;
+            break;
+        case FragmentOutput:
+            libraryInfo.flags = VK_GRAPHICS_PIPELINE_LIBRARY_FRAGMENT_OUTPUT_INTERFACE_BIT_EXT;
+            pipelineInfo.pColorBlendState = &config.colorBlendInfo;
+            pipelineInfo.pMultisampleState = &config.multisamplingInfo;
+            break;
+        default:
+            break;
+        }
+
+        if (part != VertexInput)
+        {
+            pipelineInfo.layout = config.pipelineLayout;
+            pipelineInfo.renderPass = config.renderPass;
+            pipelineInfo.subpass = config.subpass;
+        }
+
+        VkPipeline library;
+        if (vkCreateGraphicsPipelines(device.device(), device.pipelineCache(), 1, &pipelineInfo, nullptr, &library) != VK_SUCCESS)
+        {
+            throw std::runtime_error("failed to create graphics pipeline library");
+        }
+        return library;
+    }
+
+    VkPipeline Pipeline::FindShared(uint64_t key, bool acquire)
+    {
+        std::lock_guard<std::mutex> lock(s_SharedMutex);
+        auto found = s_SharedPipelines.find(key);
+        if (found == s_SharedPipelines.end())
+            return VK_NULL_HANDLE;
+        if (acquire)
+            found->second.users++;
+        return found->second.pipeline;
     }
 
-    void Pipeline::CreateShaderModule(const std::vector<char> &code, VkShaderModule *shaderModule)
+    VkPipeline Pipeline::AddShared(uint64_t key, VkPipeline pipeline)
     {
-        VkShaderModuleCreateInfo createInfo = {};
-        createInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
-        createInfo.codeSize = code.size();
-        createInfo.pCode = reinterpret_cast<const uint32_t *>(code.data());
+        std::lock_guard<std::mutex> lock(s_SharedMutex);
+        auto &shared = s_SharedPipelines[key];
+        if (shared.pipeline == VK_NULL_HANDLE)
+            shared.pipeline = pipeline;
+        else
+            vkDestroyPipeline(Device::Get().device(), pipeline, nullptr);
+        shared.users++;
+        return shared.pipeline;
+    }
 
-        if (vkCreateShaderModule(device.device(), &createInfo, nullptr, shaderModule) != VK_SUCCESS)
+    void Pipeline::ReleaseShared(uint64_t key)
+    {
+        std::lock_guard<std::mutex> lock(s_SharedMutex);
+        auto found = s_SharedPipelines.find(key);
+        if (found == s_SharedPipelines.end())
+            return;
+        if (--found->second.users == 0)
         {
-            throw std::runtime_error("failed to create shader module!");
+            vkDestroyPipeline(Device::Get().device(), found->second.pipeline, nullptr);
+            s_SharedPipelines.erase(found);
         }
     }
 
+    void Pipeline::Release(const BuildResult &pipeline)
+    {
+        if (pipeline.key != 0)
+            ReleaseShared(pipeline.key);
+        else
+            vkDestroyPipeline(Device::Get().device(), pipeline.pipeline, nullptr);
+    }
+
+    void Pipeline::Retire(const BuildResult &pipeline)
+    {
+        if (pipeline.pipeline != VK_NULL_HANDLE)
+            DeletionQueue::Push([pipeline]() { Release(pipeline); });
+    }
+
+    void Pipeline::DiscardPendingBuild()
+    {
+        if (!pendingBuild.valid())
+            return;
+        try
+        {
+            Release(pendingBuild.get());
+        }
+        catch (const std::exception &)
+        {
+        }
+        rebuildRequested = false;
+    }
+
     void Pipeline::Recreate()
     {
-        vkDeviceWaitIdle(device.device());
-        vkDestroyPipeline(device.device(), graphicsPipeline, nullptr);
+        // a background build would be outdated by the pipeline created here
+        DiscardPendingBuild();
+        Retire({graphicsPipeline, graphicsPipelineKey});
+        graphicsPipeline = VK_NULL_HANDLE;
+        graphicsPipelineKey = 0;
         Create();
         LOG_INFO("[Renderer] Pipeline recreated");
     }
 
+    void Pipeline::RecreateAsync()
+    {
+        // a build already running finishes first, the latest config is built right after it
+        if (pendingBuild.valid())
+        {
+            rebuildRequested = true;
+            return;
+        }
+        StartBuild(device.hasGraphicsPipelineLibrary() ? LinkMode::FastLink : LinkMode::Monolithic);
+    }
+
+    void Pipeline::StartBuild(LinkMode mode)
+    {
+        // the optimized link reuses the snapshot and libraries of the fast link it replaces
+        if (mode != LinkMode::Optimized)
+        {
+            buildConfig = pipelineConfigInfo;
+            buildConfig.colorBlendInfo.pAttachments = buildConfig.colorBlendAttachments.data();
+            buildConfig.dynamicStateInfo.pDynamicStates = buildConfig.dynamicStateEnables.data();
+        }
+
+        pendingMode = mode;
+        pendingBuild = std::async(std::launch::async, [this, mode]() {
+            if (mode != LinkMode::Optimized)
+                LoadShaderModules();
+            return Build(buildConfig, mode);
+        });
+    }
+
+    void Pipeline::Update()
+    {
+        if (!pendingBuild.valid() || pendingBuild.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+            return;
+
+        BuildResult result{};
+        try
+        {
+            result = pendingBuild.get();
+        }
+        catch (const std::exception &e)
+        {
+            LOG_ERROR("[Renderer] Pipeline build failed: {}", e.what());
+        }
+
+        // frames still in flight may have the old pipeline bound
+        if (result.pipeline != VK_NULL_HANDLE)
+        {
+            Retire({graphicsPipeline, graphicsPipelineKey});
+            graphicsPipeline = result.pipeline;
+            graphicsPipelineKey = result.key;
+            LOG_INFO("[Renderer] Pipeline {}", pendingMode == LinkMode::Optimized ? "optimized" : "recreated");
+        }
+
+        if (rebuildRequested)
+        {
+            rebuildRequested = false;
+            StartBuild(device.hasGraphicsPipelineLibrary() ? LinkMode::FastLink : LinkMode::Monolithic);
+        }
+        else if (result.pipeline != VK_NULL_HANDLE && result.key == 0 && pendingMode == LinkMode::FastLink)
+        {
+            StartBuild(LinkMode::Optimized);
+        }
+    }
+
     void Pipeline::Bind(VkCommandBuffer commandBuffer)
     {
         vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, graphicsPipeline);
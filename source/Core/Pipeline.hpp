@@ -4,6 +4,42 @@
 
 namespace Nyxis
 {
+    // Specialization constant values of one shader stage
+    struct ShaderSpecialization
+    {
+        std::vector<VkSpecializationMapEntry> entries{};
+        std::vector<uint8_t> data{};
+
+        template <typename T>
+        void SetConstant(uint32_t constantID, const T &value)
+        {
+            const auto *bytes = reinterpret_cast<const uint8_t *>(&value);
+            for (const auto &entry : entries)
+            {
+                if (entry.constantID == constantID)
+                {
+                    memcpy(data.data() + entry.offset, bytes, sizeof(T));
+                    return;
+                }
+            }
+            entries.push_back({constantID, static_cast<uint32_t>(data.size()), sizeof(T)});
+            data.insert(data.end(), bytes, bytes + sizeof(T));
+        }
+
+        // points into this object, only valid as long as it is not modified
+        VkSpecializationInfo GetInfo() const
+        {
+            VkSpecializationInfo info{};
+            info.mapEntryCount = static_cast<uint32_t>(entries.size());
+            info.pMapEntries = entries.data();
+            info.dataSize = data.size();
+            info.pData = data.data();
+            return info;
+        }
+
+        bool Empty() const { return entries.empty(); }
+    };
+
     struct PipelineConfigInfo
     {
         PipelineConfigInfo() = default;
@@ -22,6 +58,9 @@ namespace Nyxis
         std::vector<VkVertexInputAttributeDescription> attributeDescriptions{};
         std::vector<VkVertexInputBindingDescription> bindingDescriptions{};
 
+        ShaderSpecialization vertexSpecialization{};
+        ShaderSpecialization fragmentSpecialization{};
+
         VkPipelineLayout pipelineLayout = nullptr;
         VkRenderPass renderPass = nullptr;
         uint32_t subpass = 0;
@@ -42,6 +81,15 @@ namespace Nyxis
 
         void Create();
         void Recreate();
+        // Rebuilds the pipeline from the current config and shaders on a worker thread,
+        // the current pipeline keeps being bound until Update() swaps the new one in
+        void RecreateAsync();
+        // Call once per frame: swaps in finished builds, replaced pipelines go through the DeletionQueue
+        void Update();
+        bool IsCompiling() const { return pendingBuild.valid(); }
+        // false until the first build finished
+        bool IsReady() const { return graphicsPipeline != VK_NULL_HANDLE; }
+        VkPipeline GetPipeline() const { return graphicsPipeline; }
         void Bind(VkCommandBuffer commandBuffer);
         PipelineConfigInfo& GetConfig() { return pipelineConfigInfo; }
     	static void DefaultPipelineConfigInfo(PipelineConfigInfo &config);
@@ -50,15 +98,64 @@ namespace Nyxis
 
     	PipelineConfigInfo pipelineConfigInfo;
     private:
+        enum class LinkMode { Monolithic, FastLink, Optimized };
+        enum LibraryPart { VertexInput = 0, PreRasterization, FragmentShader, FragmentOutput, LibraryPartCount };
 
-        void CreateShaderModule(const std::vector<char> &code, VkShaderModule *shaderModule);
+        // key is the shared pipeline key, 0 for pipelines only this object uses
+        struct BuildResult
+        {
+            VkPipeline pipeline = VK_NULL_HANDLE;
+            uint64_t key = 0;
+        };
+
+        struct SharedPipeline
+        {
+            VkPipeline pipeline = VK_NULL_HANDLE;
+            uint32_t users = 0;
+        };
+
+        void LoadShaderModules();
+        void StartBuild(LinkMode mode);
+        void DiscardPendingBuild();
+        static void Release(const BuildResult &pipeline);
+        // frames in flight may still have the pipeline bound
+        static void Retire(const BuildResult &pipeline);
+        BuildResult Build(const PipelineConfigInfo &config, LinkMode mode);
+        VkPipeline BuildMonolithic(const PipelineConfigInfo &config);
+        VkPipeline BuildFromLibraries(const PipelineConfigInfo &config, bool optimized);
+        VkPipeline GetLibrary(const PipelineConfigInfo &config, LibraryPart part);
+        VkPipeline CreateLibrary(const PipelineConfigInfo &config, LibraryPart part);
+        uint64_t HashLibraryPart(const PipelineConfigInfo &config, LibraryPart part) const;
+        uint64_t HashConfig(const PipelineConfigInfo &config) const;
+
+        // returns the shared pipeline and takes a reference if acquire is set, VK_NULL_HANDLE if there is none
+        static VkPipeline FindShared(uint64_t key, bool acquire);
+        // takes a reference, if another thread shared an identical pipeline first that one is kept
+        static VkPipeline AddShared(uint64_t key, VkPipeline pipeline);
+        static void ReleaseShared(uint64_t key);
 
         Device &device = Device::Get();
-        VkPipeline graphicsPipeline;
+        VkPipeline graphicsPipeline = VK_NULL_HANDLE;
+        uint64_t graphicsPipelineKey = 0;
 
         std::string vertPath;
         std::string fragPath;
-        VkShaderModule vertShaderModule;
-        VkShaderModule fragShaderModule;
+        VkShaderModule vertShaderModule = VK_NULL_HANDLE;
+        VkShaderModule fragShaderModule = VK_NULL_HANDLE;
+        uint64_t vertCodeHash = 0;
+        uint64_t fragCodeHash = 0;
+
+        std::future<BuildResult> pendingBuild;
+        LinkMode pendingMode = LinkMode::Monolithic;
+        bool rebuildRequested = false;
+        PipelineConfigInfo buildConfig; // snapshot of the config the worker builds from
+
+        // keys of the shared library parts this pipeline holds a reference to, 0 for parts not built yet
+        std::array<uint64_t, LibraryPartCount> libraryKeys{};
+
+        // pipelines and library parts keyed by a hash of the state they are built from, shared by every
+        // Pipeline with identical state; a config tweak only compiles the library part it touches
+        static inline std::unordered_map<uint64_t, SharedPipeline> s_SharedPipelines{};
+        static inline std::mutex s_SharedMutex{};
     };
 } // namespace Nyxis
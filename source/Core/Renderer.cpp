@@ -1,5 +1,7 @@
 ﻿#include "Core/Renderer.hpp"
 #include "Core/Nyxispch.hpp"
+#include "Core/DeletionQueue.hpp"
+#include "Core/GpuProfiler.hpp"
 
 namespace Nyxis
 {
@@ -10,13 +12,24 @@ namespace Nyxis
         m_Device = device;
     	RecreateSwapChain();
         CreateCommandBuffers();
+        GpuProfiler::Init(device);
         m_WorldImageSize = m_SwapChain->GetSwapChainExtent();
         m_OldWorldImageSize = m_WorldImageSize;
     }
 
+    void Renderer::InitHeadless(Device* device, VkExtent2D extent)
+    {
+        assert(Device::IsHeadless() && "The device has to be created headless");
+        m_HeadlessExtent = extent;
+        Init(nullptr, device);
+    }
+
     void Renderer::Shutdown()
     {
         FreeCommandBuffers();
+        for (auto& readback : m_FrameReadbacks)
+            readback = {};
+        GpuProfiler::Shutdown();
     }
 
     VkImageView Renderer::GetWorldImageView(int index)
@@ -33,32 +46,179 @@ namespace Nyxis
 
     void Renderer::RecreateSwapChain()
     {
-	    auto windowExtent = m_Window->GetExtent();
-        while (windowExtent.width == 0 || windowExtent.height == 0)
+	    auto windowExtent = m_Window ? m_Window->GetExtent() : m_HeadlessExtent;
+        while (m_Window && (windowExtent.width == 0 || windowExtent.height == 0))
         {
             windowExtent = m_Window->GetExtent();
             glfwWaitEvents();
         }
 
         vkDeviceWaitIdle(m_Device->device());
+        // the slots are renumbered with the new frame count
+        ResolveFrameReadbacks();
         if (m_SwapChain == nullptr)
         {
-            m_SwapChain = std::make_unique<SwapChain>(windowExtent);
+            m_SwapChain = std::make_unique<SwapChain>(windowExtent, m_FramePacing);
         }
         else
         {
-            m_SwapChain = std::make_unique<SwapChain>(windowExtent, m_WorldImageSize, std::move(m_SwapChain));
+            m_SwapChain = std::make_unique<SwapChain>(windowExtent, m_WorldImageSize, m_FramePacing, std::move(m_SwapChain));
             if (m_SwapChain->ImageCount() != m_MainCommandBuffers.size())
             {
                 FreeCommandBuffers();
                 CreateCommandBuffers();
             }
         }
+        // the fences of the frame slots were recreated
+        m_SwapChainVersion++;
+        m_SlotPending.fill(false);
+    }
+
+    bool Renderer::IsFrameComplete(VkFence fence, uint32_t swapChainVersion)
+    {
+        return swapChainVersion != m_SwapChainVersion || vkGetFenceStatus(m_Device->device(), fence) == VK_SUCCESS;
+    }
+
+    void Renderer::SetFramePacing(const FramePacing& pacing)
+    {
+        m_FramePacingChanged |= pacing.mode != m_FramePacing.mode || pacing.framesInFlight != m_FramePacing.framesInFlight;
+        m_FramePacing = pacing;
+        m_FramePacing.framesInFlight = std::clamp(pacing.framesInFlight, 1u, static_cast<uint32_t>(SwapChain::MAX_FRAMES_IN_FLIGHT));
+        m_FramePacing.frameLimit = std::max(pacing.frameLimit, 0.0f);
+    }
+
+    void Renderer::PaceFrame()
+    {
+        using Clock = std::chrono::steady_clock;
+
+        if (m_FramePacing.frameLimit > 0.0f)
+        {
+            const auto period = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0 / m_FramePacing.frameLimit));
+            std::this_thread::sleep_until(m_NextFrameTime);
+            m_NextFrameTime = std::max(Clock::now(), m_NextFrameTime) + period;
+        }
+
+        CollectLatency();
+        // the acquire would block here anyway, waiting before input is read keeps the input of the frame fresh
+        if (m_FramePacing.mode == FramePacing::Mode::LowLatency && !m_FramePacingChanged)
+        {
+            const auto waitStart = Clock::now();
+            m_SwapChain->WaitForFrame();
+            m_Latency.waitMs = std::chrono::duration<float, std::milli>(Clock::now() - waitStart).count();
+            CollectLatency();
+        }
+        else
+        {
+            m_Latency.waitMs = 0.0f;
+        }
+        m_InputTime = Clock::now();
+    }
+
+    void Renderer::CollectLatency()
+    {
+        const auto now = std::chrono::steady_clock::now();
+        for (uint32_t slot = 0; slot < m_SwapChain->GetFramesInFlight(); slot++)
+        {
+            if (!m_SlotPending[slot] || vkGetFenceStatus(m_Device->device(), m_SwapChain->GetFrameFence(slot)) != VK_SUCCESS)
+                continue;
+            m_SlotPending[slot] = false;
+            m_Latency.lastMs = std::chrono::duration<float, std::milli>(now - m_SlotInputTimes[slot]).count();
+            m_Latency.averageMs = m_Latency.averageMs == 0.0f ? m_Latency.lastMs : glm::mix(m_Latency.averageMs, m_Latency.lastMs, 0.1f);
+        }
+    }
+
+    void Renderer::FlushFrames()
+    {
+        vkDeviceWaitIdle(m_Device->device());
+        ResolveFrameReadbacks();
+    }
+
+    void Renderer::RecordFrameReadback(VkCommandBuffer commandBuffer)
+    {
+        auto& readback = m_FrameReadbacks[m_CurrentImageIndex];
+        const auto extent = m_SwapChain->GetWorldExtent();
+        const VkDeviceSize size = static_cast<VkDeviceSize>(extent.width) * extent.height * 4;
+        // the previous frame of this slot was resolved once its fence was waited on
+        if (!readback.buffer || readback.buffer->getBufferSize() < size)
+        {
+            readback.buffer = std::make_unique<Buffer>(size, 1, VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+                VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+            readback.buffer->map();
+        }
+
+        const VkImage image = m_SwapChain->GetWorldImage(m_CurrentImageIndex);
+        VkImageMemoryBarrier barrier{};
+        barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+        barrier.srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+        barrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+        barrier.oldLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+        barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+        barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.image = image;
+        barrier.subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1 };
+        vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT,
+            0, 0, nullptr, 0, nullptr, 1, &barrier);
+
+        VkBufferImageCopy region{};
+        region.imageSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1 };
+        region.imageExtent = { extent.width, extent.height, 1 };
+        vkCmdCopyImageToBuffer(commandBuffer, image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, readback.buffer->getBuffer(), 1, &region);
+
+        barrier.srcAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+        barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+        barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+        barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+        vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+            0, 0, nullptr, 0, nullptr, 1, &barrier);
+
+        VkBufferMemoryBarrier hostBarrier{};
+        hostBarrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+        hostBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        hostBarrier.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+        hostBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        hostBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        hostBarrier.buffer = readback.buffer->getBuffer();
+        hostBarrier.size = VK_WHOLE_SIZE;
+        vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_HOST_BIT,
+            0, 0, nullptr, 1, &hostBarrier, 0, nullptr);
+
+        readback.extent = extent;
+        readback.frame = m_FrameCounter;
+        readback.pending = true;
+    }
+
+    void Renderer::ResolveFrameReadbacks()
+    {
+        std::vector<uint32_t> pending;
+        for (uint32_t slot = 0; slot < m_FrameReadbacks.size(); slot++)
+        {
+            if (m_FrameReadbacks[slot].pending)
+                pending.push_back(slot);
+        }
+        std::sort(pending.begin(), pending.end(), [](uint32_t lhs, uint32_t rhs) { return m_FrameReadbacks[lhs].frame < m_FrameReadbacks[rhs].frame; });
+
+        for (const auto slot : pending)
+        {
+            // frames complete in submission order, later ones wait for the next call
+            if (vkGetFenceStatus(m_Device->device(), m_SwapChain->GetFrameFence(slot)) != VK_SUCCESS)
+                break;
+            auto* readback = &m_FrameReadbacks[slot];
+            readback->pending = false;
+            if (!m_FrameCallback)
+                continue;
+            CapturedFrame frame{};
+            frame.frame = readback->frame;
+            frame.extent = readback->extent;
+            const auto* pixels = static_cast<const uint8_t*>(readback->buffer->getMappedMemory());
+            frame.pixels.assign(pixels, pixels + static_cast<size_t>(readback->extent.width) * readback->extent.height * 4);
+            m_FrameCallback(frame);
+        }
     }
 
     void Renderer::CreateCommandBuffers()
     {
-        m_MainCommandBuffers.resize(SwapChain::MAX_FRAMES_IN_FLIGHT);
+        m_MainCommandBuffers.resize(m_SwapChain->ImageCount());
 
         VkCommandBufferAllocateInfo allocInfo{};
         allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
@@ -71,7 +231,7 @@ namespace Nyxis
             throw std::runtime_error("failed to allocate command buffer!");
         }
 
-        m_UICommandBuffers.resize(SwapChain::MAX_FRAMES_IN_FLIGHT);
+        m_UICommandBuffers.resize(m_SwapChain->ImageCount());
 
         allocInfo.commandPool = m_Device->getCommandPool({ Final });
         if (vkAllocateCommandBuffers(m_Device->device(), &allocInfo, m_UICommandBuffers.data()) != VK_SUCCESS)
@@ -105,6 +265,12 @@ namespace Nyxis
     {
         assert(!m_IsFrameStarted && "Can't call BeginWorldFrame while already in progress");
 
+        if (m_FramePacingChanged)
+        {
+            m_FramePacingChanged = false;
+            RecreateSwapChain();
+        }
+
         auto result = m_SwapChain->AcquireNextImage(&m_CurrentImageIndex);
 
         if (result == VK_ERROR_OUT_OF_DATE_KHR)
@@ -125,6 +291,11 @@ namespace Nyxis
             throw std::runtime_error("failed to acquire swap chain image!");
         }
 
+        // the fence of this frame slot was waited on by the acquire
+        CollectLatency();
+        if (m_FrameReadbacks[m_CurrentImageIndex].pending)
+            ResolveFrameReadbacks();
+        DeletionQueue::BeginFrame();
         m_IsFrameStarted = true;
         auto commandBuffer = GetMainCommandBuffer();
 
@@ -134,11 +305,35 @@ namespace Nyxis
         if (vkBeginCommandBuffer(commandBuffer, &beginInfo) != VK_SUCCESS)
             throw std::runtime_error("failed to begin recording command buffer!");
 
+        GpuProfiler::BeginFrame(commandBuffer, m_CurrentImageIndex);
+        GpuProfiler::BeginPass(commandBuffer, GpuPass::World);
+
 		return commandBuffer;
     }
 
     void Renderer::EndWorldFrame()
 	{
+    	assert(m_IsFrameStarted && "Can't end frame while not in progress ");
+
+        auto worldCommandBuffer = GetMainCommandBuffer();
+        if (IsHeadless() && m_FrameCallback)
+            RecordFrameReadback(worldCommandBuffer);
+        GpuProfiler::EndPass(worldCommandBuffer, GpuPass::World);
+
+        if (vkEndCommandBuffer(worldCommandBuffer) != VK_SUCCESS)
+            throw std::runtime_error("failed to record command buffer");
+
+        const uint32_t slot = m_SwapChain->GetCurrentFrame();
+        m_SwapChain->SubmitWorldCommandBuffers(&worldCommandBuffer, &m_CurrentImageIndex);
+        m_FrameCounter++;
+
+        // there is no UI pass, the world submission completes the frame
+        if (IsHeadless())
+        {
+            m_SlotInputTimes[slot] = m_InputTime;
+            m_SlotPending[slot] = true;
+            m_IsFrameStarted = false;
+        }
 	}
 
 	VkCommandBuffer Renderer::BeginUIFrame()
@@ -180,6 +375,7 @@ namespace Nyxis
         VkRect2D scissor{ {0, 0}, m_SwapChain->GetSwapChainExtent() };
         vkCmdSetViewport(commandBuffer, 0, 1, &viewport);
         vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
+        GpuProfiler::BeginPass(commandBuffer, GpuPass::UI);
 
 		return commandBuffer;
 	}
@@ -188,6 +384,7 @@ namespace Nyxis
     {
         assert(m_IsFrameStarted && "Can't call EndUIRenderPass while in progress");
         assert(commandBuffer == GetUICommandBuffer() && "Can't end render pass on command buffer from another frame");
+        GpuProfiler::EndPass(commandBuffer, GpuPass::UI);
     	vkCmdEndRenderPass(commandBuffer);
 
         VkCommandBuffer commandBuffers[] = { GetUICommandBuffer() };
@@ -195,7 +392,10 @@ namespace Nyxis
         if (vkEndCommandBuffer(commandBuffers[0]) != VK_SUCCESS)
             throw std::runtime_error("failed to record command buffer");
 
+        const uint32_t slot = m_SwapChain->GetCurrentFrame();
         auto result = m_SwapChain->SubmitSwapChainCommandBuffers(commandBuffers, &m_CurrentImageIndex);
+        m_SlotInputTimes[slot] = m_InputTime;
+        m_SlotPending[slot] = true;
 
         if (result == VK_ERROR_OUT_OF_DATE_KHR || result == VK_SUBOPTIMAL_KHR || m_Window->WindowResized())
         {
@@ -249,13 +449,5 @@ namespace Nyxis
         assert(commandBuffer == GetMainCommandBuffer() && "Can't end render pass on command buffer from another frame");
 
         vkCmdEndRenderPass(commandBuffer);
-
-    	assert(m_IsFrameStarted && "Can't end frame while not in progress ");
-
-        auto worldCommandBuffer = GetMainCommandBuffer();
-
-        if (vkEndCommandBuffer(worldCommandBuffer) != VK_SUCCESS)
-            throw std::runtime_error("failed to record command buffer");
-        m_SwapChain->SubmitWorldCommandBuffers(&worldCommandBuffer, &m_CurrentImageIndex);
 	}
 } // namespace Nyxis
\ No newline at end of file
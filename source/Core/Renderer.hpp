@@ -2,6 +2,7 @@
 #include "Core/Window.hpp"
 #include "Core/Device.hpp"
 #include "Core/SwapChain.hpp"
+#include "Core/Buffer.hpp"
 #include "Scene/Scene.hpp"
 
 namespace Nyxis
@@ -9,8 +10,33 @@ namespace Nyxis
     class Renderer
     {
     public:
+        // input sampled by the frame until the CPU observed the fence of its last submission
+        struct LatencyStatistics
+        {
+            float averageMs = 0.0f;
+            float lastMs = 0.0f;
+            // time PaceFrame blocked on the frame fence
+            float waitMs = 0.0f;
+        };
+
+        // a world image read back in headless mode, tightly packed RGBA8
+        struct CapturedFrame
+        {
+            uint64_t frame = 0;
+            VkExtent2D extent{};
+            std::vector<uint8_t> pixels;
+        };
+        using FrameCallback = std::function<void(const CapturedFrame&)>;
+
         static void Init(Window* window, Device* device);
+        // renders into offscreen targets of the given size, the device has to be headless as well
+        static void InitHeadless(Device* device, VkExtent2D extent);
         static void Shutdown();
+        [[nodiscard]] static bool IsHeadless() { return m_Window == nullptr; }
+        // headless only, every world image is read back and handed over once its frame completed
+        static void SetFrameCallback(FrameCallback callback) { m_FrameCallback = std::move(callback); }
+        // waits for the GPU and hands over the frames still in flight
+        static void FlushFrames();
 
     	[[nodiscard]] static VkImageView GetWorldImageView(int index);
 		[[nodiscard]] static VkImageView GetIDImageView();
@@ -18,6 +44,11 @@ namespace Nyxis
     	[[nodiscard]] static VkRenderPass GetSwapChainRenderPass() { return m_SwapChain->GetMainRenderPass(); }
         [[nodiscard]] static VkRenderPass GetUIRenderPass() { return m_SwapChain->GetUIRenderPass(); }
         [[nodiscard]] static VkExtent2D GetAspectRatio() { return m_WorldImageSize; }
+        [[nodiscard]] static VkExtent2D GetWorldExtent() { return m_SwapChain->GetWorldExtent(); }
+        [[nodiscard]] static VkFence GetFrameFence() { return m_SwapChain->GetFrameFence(); }
+        // fences go away with the swap chain, which is only recreated once the device is idle
+        [[nodiscard]] static uint32_t GetSwapChainVersion() { return m_SwapChainVersion; }
+        [[nodiscard]] static bool IsFrameComplete(VkFence fence, uint32_t swapChainVersion);
         [[nodiscard]] static VkCommandBuffer GetMainCommandBuffer();
         [[nodiscard]] static VkCommandBuffer GetUICommandBuffer();
         [[nodiscard]] static int GetFrameIndex() { return m_CurrentImageIndex; }
@@ -25,6 +56,13 @@ namespace Nyxis
 		static void SetWorldImageSize(VkExtent2D extent) { m_WorldImageSize = extent; }
 		static void SwitchImageView() { m_ShowWorldImage = !m_ShowWorldImage; }
 
+        [[nodiscard]] static const FramePacing& GetFramePacing() { return m_FramePacing; }
+        // frames in flight and mode changes recreate the swap chain at the next BeginWorldFrame
+        static void SetFramePacing(const FramePacing& pacing);
+        // call before input is polled: applies the frame limiter and in low latency mode waits for the frame slot
+        static void PaceFrame();
+        [[nodiscard]] static const LatencyStatistics& GetLatencyStatistics() { return m_Latency; }
+
         [[nodiscard]]  static VkCommandBuffer BeginWorldFrame() ;
         static void EndWorldFrame();
 
@@ -38,11 +76,24 @@ namespace Nyxis
         static void CreateCommandBuffers();
         static void FreeCommandBuffers();
         static void RecreateSwapChain();
+        static void CollectLatency();
+
+        struct FrameReadback
+        {
+            Scope<Buffer> buffer;
+            VkExtent2D extent{};
+            uint64_t frame = 0;
+            bool pending = false;
+        };
+        static void RecordFrameReadback(VkCommandBuffer commandBuffer);
+        // hands over the completed frames, oldest first
+        static void ResolveFrameReadbacks();
 
 		static inline Window* m_Window = nullptr;
         static inline Device *m_Device = nullptr;
         static inline Ref<Scene> m_Scene = nullptr;
         static inline Ref<SwapChain> m_SwapChain = nullptr;
+        static inline uint32_t m_SwapChainVersion = 0;
 
     	static inline uint32_t m_CurrentImageIndex{};
         static inline bool m_IsFrameStarted{ false };
@@ -53,5 +104,20 @@ namespace Nyxis
         static inline VkExtent2D m_WorldImageSize;
 		static inline VkExtent2D m_OldWorldImageSize;
 	    static inline bool m_ShowWorldImage = true;
+
+        static inline FramePacing m_FramePacing{};
+        static inline bool m_FramePacingChanged = false;
+        static inline std::chrono::steady_clock::time_point m_NextFrameTime{};
+        static inline std::chrono::steady_clock::time_point m_InputTime{};
+        // input time of the frame last submitted in every frame slot, until its fence was observed
+        static inline std::array<std::chrono::steady_clock::time_point, SwapChain::MAX_FRAMES_IN_FLIGHT> m_SlotInputTimes{};
+        static inline std::array<bool, SwapChain::MAX_FRAMES_IN_FLIGHT> m_SlotPending{};
+        static inline LatencyStatistics m_Latency{};
+
+        static inline VkExtent2D m_HeadlessExtent{};
+        static inline FrameCallback m_FrameCallback;
+        // indexed by the image index, which is the frame slot in headless mode
+        static inline std::array<FrameReadback, SwapChain::MAX_FRAMES_IN_FLIGHT> m_FrameReadbacks{};
+        static inline uint64_t m_FrameCounter = 0;
     }; // class Renderer
 } // namespace Nyxis
@@ -0,0 +1,67 @@
+#include "Core/ShaderModuleCache.hpp"
+#include "Core/Pipeline.hpp"
+#include "Utils/Utils.hpp"
+
+namespace Nyxis
+{
+    ShaderModuleCache::Module ShaderModuleCache::Acquire(const std::string &path)
+    {
+        std::lock_guard<std::mutex> lock(s_Mutex);
+
+        std::error_code error;
+        const auto writeTime = std::filesystem::last_write_time(path, error);
+
+        // unchanged files are not read again
+        auto file = s_Files.find(path);
+        if (!error && file != s_Files.end() && file->second.writeTime == writeTime)
+        {
+            auto cached = s_Modules.find(file->second.codeHash);
+            if (cached != s_Modules.end())
+            {
+                cached->second.users++;
+                return {cached->second.module, cached->first};
+            }
+        }
+
+        const auto code = Pipeline::ReadFile(path);
+        const uint64_t codeHash = hashBytes(code.data(), code.size());
+        s_Files[path] = {writeTime, codeHash};
+
+        auto &entry = s_Modules[codeHash];
+        if (entry.module == VK_NULL_HANDLE)
+        {
+            VkShaderModuleCreateInfo createInfo = {};
+            createInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+            createInfo.codeSize = code.size();
+            createInfo.pCode = reinterpret_cast<const uint32_t *>(code.data());
+
+            if (vkCreateShaderModule(Device::Get().device(), &createInfo, nullptr, &entry.module) != VK_SUCCESS)
+            {
+                s_Modules.erase(codeHash);
+                throw std::runtime_error("failed to create shader module!");
+            }
+            s_ModuleHashes[entry.module] = codeHash;
+        }
+        entry.users++;
+        return {entry.module, codeHash};
+    }
+
+    void ShaderModuleCache::Release(VkShaderModule module)
+    {
+        if (module == VK_NULL_HANDLE)
+            return;
+
+        std::lock_guard<std::mutex> lock(s_Mutex);
+        auto hash = s_ModuleHashes.find(module);
+        if (hash == s_ModuleHashes.end())
+            return;
+
+        auto entry = s_Modules.find(hash->second);
+        if (--entry->second.users == 0)
+        {
+            vkDestroyShaderModule(Device::Get().device(), module, nullptr);
+            s_Modules.erase(entry);
+            s_ModuleHashes.erase(hash);
+        }
+    }
+} // namespace Nyxis
@@ -0,0 +1,41 @@
+#pragma once
+#include "Core/Nyxispch.hpp"
+#include "Core/Device.hpp"
+
+#include <filesystem>
+
+namespace Nyxis
+{
+    // Shader modules shared by content: every distinct SPIR-V binary is created once and kept
+    // until its last user releases it. Files are only read again when they changed on disk.
+    class ShaderModuleCache
+    {
+    public:
+        struct Module
+        {
+            VkShaderModule module = VK_NULL_HANDLE;
+            uint64_t codeHash = 0;
+        };
+
+        static Module Acquire(const std::string &path);
+        static void Release(VkShaderModule module);
+
+    private:
+        struct Entry
+        {
+            VkShaderModule module = VK_NULL_HANDLE;
+            uint32_t users = 0;
+        };
+
+        struct FileState
+        {
+            std::filesystem::file_time_type writeTime{};
+            uint64_t codeHash = 0;
+        };
+
+        static inline std::unordered_map<uint64_t, Entry> s_Modules{};
+        static inline std::unordered_map<VkShaderModule, uint64_t> s_ModuleHashes{};
+        static inline std::unordered_map<std::string, FileState> s_Files{};
+        static inline std::mutex s_Mutex{};
+    };
+} // namespace Nyxis
@@ -2,15 +2,17 @@
 
 namespace Nyxis
 {
-    SwapChain::SwapChain(VkExtent2D extent)
-		: m_WindowExtent{extent}
+    SwapChain::SwapChain(VkExtent2D extent, const FramePacing& pacing)
+		: m_PacingMode(pacing.mode), m_FramesInFlight(std::clamp(pacing.framesInFlight, 1u, static_cast<uint32_t>(MAX_FRAMES_IN_FLIGHT))),
+		  m_WindowExtent{extent}
 	{
 		m_WorldExtent = m_WindowExtent;
 		Init();
 	}
 
-	SwapChain::SwapChain(VkExtent2D windowExtent, VkExtent2D worldExtent, std::shared_ptr<SwapChain> previous)
-		: m_WindowExtent{ windowExtent }, m_WorldExtent(worldExtent), m_OldSwapChain{ previous }
+	SwapChain::SwapChain(VkExtent2D windowExtent, VkExtent2D worldExtent, const FramePacing& pacing, std::shared_ptr<SwapChain> previous)
+		: m_PacingMode(pacing.mode), m_FramesInFlight(std::clamp(pacing.framesInFlight, 1u, static_cast<uint32_t>(MAX_FRAMES_IN_FLIGHT))),
+		  m_WindowExtent{ windowExtent }, m_WorldExtent(worldExtent), m_OldSwapChain{ previous }
 	{
 		Init();
 		m_OldSwapChain = nullptr;
@@ -57,7 +59,7 @@ namespace Nyxis
 		vkDestroyRenderPass(device.device(), m_UIRenderPass, nullptr);
 
 		// cleanup synchronization objects
-		for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++)
+		for (size_t i = 0; i < m_InFlightFences.size(); i++)
 		{
 			vkDestroySemaphore(device.device(), m_RenderFinishedSemaphores[i], nullptr);
 			vkDestroySemaphore(device.device(), m_ImageAvailableSemaphores[i], nullptr);
@@ -76,10 +78,13 @@ namespace Nyxis
 		CreateSwapChainFramebuffers();
 		CreateWorldFramebuffers();
 		CreateSyncObjects();
-    	LOG_INFO("[Core] Successfully created swap chain.");
+		if (Device::IsHeadless())
+			LOG_INFO("[Core] Successfully created {} offscreen targets.", m_ImageCount);
+		else
+    		LOG_INFO("[Core] Successfully created swap chain.");
 	}
 
-	VkResult SwapChain::AcquireNextImage(uint32_t* imageIndex)
+	void SwapChain::WaitForFrame()
 	{
 		vkWaitForFences(
 			device.device(),
@@ -87,6 +92,18 @@ namespace Nyxis
 			&m_InFlightFences[m_CurrentFrame],
 			VK_TRUE,
 			std::numeric_limits<uint64_t>::max());
+	}
+
+	VkResult SwapChain::AcquireNextImage(uint32_t* imageIndex)
+	{
+		WaitForFrame();
+
+		// every frame slot owns its offscreen target
+		if (Device::IsHeadless())
+		{
+			*imageIndex = static_cast<uint32_t>(m_CurrentFrame);
+			return VK_SUCCESS;
+		}
 
 		VkResult result = vkAcquireNextImageKHR(
 			device.device(),
@@ -108,6 +125,22 @@ namespace Nyxis
 
 		m_ImagesInFlight[*imageIndex] = m_InFlightFences[m_CurrentFrame];
 
+		if (Device::IsHeadless())
+		{
+			VkSubmitInfo submitInfo = {};
+			submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+			submitInfo.commandBufferCount = 1;
+			submitInfo.pCommandBuffers = buffers;
+
+			vkResetFences(device.device(), 1, &m_InFlightFences[m_CurrentFrame]);
+			if (vkQueueSubmit(device.graphicsQueue(), 1, &submitInfo, m_InFlightFences[m_CurrentFrame]) != VK_SUCCESS)
+			{
+				throw std::runtime_error("failed to submit draw command buffer!");
+			}
+			m_CurrentFrame = (m_CurrentFrame + 1) % m_FramesInFlight;
+			return;
+		}
+
 		// create signal and wait semaphores for the first command buffer
 		VkSemaphore signalSemaphore = m_WorldImageAvailableSemaphores[m_CurrentFrame];	
 		VkSemaphore waitSemaphores = m_ImageAvailableSemaphores[m_CurrentFrame];
@@ -124,9 +157,8 @@ namespace Nyxis
 		submitInfo.signalSemaphoreCount = 1;
 		submitInfo.pSignalSemaphores = &signalSemaphore;
 
-		// submit the first command buffer
-		vkResetFences(device.device(), 1, &m_InFlightFences[m_CurrentFrame]);
-		if (vkQueueSubmit(device.graphicsQueue(), 1, &submitInfo, m_InFlightFences[m_CurrentFrame]) != VK_SUCCESS)
+		// submit the first command buffer, the frame fence is signaled by the second one
+		if (vkQueueSubmit(device.graphicsQueue(), 1, &submitInfo, VK_NULL_HANDLE) != VK_SUCCESS)
 		{
 			throw std::runtime_error("failed to submit draw command buffer!");
 		}
@@ -135,11 +167,6 @@ namespace Nyxis
 	VkResult SwapChain::SubmitSwapChainCommandBuffers(
 		const VkCommandBuffer* buffers, uint32_t* imageIndex)
 	{
-		if (m_ImagesInFlight[*imageIndex] != VK_NULL_HANDLE)
-		{
-			vkWaitForFences(device.device(), 1, &m_ImagesInFlight[*imageIndex], VK_TRUE, UINT64_MAX);
-		}
-
 		// create signal and wait semaphores for the second command buffer
 		VkSemaphore waitSemaphores = m_WorldImageAvailableSemaphores[m_CurrentFrame];
 		VkSemaphore signalSemaphore = m_RenderFinishedSemaphores[m_CurrentFrame];
@@ -155,8 +182,9 @@ namespace Nyxis
 		submitInfo.signalSemaphoreCount = 1;
 		submitInfo.pSignalSemaphores = &signalSemaphore;
 
-		// submit the second command buffer
-		if (vkQueueSubmit(device.graphicsQueue(), 1, &submitInfo, VK_NULL_HANDLE) != VK_SUCCESS)
+		// submit the second command buffer, its fence covers the whole frame
+		vkResetFences(device.device(), 1, &m_InFlightFences[m_CurrentFrame]);
+		if (vkQueueSubmit(device.graphicsQueue(), 1, &submitInfo, m_InFlightFences[m_CurrentFrame]) != VK_SUCCESS)
 		{
 			throw std::runtime_error("failed to submit draw command buffer!");
 		}
@@ -176,19 +204,32 @@ namespace Nyxis
 
 		auto result = vkQueuePresentKHR(device.presentQueue(), &presentInfo);
 
-		m_CurrentFrame = (m_CurrentFrame + 1) % MAX_FRAMES_IN_FLIGHT;
+		m_CurrentFrame = (m_CurrentFrame + 1) % m_FramesInFlight;
 
 		return result;
 	}
 
 	void SwapChain::CreateSwapChain()
 	{
+		if (Device::IsHeadless())
+		{
+			// RGBA, so read back frames need no swizzle
+			m_SwapChainImageFormat = VK_FORMAT_R8G8B8A8_SRGB;
+			m_SwapChainExtent = m_WindowExtent;
+			m_ImageCount = m_FramesInFlight;
+			return;
+		}
+
 		SwapChainSupportDetails swapChainSupport = device.getSwapChainSupport();
 
 		VkSurfaceFormatKHR surfaceFormat = ChooseSwapSurfaceFormat(swapChainSupport.formats);
     	VkExtent2D extent = ChooseSwapExtent(swapChainSupport.capabilities);
 
-		uint32_t imageCount = swapChainSupport.capabilities.minImageCount + 1;
+		m_PresentMode = ChooseSwapPresentMode(swapChainSupport.presentModes);
+
+		// one image more than frames in flight, bounded by the per-frame arrays indexed with the image index
+		uint32_t imageCount = std::max(swapChainSupport.capabilities.minImageCount + 1, m_FramesInFlight + 1);
+		imageCount = std::max(std::min(imageCount, static_cast<uint32_t>(MAX_FRAMES_IN_FLIGHT)), swapChainSupport.capabilities.minImageCount);
 		if (swapChainSupport.capabilities.maxImageCount > 0 &&
 			imageCount > swapChainSupport.capabilities.maxImageCount)
 		{
@@ -244,6 +285,7 @@ namespace Nyxis
 
 		m_SwapChainImageFormat = surfaceFormat.format;
 		m_SwapChainExtent = extent;
+		m_ImageCount = imageCount;
 	}
 
 	void insertImageMemoryBarrier(VkCommandBuffer cmdbuffer,
@@ -279,11 +321,11 @@ namespace Nyxis
 
 	void SwapChain::CreateWorldImages()
 	{
-		m_WorldImages.resize(m_SwapChainImages.size());
-		m_WorldImageMemories.resize(m_SwapChainImages.size());
+		m_WorldImages.resize(m_ImageCount);
+		m_WorldImageMemories.resize(m_ImageCount);
 
-		m_IDImages.resize(m_SwapChainImages.size());
-		m_IDImageMemories.resize(m_SwapChainImages.size());
+		m_IDImages.resize(m_ImageCount);
+		m_IDImageMemories.resize(m_ImageCount);
 
 		auto func = [&](std::vector<VkImage>& images, std::vector<VkDeviceMemory>& memories, VkFormat format, VkImageUsageFlags usage) {
 			for (size_t i = 0; i < images.size(); i++) {
@@ -342,7 +384,7 @@ namespace Nyxis
 			}
 		};
 
-		func(m_WorldImages, m_WorldImageMemories, m_SwapChainImageFormat, VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT);
+		func(m_WorldImages, m_WorldImageMemories, m_SwapChainImageFormat, VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT);
 		func(m_IDImages, m_IDImageMemories, VK_FORMAT_R32_UINT, VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT);
 	}
 
@@ -350,7 +392,7 @@ namespace Nyxis
 	{
 		m_SwapChainImageViews.resize(m_SwapChainImages.size());
 
-		for (size_t i = 0; i < m_WorldImages.size(); i++)
+		for (size_t i = 0; i < m_SwapChainImages.size(); i++)
 		{
 			VkImageViewCreateInfo viewInfo{};
 			viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
@@ -479,6 +521,10 @@ namespace Nyxis
 			throw std::runtime_error("failed to create main render pass!");
 		}
 
+		// nothing is presented without a surface
+		if (Device::IsHeadless())
+			return;
+
 		colorAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
 		colorAttachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
 		colorAttachment.finalLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
@@ -505,9 +551,9 @@ namespace Nyxis
 
 	void SwapChain::CreateSwapChainFramebuffers()
 	{
-		m_SwapChainFramebuffers.resize(ImageCount());
+		m_SwapChainFramebuffers.resize(m_SwapChainImageViews.size());
 
-		for (int i = 0; i < ImageCount(); i++)
+		for (size_t i = 0; i < m_SwapChainImageViews.size(); i++)
 		{
 			VkImageView attachments[1] = {m_SwapChainImageViews[i]};
 			VkFramebufferCreateInfo framebufferInfo{};
@@ -612,14 +658,14 @@ namespace Nyxis
 
 	void SwapChain::CreateSyncObjects()
 	{
-		m_ImageAvailableSemaphores.resize(MAX_FRAMES_IN_FLIGHT);
-		m_RenderFinishedSemaphores.resize(MAX_FRAMES_IN_FLIGHT);
-		m_InFlightFences.resize(MAX_FRAMES_IN_FLIGHT);
+		m_ImageAvailableSemaphores.resize(m_FramesInFlight);
+		m_RenderFinishedSemaphores.resize(m_FramesInFlight);
+		m_InFlightFences.resize(m_FramesInFlight);
 		m_ImagesInFlight.resize(ImageCount(), VK_NULL_HANDLE);
 
-		m_WorldImageAvailableSemaphores.resize(MAX_FRAMES_IN_FLIGHT);
-		m_WorldRenderFinishedSemaphores.resize(MAX_FRAMES_IN_FLIGHT);
-		m_WorldInFlightFences.resize(MAX_FRAMES_IN_FLIGHT);
+		m_WorldImageAvailableSemaphores.resize(m_FramesInFlight);
+		m_WorldRenderFinishedSemaphores.resize(m_FramesInFlight);
+		m_WorldInFlightFences.resize(m_FramesInFlight);
 		m_WorldImagesInFlight.resize(ImageCount(), VK_NULL_HANDLE);
 
 		VkSemaphoreCreateInfo semaphoreInfo = {};
@@ -631,7 +677,7 @@ namespace Nyxis
 
 		vkCreateSemaphore(device.device(), &semaphoreInfo, nullptr, &m_WorldImageAvailableSemaphore);
 
-		for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++)
+		for (size_t i = 0; i < m_FramesInFlight; i++)
 		{
 			if (vkCreateSemaphore(device.device(), &semaphoreInfo, nullptr, &m_ImageAvailableSemaphores[i]) !=
 				VK_SUCCESS ||
@@ -668,23 +714,18 @@ namespace Nyxis
 	VkPresentModeKHR SwapChain::ChooseSwapPresentMode(
 		const std::vector<VkPresentModeKHR>& availablePresentModes)
 	{
-		for (const auto &availablePresentMode : availablePresentModes)
-		{
-		    if (availablePresentMode == VK_PRESENT_MODE_MAILBOX_KHR)
-		    {
+		// mailbox presents the newest frame without tearing, immediate never blocks the queue on the display
+		const std::array<VkPresentModeKHR, 2> preferred = m_PacingMode == FramePacing::Mode::LowLatency
+			? std::array{ VK_PRESENT_MODE_MAILBOX_KHR, VK_PRESENT_MODE_IMMEDIATE_KHR }
+			: std::array{ VK_PRESENT_MODE_IMMEDIATE_KHR, VK_PRESENT_MODE_MAILBOX_KHR };
 
-		        LOG_INFO("[Core] Present mode : Mailbox");
-		        return availablePresentMode;
-		    }
-		}
-		
-		for (const auto &availablePresentMode : availablePresentModes)
+		for (const auto presentMode : preferred)
 		{
-		    if (availablePresentMode == VK_PRESENT_MODE_IMMEDIATE_KHR)
-		    {
-		        LOG_INFO("[Core] Present mode: Immediate");
-		        return availablePresentMode;
-		    }
+			if (std::find(availablePresentModes.begin(), availablePresentModes.end(), presentMode) != availablePresentModes.end())
+			{
+				LOG_INFO("[Core] Present mode: {}", presentMode == VK_PRESENT_MODE_MAILBOX_KHR ? "Mailbox" : "Immediate");
+				return presentMode;
+			}
 		}
 
 		LOG_INFO("[Core] Present mode: V - Sync");
@@ -4,13 +4,26 @@
 
 namespace Nyxis
 {
+    // how frames are paced against the GPU and the display, changing it recreates the swap chain
+    struct FramePacing
+    {
+        enum class Mode { LowLatency, Throughput };
+
+        Mode mode = Mode::LowLatency;
+        // frames the CPU may record ahead of the GPU, 1 to SwapChain::MAX_FRAMES_IN_FLIGHT
+        uint32_t framesInFlight = 2;
+        // CPU side limit in frames per second, 0 disables it
+        float frameLimit = 0.0f;
+    };
+
     class SwapChain
     {
     public:
-        static constexpr int MAX_FRAMES_IN_FLIGHT = 3;
+        // upper bound of the runtime frames in flight, per-frame arrays are sized with it
+        static constexpr int MAX_FRAMES_IN_FLIGHT = 4;
 
-        SwapChain(VkExtent2D windowExtent);
-        SwapChain(VkExtent2D windowExtent, VkExtent2D worldExtent, std::shared_ptr<SwapChain> previous);
+        SwapChain(VkExtent2D windowExtent, const FramePacing &pacing);
+        SwapChain(VkExtent2D windowExtent, VkExtent2D worldExtent, const FramePacing &pacing, std::shared_ptr<SwapChain> previous);
 
         ~SwapChain();
 
@@ -29,6 +42,12 @@ namespace Nyxis
         [[nodiscard]] VkFormat GetSwapChainImageFormat() const { return m_SwapChainImageFormat; }
         [[nodiscard]] VkExtent2D GetSwapChainExtent() const { return m_SwapChainExtent; }
         [[nodiscard]] VkExtent2D GetWorldExtent() const { return m_WorldExtent; }
+        // signaled once the frame that is currently recorded completed on the GPU
+        [[nodiscard]] VkFence GetFrameFence() const { return m_InFlightFences[m_CurrentFrame]; }
+        [[nodiscard]] VkFence GetFrameFence(uint32_t slot) const { return m_InFlightFences[slot]; }
+        [[nodiscard]] uint32_t GetCurrentFrame() const { return static_cast<uint32_t>(m_CurrentFrame); }
+        [[nodiscard]] uint32_t GetFramesInFlight() const { return m_FramesInFlight; }
+        [[nodiscard]] VkPresentModeKHR GetPresentMode() const { return m_PresentMode; }
         [[nodiscard]] uint32_t GetSwapChainWidth() const { return m_SwapChainExtent.width; }
         [[nodiscard]] uint32_t GetSwapChainHeight() const { return m_SwapChainExtent.height; }
         [[nodiscard]] float ExtentAspectRatio() const {
@@ -38,9 +57,12 @@ namespace Nyxis
 
     	void RecreateWorldImages();
 		void SetWorldImageExtent(VkExtent2D extent) { m_WorldExtent = extent; }
+        // in headless mode this submission signals the frame fence, nothing is presented
         void SubmitWorldCommandBuffers(const VkCommandBuffer* commandBuffer, uint32_t* imageIndex);
         VkResult SubmitSwapChainCommandBuffers(const VkCommandBuffer* buffers, uint32_t* imageIndex);
 
+        // blocks until the frame slot about to be recorded is free again
+        void WaitForFrame();
         VkResult AcquireNextImage(uint32_t *imageIndex);
 
     private:
@@ -61,13 +83,18 @@ namespace Nyxis
         VkExtent2D ChooseSwapExtent(const VkSurfaceCapabilitiesKHR &capabilities) const;
 
 		VkPresentModeKHR m_PresentMode = VK_PRESENT_MODE_FIFO_KHR;
+		FramePacing::Mode m_PacingMode = FramePacing::Mode::LowLatency;
+		uint32_t m_FramesInFlight = 2;
         VkFormat m_SwapChainImageFormat;
         VkExtent2D m_SwapChainExtent;
 
         std::vector<VkFramebuffer> m_SwapChainFramebuffers;
         std::vector<VkFramebuffer> m_WorldFramebuffers;
-        VkRenderPass m_MainRenderPass;
-        VkRenderPass m_UIRenderPass;
+        VkRenderPass m_MainRenderPass = VK_NULL_HANDLE;
+        // not created in headless mode
+        VkRenderPass m_UIRenderPass = VK_NULL_HANDLE;
+        // swap chain images, or one world image per frame in flight in headless mode
+        uint32_t m_ImageCount = 0;
 
 		std::vector<VkDeviceMemory> m_WorldImageMemories;
 	    std::vector<VkDeviceMemory> m_IDImageMemories;
@@ -87,7 +114,7 @@ namespace Nyxis
         VkExtent2D m_WindowExtent;
         VkExtent2D m_WorldExtent;
 
-        VkSwapchainKHR m_SwapChain;
+        VkSwapchainKHR m_SwapChain = VK_NULL_HANDLE;
         std::shared_ptr<SwapChain> m_OldSwapChain;
 
         std::vector<VkSemaphore> m_ImageAvailableSemaphores;
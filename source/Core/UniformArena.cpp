@@ -0,0 +1,98 @@
+#include "Core/UniformArena.hpp"
+#include "Core/DeletionQueue.hpp"
+#include "Core/Device.hpp"
+#include "Core/Log.hpp"
+#include "Core/SwapChain.hpp"
+
+namespace Nyxis
+{
+    void UniformArena::Init(VkDeviceSize capacity)
+    {
+        const auto &limits = Device::Get().properties.limits;
+        // dynamic offsets of uniform and storage buffers have to satisfy both limits
+        s_Alignment = std::max(limits.minUniformBufferOffsetAlignment, limits.minStorageBufferOffsetAlignment);
+
+        s_Buffers.resize(SwapChain::MAX_FRAMES_IN_FLIGHT);
+        for (auto &buffer : s_Buffers)
+        {
+            buffer = std::make_unique<Buffer>(capacity, 1, VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+                                              VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+            buffer->map();
+        }
+    }
+
+    void UniformArena::Shutdown()
+    {
+        std::lock_guard<std::mutex> lock(s_Mutex);
+        s_Buffers.clear();
+        s_FreeSlots.clear();
+        s_Top = 0;
+        s_Allocations = 0;
+    }
+
+    VkDeviceSize UniformArena::Allocate(VkDeviceSize size)
+    {
+        std::lock_guard<std::mutex> lock(s_Mutex);
+        const VkDeviceSize alignedSize = AlignedSize(size);
+        s_Allocations++;
+
+        auto freeSlots = s_FreeSlots.find(alignedSize);
+        if (freeSlots != s_FreeSlots.end() && !freeSlots->second.empty())
+        {
+            const VkDeviceSize offset = freeSlots->second.back();
+            freeSlots->second.pop_back();
+            return offset;
+        }
+
+        const VkDeviceSize offset = s_Top;
+        s_Top += alignedSize;
+        return offset;
+    }
+
+    void UniformArena::Free(VkDeviceSize offset, VkDeviceSize size)
+    {
+        if (offset == INVALID_OFFSET)
+            return;
+
+        // frames in flight read their own buffer, the slot is only rewritten by frames recorded after this
+        std::lock_guard<std::mutex> lock(s_Mutex);
+        s_FreeSlots[AlignedSize(size)].push_back(offset);
+        s_Allocations--;
+    }
+
+    bool UniformArena::BeginFrame(uint32_t frameIndex)
+    {
+        std::lock_guard<std::mutex> lock(s_Mutex);
+        auto &buffer = s_Buffers[frameIndex];
+        const VkDeviceSize capacity = buffer->getBufferSize();
+        if (s_Top <= capacity)
+            return false;
+
+        // the contents move over so up to date slots stay valid, frames in flight may still read the old buffer
+        const VkDeviceSize newCapacity = std::max(s_Top, capacity * 2);
+        auto grown = std::make_unique<Buffer>(newCapacity, 1, VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+                                              VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+        grown->map();
+        memcpy(grown->getMappedMemory(), buffer->getMappedMemory(), capacity);
+        DeletionQueue::Release(std::move(buffer));
+        buffer = std::move(grown);
+
+        LOG_INFO("[Renderer] Uniform arena of frame {} grown to {} KB", frameIndex, newCapacity >> 10);
+        return true;
+    }
+
+    void UniformArena::Write(uint32_t frameIndex, VkDeviceSize offset, const void *data, VkDeviceSize size)
+    {
+        memcpy(static_cast<uint8_t *>(s_Buffers[frameIndex]->getMappedMemory()) + offset, data, size);
+    }
+
+    UniformArena::Statistics UniformArena::GetStatistics()
+    {
+        std::lock_guard<std::mutex> lock(s_Mutex);
+        Statistics statistics{};
+        statistics.capacity = s_Buffers.empty() ? 0 : s_Buffers.front()->getBufferSize();
+        statistics.used = s_Top;
+        statistics.allocations = s_Allocations;
+        return statistics;
+    }
+} // namespace Nyxis
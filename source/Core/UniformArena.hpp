@@ -0,0 +1,48 @@
+#pragma once
+#include "Core/Nyxispch.hpp"
+#include "Core/Buffer.hpp"
+
+namespace Nyxis
+{
+    // Per-object constants of every model and mesh, packed into one persistently mapped buffer per frame
+    // in flight and addressed through dynamic offsets. An allocation has the same offset in every frame's
+    // buffer, so objects keep their slot and only rewrite it when their data changed.
+    class UniformArena
+    {
+    public:
+        static constexpr VkDeviceSize INVALID_OFFSET = ~0ull;
+
+        struct Statistics
+        {
+            VkDeviceSize capacity = 0;
+            VkDeviceSize used = 0;
+            uint32_t allocations = 0;
+        };
+
+        static void Init(VkDeviceSize capacity = 1ull << 20);
+        static void Shutdown();
+
+        // thread safe, the slot can be written from the next BeginFrame on
+        static VkDeviceSize Allocate(VkDeviceSize size);
+        static void Free(VkDeviceSize offset, VkDeviceSize size);
+
+        // grows the buffer of this frame if allocations outgrew it, returns true if the buffer was replaced;
+        // the old one is retired through the deletion queue
+        static bool BeginFrame(uint32_t frameIndex);
+        static void Write(uint32_t frameIndex, VkDeviceSize offset, const void *data, VkDeviceSize size);
+
+        static Buffer &GetBuffer(uint32_t frameIndex) { return *s_Buffers[frameIndex]; }
+        static Statistics GetStatistics();
+
+    private:
+        static VkDeviceSize AlignedSize(VkDeviceSize size) { return (size + s_Alignment - 1) & ~(s_Alignment - 1); }
+
+        static inline std::vector<Scope<Buffer>> s_Buffers{};
+        static inline VkDeviceSize s_Alignment = 256;
+        static inline VkDeviceSize s_Top = 0;
+        static inline uint32_t s_Allocations = 0;
+        // released slots by aligned size
+        static inline std::unordered_map<VkDeviceSize, std::vector<VkDeviceSize>> s_FreeSlots{};
+        static inline std::mutex s_Mutex{};
+    };
+} // namespace Nyxis
@@ -18,7 +18,8 @@ namespace Nyxis
         bool WindowResized() { return m_Data.framebufferResized; }
         void ResetWindowResizedFlag() { m_Data.framebufferResized = false; };
 
-        static GLFWwindow* GetGLFWwindow() { return s_Instance->m_Data.window; }
+        // nullptr in headless mode, where no window is created
+        static GLFWwindow* GetGLFWwindow() { return s_Instance ? s_Instance->m_Data.window : nullptr; }
 		static Window & Get(int width, int height, const std::string& name)
 		{
 			s_Instance = new Window(width, height, name);
@@ -1,8 +1,52 @@
 #include "Core/Application.hpp"
 #include "Core/Log.hpp"
 
-int main()
+// [--pipeline-cache <file>] --headless [--width <n>] [--height <n>] [--frames <n>] [--project <file.npj>] [--output <directory>]
+static bool ParseArguments(int argc, char** argv)
 {
+	Nyxis::HeadlessSettings settings{};
+	bool headless = false;
+	for (int i = 1; i < argc; i++)
+	{
+		const std::string argument = argv[i];
+		const bool hasValue = i + 1 < argc;
+		if (argument == "--headless")
+			headless = true;
+		else if (argument == "--width" && hasValue)
+			settings.width = static_cast<uint32_t>(std::stoul(argv[++i]));
+		else if (argument == "--height" && hasValue)
+			settings.height = static_cast<uint32_t>(std::stoul(argv[++i]));
+		else if (argument == "--frames" && hasValue)
+			settings.frameCount = static_cast<uint32_t>(std::stoul(argv[++i]));
+		else if (argument == "--project" && hasValue)
+			settings.projectPath = argv[++i];
+		else if (argument == "--output" && hasValue)
+			settings.outputDirectory = argv[++i];
+		else if (argument == "--pipeline-cache" && hasValue)
+			Nyxis::Device::SetPipelineCachePath(argv[++i]);
+		else
+		{
+			std::cerr << "Unknown argument: " << argument << std::endl;
+			return false;
+		}
+	}
+	if (headless)
+		Nyxis::Application::SetHeadless(settings);
+	return true;
+}
+
+int main(int argc, char** argv)
+{
+	try
+	{
+		if (!ParseArguments(argc, argv))
+			return EXIT_FAILURE;
+	}
+	catch (const std::exception &e)
+	{
+		std::cerr << "Invalid argument: " << e.what() << std::endl;
+		return EXIT_FAILURE;
+	}
 	Nyxis::Log::Init();
     Nyxis::Application* app = Nyxis::Application::GetInstance();
     try
@@ -17,4 +61,4 @@ int main()
 	delete app;
 	Nyxis::Log::Shutdown();
     return 0;
-}
\ No newline at end of file
+}
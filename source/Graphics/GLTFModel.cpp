@@ -62,12 +62,34 @@ namespace Nyxis
 	void ModelTexture::destroy()
 	{
 		auto& device = Device::Get();
-		vkDestroyImageView(device.device(), view, nullptr);
-		vkDestroyImage(device.device(), image, nullptr);
-		vkFreeMemory(device.device(), deviceMemory, nullptr);
+		if (streamHandle != TextureStreamer::INVALID_HANDLE) {
+			TextureStreamer::Unregister(streamHandle);
+		}
+		else {
+			vkDestroyImageView(device.device(), view, nullptr);
+			vkDestroyImage(device.device(), image, nullptr);
+			vkFreeMemory(device.device(), deviceMemory, nullptr);
+		}
 		vkDestroySampler(device.device(), sampler, nullptr);
 	}
 
+	bool ModelTexture::refreshStreamed()
+	{
+		if (streamHandle == TextureStreamer::INVALID_HANDLE)
+			return false;
+
+		const auto& residency = TextureStreamer::GetResidency(streamHandle);
+		if (residency.version == streamVersion)
+			return false;
+
+		image = residency.image;
+		view = residency.view;
+		deviceMemory = VK_NULL_HANDLE;
+		streamVersion = residency.version;
+		updateDescriptor();
+		return true;
+	}
+
 	void ModelTexture::fromglTFImage(tinygltf::Image& gltfimage, TextureSampler textureSampler)
 	{
 		auto& device = Device::Get();
@@ -107,6 +129,17 @@ namespace Nyxis
 		height = gltfimage.height;
 		mipLevels = static_cast<uint32_t> (floor(log2(std::max(width, height))) + 1);
 
+		// only the small mips are uploaded now, the rest follows on demand
+		if (TextureStreamer::s_Settings.enabled) {
+			streamHandle = TextureStreamer::Register(buffer, width, height);
+			imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+			createSampler(textureSampler);
+			refreshStreamed();
+			if (deleteBuffer)
+				delete[] buffer;
+			return;
+		}
+
 		VkMemoryAllocateInfo memAllocInfo = {};
 		memAllocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
 		VkMemoryRequirements memReqs;
@@ -277,23 +310,7 @@ namespace Nyxis
 
 		device.endSingleTimeCommands(commandBuffer);
 
-		VkSamplerCreateInfo samplerInfo = {};
-		samplerInfo.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
-		samplerInfo.magFilter = textureSampler.magFilter;
-		samplerInfo.minFilter = textureSampler.minFilter;
-		samplerInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR;
-		samplerInfo.addressModeU = textureSampler.addressModeU;
-		samplerInfo.addressModeV = textureSampler.addressModeV;
-		samplerInfo.addressModeW = textureSampler.addressModeW;
-		samplerInfo.compareOp = VK_COMPARE_OP_NEVER;
-		samplerInfo.borderColor = VK_BORDER_COLOR_INT_OPAQUE_WHITE;
-		samplerInfo.maxAnisotropy = 1.0f;
-		samplerInfo.anisotropyEnable = VK_FALSE;
-		samplerInfo.maxLod = static_cast<float>(mipLevels);
-		samplerInfo.maxAnisotropy = 8.0f;
-		samplerInfo.anisotropyEnable = VK_TRUE;
-		if (vkCreateSampler(device.device(), &samplerInfo, nullptr, &sampler) != VK_SUCCESS)
-			throw std::runtime_error("failed to create texture sampler!");
+		createSampler(textureSampler);
 
 		VkImageViewCreateInfo viewInfo = {};
 		viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
@@ -315,11 +332,35 @@ namespace Nyxis
 			delete[] buffer;
 	}
 
+	void ModelTexture::createSampler(TextureSampler textureSampler)
+	{
+		auto& device = Device::Get();
+
+		VkSamplerCreateInfo samplerInfo = {};
+		samplerInfo.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+		samplerInfo.magFilter = textureSampler.magFilter;
+		samplerInfo.minFilter = textureSampler.minFilter;
+		samplerInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR;
+		samplerInfo.addressModeU = textureSampler.addressModeU;
+		samplerInfo.addressModeV = textureSampler.addressModeV;
+		samplerInfo.addressModeW = textureSampler.addressModeW;
+		samplerInfo.compareOp = VK_COMPARE_OP_NEVER;
+		samplerInfo.borderColor = VK_BORDER_COLOR_INT_OPAQUE_WHITE;
+		samplerInfo.maxAnisotropy = 1.0f;
+		samplerInfo.anisotropyEnable = VK_FALSE;
+		samplerInfo.maxLod = static_cast<float>(mipLevels);
+		samplerInfo.maxAnisotropy = 8.0f;
+		samplerInfo.anisotropyEnable = VK_TRUE;
+		if (vkCreateSampler(device.device(), &samplerInfo, nullptr, &sampler) != VK_SUCCESS)
+			throw std::runtime_error("failed to create texture sampler!");
+	}
+
 	// Primitive
-	Primitive::Primitive(uint32_t firstIndex, uint32_t indexCount, uint32_t vertexCount, Material& material)
-		: firstIndex(firstIndex), indexCount(indexCount), vertexCount(vertexCount), material(material)
+	Primitive::Primitive(uint32_t firstIndex, uint32_t indexCount, uint32_t vertexOffset, uint32_t vertexCount, Material& material)
+		: firstIndex(firstIndex), indexCount(indexCount), vertexOffset(vertexOffset), vertexCount(vertexCount), material(material)
 	{
 		hasIndices = indexCount > 0;
+		lods.push_back({ firstIndex, indexCount, 0.0f });
 	}
 
 	void Primitive::setBoundingBox(glm::vec3 min, glm::vec3 max)
@@ -334,15 +375,12 @@ namespace Nyxis
 	{
 		this->uniformBlock.matrix = matrix;
 		this->uniformBlock.id = id;
-		uniformBuffer.meshBuffer = std::make_unique<Buffer>(sizeof(uniformBlock), 1, VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
-			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, &uniformBlock);
-		uniformBuffer.meshBuffer->map();
-		uniformBuffer.descriptor = { uniformBuffer.meshBuffer->getBuffer(), 0, sizeof(uniformBlock) };
+		uniformOffset = UniformArena::Allocate(sizeof(UniformBlock));
 	}
 
 	Mesh::~Mesh()
 	{
-
+		UniformArena::Free(uniformOffset, sizeof(UniformBlock));
 	}
 
 	void Mesh::setBoundingBox(glm::vec3 min, glm::vec3 max)
@@ -352,47 +390,80 @@ namespace Nyxis
 		bb.valid = true;
 	}
 
-	// Node
-	glm::mat4 Node::localMatrix()
+	VkDeviceSize Mesh::upload(uint32_t frameIndex)
+	{
+		const uint32_t frameBit = 1u << frameIndex;
+		if ((outdatedFrames & frameBit) == 0)
+			return 0;
+		UniformArena::Write(frameIndex, uniformOffset, &uniformBlock, sizeof(uniformBlock));
+		outdatedFrames &= ~frameBit;
+		return sizeof(uniformBlock);
+	}
+
+	// NodeHierarchy
+	uint32_t NodeHierarchy::add(Node* node, int32_t parent, uint32_t gltfIndex)
 	{
-		return glm::translate(glm::mat4(1.0f), translation) * glm::mat4(rotation) * glm::scale(glm::mat4(1.0f), scale) * matrix;
+		const uint32_t index = static_cast<uint32_t>(nodes.size());
+		nodes.push_back(node);
+		parents.push_back(parent);
+		translations.emplace_back(0.0f);
+		rotations.emplace_back(1.0f, 0.0f, 0.0f, 0.0f);
+		scales.emplace_back(1.0f);
+		matrices.emplace_back(1.0f);
+		worldMatrices.emplace_back(1.0f);
+		dirty.push_back(1);
+		if (gltfIndex >= lookup.size())
+			lookup.resize(gltfIndex + 1, -1);
+		lookup[gltfIndex] = static_cast<int32_t>(index);
+		node->hierarchy = this;
+		node->hierarchyIndex = index;
+		return index;
 	}
 
-	glm::mat4 Node::getMatrix()
+	glm::mat4 NodeHierarchy::localMatrix(uint32_t index) const
 	{
-		glm::mat4 m = localMatrix();
-		Node* p = parent;
-		while (p) {
-			m = p->localMatrix() * m;
-			p = p->parent;
+		return glm::translate(glm::mat4(1.0f), translations[index]) * glm::mat4(rotations[index]) * glm::scale(glm::mat4(1.0f), scales[index]) * matrices[index];
+	}
+
+	bool NodeHierarchy::updateWorldMatrices()
+	{
+		// parents come first, so their dirty flag and world matrix are final when a child is visited
+		bool changed = false;
+		for (size_t i = 0; i < nodes.size(); i++) {
+			const int32_t parent = parents[i];
+			if (parent >= 0 && dirty[parent])
+				dirty[i] = 1;
+			if (!dirty[i])
+				continue;
+			worldMatrices[i] = parent >= 0 ? worldMatrices[parent] * localMatrix(static_cast<uint32_t>(i)) : localMatrix(static_cast<uint32_t>(i));
+			changed = true;
 		}
-		return m;
+		std::fill(dirty.begin(), dirty.end(), 0);
+		return changed;
 	}
 
-	void Node::update() {
+	Node* NodeHierarchy::find(uint32_t gltfIndex) const
+	{
+		if (gltfIndex >= lookup.size() || lookup[gltfIndex] < 0)
+			return nullptr;
+		return nodes[lookup[gltfIndex]];
+	}
+
+	// Node
+	void Node::update(std::vector<glm::mat4>& jointMatrices) {
+		// only the CPU side data is written here, the renderer uploads it into the buffers of the frame it records
 		if (mesh) {
-			glm::mat4 m = getMatrix();
+			const glm::mat4& m = getMatrix();
+			mesh->uniformBlock.matrix = m;
 			if (skin) {
-				mesh->uniformBlock.matrix = m;
-				// Update join matrices
+				// Update joint matrices
 				glm::mat4 inverseTransform = glm::inverse(m);
-				size_t numJoints = std::min((uint32_t)skin->joints.size(), MAX_NUM_JOINTS);
-				for (size_t i = 0; i < numJoints; i++) {
-					Node* jointNode = skin->joints[i];
-					glm::mat4 jointMat = jointNode->getMatrix() * skin->inverseBindMatrices[i];
-					jointMat = inverseTransform * jointMat;
-					mesh->uniformBlock.jointMatrix[i] = jointMat;
+				for (size_t i = 0; i < skin->joints.size(); i++) {
+					jointMatrices[mesh->uniformBlock.jointOffset + i] = inverseTransform * skin->joints[i]->getMatrix() * skin->inverseBindMatrices[i];
 				}
-				mesh->uniformBlock.jointcount = (float)numJoints;
-				memcpy(mesh->uniformBuffer.meshBuffer->getMappedMemory(), &mesh->uniformBlock, sizeof(mesh->uniformBlock));
+				mesh->uniformBlock.jointcount = (float)skin->joints.size();
 			}
-			else {
-				memcpy(mesh->uniformBuffer.meshBuffer->getMappedMemory(), &m, sizeof(glm::mat4));
-			}
-		}
-
-		for (auto& child : children) {
-			child->update();
+			mesh->markOutdated();
 		}
 	}
 
@@ -403,30 +474,30 @@ namespace Nyxis
 	// Model
 	Model::Model()
 	{
-		uniformBuffers.resize(SwapChain::MAX_FRAMES_IN_FLIGHT);
-		for (int i = 0; i < SwapChain::MAX_FRAMES_IN_FLIGHT; i++) {
-			uniformBuffers[i] = std::make_shared<Buffer>(sizeof(UBOMatrix), 1, VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
-			uniformBuffers[i]->map();
-		}
-
-		descriptorSets.resize(SwapChain::MAX_FRAMES_IN_FLIGHT);
+		uniformOffset = UniformArena::Allocate(sizeof(UBOMatrix));
+		uniformEnd = uniformOffset + sizeof(UBOMatrix);
 	}
 
 	Model::Model(const std::string& filename)
+		: Model(filename, nullptr)
+	{
+	}
+
+	Model::Model(const std::string& filename, Ref<tinygltf::Model> parsed)
 	{
 		path = filename;
 		const auto assets_path = Application::GetProject()->GetAssetPath();
 		LOG_INFO("[Renderer] Loading model from {}", path);
 		auto tStart = std::chrono::high_resolution_clock::now();
-		loadFromFile(assets_path + filename);
+		loadFromFile(assets_path + filename, 1.0f, std::move(parsed));
 
-		uniformBuffers.resize(SwapChain::MAX_FRAMES_IN_FLIGHT);
-		for (int i = 0; i < SwapChain::MAX_FRAMES_IN_FLIGHT; i++) {
-			uniformBuffers[i] = std::make_shared<Buffer>(sizeof(UBOMatrix), 1, VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
-			uniformBuffers[i]->map();
+		uniformOffset = UniformArena::Allocate(sizeof(UBOMatrix));
+		uniformEnd = uniformOffset + sizeof(UBOMatrix);
+		for (auto node : linearNodes) {
+			if (node->mesh)
+				uniformEnd = std::max(uniformEnd, node->mesh->uniformOffset + sizeof(Mesh::UniformBlock));
 		}
-		descriptorSets.resize(SwapChain::MAX_FRAMES_IN_FLIGHT);
-		setupDescriptorSet(GLTFRenderer::s_SceneInfo, GLTFRenderer::s_UniformBuffersParams);
+		setupDescriptorSet(GLTFRenderer::s_SceneInfo);
 
 		auto tFileLoad = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - tStart).count();
 		LOG_INFO("[Renderer] Loading took {} ms", tFileLoad);
@@ -434,9 +505,12 @@ namespace Nyxis
 
 	Model::~Model()
 	{
-		for (auto texture : textures) {
-			texture.destroy();
-		}
+		// frames in flight may still draw this model, its GPU objects go once those completed
+		DeletionQueue::Push([textures = std::move(textures)]() mutable {
+			for (auto& texture : textures) {
+				texture.destroy();
+			}
+		});
 		textures.resize(0);
 		textureSamplers.resize(0);
 		materials.resize(0);
@@ -447,7 +521,22 @@ namespace Nyxis
 		}
 		skins.resize(0);
 
-		ModelDescriptorManager::GetDescriptorPool()->freeDescriptors(descriptorSets);
+		UniformArena::Free(uniformOffset, sizeof(UBOMatrix));
+		// skinning sets are only allocated once the compute pre-skinning pass ran for a frame
+		std::vector<VkDescriptorSet> descriptorSets = meshlets.descriptorSets;
+		for (auto descriptorSet : skinning.descriptorSets) {
+			if (descriptorSet != VK_NULL_HANDLE)
+				descriptorSets.push_back(descriptorSet);
+		}
+		if (!descriptorSets.empty()) {
+			DeletionQueue::Push([pool = ModelDescriptorManager::GetDescriptorPool(), descriptorSets]() mutable {
+				pool->freeDescriptors(descriptorSets);
+			});
+		}
+		DeletionQueue::Release(std::move(vertexBuffer), std::move(indexBuffer), std::move(meshlets.meshletBuffer),
+			std::move(meshlets.vertexBuffer), std::move(meshlets.triangleBuffer), std::move(meshlets.drawTemplateBuffer),
+			std::move(meshlets.drawDataBuffers), std::move(meshlets.drawCommandBuffers), std::move(meshlets.indexBuffers),
+			std::move(meshlets.countBuffers), std::move(skinning.vertexBuffers));
 	}
 
 	void Model::loadNode(Node* parent, const tinygltf::Node& node, uint32_t nodeIndex, const tinygltf::Model& model, LoaderInfo& loaderInfo, float globalscale)
@@ -461,29 +550,27 @@ namespace Nyxis
 		newNode->parent = parent;
 		newNode->name = node.name;
 		newNode->skinIndex = node.skin;
-		newNode->matrix = glm::mat4(1.0f);
+		// added before the children are loaded, which keeps the hierarchy ordered parents first
+		const uint32_t flatIndex = hierarchy->add(newNode, parent ? static_cast<int32_t>(parent->hierarchyIndex) : -1, nodeIndex);
 
 		// Generate local node matrix
-		glm::vec3 translation = glm::vec3(0.0f);
 		if (node.translation.size() == 3) {
-			translation = glm::make_vec3(node.translation.data());
-			newNode->translation = translation;
+			glm::vec3 translation = glm::make_vec3(node.translation.data());
+			hierarchy->setTranslation(flatIndex, translation);
 			transform.translation = translation;
 		}
-		glm::mat4 rotation = glm::mat4(1.0f);
 		if (node.rotation.size() == 4) {
 			glm::quat q = glm::make_quat(node.rotation.data());
-			newNode->rotation = glm::mat4(q);
+			hierarchy->setRotation(flatIndex, q);
 			transform.rotation = glm::eulerAngles(q);
 		}
-		glm::vec3 scale = glm::vec3(1.0f);
 		if (node.scale.size() == 3) {
-			scale = glm::make_vec3(node.scale.data());
-			newNode->scale = scale;
+			glm::vec3 scale = glm::make_vec3(node.scale.data());
+			hierarchy->setScale(flatIndex, scale);
 			transform.scale = scale;
 		}
 		if (node.matrix.size() == 16) {
-			newNode->matrix = glm::make_mat4x4(node.matrix.data());
+			hierarchy->matrices[flatIndex] = glm::make_mat4x4(node.matrix.data());
 		}
 
 		// Node with children
@@ -496,7 +583,7 @@ namespace Nyxis
 		// Node contains mesh data
 		if (node.mesh > -1) {
 			const tinygltf::Mesh mesh = model.meshes[node.mesh];
-			Mesh* newMesh = new Mesh(newNode->matrix, newNode->index);
+			Mesh* newMesh = new Mesh(hierarchy->matrices[flatIndex], newNode->index);
 			for (size_t j = 0; j < mesh.primitives.size(); j++) {
 				const tinygltf::Primitive& primitive = mesh.primitives[j];
 				uint32_t vertexStart = static_cast<uint32_t>(loaderInfo.vertexPos);
@@ -638,7 +725,7 @@ namespace Nyxis
 					case TINYGLTF_PARAMETER_TYPE_UNSIGNED_INT: {
 						const uint32_t* buf = static_cast<const uint32_t*>(dataPtr);
 						for (size_t index = 0; index < accessor.count; index++) {
-							loaderInfo.indexBuffer[loaderInfo.indexPos] = buf[index] + vertexStart;
+							loaderInfo.indexBuffer[loaderInfo.indexPos] = buf[index];
 							loaderInfo.indexPos++;
 						}
 						break;
@@ -646,7 +733,7 @@ namespace Nyxis
 					case TINYGLTF_PARAMETER_TYPE_UNSIGNED_SHORT: {
 						const uint16_t* buf = static_cast<const uint16_t*>(dataPtr);
 						for (size_t index = 0; index < accessor.count; index++) {
-							loaderInfo.indexBuffer[loaderInfo.indexPos] = buf[index] + vertexStart;
+							loaderInfo.indexBuffer[loaderInfo.indexPos] = buf[index];
 							loaderInfo.indexPos++;
 						}
 						break;
@@ -654,7 +741,7 @@ namespace Nyxis
 					case TINYGLTF_PARAMETER_TYPE_UNSIGNED_BYTE: {
 						const uint8_t* buf = static_cast<const uint8_t*>(dataPtr);
 						for (size_t index = 0; index < accessor.count; index++) {
-							loaderInfo.indexBuffer[loaderInfo.indexPos] = buf[index] + vertexStart;
+							loaderInfo.indexBuffer[loaderInfo.indexPos] = buf[index];
 							loaderInfo.indexPos++;
 						}
 						break;
@@ -664,10 +751,61 @@ namespace Nyxis
 						return;
 					}
 				}
-				Primitive* newPrimitive = new Primitive(indexStart, indexCount, vertexCount, primitive.material > -1 ? materials[primitive.material] : materials.back());
+				// Vertex cache, overdraw and vertex fetch optimization, only for triangle lists
+				if (hasIndices && (primitive.mode == TINYGLTF_MODE_TRIANGLES || primitive.mode == -1)) {
+					const auto result = MeshOptimizer::Optimize(&loaderInfo.vertexBuffer[vertexStart], vertexCount,
+						&loaderInfo.indexBuffer[indexStart], indexCount, &Vertex::pos);
+					vertexCount = static_cast<uint32_t>(result.vertexCount);
+					loaderInfo.vertexPos = vertexStart + vertexCount;
+					loaderInfo.statsBefore += result.before;
+					loaderInfo.statsAfter += result.after;
+				}
+				Primitive* newPrimitive = new Primitive(indexStart, indexCount, vertexStart, vertexCount, primitive.material > -1 ? materials[primitive.material] : materials.back());
 				newPrimitive->setBoundingBox(posMin, posMax);
+				if (hasIndices && (primitive.mode == TINYGLTF_MODE_TRIANGLES || primitive.mode == -1)) {
+					generateLods(*newPrimitive, loaderInfo);
+
+					// culling expands the meshlets of the level selected for the node
+					const uint32_t firstMeshlet = static_cast<uint32_t>(loaderInfo.meshlets.size());
+					for (size_t level = 0; level < newPrimitive->lods.size(); level++) {
+						auto& lod = newPrimitive->lods[level];
+						// coarser levels are still relative to lodIndices
+						const uint32_t* lodIndices = level == 0 ? &loaderInfo.indexBuffer[indexStart] : &loaderInfo.lodIndices[lod.firstIndex];
+						lod.firstMeshlet = static_cast<uint32_t>(loaderInfo.meshlets.size());
+						MeshOptimizer::BuildMeshlets(lodIndices, lod.indexCount, &loaderInfo.vertexBuffer[vertexStart].pos.x,
+							sizeof(Vertex), vertexCount, loaderInfo.meshlets, loaderInfo.meshletVertices, loaderInfo.meshletTriangles);
+						lod.meshletCount = static_cast<uint32_t>(loaderInfo.meshlets.size()) - lod.firstMeshlet;
+					}
+
+					// ratio of texture space to object space area, a texture of width w has w * uvDensity texels per object unit
+					double uvArea = 0.0, posArea = 0.0;
+					for (uint32_t i = 0; i + 2 < indexCount; i += 3) {
+						const Vertex& v0 = loaderInfo.vertexBuffer[vertexStart + loaderInfo.indexBuffer[indexStart + i]];
+						const Vertex& v1 = loaderInfo.vertexBuffer[vertexStart + loaderInfo.indexBuffer[indexStart + i + 1]];
+						const Vertex& v2 = loaderInfo.vertexBuffer[vertexStart + loaderInfo.indexBuffer[indexStart + i + 2]];
+						posArea += glm::length(glm::cross(v1.pos - v0.pos, v2.pos - v0.pos));
+						const glm::vec2 e1 = v1.uv0 - v0.uv0, e2 = v2.uv0 - v0.uv0;
+						uvArea += std::abs(e1.x * e2.y - e1.y * e2.x);
+					}
+					newPrimitive->uvDensity = posArea > 0.0 ? static_cast<float>(std::sqrt(uvArea / posArea)) : 0.0f;
+
+					// both sides are visible, backface cones would cull them
+					if (newPrimitive->material.doubleSided) {
+						for (uint32_t m = firstMeshlet; m < loaderInfo.meshlets.size(); m++) {
+							loaderInfo.meshlets[m].coneCutoff = 1.0f;
+						}
+					}
+				}
 				newMesh->primitives.push_back(newPrimitive);
 			}
+			for (auto p : newMesh->primitives) {
+				newMesh->lodErrors.resize(std::max(newMesh->lodErrors.size(), p->lods.size()), 0.0f);
+			}
+			for (auto p : newMesh->primitives) {
+				for (uint32_t level = 0; level < newMesh->lodErrors.size(); level++) {
+					newMesh->lodErrors[level] = std::max(newMesh->lodErrors[level], p->getLod(level).error);
+				}
+			}
 			// Mesh BB from BBs of primitives
 			for (auto p : newMesh->primitives) {
 				if (p->bb.valid && !newMesh->bb.valid) {
@@ -688,6 +826,37 @@ namespace Nyxis
 		linearNodes.push_back(newNode);
 	}
 
+	void Model::generateLods(Primitive& primitive, LoaderInfo& loaderInfo)
+	{
+		const uint32_t* indices = &loaderInfo.indexBuffer[primitive.firstIndex];
+		const float* positions = &loaderInfo.vertexBuffer[primitive.vertexOffset].pos.x;
+		// simplification error is bounded relative to the primitive size
+		const float maxError = glm::length(primitive.bb.max - primitive.bb.min) * 0.1f;
+
+		size_t targetIndexCount = primitive.indexCount;
+		for (uint32_t level = 1; level < Primitive::MAX_LODS; level++) {
+			targetIndexCount = targetIndexCount / 6 * 3;
+			if (targetIndexCount < 3) {
+				break;
+			}
+
+			float error = 0.0f;
+			auto lodIndices = MeshOptimizer::Simplify(indices, primitive.indexCount, positions, sizeof(Vertex),
+				primitive.vertexCount, targetIndexCount, maxError, &error);
+
+			// not worth a level if the previous one is not at least a quarter larger
+			if (lodIndices.empty() || lodIndices.size() * 5 > primitive.lods.back().indexCount * 4) {
+				break;
+			}
+
+			MeshOptimizer::OptimizeVertexCache(lodIndices.data(), lodIndices.size(), primitive.vertexCount);
+
+			// firstIndex is relative to lodIndices until the index buffer is assembled
+			primitive.lods.push_back({ static_cast<uint32_t>(loaderInfo.lodIndices.size()), static_cast<uint32_t>(lodIndices.size()), error });
+			loaderInfo.lodIndices.insert(loaderInfo.lodIndices.end(), lodIndices.begin(), lodIndices.end());
+		}
+	}
+
 	void Model::getNodeProps(const tinygltf::Node& node, const tinygltf::Model& model, size_t& vertexCount, size_t& indexCount)
 	{
 		if (node.children.size() > 0) {
@@ -734,6 +903,8 @@ namespace Nyxis
 				newSkin->inverseBindMatrices.resize(accessor.count);
 				memcpy(newSkin->inverseBindMatrices.data(), &buffer.data[accessor.byteOffset + bufferView.byteOffset], accessor.count * sizeof(glm::mat4));
 			}
+			// missing inverse bind matrices are identities
+			newSkin->inverseBindMatrices.resize(newSkin->joints.size(), glm::mat4(1.0f));
 
 			skins.push_back(newSkin);
 		}
@@ -1013,10 +1184,9 @@ namespace Nyxis
 		}
 	}
 
-	void Model::loadFromFile(std::string filename, float scale)
+	Ref<tinygltf::Model> Model::parseFile(const std::string& filename)
 	{
-		auto& device = Device::Get();
-		tinygltf::Model gltfModel;
+		auto gltfModel = std::make_shared<tinygltf::Model>();
 		tinygltf::TinyGLTF gltfContext;
 
 		std::string error;
@@ -1028,56 +1198,116 @@ namespace Nyxis
 			binary = (filename.substr(extpos + 1, filename.length() - extpos) == "glb");
 		}
 
-		bool fileLoaded = binary ? gltfContext.LoadBinaryFromFile(&gltfModel, &error, &warning, filename.c_str()) : gltfContext.LoadASCIIFromFile(&gltfModel, &error, &warning, filename.c_str());
+		bool fileLoaded = binary ? gltfContext.LoadBinaryFromFile(gltfModel.get(), &error, &warning, filename.c_str()) : gltfContext.LoadASCIIFromFile(gltfModel.get(), &error, &warning, filename.c_str());
+		if (!fileLoaded) {
+			LOG_ERROR("[Renderer] Could not load gltf file: {}", error);
+			return nullptr;
+		}
+		return gltfModel;
+	}
+
+	void Model::loadFromFile(std::string filename, float scale, Ref<tinygltf::Model> parsed)
+	{
+		auto& device = Device::Get();
+		if (!parsed)
+			parsed = parseFile(filename);
+		if (!parsed)
+			return;
+		// only read from here on, so a parsed file may be shared by several models
+		tinygltf::Model& gltfModel = *parsed;
 
 		LoaderInfo loaderInfo{};
 		size_t vertexCount = 0;
 		size_t indexCount = 0;
 
-		if (fileLoaded) {
-			loadTextureSamplers(gltfModel);
-			loadTextures(gltfModel);
-			loadMaterials(gltfModel);
+		loadTextureSamplers(gltfModel);
+		loadTextures(gltfModel);
+		loadMaterials(gltfModel);
 
-			const tinygltf::Scene& scene = gltfModel.scenes[gltfModel.defaultScene > -1 ? gltfModel.defaultScene : 0];
+		const tinygltf::Scene& scene = gltfModel.scenes[gltfModel.defaultScene > -1 ? gltfModel.defaultScene : 0];
 
-			// Get vertex and index buffer sizes up-front
-			for (size_t i = 0; i < scene.nodes.size(); i++) {
-				getNodeProps(gltfModel.nodes[scene.nodes[i]], gltfModel, vertexCount, indexCount);
-			}
-			loaderInfo.vertexBuffer = new Vertex[vertexCount];
-			loaderInfo.indexBuffer = new uint32_t[indexCount];
+		// Get vertex and index buffer sizes up-front
+		for (size_t i = 0; i < scene.nodes.size(); i++) {
+			getNodeProps(gltfModel.nodes[scene.nodes[i]], gltfModel, vertexCount, indexCount);
+		}
+		loaderInfo.vertexBuffer = new Vertex[vertexCount];
+		loaderInfo.indexBuffer = new uint32_t[indexCount];
 
-			// TODO: scene handling with no default scene
-			for (size_t i = 0; i < scene.nodes.size(); i++) {
-				const tinygltf::Node node = gltfModel.nodes[scene.nodes[i]];
-				loadNode(nullptr, node, scene.nodes[i], gltfModel, loaderInfo, scale);
-			}
-			if (gltfModel.animations.size() > 0) {
-				loadAnimations(gltfModel);
-			}
-			loadSkins(gltfModel);
+		// TODO: scene handling with no default scene
+		for (size_t i = 0; i < scene.nodes.size(); i++) {
+			const tinygltf::Node node = gltfModel.nodes[scene.nodes[i]];
+			loadNode(nullptr, node, scene.nodes[i], gltfModel, loaderInfo, scale);
+		}
+		if (gltfModel.animations.size() > 0) {
+			loadAnimations(gltfModel);
+		}
+		loadSkins(gltfModel);
 
-			for (auto node : linearNodes) {
-				// Assign skins
-				if (node->skinIndex > -1) {
-					node->skin = skins[node->skinIndex];
-				}
-				// Initial pose
+		for (auto node : linearNodes) {
+			// Assign skins and reserve their joints in the palette
+			if (node->skinIndex > -1) {
+				node->skin = skins[node->skinIndex];
 				if (node->mesh) {
-					node->update();
+					node->mesh->uniformBlock.jointOffset = static_cast<uint32_t>(jointMatrices.size());
+					jointMatrices.resize(jointMatrices.size() + node->skin->joints.size(), glm::mat4(1.0f));
 				}
 			}
 		}
-		else {
-			LOG_ERROR("[Renderer] Could not load gltf file: {}", error);
-			return;
+		// Initial pose
+		hierarchy->updateWorldMatrices();
+		for (auto node : hierarchy->nodes) {
+			if (node->mesh) {
+				node->update(jointMatrices);
+			}
 		}
 
 		extensions = gltfModel.extensionsUsed;
 
+		if (loaderInfo.statsBefore.triangleCount > 0) {
+			LOG_INFO("[Renderer] Optimized {}: vertices {} -> {}, ACMR {:.3f} -> {:.3f}, ATVR {:.3f} -> {:.3f}", filename,
+				vertexCount, loaderInfo.vertexPos, loaderInfo.statsBefore.acmr(), loaderInfo.statsAfter.acmr(),
+				loaderInfo.statsBefore.atvr(), loaderInfo.statsAfter.atvr());
+		}
+
+		// the optimizer may have removed duplicate vertices
+		vertexCount = loaderInfo.vertexPos;
+
+		// lod ranges follow the full detail indices
+		std::vector<uint32_t> indices(loaderInfo.indexBuffer, loaderInfo.indexBuffer + indexCount);
+		indices.insert(indices.end(), loaderInfo.lodIndices.begin(), loaderInfo.lodIndices.end());
+		for (auto node : linearNodes) {
+			if (node->mesh) {
+				for (auto primitive : node->mesh->primitives) {
+					for (size_t level = 1; level < primitive->lods.size(); level++) {
+						primitive->lods[level].firstIndex += static_cast<uint32_t>(indexCount);
+					}
+				}
+			}
+		}
+		indexCount = indices.size();
+
+		// indices are primitive local, so 16 bits are enough as long as no single primitive exceeds them
+		indexType = VK_INDEX_TYPE_UINT16;
+		for (auto node : linearNodes) {
+			if (node->mesh) {
+				for (auto primitive : node->mesh->primitives) {
+					if (!MeshOptimizer::FitsUint16(primitive->vertexCount)) {
+						indexType = VK_INDEX_TYPE_UINT32;
+					}
+				}
+			}
+		}
+		const size_t indexSize = indexType == VK_INDEX_TYPE_UINT16 ? sizeof(uint16_t) : sizeof(uint32_t);
+
+		std::vector<uint16_t> indices16;
+		const void* indexData = indices.data();
+		if (indexType == VK_INDEX_TYPE_UINT16) {
+			indices16.assign(indices.begin(), indices.end());
+			indexData = indices16.data();
+		}
+
 		size_t vertexBufferSize = vertexCount * sizeof(Vertex);
-		size_t indexBufferSize = indexCount * sizeof(uint32_t);
+		size_t indexBufferSize = indexCount * indexSize;
 
 		assert(vertexBufferSize > 0);
 
@@ -1086,20 +1316,25 @@ namespace Nyxis
 			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, loaderInfo.vertexBuffer);
 		vertexStagingBuffer.map();
 
-		vertexBuffer = std::make_unique<Buffer>(sizeof(Vertex), vertexCount, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
-						VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+		// skinned models are also read by the compute pre-skinning pass
+		VkBufferUsageFlags vertexUsage = VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+		if (!skins.empty())
+			vertexUsage |= VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+		vertexBuffer = std::make_unique<Buffer>(sizeof(Vertex), vertexCount, vertexUsage, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
 		device.copyBuffer(vertexStagingBuffer.getBuffer(), vertexBuffer->getBuffer(), vertexBufferSize);
 
 		if (indexBufferSize > 0) {
-			Buffer indexStagingBuffer(sizeof(uint32_t), indexCount, VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-				VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, loaderInfo.indexBuffer);
+			Buffer indexStagingBuffer(indexSize, indexCount, VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+				VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, indexData);
 			indexStagingBuffer.map();
 
-			indexBuffer = std::make_unique<Buffer>(sizeof(uint32_t), indexCount, 
+			indexBuffer = std::make_unique<Buffer>(indexSize, indexCount, 
 				VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
 			device.copyBuffer(indexStagingBuffer.getBuffer(), indexBuffer->getBuffer(), indexBufferSize);
 		}
 
+		setupMeshlets(loaderInfo);
+
 		// Copy from staging buffers
 		delete[] loaderInfo.vertexBuffer;
 		delete[] loaderInfo.indexBuffer;
@@ -1108,11 +1343,175 @@ namespace Nyxis
 		ready = true;
 	}
 
+	void Model::setupMeshlets(LoaderInfo& loaderInfo)
+	{
+		// skinned vertices move away from the bind pose bounds the meshlets were built with
+		meshlets.available = skins.empty() && !loaderInfo.meshlets.empty();
+		for (auto node : linearNodes) {
+			if (node->mesh) {
+				for (auto primitive : node->mesh->primitives) {
+					const bool split = std::all_of(primitive->lods.begin(), primitive->lods.end(), [](const Primitive::Lod& lod) { return lod.meshletCount > 0; });
+					if (primitive->hasIndices && !split) {
+						meshlets.available = false;
+					}
+				}
+			}
+		}
+		if (!meshlets.available) {
+			return;
+		}
+
+		std::vector<MeshletGPU> gpuMeshlets;
+		std::vector<VkDrawIndexedIndirectCommand> drawCommands;
+		uint32_t outputIndexCount = 0;
+
+		for (auto node : linearNodes) {
+			if (!node->mesh) {
+				continue;
+			}
+			for (auto primitive : node->mesh->primitives) {
+				if (!primitive->hasIndices) {
+					continue;
+				}
+
+				primitive->meshletDraw = static_cast<uint32_t>(meshlets.draws.size());
+				meshlets.draws.push_back({ node, primitive });
+
+				// every draw owns a range large enough for all triangles of its full detail level
+				drawCommands.push_back({ 0, 1, outputIndexCount, static_cast<int32_t>(primitive->vertexOffset), 0 });
+				outputIndexCount += primitive->indexCount;
+
+				for (uint32_t level = 0; level < primitive->lods.size(); level++) {
+					const auto& lod = primitive->lods[level];
+					for (uint32_t m = lod.firstMeshlet; m < lod.firstMeshlet + lod.meshletCount; m++) {
+						const auto& meshlet = loaderInfo.meshlets[m];
+						MeshletGPU gpuMeshlet{};
+						gpuMeshlet.sphere = glm::vec4(meshlet.center, meshlet.radius);
+						gpuMeshlet.cone = glm::vec4(meshlet.coneAxis, meshlet.coneCutoff);
+						gpuMeshlet.vertexOffset = meshlet.vertexOffset;
+						gpuMeshlet.triangleOffset = meshlet.triangleOffset;
+						gpuMeshlet.vertexCount = meshlet.vertexCount;
+						gpuMeshlet.triangleCount = meshlet.triangleCount;
+						gpuMeshlet.drawIndex = primitive->meshletDraw;
+						gpuMeshlet.lod = level;
+						gpuMeshlets.push_back(gpuMeshlet);
+					}
+				}
+			}
+		}
+		meshlets.meshletCount = static_cast<uint32_t>(gpuMeshlets.size());
+
+		auto upload = [&](const void* data, VkDeviceSize instanceSize, size_t instanceCount, VkBufferUsageFlags usage) {
+			Buffer stagingBuffer(instanceSize, instanceCount, VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+				VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, data);
+			auto buffer = std::make_unique<Buffer>(instanceSize, instanceCount, usage | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+				VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+			device.copyBuffer(stagingBuffer.getBuffer(), buffer->getBuffer(), instanceSize * instanceCount);
+			return buffer;
+		};
+
+		meshlets.meshletBuffer = upload(gpuMeshlets.data(), sizeof(MeshletGPU), gpuMeshlets.size(), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT);
+		meshlets.vertexBuffer = upload(loaderInfo.meshletVertices.data(), sizeof(uint32_t), loaderInfo.meshletVertices.size(), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT);
+		meshlets.triangleBuffer = upload(loaderInfo.meshletTriangles.data(), sizeof(uint32_t), loaderInfo.meshletTriangles.size(), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT);
+		meshlets.drawTemplateBuffer = upload(drawCommands.data(), sizeof(VkDrawIndexedIndirectCommand), drawCommands.size(), VK_BUFFER_USAGE_TRANSFER_SRC_BIT);
+
+		meshlets.drawDataBuffers.resize(SwapChain::MAX_FRAMES_IN_FLIGHT);
+		meshlets.drawCommandBuffers.resize(SwapChain::MAX_FRAMES_IN_FLIGHT);
+		meshlets.indexBuffers.resize(SwapChain::MAX_FRAMES_IN_FLIGHT);
+		meshlets.descriptorSets.resize(SwapChain::MAX_FRAMES_IN_FLIGHT);
+		meshlets.countBuffers.resize(SwapChain::MAX_FRAMES_IN_FLIGHT);
+		meshlets.countsWritten.assign(SwapChain::MAX_FRAMES_IN_FLIGHT, false);
+
+		for (int i = 0; i < SwapChain::MAX_FRAMES_IN_FLIGHT; i++) {
+			meshlets.drawDataBuffers[i] = std::make_unique<Buffer>(sizeof(MeshletDrawGPU), meshlets.draws.size(), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+				VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+			meshlets.drawDataBuffers[i]->map();
+			meshlets.countBuffers[i] = std::make_unique<Buffer>(sizeof(VkDrawIndexedIndirectCommand), drawCommands.size(), VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+				VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+			meshlets.countBuffers[i]->map();
+			meshlets.drawCommandBuffers[i] = std::make_unique<Buffer>(sizeof(VkDrawIndexedIndirectCommand), drawCommands.size(),
+				VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+			meshlets.indexBuffers[i] = std::make_unique<Buffer>(sizeof(uint32_t), outputIndexCount,
+				VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+
+			DescriptorWriter(ModelDescriptorManager::GetMeshletDescriptorSetLayout(), ModelDescriptorManager::GetDescriptorPool())
+				.writeBuffer(0, meshlets.meshletBuffer->getDescriptorInfo())
+				.writeBuffer(1, meshlets.vertexBuffer->getDescriptorInfo())
+				.writeBuffer(2, meshlets.triangleBuffer->getDescriptorInfo())
+				.writeBuffer(3, meshlets.drawDataBuffers[i]->getDescriptorInfo())
+				.writeBuffer(4, meshlets.drawCommandBuffers[i]->getDescriptorInfo())
+				.writeBuffer(5, meshlets.indexBuffers[i]->getDescriptorInfo())
+				.build(meshlets.descriptorSets[i]);
+		}
+
+		LOG_INFO("[Renderer] Built {} meshlets for {} draws", meshlets.meshletCount, meshlets.draws.size());
+	}
+
+	void Model::updateMeshletDraws(uint32_t index, const glm::mat4& modelMatrix)
+	{
+		// same space the vertex shader outputs world positions in, including its y flip
+		const glm::mat4 flipY = glm::scale(glm::mat4(1.0f), glm::vec3(1.0f, -1.0f, 1.0f));
+		auto drawData = static_cast<MeshletDrawGPU*>(meshlets.drawDataBuffers[index]->getMappedMemory());
+		for (size_t i = 0; i < meshlets.draws.size(); i++) {
+			const auto& draw = meshlets.draws[i];
+			drawData[i].transform = flipY * modelMatrix * draw.node->getMatrix();
+			drawData[i].lod = std::min<uint32_t>(draw.node->lodLevel, static_cast<uint32_t>(draw.primitive->lods.size() - 1));
+		}
+	}
+
+	void Model::collectVisibleTriangles(uint32_t index)
+	{
+		if (!meshlets.countsWritten[index]) {
+			return;
+		}
+		auto commands = static_cast<const VkDrawIndexedIndirectCommand*>(meshlets.countBuffers[index]->getMappedMemory());
+		uint64_t indexCount = 0;
+		for (size_t i = 0; i < meshlets.draws.size(); i++) {
+			indexCount += commands[i].indexCount;
+		}
+		meshlets.visibleTriangles = indexCount / 3;
+	}
+
+	void Model::setupSkinning()
+	{
+		auto& device = Device::Get();
+		const VkDeviceSize size = vertexBuffer->getBufferSize();
+
+		// unskinned vertices are copied once, the compute pass only rewrites positions and normals of skinned ones
+		skinning.vertexBuffers.resize(SwapChain::MAX_FRAMES_IN_FLIGHT);
+		skinning.descriptorSets.resize(SwapChain::MAX_FRAMES_IN_FLIGHT, VK_NULL_HANDLE);
+		skinning.paletteVersions.resize(SwapChain::MAX_FRAMES_IN_FLIGHT, UINT32_MAX);
+		for (auto& buffer : skinning.vertexBuffers) {
+			buffer = std::make_unique<Buffer>(sizeof(Vertex), vertexBuffer->getInstanceCount(),
+				VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+			device.copyBuffer(vertexBuffer->getBuffer(), buffer->getBuffer(), size);
+		}
+	}
+
+	void Model::writeSkinningDescriptorSet(uint32_t index, VkDescriptorBufferInfo* jointBuffer, uint32_t paletteVersion)
+	{
+		DescriptorWriter writer(ModelDescriptorManager::GetSkinningDescriptorSetLayout(), ModelDescriptorManager::GetDescriptorPool());
+		writer.writeBuffer(0, vertexBuffer->getDescriptorInfo())
+			.writeBuffer(1, skinning.vertexBuffers[index]->getDescriptorInfo())
+			.writeBuffer(2, jointBuffer);
+		if (skinning.descriptorSets[index] == VK_NULL_HANDLE)
+			writer.build(skinning.descriptorSets[index]);
+		else
+			writer.overwrite(skinning.descriptorSets[index]);
+		skinning.paletteVersions[index] = paletteVersion;
+	}
+
 	void Model::drawNode(Node* node, VkCommandBuffer commandBuffer)
 	{
 		if (node->mesh) {
 			for (Primitive* primitive : node->mesh->primitives) {
-				vkCmdDrawIndexed(commandBuffer, primitive->indexCount, 1, primitive->firstIndex, 0, 0);
+				if (primitive->hasIndices) {
+					const auto& lod = primitive->getLod(node->lodLevel);
+					vkCmdDrawIndexed(commandBuffer, lod.indexCount, 1, lod.firstIndex, primitive->vertexOffset, 0);
+				}
+				else {
+					vkCmdDraw(commandBuffer, primitive->vertexCount, 1, primitive->vertexOffset, 0);
+				}
 			}
 		}
 		for (auto& child : node->children) {
@@ -1126,7 +1525,7 @@ namespace Nyxis
 		const auto buffer = vertexBuffer->getBuffer();
 		vkCmdBindVertexBuffers(commandBuffer, 0, 1, &buffer, offsets);
 		if(indexBuffer != nullptr)
-			vkCmdBindIndexBuffer(commandBuffer, indexBuffer->getBuffer(), 0, VK_INDEX_TYPE_UINT32);
+			vkCmdBindIndexBuffer(commandBuffer, indexBuffer->getBuffer(), 0, indexType);
 	}
 
 	void Model::draw(VkCommandBuffer commandBuffer)
@@ -1183,96 +1582,176 @@ namespace Nyxis
 		aabb[3][2] = dimensions.min[2];
 	}
 
-	void Model::updateAnimation(float deltaTime)
+	uint32_t AnimationSampler::findKey(float time, uint32_t& cursor) const
 	{
-		if (animations.size() == 0)
-			return;
+		const uint32_t lastKey = static_cast<uint32_t>(inputs.size()) - 2;
 
-		animationTimer += deltaTime;
-		if (animationTimer > animations[animationIndex].end)
-			animationTimer -= animations[animationIndex].end;
+		// forward playback stays in the cached interval or moves on to the next one
+		for (uint32_t key = std::min(cursor, lastKey); key <= std::min(cursor + 1, lastKey); key++) {
+			if (time >= inputs[key] && time < inputs[key + 1]) {
+				cursor = key;
+				return key;
+			}
+		}
+
+		// seeks, loops and times outside the clip
+		auto next = std::upper_bound(inputs.begin(), inputs.end(), time);
+		const uint32_t key = next == inputs.begin() ? 0 : std::min(static_cast<uint32_t>(next - inputs.begin()) - 1, lastKey);
+		cursor = key;
+		return key;
+	}
+
+	glm::vec4 AnimationSampler::cubicSpline(uint32_t key, float u, float duration) const
+	{
+		const float u2 = u * u;
+		const float u3 = u2 * u;
+		const glm::vec4& v0 = outputsVec4[key * 3 + 1];
+		const glm::vec4& outTangent = outputsVec4[key * 3 + 2];
+		const glm::vec4& inTangent = outputsVec4[(key + 1) * 3];
+		const glm::vec4& v1 = outputsVec4[(key + 1) * 3 + 1];
+		return (2.0f * u3 - 3.0f * u2 + 1.0f) * v0 + (u3 - 2.0f * u2 + u) * duration * outTangent
+			+ (-2.0f * u3 + 3.0f * u2) * v1 + (u3 - u2) * duration * inTangent;
+	}
+
+	void AnimationBatch::clear()
+	{
+		channels.clear();
+		from.clear();
+		to.clear();
+		weights.clear();
+		results.clear();
+	}
+
+	void AnimationBatch::add(AnimationChannel* channel, const glm::vec4& a, const glm::vec4& b, float weight)
+	{
+		channels.push_back(channel);
+		from.push_back(a);
+		to.push_back(b);
+		weights.push_back(weight);
+	}
+
+	static void lerpBatch(AnimationBatch& batch)
+	{
+		batch.results.resize(batch.channels.size());
+		for (size_t i = 0; i < batch.channels.size(); i++) {
+			batch.results[i] = batch.from[i] + (batch.to[i] - batch.from[i]) * batch.weights[i];
+		}
+	}
 
+	// quaternions stored as xyzw, takes the shortest arc and blends linearly where the inputs are nearly parallel
+	static void slerpBatch(AnimationBatch& batch)
+	{
+		batch.results.resize(batch.channels.size());
+		for (size_t i = 0; i < batch.channels.size(); i++) {
+			glm::vec4 to = batch.to[i];
+			float cosTheta = glm::dot(batch.from[i], to);
+			if (cosTheta < 0.0f) {
+				to = -to;
+				cosTheta = -cosTheta;
+			}
+			float weightFrom = 1.0f - batch.weights[i];
+			float weightTo = batch.weights[i];
+			if (cosTheta < 0.9995f) {
+				const float theta = std::acos(cosTheta);
+				const float sinTheta = std::sin(theta);
+				weightFrom = std::sin(weightFrom * theta) / sinTheta;
+				weightTo = std::sin(weightTo * theta) / sinTheta;
+			}
+			batch.results[i] = glm::normalize(batch.from[i] * weightFrom + to * weightTo);
+		}
+	}
+
+	static void applyChannel(const AnimationChannel& channel, const glm::vec4& value)
+	{
+		switch (channel.path) {
+		case AnimationChannel::PathType::TRANSLATION:
+			channel.node->hierarchy->setTranslation(channel.node->hierarchyIndex, glm::vec3(value));
+			break;
+		case AnimationChannel::PathType::SCALE:
+			channel.node->hierarchy->setScale(channel.node->hierarchyIndex, glm::vec3(value));
+			break;
+		case AnimationChannel::PathType::ROTATION:
+			channel.node->hierarchy->setRotation(channel.node->hierarchyIndex, glm::normalize(glm::quat(value.w, value.x, value.y, value.z)));
+			break;
+		}
+	}
+
+	void Model::updateAnimation(float deltaTime)
+	{
 		if (animations.empty())
 			return;
 
 		if (animationIndex > static_cast<uint32_t>(animations.size()) - 1) {
-			std::cout << "No animation with index " << animationIndex << std::endl;
+			LOG_WARN("[Renderer] No animation with index {}", animationIndex);
 			return;
 		}
 
 		Animation& animation = animations[animationIndex];
+		animationTimer += deltaTime;
+		if (animationTimer > animation.end)
+			animationTimer -= animation.end;
+
+		animation.lerpBatch.clear();
+		animation.slerpBatch.clear();
 
 		bool updated = false;
 		for (auto& channel : animation.channels) {
-			AnimationSampler& sampler = animation.samplers[channel.samplerIndex];
-			if (sampler.inputs.size() > sampler.outputsVec4.size()) 
+			const AnimationSampler& sampler = animation.samplers[channel.samplerIndex];
+			const size_t stride = sampler.interpolation == AnimationSampler::InterpolationType::CUBICSPLINE ? 3 : 1;
+			if (sampler.inputs.empty() || sampler.outputsVec4.size() < sampler.inputs.size() * stride)
 				continue;
 
-			for (size_t i = 0; i < sampler.inputs.size() - 1; i++) {
-				if ((animationTimer >= sampler.inputs[i]) && (animationTimer <= sampler.inputs[i + 1])) {
-					float u = std::max(0.0f, animationTimer - sampler.inputs[i]) / (sampler.inputs[i + 1] - sampler.inputs[i]);
-					if (u <= 1.0f) {
-						switch (channel.path) {
-						case AnimationChannel::PathType::TRANSLATION: {
-							glm::vec4 trans = glm::mix(sampler.outputsVec4[i], sampler.outputsVec4[i + 1], u);
-							channel.node->translation = glm::vec3(trans);
-							break;
-						}
-						case AnimationChannel::PathType::SCALE: {
-							glm::vec4 trans = glm::mix(sampler.outputsVec4[i], sampler.outputsVec4[i + 1], u);
-							channel.node->scale = glm::vec3(trans);
-							break;
-						}
-						case AnimationChannel::PathType::ROTATION: {
-							glm::quat q1;
-							q1.x = sampler.outputsVec4[i].x;
-							q1.y = sampler.outputsVec4[i].y;
-							q1.z = sampler.outputsVec4[i].z;
-							q1.w = sampler.outputsVec4[i].w;
-							glm::quat q2;
-							q2.x = sampler.outputsVec4[i + 1].x;
-							q2.y = sampler.outputsVec4[i + 1].y;
-							q2.z = sampler.outputsVec4[i + 1].z;
-							q2.w = sampler.outputsVec4[i + 1].w;
-							channel.node->rotation = glm::normalize(glm::slerp(q1, q2, u));
-							break;
-						}
-						}
-						updated = true;
-					}
-				}
+			updated = true;
+			if (sampler.inputs.size() == 1) {
+				applyChannel(channel, sampler.value(0));
+				continue;
+			}
+
+			const uint32_t key = sampler.findKey(animationTimer, channel.cursor);
+			const float duration = sampler.inputs[key + 1] - sampler.inputs[key];
+			const float u = duration > 0.0f ? glm::clamp((animationTimer - sampler.inputs[key]) / duration, 0.0f, 1.0f) : 1.0f;
+
+			switch (sampler.interpolation) {
+			case AnimationSampler::InterpolationType::STEP:
+				applyChannel(channel, sampler.value(u < 1.0f ? key : key + 1));
+				break;
+			case AnimationSampler::InterpolationType::CUBICSPLINE:
+				applyChannel(channel, sampler.cubicSpline(key, u, duration));
+				break;
+			default: {
+				auto& batch = channel.path == AnimationChannel::PathType::ROTATION ? animation.slerpBatch : animation.lerpBatch;
+				batch.add(&channel, sampler.value(key), sampler.value(key + 1), u);
+				break;
 			}
-		}
-		if (updated) {
-			for (auto& node : nodes) {
-				node->update();
 			}
 		}
-	}
 
-	Node* Model::findNode(Node* parent, uint32_t index) {
-		Node* nodeFound = nullptr;
-		if (parent->index == index) {
-			return parent;
+		lerpBatch(animation.lerpBatch);
+		slerpBatch(animation.slerpBatch);
+		for (auto* batch : { &animation.lerpBatch, &animation.slerpBatch }) {
+			for (size_t i = 0; i < batch->channels.size(); i++) {
+				applyChannel(*batch->channels[i], batch->results[i]);
+			}
 		}
-		for (auto& child : parent->children) {
-			nodeFound = findNode(child, index);
-			if (nodeFound) {
-				break;
+
+		if (updated && hierarchy->updateWorldMatrices()) {
+			for (auto node : hierarchy->nodes) {
+				if (node->mesh)
+					node->update(jointMatrices);
 			}
+			if (!jointMatrices.empty())
+				markJointsOutdated();
 		}
-		return nodeFound;
 	}
 
-	Node* Model::nodeFromIndex(uint32_t index) {
-		Node* nodeFound = nullptr;
-		for (auto& node : nodes) {
-			nodeFound = findNode(node, index);
-			if (nodeFound) {
-				break;
-			}
+	VkDeviceSize Model::uploadMeshUniforms(uint32_t frameIndex)
+	{
+		VkDeviceSize bytes = 0;
+		for (auto node : linearNodes) {
+			if (node->mesh)
+				bytes += node->mesh->upload(frameIndex);
 		}
-		return nodeFound;
+		return bytes;
 	}
 
 	void Model::updateModelMatrix(TransformComponent& transform)
@@ -1291,114 +1770,103 @@ namespace Nyxis
 		modelMatrix = glm::rotate(modelMatrix, glm::radians(transform.rotation.y), glm::vec3(0.0f, 1.0f, 0.0f));
 	}
 
-	void Model::setupDescriptorSet(SceneInfo& sceneInfo, std::vector<Ref<Buffer>>& shaderValuesBuffer)
+	void Model::setupDescriptorSet(SceneInfo& sceneInfo)
 	{
-		if (shaderValuesBuffer.size() == 0)
-		{
-			LOG_INFO("[Renderer] Shader Values Buffer is not ready!");
-			return;
+		auto pool = ModelDescriptorManager::GetDescriptorPool();
+		VkDescriptorSetLayout materialLayout = ModelDescriptorManager::GetMaterialDescriptorSetLayout()->getDescriptorSetLayout();
+
+		// Material (samplers)
+		for (auto& material : materials) {
+			pool->allocateDescriptor(materialLayout, material.descriptorSet);
+			writeMaterialDescriptorSet(material, sceneInfo);
 		}
+	}
 
+	void Model::writeMaterialDescriptorSet(Material& material, SceneInfo& sceneInfo)
+	{
 		auto& device = Device::Get();
-		auto pool = ModelDescriptorManager::GetDescriptorPool();
 
-		struct 
-		{
-			VkDescriptorSetLayout scene = ModelDescriptorManager::GetModelDescriptorSetLayout()->getDescriptorSetLayout();
-			VkDescriptorSetLayout material = ModelDescriptorManager::GetMaterialDescriptorSetLayout()->getDescriptorSetLayout();
-			VkDescriptorSetLayout node = ModelDescriptorManager::GetNodeDescriptorSetLayout()->getDescriptorSetLayout();
-		} descriptorSetLayouts;
+		std::vector<VkDescriptorImageInfo> imageDescriptors = {
+			sceneInfo.textures.empty.m_Descriptor,
+			sceneInfo.textures.empty.m_Descriptor,
+			material.normalTexture ? material.normalTexture->descriptor : sceneInfo.textures.empty.m_Descriptor,
+			material.occlusionTexture ? material.occlusionTexture->descriptor : sceneInfo.textures.empty.m_Descriptor,
+			material.emissiveTexture ? material.emissiveTexture->descriptor : sceneInfo.textures.empty.m_Descriptor
+		};
 
-		VkDescriptorPool descriptorPool = ModelDescriptorManager::GetDescriptorPool()->getDescriptorPool();
-		// Scene (matrices and environment maps)
-		{
-			for (auto i = 0; i < descriptorSets.size(); i++) {
-				DescriptorWriter(ModelDescriptorManager::GetModelDescriptorSetLayout(), pool)
-					.writeBuffer(0, uniformBuffers[i]->getDescriptorInfo())
-					.writeBuffer(1, shaderValuesBuffer[i]->getDescriptorInfo())
-					.writeImage(2, &sceneInfo.textures.irradianceCube.m_Descriptor)
-					.writeImage(3, &sceneInfo.textures.prefilteredCube.m_Descriptor)
-					.writeImage(4, &sceneInfo.textures.lutBrdf.m_Descriptor)
-					.build(descriptorSets[i]);
+		// TODO: glTF specs states that metallic roughness should be preferred, even if specular glosiness is present
+
+		if (material.pbrWorkflows.metallicRoughness) {
+			if (material.baseColorTexture) {
+				imageDescriptors[0] = material.baseColorTexture->descriptor;
+			}
+			if (material.metallicRoughnessTexture) {
+				imageDescriptors[1] = material.metallicRoughnessTexture->descriptor;
 			}
 		}
-		
-		// Material (samplers)
-		{
-			// Per-Material descriptor sets
-			for (auto& material : materials) {
-				pool->allocateDescriptor(descriptorSetLayouts.material, material.descriptorSet);
-
-				std::vector<VkDescriptorImageInfo> imageDescriptors = {
-					sceneInfo.textures.empty.m_Descriptor,
-					sceneInfo.textures.empty.m_Descriptor,
-					material.normalTexture ? material.normalTexture->descriptor : sceneInfo.textures.empty.m_Descriptor,
-					material.occlusionTexture ? material.occlusionTexture->descriptor : sceneInfo.textures.empty.m_Descriptor,
-					material.emissiveTexture ? material.emissiveTexture->descriptor : sceneInfo.textures.empty.m_Descriptor
-				};
-		
-				// TODO: glTF specs states that metallic roughness should be preferred, even if specular glosiness is present
-		
-				if (material.pbrWorkflows.metallicRoughness) {
-					if (material.baseColorTexture) {
-						imageDescriptors[0] = material.baseColorTexture->descriptor;
-					}
-					if (material.metallicRoughnessTexture) {
-						imageDescriptors[1] = material.metallicRoughnessTexture->descriptor;
-					}
-				}
-		
-				if (material.pbrWorkflows.specularGlossiness) {
-					if (material.extension.diffuseTexture) {
-						imageDescriptors[0] = material.extension.diffuseTexture->descriptor;
-					}
-					if (material.extension.specularGlossinessTexture) {
-						imageDescriptors[1] = material.extension.specularGlossinessTexture->descriptor;
-					}
-				}
-		
-				std::array<VkWriteDescriptorSet, 5> writeDescriptorSets{};
-				for (size_t i = 0; i < imageDescriptors.size(); i++) {
-					writeDescriptorSets[i].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-					writeDescriptorSets[i].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-					writeDescriptorSets[i].descriptorCount = 1;
-					writeDescriptorSets[i].dstSet = material.descriptorSet;
-					writeDescriptorSets[i].dstBinding = static_cast<uint32_t>(i);
-					writeDescriptorSets[i].pImageInfo = &imageDescriptors[i];
-				}
-		
-				vkUpdateDescriptorSets(device.device(), static_cast<uint32_t>(writeDescriptorSets.size()), writeDescriptorSets.data(), 0, NULL);
+
+		if (material.pbrWorkflows.specularGlossiness) {
+			if (material.extension.diffuseTexture) {
+				imageDescriptors[0] = material.extension.diffuseTexture->descriptor;
 			}
-		
-			// Model node (matrices)
-			{
-				// Per-Node descriptor set
-				for (auto& node : nodes) {
-					setupNodeDescriptorSet(node);
-				}
+			if (material.extension.specularGlossinessTexture) {
+				imageDescriptors[1] = material.extension.specularGlossinessTexture->descriptor;
 			}
 		}
+
+		std::array<VkWriteDescriptorSet, 5> writeDescriptorSets{};
+		for (size_t i = 0; i < imageDescriptors.size(); i++) {
+			writeDescriptorSets[i].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+			writeDescriptorSets[i].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+			writeDescriptorSets[i].descriptorCount = 1;
+			writeDescriptorSets[i].dstSet = material.descriptorSet;
+			writeDescriptorSets[i].dstBinding = static_cast<uint32_t>(i);
+			writeDescriptorSets[i].pImageInfo = &imageDescriptors[i];
+		}
+
+		vkUpdateDescriptorSets(device.device(), static_cast<uint32_t>(writeDescriptorSets.size()), writeDescriptorSets.data(), 0, NULL);
 	}
 
-	void Model::setupNodeDescriptorSet(const Node* node)
+	void Model::updateStreamedTextures(SceneInfo& sceneInfo)
 	{
-		auto descriptorPool = ModelDescriptorManager::GetDescriptorPool();
-		auto descriptorSetLayout = ModelDescriptorManager::GetNodeDescriptorSetLayout()->getDescriptorSetLayout();
-		if (node->mesh) {
-			ModelDescriptorManager::GetDescriptorPool()->allocateDescriptor(descriptorSetLayout, node->mesh->uniformBuffer.descriptorSet);
-			DescriptorWriter (ModelDescriptorManager::GetNodeDescriptorSetLayout(), ModelDescriptorManager::GetDescriptorPool())
-				.writeBuffer(0, &node->mesh->uniformBuffer.descriptor)
-				.build(node->mesh->uniformBuffer.descriptorSet);
+		std::unordered_set<const ModelTexture*> changed;
+		for (auto& texture : textures) {
+			if (texture.refreshStreamed()) {
+				changed.insert(&texture);
+			}
 		}
-		for (const auto& child : node->children) {
-			setupNodeDescriptorSet(child);
+		if (changed.empty())
+			return;
+
+		auto uses = [&](const ModelTexture* texture) { return texture && changed.count(texture); };
+		auto pool = ModelDescriptorManager::GetDescriptorPool();
+		auto layout = ModelDescriptorManager::GetMaterialDescriptorSetLayout()->getDescriptorSetLayout();
+		for (auto& material : materials) {
+			if (material.descriptorSet == VK_NULL_HANDLE)
+				continue;
+			if (!uses(material.baseColorTexture) && !uses(material.metallicRoughnessTexture) && !uses(material.normalTexture) &&
+				!uses(material.occlusionTexture) && !uses(material.emissiveTexture) &&
+				!uses(material.extension.diffuseTexture) && !uses(material.extension.specularGlossinessTexture))
+				continue;
+
+			// the current set may still be bound by frames in flight, so it is replaced instead of updated
+			DeletionQueue::Push([pool, descriptorSet = material.descriptorSet]() {
+				std::vector<VkDescriptorSet> descriptorSets{ descriptorSet };
+				pool->freeDescriptors(descriptorSets);
+			});
+			pool->allocateDescriptor(layout, material.descriptorSet);
+			writeMaterialDescriptorSet(material, sceneInfo);
 		}
 	}
 
-	void Model::updateUniformBuffer(uint32_t index, UBOMatrix* ubo)
+	bool Model::updateUniformBuffer(uint32_t index, UBOMatrix* ubo)
 	{
-		uniformBuffers[index]->writeToBuffer(ubo);
-		uniformBuffers[index]->flush();
+		const uint32_t frameBit = 1u << index;
+		if ((outdatedUniformFrames & frameBit) == 0)
+			return false;
+		UniformArena::Write(index, uniformOffset, ubo, sizeof(UBOMatrix));
+		outdatedUniformFrames &= ~frameBit;
+		return true;
 	}
 
 	Ref<DescriptorPool> ModelDescriptorManager::GetDescriptorPool()
@@ -1415,12 +1883,14 @@ namespace Nyxis
 	{
 		m_DescriptorPool = DescriptorPool::Builder()
 			.addPoolSize(VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 1000)
+			.addPoolSize(VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, 100)
 			.addPoolSize(VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1000)
+			.addPoolSize(VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1000)
 			.setPoolFlags(VK_DESCRIPTOR_POOL_CREATE_FREE_DESCRIPTOR_SET_BIT)
 			.build();
 
 		m_ModelDescriptorSetLayout = DescriptorSetLayout::Builder()
-			.addBinding(0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT, 1)
+			.addBinding(0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT, 1)
 			.addBinding(1, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,VK_SHADER_STAGE_FRAGMENT_BIT, 1)
 			.addBinding(2, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_FRAGMENT_BIT, 1)
 			.addBinding(3, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_FRAGMENT_BIT, 1)
@@ -1436,7 +1906,22 @@ namespace Nyxis
 			.build();
 
 		m_NodeDescriptorSetLayout = DescriptorSetLayout::Builder()
-			.addBinding(0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 1, VK_SHADER_STAGE_VERTEX_BIT)
+			.addBinding(0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, VK_SHADER_STAGE_VERTEX_BIT, 1)
+			.build();
+
+		m_MeshletDescriptorSetLayout = DescriptorSetLayout::Builder()
+			.addBinding(0, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT, 1)
+			.addBinding(1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT, 1)
+			.addBinding(2, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT, 1)
+			.addBinding(3, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT, 1)
+			.addBinding(4, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT, 1)
+			.addBinding(5, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT, 1)
+			.build();
+
+		m_SkinningDescriptorSetLayout = DescriptorSetLayout::Builder()
+			.addBinding(0, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT, 1)
+			.addBinding(1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT, 1)
+			.addBinding(2, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT, 1)
 			.build();
 	}
 
@@ -1469,4 +1954,24 @@ namespace Nyxis
 		}
 		return m_NodeDescriptorSetLayout;
 	}
+
+	Ref<DescriptorSetLayout> ModelDescriptorManager::GetMeshletDescriptorSetLayout()
+	{
+		if (m_SetupState == false)
+		{
+			Setup();
+			m_SetupState = true;
+		}
+		return m_MeshletDescriptorSetLayout;
+	}
+
+	Ref<DescriptorSetLayout> ModelDescriptorManager::GetSkinningDescriptorSetLayout()
+	{
+		if (m_SetupState == false)
+		{
+			Setup();
+			m_SetupState = true;
+		}
+		return m_SkinningDescriptorSetLayout;
+	}
 }
@@ -3,13 +3,15 @@
 #include "Core/Device.hpp"
 #include "Core/Buffer.hpp"
 #include "Core/Descriptors.hpp"
+#include "Core/DeletionQueue.hpp"
+#include "Core/UniformArena.hpp"
 #include "Graphics/Texture.hpp"
+#include "Graphics/MeshOptimizer.hpp"
+#include "Graphics/TextureStreamer.hpp"
 #include "Scene/Components.hpp"
 
 #include <tinygltf/tiny_gltf.h>
 
-#define MAX_NUM_JOINTS 128u
-
 namespace Nyxis
 {
 	struct Node;
@@ -51,6 +53,8 @@ namespace Nyxis
 		uint entityID;
 		uint selectedEntityID;
 		bool isMouseClicked;
+		// first joint of the model in the frame's joint palette, -1 if its vertices were skinned by the compute pass
+		int32_t jointOffset = 0;
 	};
 
 	struct Textures {
@@ -93,10 +97,16 @@ namespace Nyxis
 		uint32_t layerCount;
 		VkDescriptorImageInfo descriptor;
 		VkSampler sampler;
+		// image, view and memory are owned by the TextureStreamer if the texture is streamed
+		uint32_t streamHandle = TextureStreamer::INVALID_HANDLE;
+		uint32_t streamVersion = 0;
 		void updateDescriptor();
 		void destroy();
 		// Load a texture from a glTF image (stored as vector of chars loaded via stb_image) and generate a full mip chaing for it
 		void fromglTFImage(tinygltf::Image& gltfimage, TextureSampler textureSampler);
+		void createSampler(TextureSampler textureSampler);
+		// picks up the image the streamer swapped in, returns true if the descriptor changed
+		bool refreshStreamed();
 	};
 	
 	struct Material {
@@ -138,11 +148,33 @@ namespace Nyxis
 	struct Primitive {
 		uint32_t firstIndex;
 		uint32_t indexCount;
+		// indices are local to the primitive, vertexOffset is added by vkCmdDrawIndexed
+		uint32_t vertexOffset;
 		uint32_t vertexCount;
 		Material& material;
 		bool hasIndices;
 		BoundingBox bb;
-		Primitive(uint32_t firstIndex, uint32_t indexCount, uint32_t vertexCount, Material& material);
+
+		// simplified index ranges sharing the primitive's vertices, lods[0] is the full detail range
+		static constexpr uint32_t MAX_LODS = 4;
+		struct Lod {
+			uint32_t firstIndex;
+			uint32_t indexCount;
+			float error; // object space distance to the full detail surface
+			// range in the model's meshlet list, every level is split into meshlets of its own
+			uint32_t firstMeshlet = 0;
+			uint32_t meshletCount = 0;
+		};
+		std::vector<Lod> lods;
+
+		// slot of the indirect draw written by meshlet culling
+		uint32_t meshletDraw = UINT32_MAX;
+
+		// texcoord 0 units per object space unit, drives the requested texture mip
+		float uvDensity = 0.0f;
+
+		Primitive(uint32_t firstIndex, uint32_t indexCount, uint32_t vertexOffset, uint32_t vertexCount, Material& material);
+		const Lod& getLod(uint32_t level) const { return lods[std::min<size_t>(level, lods.size() - 1)]; }
 		void setBoundingBox(glm::vec3 min, glm::vec3 max);
 	};
 
@@ -151,21 +183,26 @@ namespace Nyxis
 		std::vector<Primitive*> primitives;
 		BoundingBox bb;
 		BoundingBox aabb;
+		// worst error of all primitives for each lod level
+		std::vector<float> lodErrors;
 		std::unique_ptr<Buffer> buffer = nullptr;
-		struct UniformBuffer {
-			Scope<Buffer> meshBuffer;
-			VkDescriptorBufferInfo descriptor;
-			VkDescriptorSet descriptorSet;
-		} uniformBuffer;
+		// slot of the uniform block in the UniformArena, which has one buffer per frame in flight
+		VkDeviceSize uniformOffset = UniformArena::INVALID_OFFSET;
+		// bit per frame whose buffer holds an outdated uniform block
+		uint32_t outdatedFrames = ~0u;
 		struct UniformBlock {
 			glm::mat4 matrix;
-			glm::mat4 jointMatrix[MAX_NUM_JOINTS]{};
+			// first joint of this mesh in the model's joint palette
+			uint32_t jointOffset{ 0 };
 			float jointcount{ 0 };
 			uint32_t id{ 0 };
 		} uniformBlock;
 		Mesh(glm::mat4 matrix, uint32_t id);
 		~Mesh();
 		void setBoundingBox(glm::vec3 min, glm::vec3 max);
+		void markOutdated() { outdatedFrames = ~0u; }
+		// writes the uniform block to the buffer of this frame if it is outdated, returns the bytes written
+		VkDeviceSize upload(uint32_t frameIndex);
 	};
 
 	struct Skin {
@@ -175,25 +212,52 @@ namespace Nyxis
 		std::vector<Node*> joints;
 	};
 
+	// The node tree of a model flattened into arrays ordered parents before children. Local transforms
+	// are set through the setters which mark them dirty, updateWorldMatrices() then refreshes the world
+	// matrices of dirty nodes and their descendants in a single linear pass.
+	struct NodeHierarchy {
+		std::vector<Node*> nodes;
+		std::vector<int32_t> parents;			// flat index of the parent, -1 for roots
+		std::vector<glm::vec3> translations;
+		std::vector<glm::quat> rotations;
+		std::vector<glm::vec3> scales;
+		std::vector<glm::mat4> matrices;		// static matrix of the glTF node
+		std::vector<glm::mat4> worldMatrices;
+		std::vector<uint8_t> dirty;
+		std::vector<int32_t> lookup;			// glTF node index -> flat index, -1 if not loaded
+
+		// the parent has to be added before its children
+		uint32_t add(Node* node, int32_t parent, uint32_t gltfIndex);
+		void setTranslation(uint32_t index, const glm::vec3& translation) { translations[index] = translation; dirty[index] = 1; }
+		void setRotation(uint32_t index, const glm::quat& rotation) { rotations[index] = rotation; dirty[index] = 1; }
+		void setScale(uint32_t index, const glm::vec3& scale) { scales[index] = scale; dirty[index] = 1; }
+		glm::mat4 localMatrix(uint32_t index) const;
+		// returns true if any world matrix changed
+		bool updateWorldMatrices();
+		Node* find(uint32_t gltfIndex) const;
+	};
+
 	struct Node {
 		Node* parent;
 		uint32_t index;
 		uint32_t entityID;
 		std::vector<Node*> children;
-		glm::mat4 matrix;
 		std::string name;
 		Mesh* mesh;
 		Skin* skin;
 		int32_t skinIndex = -1;
-		glm::vec3 translation{};
-		glm::vec3 scale{ 1.0f };
-		glm::quat rotation{};
 		BoundingBox bvh;
 		BoundingBox aabb;
-		
-		glm::mat4 localMatrix();
-		glm::mat4 getMatrix();
-		void update();
+		uint32_t lodLevel = 0;
+		// transforms live in the model's flattened hierarchy
+		NodeHierarchy* hierarchy = nullptr;
+		uint32_t hierarchyIndex = 0;
+
+		glm::mat4 localMatrix() const { return hierarchy->localMatrix(hierarchyIndex); }
+		// world matrix as of the last NodeHierarchy::updateWorldMatrices()
+		const glm::mat4& getMatrix() const { return hierarchy->worldMatrices[hierarchyIndex]; }
+		// writes the matrix of the mesh and, for skinned meshes, its joint matrices into the model's palette
+		void update(std::vector<glm::mat4>& jointMatrices);
 		~Node();
 	};
 
@@ -202,13 +266,34 @@ namespace Nyxis
 		PathType path;
 		Node* node;
 		uint32_t samplerIndex;
+		// key interval of the last evaluation, forward playback finds the next one right after it
+		uint32_t cursor = 0;
 	};
 
 	struct AnimationSampler {
 		enum InterpolationType { LINEAR, STEP, CUBICSPLINE };
 		InterpolationType interpolation;
 		std::vector<float> inputs;
+		// CUBICSPLINE stores in-tangent, value and out-tangent for every key
 		std::vector<glm::vec4> outputsVec4;
+
+		// first key of the interval containing time, amortized O(1) through the cursor and a binary search otherwise
+		uint32_t findKey(float time, uint32_t& cursor) const;
+		glm::vec4 value(uint32_t key) const { return interpolation == CUBICSPLINE ? outputsVec4[key * 3 + 1] : outputsVec4[key]; }
+		// hermite spline between key and key + 1, duration is the length of the interval
+		glm::vec4 cubicSpline(uint32_t key, float u, float duration) const;
+	};
+
+	// channels interpolated the same way, evaluated together in SoA form
+	struct AnimationBatch {
+		std::vector<AnimationChannel*> channels;
+		std::vector<glm::vec4> from;
+		std::vector<glm::vec4> to;
+		std::vector<float> weights;
+		std::vector<glm::vec4> results;
+
+		void clear();
+		void add(AnimationChannel* channel, const glm::vec4& a, const glm::vec4& b, float weight);
 	};
 
 	struct Animation {
@@ -217,6 +302,9 @@ namespace Nyxis
 		std::vector<AnimationChannel> channels;
 		float start = std::numeric_limits<float>::max();
 		float end = std::numeric_limits<float>::min();
+		// scratch batches reused by every update
+		AnimationBatch lerpBatch;
+		AnimationBatch slerpBatch;
 	};
 
 	struct Model {
@@ -236,12 +324,16 @@ namespace Nyxis
 
 		Scope<Buffer> vertexBuffer = nullptr;
 		Scope<Buffer> indexBuffer = nullptr;
+		// 16 bit when every primitive has less than 65536 vertices
+		VkIndexType indexType = VK_INDEX_TYPE_UINT32;
 
 		glm::mat4 aabb;
 		glm::mat4 modelMatrix{ 1.0f };
 
 		std::vector<Node*> nodes;
 		std::vector<Node*> linearNodes;
+		// heap allocated so the nodes' back pointers survive moves of the model
+		Scope<NodeHierarchy> hierarchy = std::make_unique<NodeHierarchy>();
 
 		std::vector<Skin*> skins;
 
@@ -261,19 +353,105 @@ namespace Nyxis
 			Vertex* vertexBuffer;
 			size_t indexPos = 0;
 			size_t vertexPos = 0;
+			MeshOptimizer::Statistics statsBefore;
+			MeshOptimizer::Statistics statsAfter;
+			// lod index ranges, appended behind the full detail indices on upload
+			std::vector<uint32_t> lodIndices;
+			std::vector<MeshOptimizer::Meshlet> meshlets;
+			std::vector<uint32_t> meshletVertices;
+			std::vector<uint32_t> meshletTriangles;
+		};
+
+		// std430 layout of the meshlet in meshlet_cull.comp
+		struct MeshletGPU {
+			glm::vec4 sphere;
+			glm::vec4 cone;
+			uint32_t vertexOffset;
+			uint32_t triangleOffset;
+			uint32_t vertexCount;
+			uint32_t triangleCount;
+			uint32_t drawIndex;
+			uint32_t lod;
+			uint32_t padding[2];
+		};
+
+		// std430 layout of the per draw data in meshlet_cull.comp
+		struct MeshletDrawGPU {
+			glm::mat4 transform;
+			// only meshlets of this lod level are expanded
+			uint32_t lod;
+			uint32_t padding[3];
+		};
+
+		struct MeshletDraw {
+			Node* node;
+			Primitive* primitive;
 		};
 
+		// GPU data for meshlet culling, only available if every indexed primitive was split into meshlets
+		struct Meshlets {
+			bool available = false;
+			uint32_t meshletCount = 0;
+			std::vector<MeshletDraw> draws;
+			Scope<Buffer> meshletBuffer = nullptr;
+			Scope<Buffer> vertexBuffer = nullptr;
+			Scope<Buffer> triangleBuffer = nullptr;
+			// indirect commands with zero index counts, copied over the per-frame commands before culling
+			Scope<Buffer> drawTemplateBuffer = nullptr;
+			// per frame in flight
+			std::vector<Scope<Buffer>> drawDataBuffers;
+			std::vector<Scope<Buffer>> drawCommandBuffers;
+			std::vector<Scope<Buffer>> indexBuffers;
+			std::vector<VkDescriptorSet> descriptorSets;
+			// host copies of the culled indirect commands, read when the frame slot is recorded again
+			std::vector<Scope<Buffer>> countBuffers;
+			std::vector<bool> countsWritten;
+			// triangles that survived culling in the last completed frame
+			uint64_t visibleTriangles = 0;
+		} meshlets;
+
+		// joint matrices of all skinned meshes, packed into the renderer's per-frame palette buffer
+		std::vector<glm::mat4> jointMatrices;
+		// offset of this model's joints in the palette of the frame being recorded
+		uint32_t jointOffset = 0;
+
+		// vertices skinned once per frame by the compute pre-skinning pass, created on first use
+		struct Skinning {
+			bool preSkinned = false;
+			std::vector<Scope<Buffer>> vertexBuffers;
+			std::vector<VkDescriptorSet> descriptorSets;
+			// version of the palette buffer each set was written with
+			std::vector<uint32_t> paletteVersions;
+		} skinning;
+
 		uint32_t animationIndex = 0;
 		float animationTimer = 0.0f;
 
-		std::vector<Ref<Buffer>> uniformBuffers;
-		std::vector<VkDescriptorSet> descriptorSets;
+		// slot of the model uniforms in the UniformArena, uniformEnd covers the mesh slots as well
+		VkDeviceSize uniformOffset = UniformArena::INVALID_OFFSET;
+		VkDeviceSize uniformEnd = 0;
+		// one bit per frame in flight whose copy of the model uniforms or joint palette is out of date
+		uint32_t outdatedUniformFrames = ~0u;
+		uint32_t outdatedJointFrames = ~0u;
 
 		Model();
 		Model(const std::string& filename);
+		// builds the model from a file parsed up front, e.g. on a loader thread
+		Model(const std::string& filename, Ref<tinygltf::Model> parsed);
 		~Model();
 
+		// thread safe, nullptr if the file could not be read
+		static Ref<tinygltf::Model> parseFile(const std::string& filename);
+
 		void loadNode(Node* parent, const tinygltf::Node& node, uint32_t nodeIndex, const tinygltf::Model& model, LoaderInfo& loaderInfo, float globalscale);
+		void generateLods(Primitive& primitive, LoaderInfo& loaderInfo);
+		void setupMeshlets(LoaderInfo& loaderInfo);
+		// transforms and the lod levels selected for the nodes, culling lags one frame behind SelectLods
+		void updateMeshletDraws(uint32_t index, const glm::mat4& modelMatrix);
+		// sums the index counts culling wrote for the frame slot's previous, completed frame
+		void collectVisibleTriangles(uint32_t index);
+		void setupSkinning();
+		void writeSkinningDescriptorSet(uint32_t index, VkDescriptorBufferInfo* jointBuffer, uint32_t paletteVersion);
 		void getNodeProps(const tinygltf::Node& node, const tinygltf::Model& model, size_t& vertexCount, size_t& indexCount);
 		void loadSkins(tinygltf::Model& gltfModel);
 		void loadTextures(tinygltf::Model& gltfModel);
@@ -282,20 +460,26 @@ namespace Nyxis
 		void loadTextureSamplers(tinygltf::Model& gltfModel);
 		void loadMaterials(tinygltf::Model& gltfModel);
 		void loadAnimations(tinygltf::Model& gltfModel);
-		void loadFromFile(std::string filename, float scale = 1.0f);
+		void loadFromFile(std::string filename, float scale = 1.0f, Ref<tinygltf::Model> parsed = nullptr);
 		void bind(VkCommandBuffer commandBuffer);
 		void drawNode(Node* node, VkCommandBuffer commandBuffer);
 		void draw(VkCommandBuffer commandBuffer);
 		void calculateBoundingBox(Node* node, Node* parent);
 		void getSceneDimensions();
 		void updateAnimation(float deltaTime);
-		Node* findNode(Node* parent, uint32_t index);
-		Node* nodeFromIndex(uint32_t index);
+		// copies changed mesh uniform blocks into the buffers of this frame, returns the bytes written
+		VkDeviceSize uploadMeshUniforms(uint32_t frameIndex);
+		Node* nodeFromIndex(uint32_t index) { return hierarchy->find(index); }
 		void updateModelMatrix(TransformComponent& transform);
-		void setupDescriptorSet(SceneInfo& sceneInfo, std::vector<Ref<Buffer>>& shaderValuesBuffer);
-		void setupNodeDescriptorSet(const Node* node);
-		void updateUniformBuffer(uint32_t index, UBOMatrix* ubo);
-		VkDescriptorSet getDescriptorSet(uint32_t index) { return descriptorSets[index]; }
+		// material descriptor sets, model and node uniforms are bound through the renderer's shared sets
+		void setupDescriptorSet(SceneInfo& sceneInfo);
+		void writeMaterialDescriptorSet(Material& material, SceneInfo& sceneInfo);
+		// rewrites the descriptor sets of materials whose textures were swapped by the streamer
+		void updateStreamedTextures(SceneInfo& sceneInfo);
+		void markUniformsOutdated() { outdatedUniformFrames = ~0u; }
+		void markJointsOutdated() { outdatedJointFrames = ~0u; }
+		// writes the model uniforms into the buffer of this frame if it is outdated, returns true if it did
+		bool updateUniformBuffer(uint32_t index, UBOMatrix* ubo);
 	};
 
 	class ModelDescriptorManager
@@ -304,9 +488,12 @@ namespace Nyxis
 		static Ref<DescriptorSetLayout> GetModelDescriptorSetLayout();
 		static Ref<DescriptorSetLayout> GetMaterialDescriptorSetLayout();
 		static Ref<DescriptorSetLayout> GetNodeDescriptorSetLayout();
+		static Ref<DescriptorSetLayout> GetMeshletDescriptorSetLayout();
+		static Ref<DescriptorSetLayout> GetSkinningDescriptorSetLayout();
 	private:
 		friend struct Model;
 		friend class GLTFRenderer;
+		friend class TextureStreamer;
 		static Ref<DescriptorPool> GetDescriptorPool();
 		static void Setup();
 
@@ -314,6 +501,8 @@ namespace Nyxis
 		inline static Ref<DescriptorSetLayout> m_ModelDescriptorSetLayout = nullptr;
 		inline static Ref<DescriptorSetLayout> m_MaterialDescriptorSetLayout = nullptr;
 		inline static Ref<DescriptorSetLayout> m_NodeDescriptorSetLayout = nullptr;
+		inline static Ref<DescriptorSetLayout> m_MeshletDescriptorSetLayout = nullptr;
+		inline static Ref<DescriptorSetLayout> m_SkinningDescriptorSetLayout = nullptr;
 
 		inline static bool m_SetupState = false;
 	};
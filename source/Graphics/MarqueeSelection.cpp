@@ -0,0 +1,269 @@
+#include "Graphics/MarqueeSelection.hpp"
+
+#include "Core/Application.hpp"
+#include "Core/Renderer.hpp"
+#include "Core/ShaderModuleCache.hpp"
+#include "Core/SwapChain.hpp"
+
+namespace Nyxis
+{
+	namespace
+	{
+		struct PushConstants
+		{
+			glm::ivec2 offset;
+			glm::ivec2 extent;
+			uint32_t pointCount;
+			uint32_t tableSize;
+			uint32_t maxIds;
+		};
+	}
+
+	void MarqueeSelection::Init()
+	{
+		auto& device = Device::Get();
+
+		s_DescriptorSetLayout = DescriptorSetLayout::Builder()
+			.addBinding(0, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_COMPUTE_BIT, 1)
+			.addBinding(1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT, 1)
+			.addBinding(2, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT, 1)
+			.addBinding(3, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT, 1)
+			.build();
+
+		s_DescriptorPool = DescriptorPool::Builder()
+			.addPoolSize(VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, SwapChain::MAX_FRAMES_IN_FLIGHT)
+			.addPoolSize(VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 3 * SwapChain::MAX_FRAMES_IN_FLIGHT)
+			.setMaxSets(SwapChain::MAX_FRAMES_IN_FLIGHT)
+			.build();
+
+		// integer ids can only be read unfiltered
+		VkSamplerCreateInfo samplerInfo{};
+		samplerInfo.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+		samplerInfo.magFilter = VK_FILTER_NEAREST;
+		samplerInfo.minFilter = VK_FILTER_NEAREST;
+		samplerInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+		samplerInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+		samplerInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+		samplerInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+		samplerInfo.maxLod = 0.0f;
+		vkCreateSampler(device.device(), &samplerInfo, nullptr, &s_Sampler);
+
+		VkDescriptorSetLayout setLayout = s_DescriptorSetLayout->getDescriptorSetLayout();
+		VkPushConstantRange pushConstantRange{};
+		pushConstantRange.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+		pushConstantRange.size = sizeof(PushConstants);
+
+		VkPipelineLayoutCreateInfo pipelineLayoutCI{};
+		pipelineLayoutCI.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+		pipelineLayoutCI.setLayoutCount = 1;
+		pipelineLayoutCI.pSetLayouts = &setLayout;
+		pipelineLayoutCI.pushConstantRangeCount = 1;
+		pipelineLayoutCI.pPushConstantRanges = &pushConstantRange;
+		vkCreatePipelineLayout(device.device(), &pipelineLayoutCI, nullptr, &s_PipelineLayout);
+
+		// the SPIR-V is produced by the build, without it the editor keeps working with click selection only
+		const std::string shaderPath = "../shaders/pbr/marquee_select.comp.spv";
+		if (std::filesystem::exists(shaderPath))
+		{
+			VkComputePipelineCreateInfo pipelineCI{};
+			pipelineCI.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+			pipelineCI.layout = s_PipelineLayout;
+			pipelineCI.stage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+			pipelineCI.stage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+			pipelineCI.stage.pName = "main";
+			pipelineCI.stage.module = ShaderModuleCache::Acquire(shaderPath).module;
+			if (vkCreateComputePipelines(device.device(), device.pipelineCache(), 1, &pipelineCI, nullptr, &s_Pipeline) != VK_SUCCESS)
+				s_Pipeline = VK_NULL_HANDLE;
+			ShaderModuleCache::Release(pipelineCI.stage.module);
+		}
+		if (s_Pipeline == VK_NULL_HANDLE)
+			LOG_ERROR("[Renderer] Failed to create the marquee selection pipeline from {}, marquee selection is disabled", shaderPath);
+
+		s_Readbacks.resize(SwapChain::MAX_FRAMES_IN_FLIGHT);
+		for (auto& readback : s_Readbacks)
+		{
+			readback.lasso = std::make_unique<Buffer>(MAX_LASSO_POINTS * sizeof(glm::vec2), 1, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+				VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+			readback.lasso->map();
+			readback.table = std::make_unique<Buffer>(TABLE_SIZE * sizeof(uint32_t), 1, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+				VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+			readback.result = std::make_unique<Buffer>((MAX_IDS + 1) * sizeof(uint32_t), 1, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+				VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+			readback.result->map();
+		}
+	}
+
+	void MarqueeSelection::Shutdown()
+	{
+		auto& device = Device::Get();
+		s_Readbacks.clear();
+		s_Slot = 0;
+		s_DescriptorPool.reset();
+		s_DescriptorSetLayout.reset();
+		vkDestroyPipeline(device.device(), s_Pipeline, nullptr);
+		vkDestroyPipelineLayout(device.device(), s_PipelineLayout, nullptr);
+		vkDestroySampler(device.device(), s_Sampler, nullptr);
+		s_Pipeline = VK_NULL_HANDLE;
+		s_PipelineLayout = VK_NULL_HANDLE;
+		s_Sampler = VK_NULL_HANDLE;
+	}
+
+	void MarqueeSelection::Request(const std::vector<glm::vec2>& points)
+	{
+		if (points.size() < 2)
+			return;
+
+		s_Request.clear();
+		if (points.size() <= MAX_LASSO_POINTS)
+			s_Request = points;
+		else
+		{
+			// long lassos are thinned out evenly, the outline stays closed
+			const float step = static_cast<float>(points.size()) / MAX_LASSO_POINTS;
+			for (uint32_t i = 0; i < MAX_LASSO_POINTS; i++)
+				s_Request.push_back(points[static_cast<size_t>(i * step)]);
+		}
+		s_Requested = true;
+	}
+
+	void MarqueeSelection::Record(VkCommandBuffer commandBuffer)
+	{
+		if (!s_Requested)
+			return;
+		if (s_Pipeline == VK_NULL_HANDLE)
+		{
+			s_Requested = false;
+			return;
+		}
+
+		// a slot still in flight is only reused once its frame completed, the request waits for a later frame otherwise
+		auto& readback = s_Readbacks[s_Slot];
+		if (readback.pending)
+		{
+			if (!Renderer::IsFrameComplete(readback.fence, readback.swapChainVersion))
+				return;
+			Resolve(readback);
+		}
+		s_Requested = false;
+		s_Slot = (s_Slot + 1) % static_cast<uint32_t>(s_Readbacks.size());
+
+		const auto extent = Renderer::GetWorldExtent();
+		glm::vec2 lower = s_Request.front();
+		glm::vec2 upper = s_Request.front();
+		for (const auto& point : s_Request)
+		{
+			lower = glm::min(lower, point);
+			upper = glm::max(upper, point);
+		}
+		const glm::ivec2 offset = glm::clamp(glm::ivec2(glm::floor(lower)), glm::ivec2(0), glm::ivec2(extent.width, extent.height));
+		const glm::ivec2 end = glm::clamp(glm::ivec2(glm::ceil(upper)), glm::ivec2(0), glm::ivec2(extent.width, extent.height));
+
+		PushConstants constants{};
+		constants.offset = offset;
+		constants.extent = end - offset;
+		constants.pointCount = s_Request.size() > 2 ? static_cast<uint32_t>(s_Request.size()) : 0;
+		constants.tableSize = TABLE_SIZE;
+		constants.maxIds = MAX_IDS;
+		if (constants.extent.x <= 0 || constants.extent.y <= 0)
+			return;
+
+		if (constants.pointCount > 0)
+			readback.lasso->writeToBuffer(s_Request.data(), constants.pointCount * sizeof(glm::vec2));
+
+		VkDescriptorImageInfo idImage{ s_Sampler, Renderer::GetIDImageView(), VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL };
+		DescriptorWriter writer(s_DescriptorSetLayout, s_DescriptorPool);
+		writer.writeImage(0, &idImage)
+			.writeBuffer(1, readback.lasso->getDescriptorInfo())
+			.writeBuffer(2, readback.table->getDescriptorInfo())
+			.writeBuffer(3, readback.result->getDescriptorInfo());
+		if (readback.descriptorSet == VK_NULL_HANDLE)
+			writer.build(readback.descriptorSet);
+		else
+			writer.overwrite(readback.descriptorSet);
+
+		vkCmdFillBuffer(commandBuffer, readback.table->getBuffer(), 0, VK_WHOLE_SIZE, 0);
+		vkCmdFillBuffer(commandBuffer, readback.result->getBuffer(), 0, sizeof(uint32_t), 0);
+
+		std::array<VkBufferMemoryBarrier, 2> clearBarriers{};
+		for (auto& barrier : clearBarriers)
+		{
+			barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+			barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+			barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+			barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+			barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+			barrier.size = VK_WHOLE_SIZE;
+		}
+		clearBarriers[0].buffer = readback.table->getBuffer();
+		clearBarriers[1].buffer = readback.result->getBuffer();
+
+		// the id attachment stays in the layout the render pass left it in
+		VkImageMemoryBarrier imageBarrier{};
+		imageBarrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+		imageBarrier.srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+		imageBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+		imageBarrier.oldLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+		imageBarrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+		imageBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		imageBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		imageBarrier.image = Renderer::GetIDImage();
+		imageBarrier.subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1 };
+
+		vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT | VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+			0, 0, nullptr, static_cast<uint32_t>(clearBarriers.size()), clearBarriers.data(), 1, &imageBarrier);
+
+		vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, s_Pipeline);
+		vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, s_PipelineLayout, 0, 1, &readback.descriptorSet, 0, nullptr);
+		vkCmdPushConstants(commandBuffer, s_PipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(PushConstants), &constants);
+		vkCmdDispatch(commandBuffer, (constants.extent.x + 15) / 16, (constants.extent.y + 15) / 16, 1);
+
+		VkBufferMemoryBarrier hostBarrier = clearBarriers[1];
+		hostBarrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+		hostBarrier.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+		vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_HOST_BIT,
+			0, 0, nullptr, 1, &hostBarrier, 0, nullptr);
+
+		readback.fence = Renderer::GetFrameFence();
+		readback.swapChainVersion = Renderer::GetSwapChainVersion();
+		readback.request = ++s_RequestCount;
+		readback.pending = true;
+	}
+
+	void MarqueeSelection::Poll()
+	{
+		for (auto& readback : s_Readbacks)
+		{
+			if (readback.pending && Renderer::IsFrameComplete(readback.fence, readback.swapChainVersion))
+				Resolve(readback);
+		}
+	}
+
+	void MarqueeSelection::Resolve(Readback& readback)
+	{
+		readback.pending = false;
+		if (readback.request < s_DeliveredRequest)
+			return;
+		s_DeliveredRequest = readback.request;
+
+		const auto* result = static_cast<const uint32_t*>(readback.result->getMappedMemory());
+		const uint32_t count = result[0];
+		if (count > MAX_IDS)
+			LOG_WARN("[Renderer] Marquee selection found {} objects, only the first {} are selected", count, MAX_IDS);
+
+		// ids of entities destroyed since the frame was rendered are dropped
+		auto scene = Application::GetScene();
+		std::vector<Entity> entities;
+		entities.reserve(std::min(count, MAX_IDS));
+		for (uint32_t i = 0; i < std::min(count, MAX_IDS); i++)
+		{
+			const auto entity = static_cast<Entity>(result[1 + i]);
+			if (scene->m_Registry.valid(entity))
+				entities.push_back(entity);
+		}
+
+		if (entities.empty())
+			EditorLayer::DeselectEntity();
+		else
+			EditorLayer::SetSelectedEntities(entities);
+	}
+}
@@ -0,0 +1,61 @@
+#pragma once
+#include "Core/Nyxispch.hpp"
+#include "Core/Device.hpp"
+#include "Core/Buffer.hpp"
+#include "Core/Descriptors.hpp"
+
+namespace Nyxis
+{
+	// Rectangle and lasso selection over the id attachment. A compute pass reduces the region to the unique
+	// entity ids inside it, only that short list is read back. Results are delivered to the EditorLayer once
+	// the frame that recorded the pass completed, nothing waits on the GPU.
+	class MarqueeSelection
+	{
+	public:
+		static constexpr uint32_t MAX_IDS = 1024;
+		static constexpr uint32_t MAX_LASSO_POINTS = 256;
+
+		static void Init();
+		static void Shutdown();
+
+		// points are in id image pixels, two points span a rectangle, more form a lasso polygon
+		static void Request(const std::vector<glm::vec2>& points);
+		// records the reduction for the current id image, called after the main render pass ended
+		static void Record(VkCommandBuffer commandBuffer);
+		// delivers the selections of completed frames
+		static void Poll();
+
+	private:
+		// hash set of the ids already appended, cleared before every pass
+		static constexpr uint32_t TABLE_SIZE = 4096;
+
+		struct Readback
+		{
+			Scope<Buffer> lasso;
+			Scope<Buffer> table;
+			Scope<Buffer> result;
+			VkDescriptorSet descriptorSet = VK_NULL_HANDLE;
+			VkFence fence = VK_NULL_HANDLE;
+			uint32_t swapChainVersion = 0;
+			bool pending = false;
+			uint64_t request = 0;
+		};
+
+		static void Resolve(Readback& readback);
+
+		static inline std::vector<Readback> s_Readbacks{};
+		// next readback slot, used round robin like the picking readbacks
+		static inline uint32_t s_Slot = 0;
+		static inline std::vector<glm::vec2> s_Request{};
+		static inline bool s_Requested = false;
+		static inline uint64_t s_RequestCount = 0;
+		// results of older requests completing late never override newer ones
+		static inline uint64_t s_DeliveredRequest = 0;
+
+		static inline Ref<DescriptorPool> s_DescriptorPool = nullptr;
+		static inline Ref<DescriptorSetLayout> s_DescriptorSetLayout = nullptr;
+		static inline VkPipelineLayout s_PipelineLayout = VK_NULL_HANDLE;
+		static inline VkPipeline s_Pipeline = VK_NULL_HANDLE;
+		static inline VkSampler s_Sampler = VK_NULL_HANDLE;
+	};
+}
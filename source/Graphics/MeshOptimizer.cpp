@@ -0,0 +1,590 @@
+#include "Graphics/MeshOptimizer.hpp"
+
+namespace Nyxis
+{
+	MeshOptimizer::Statistics MeshOptimizer::AnalyzeVertexCache(const uint32_t* indices, size_t indexCount, size_t vertexCount, uint32_t cacheSize)
+	{
+		Statistics stats;
+		stats.triangleCount = indexCount / 3;
+		stats.vertexCount = vertexCount;
+
+		// FIFO cache simulation; a vertex is resident while fewer than cacheSize misses happened since it was loaded
+		std::vector<uint32_t> cacheTimestamps(vertexCount, 0);
+		uint32_t timestamp = cacheSize + 1;
+
+		for (size_t i = 0; i < indexCount; i++)
+		{
+			const uint32_t index = indices[i];
+			if (timestamp - cacheTimestamps[index] > cacheSize)
+			{
+				cacheTimestamps[index] = timestamp++;
+				stats.cacheMisses++;
+			}
+		}
+
+		return stats;
+	}
+
+	void MeshOptimizer::OptimizeVertexCache(uint32_t* indices, size_t indexCount, size_t vertexCount, uint32_t cacheSize)
+	{
+		const size_t triangleCount = indexCount / 3;
+		if (triangleCount == 0 || vertexCount == 0)
+			return;
+
+		// vertex -> triangle adjacency
+		std::vector<uint32_t> liveTriangles(vertexCount, 0);
+		for (size_t i = 0; i < indexCount; i++)
+			liveTriangles[indices[i]]++;
+
+		std::vector<uint32_t> adjacencyOffsets(vertexCount + 1, 0);
+		for (size_t v = 0; v < vertexCount; v++)
+			adjacencyOffsets[v + 1] = adjacencyOffsets[v] + liveTriangles[v];
+
+		std::vector<uint32_t> adjacency(indexCount);
+		{
+			std::vector<uint32_t> fill(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+			for (size_t i = 0; i < indexCount; i++)
+				adjacency[fill[indices[i]]++] = static_cast<uint32_t>(i / 3);
+		}
+
+		std::vector<uint32_t> cacheTimestamps(vertexCount, 0);
+		uint32_t timestamp = cacheSize + 1;
+
+		std::vector<bool> emitted(triangleCount, false);
+		std::vector<uint32_t> deadEnd;
+		std::vector<uint32_t> candidates;
+		std::vector<uint32_t> result;
+		result.reserve(indexCount);
+		deadEnd.reserve(indexCount);
+
+		constexpr uint32_t none = ~0u;
+		uint32_t fanning = indices[0];
+		uint32_t inputCursor = 0;
+
+		while (fanning != none)
+		{
+			candidates.clear();
+
+			// emit all live triangles around the fanning vertex
+			for (uint32_t a = adjacencyOffsets[fanning]; a < adjacencyOffsets[fanning + 1]; a++)
+			{
+				const uint32_t triangle = adjacency[a];
+				if (emitted[triangle])
+					continue;
+
+				for (uint32_t k = 0; k < 3; k++)
+				{
+					const uint32_t v = indices[triangle * 3 + k];
+					result.push_back(v);
+					deadEnd.push_back(v);
+					candidates.push_back(v);
+					liveTriangles[v]--;
+
+					if (timestamp - cacheTimestamps[v] > cacheSize)
+						cacheTimestamps[v] = timestamp++;
+				}
+				emitted[triangle] = true;
+			}
+
+			// pick the candidate that will still be in the cache after its remaining triangles are emitted,
+			// preferring the oldest one so it is used before it gets evicted
+			uint32_t best = none;
+			int bestPriority = -1;
+			for (const uint32_t v : candidates)
+			{
+				if (liveTriangles[v] == 0)
+					continue;
+
+				int priority = 0;
+				if (timestamp - cacheTimestamps[v] + 2 * liveTriangles[v] <= cacheSize)
+					priority = static_cast<int>(timestamp - cacheTimestamps[v]);
+
+				if (priority > bestPriority)
+				{
+					bestPriority = priority;
+					best = v;
+				}
+			}
+
+			// dead end: fall back to recently used vertices, then to input order
+			while (best == none && !deadEnd.empty())
+			{
+				const uint32_t v = deadEnd.back();
+				deadEnd.pop_back();
+				if (liveTriangles[v] > 0)
+					best = v;
+			}
+
+			while (best == none && inputCursor < vertexCount)
+			{
+				if (liveTriangles[inputCursor] > 0)
+					best = inputCursor;
+				inputCursor++;
+			}
+
+			fanning = best;
+		}
+
+		assert(result.size() == triangleCount * 3);
+		std::copy(result.begin(), result.end(), indices);
+	}
+
+	void MeshOptimizer::OptimizeOverdraw(uint32_t* indices, size_t indexCount, const float* positions, size_t positionStride,
+		size_t vertexCount, float threshold, uint32_t cacheSize)
+	{
+		const size_t triangleCount = indexCount / 3;
+		if (triangleCount < 2 || vertexCount == 0)
+			return;
+
+		auto position = [&](uint32_t index) {
+			const float* p = reinterpret_cast<const float*>(reinterpret_cast<const uint8_t*>(positions) + index * positionStride);
+			return glm::vec3(p[0], p[1], p[2]);
+		};
+
+		const float meshAcmr = AnalyzeVertexCache(indices, indexCount, vertexCount, cacheSize).acmr();
+
+		// soft cluster boundaries: start a new cluster as soon as the current one is cache efficient enough,
+		// so that reordering clusters costs at most `threshold` in vertex cache efficiency
+		std::vector<uint32_t> clusters{ 0 };
+		{
+			std::vector<uint32_t> cacheTimestamps(vertexCount, 0);
+			uint32_t timestamp = cacheSize + 1;
+			size_t clusterMisses = 0;
+			size_t clusterTriangles = 0;
+
+			for (size_t t = 0; t < triangleCount; t++)
+			{
+				for (uint32_t k = 0; k < 3; k++)
+				{
+					const uint32_t v = indices[t * 3 + k];
+					if (timestamp - cacheTimestamps[v] > cacheSize)
+					{
+						cacheTimestamps[v] = timestamp++;
+						clusterMisses++;
+					}
+				}
+				clusterTriangles++;
+
+				if (t + 1 < triangleCount && static_cast<float>(clusterMisses) / clusterTriangles <= meshAcmr * threshold)
+				{
+					clusters.push_back(static_cast<uint32_t>(t + 1));
+					// the next cluster may be drawn after any other one, so it starts with a cold cache
+					timestamp += cacheSize + 1;
+					clusterMisses = 0;
+					clusterTriangles = 0;
+				}
+			}
+		}
+
+		if (clusters.size() < 2)
+			return;
+
+		glm::vec3 meshCentroid(0.0f);
+		for (size_t i = 0; i < indexCount; i++)
+			meshCentroid += position(indices[i]);
+		meshCentroid /= static_cast<float>(indexCount);
+
+		// clusters that face away from the centroid are likely to occlude the rest of the mesh, draw them first
+		std::vector<float> sortKeys(clusters.size());
+		for (size_t c = 0; c < clusters.size(); c++)
+		{
+			const size_t begin = clusters[c];
+			const size_t end = c + 1 < clusters.size() ? clusters[c + 1] : triangleCount;
+
+			glm::vec3 centroid(0.0f);
+			glm::vec3 normal(0.0f);
+			float area = 0.0f;
+
+			for (size_t t = begin; t < end; t++)
+			{
+				const glm::vec3 p0 = position(indices[t * 3 + 0]);
+				const glm::vec3 p1 = position(indices[t * 3 + 1]);
+				const glm::vec3 p2 = position(indices[t * 3 + 2]);
+
+				const glm::vec3 n = glm::cross(p1 - p0, p2 - p0);
+				const float a = glm::length(n);
+
+				centroid += (p0 + p1 + p2) * (a / 3.0f);
+				normal += n;
+				area += a;
+			}
+
+			if (area > 0.0f)
+				centroid /= area;
+
+			const float normalLength = glm::length(normal);
+			sortKeys[c] = normalLength > 0.0f ? glm::dot(centroid - meshCentroid, normal / normalLength) : 0.0f;
+		}
+
+		std::vector<uint32_t> order(clusters.size());
+		std::iota(order.begin(), order.end(), 0);
+		std::stable_sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) { return sortKeys[a] > sortKeys[b]; });
+
+		std::vector<uint32_t> result;
+		result.reserve(indexCount);
+		for (const uint32_t c : order)
+		{
+			const size_t begin = clusters[c];
+			const size_t end = c + 1 < clusters.size() ? clusters[c + 1] : triangleCount;
+			result.insert(result.end(), indices + begin * 3, indices + end * 3);
+		}
+
+		std::copy(result.begin(), result.end(), indices);
+	}
+
+	namespace
+	{
+		// symmetric 4x4 plane quadric, stored as the upper triangle of A, b and c
+		struct Quadric
+		{
+			float a00 = 0, a11 = 0, a22 = 0, a01 = 0, a02 = 0, a12 = 0;
+			float b0 = 0, b1 = 0, b2 = 0;
+			float c = 0;
+			float weight = 0;
+
+			void addPlane(const glm::vec3& n, float d, float w)
+			{
+				a00 += w * n.x * n.x; a11 += w * n.y * n.y; a22 += w * n.z * n.z;
+				a01 += w * n.x * n.y; a02 += w * n.x * n.z; a12 += w * n.y * n.z;
+				b0 += w * n.x * d; b1 += w * n.y * d; b2 += w * n.z * d;
+				c += w * d * d;
+				weight += w;
+			}
+
+			Quadric& operator+=(const Quadric& q)
+			{
+				a00 += q.a00; a11 += q.a11; a22 += q.a22;
+				a01 += q.a01; a02 += q.a02; a12 += q.a12;
+				b0 += q.b0; b1 += q.b1; b2 += q.b2;
+				c += q.c;
+				weight += q.weight;
+				return *this;
+			}
+
+			// squared distance to the accumulated planes, area weighted
+			float error(const glm::vec3& v) const
+			{
+				const float rx = a00 * v.x + a01 * v.y + a02 * v.z;
+				const float ry = a01 * v.x + a11 * v.y + a12 * v.z;
+				const float rz = a02 * v.x + a12 * v.y + a22 * v.z;
+				const float e = v.x * rx + v.y * ry + v.z * rz + 2.0f * (v.x * b0 + v.y * b1 + v.z * b2) + c;
+				return weight > 0.0f ? std::max(e, 0.0f) / weight : 0.0f;
+			}
+		};
+
+		struct Collapse
+		{
+			uint32_t from;
+			uint32_t to;
+			float error;
+			// version of the source vertex the error was computed with
+			uint32_t version;
+		};
+	}
+
+	std::vector<uint32_t> MeshOptimizer::Simplify(const uint32_t* indices, size_t indexCount, const float* positions, size_t positionStride,
+		size_t vertexCount, size_t targetIndexCount, float targetError, float* resultError)
+	{
+		std::vector<uint32_t> result(indices, indices + indexCount);
+		if (resultError)
+			*resultError = 0.0f;
+		if (indexCount % 3 != 0 || targetIndexCount >= indexCount || vertexCount == 0)
+			return result;
+
+		auto position = [&](uint32_t index) {
+			const float* p = reinterpret_cast<const float*>(reinterpret_cast<const uint8_t*>(positions) + index * positionStride);
+			return glm::vec3(p[0], p[1], p[2]);
+		};
+
+		// vertices sharing a position with another vertex sit on an attribute seam
+		std::vector<bool> locked(vertexCount, false);
+		{
+			std::unordered_map<glm::vec3, uint32_t> firstWithPosition;
+			firstWithPosition.reserve(vertexCount);
+			for (uint32_t v = 0; v < vertexCount; v++)
+			{
+				auto [it, inserted] = firstWithPosition.try_emplace(position(v), v);
+				if (!inserted)
+					locked[v] = locked[it->second] = true;
+			}
+		}
+
+		// border vertices: an edge that is used by exactly one triangle
+		{
+			std::unordered_map<uint64_t, uint32_t> edgeUse;
+			edgeUse.reserve(indexCount);
+			auto edgeKey = [](uint32_t a, uint32_t b) { return (uint64_t(std::min(a, b)) << 32) | std::max(a, b); };
+			for (size_t i = 0; i < indexCount; i += 3)
+				for (uint32_t k = 0; k < 3; k++)
+					edgeUse[edgeKey(indices[i + k], indices[i + (k + 1) % 3])]++;
+
+			for (const auto& [key, count] : edgeUse)
+			{
+				if (count == 1)
+				{
+					locked[static_cast<uint32_t>(key >> 32)] = true;
+					locked[static_cast<uint32_t>(key & 0xffffffff)] = true;
+				}
+			}
+		}
+
+		std::vector<Quadric> quadrics(vertexCount);
+		for (size_t i = 0; i < indexCount; i += 3)
+		{
+			const glm::vec3 p0 = position(indices[i + 0]);
+			const glm::vec3 p1 = position(indices[i + 1]);
+			const glm::vec3 p2 = position(indices[i + 2]);
+
+			glm::vec3 n = glm::cross(p1 - p0, p2 - p0);
+			const float area = glm::length(n);
+			if (area <= 0.0f)
+				continue;
+			n /= area;
+
+			for (uint32_t k = 0; k < 3; k++)
+				quadrics[indices[i + k]].addPlane(n, -glm::dot(n, p0), area);
+		}
+
+		const float maxError = targetError * targetError;
+		float reachedError = 0.0f;
+
+		// vertex -> triangle adjacency, a collapse hands the triangles of the source vertex to the target
+		std::vector<std::vector<uint32_t>> adjacency(vertexCount);
+		for (size_t i = 0; i < indexCount; i++)
+			adjacency[indices[i]].push_back(static_cast<uint32_t>(i / 3));
+		std::vector<bool> removedTriangles(indexCount / 3, false);
+		std::vector<bool> collapsed(vertexCount, false);
+		// bumped when the quadric of a vertex grows, queued collapses out of it carry an outdated cost then
+		std::vector<uint32_t> versions(vertexCount, 0);
+		// per collapse marks, neighbours are requeued once and only the new ones need a collapse onto the target
+		std::vector<uint32_t> targetNeighbours(vertexCount, 0);
+		std::vector<uint32_t> requeued(vertexCount, 0);
+		uint32_t stamp = 0;
+
+		// cheapest collapse on top; entries are never updated in place, outdated ones are skipped when they surface
+		auto cheaper = [](const Collapse& l, const Collapse& r) { return l.error > r.error; };
+		std::priority_queue<Collapse, std::vector<Collapse>, decltype(cheaper)> queue(cheaper);
+		auto push = [&](uint32_t from, uint32_t to) {
+			if (!locked[from])
+				queue.push({ from, to, quadrics[from].error(position(to)), versions[from] });
+		};
+		for (size_t i = 0; i < indexCount; i += 3)
+		{
+			for (uint32_t k = 0; k < 3; k++)
+			{
+				const uint32_t a = indices[i + k];
+				const uint32_t b = indices[i + (k + 1) % 3];
+				push(a, b);
+				push(b, a);
+			}
+		}
+
+		size_t triangleCount = indexCount / 3;
+		while (triangleCount * 3 > targetIndexCount && !queue.empty())
+		{
+			const Collapse collapse = queue.top();
+			if (collapse.error > maxError)
+				break;
+			queue.pop();
+			if (collapsed[collapse.from] || collapsed[collapse.to] || collapse.version != versions[collapse.from])
+				continue;
+
+			// reject collapses that flip or degenerate any remaining triangle around the source vertex,
+			// and edges that only existed in triangles removed since the entry was queued
+			const glm::vec3 target = position(collapse.to);
+			bool valid = true;
+			size_t shared = 0;
+			for (const uint32_t t : adjacency[collapse.from])
+			{
+				if (removedTriangles[t])
+					continue;
+				const uint32_t* tri = &result[t * 3];
+				if (tri[0] == collapse.to || tri[1] == collapse.to || tri[2] == collapse.to)
+				{
+					shared++;
+					continue;
+				}
+
+				const glm::vec3 p0 = position(tri[0]);
+				const glm::vec3 p1 = position(tri[1]);
+				const glm::vec3 p2 = position(tri[2]);
+				const glm::vec3 before = glm::cross(p1 - p0, p2 - p0);
+				const glm::vec3 q0 = tri[0] == collapse.from ? target : p0;
+				const glm::vec3 q1 = tri[1] == collapse.from ? target : p1;
+				const glm::vec3 q2 = tri[2] == collapse.from ? target : p2;
+				const glm::vec3 after = glm::cross(q1 - q0, q2 - q0);
+
+				valid = glm::dot(before, after) > 0.0f;
+				if (!valid)
+					break;
+			}
+			if (!valid || shared == 0)
+				continue;
+
+			auto& around = adjacency[collapse.to];
+			stamp++;
+			for (const uint32_t t : around)
+			{
+				if (removedTriangles[t])
+					continue;
+				for (uint32_t k = 0; k < 3; k++)
+					targetNeighbours[result[t * 3 + k]] = stamp;
+			}
+
+			for (const uint32_t t : adjacency[collapse.from])
+			{
+				if (removedTriangles[t])
+					continue;
+				uint32_t* tri = &result[t * 3];
+				if (tri[0] == collapse.to || tri[1] == collapse.to || tri[2] == collapse.to)
+				{
+					removedTriangles[t] = true;
+					triangleCount--;
+					continue;
+				}
+				for (uint32_t k = 0; k < 3; k++)
+				{
+					if (tri[k] == collapse.from)
+						tri[k] = collapse.to;
+				}
+				around.push_back(t);
+			}
+			adjacency[collapse.from] = {};
+			collapsed[collapse.from] = true;
+			quadrics[collapse.to] += quadrics[collapse.from];
+			versions[collapse.to]++;
+			reachedError = std::max(reachedError, collapse.error);
+
+			// the target's own costs grew and the former neighbours of the source gained edges to it
+			around.erase(std::remove_if(around.begin(), around.end(), [&](uint32_t t) { return removedTriangles[t]; }), around.end());
+			for (const uint32_t t : around)
+			{
+				for (uint32_t k = 0; k < 3; k++)
+				{
+					const uint32_t neighbour = result[t * 3 + k];
+					if (neighbour == collapse.to || requeued[neighbour] == stamp)
+						continue;
+					requeued[neighbour] = stamp;
+					push(collapse.to, neighbour);
+					if (targetNeighbours[neighbour] != stamp)
+						push(neighbour, collapse.to);
+				}
+			}
+		}
+
+		size_t write = 0;
+		for (size_t t = 0; t < removedTriangles.size(); t++)
+		{
+			if (removedTriangles[t])
+				continue;
+			result[write++] = result[t * 3 + 0];
+			result[write++] = result[t * 3 + 1];
+			result[write++] = result[t * 3 + 2];
+		}
+		result.resize(write);
+
+		if (resultError)
+			*resultError = std::sqrt(reachedError);
+		return result;
+	}
+
+	void MeshOptimizer::BuildMeshlets(const uint32_t* indices, size_t indexCount, const float* positions, size_t positionStride, size_t vertexCount,
+		std::vector<Meshlet>& meshlets, std::vector<uint32_t>& meshletVertices, std::vector<uint32_t>& meshletTriangles)
+	{
+		auto position = [&](uint32_t index) {
+			const float* p = reinterpret_cast<const float*>(reinterpret_cast<const uint8_t*>(positions) + index * positionStride);
+			return glm::vec3(p[0], p[1], p[2]);
+		};
+
+		auto computeBounds = [&](Meshlet& meshlet) {
+			glm::vec3 min(std::numeric_limits<float>::max());
+			glm::vec3 max(std::numeric_limits<float>::lowest());
+			for (uint32_t v = 0; v < meshlet.vertexCount; v++) {
+				const glm::vec3 p = position(meshletVertices[meshlet.vertexOffset + v]);
+				min = glm::min(min, p);
+				max = glm::max(max, p);
+			}
+			meshlet.center = (min + max) * 0.5f;
+			meshlet.radius = 0.0f;
+			for (uint32_t v = 0; v < meshlet.vertexCount; v++)
+				meshlet.radius = std::max(meshlet.radius, glm::length(position(meshletVertices[meshlet.vertexOffset + v]) - meshlet.center));
+
+			std::vector<glm::vec3> normals;
+			normals.reserve(meshlet.triangleCount);
+			glm::vec3 axis(0.0f);
+			for (uint32_t t = 0; t < meshlet.triangleCount; t++) {
+				const uint32_t packed = meshletTriangles[meshlet.triangleOffset + t];
+				const glm::vec3 p0 = position(meshletVertices[meshlet.vertexOffset + (packed & 0xff)]);
+				const glm::vec3 p1 = position(meshletVertices[meshlet.vertexOffset + ((packed >> 8) & 0xff)]);
+				const glm::vec3 p2 = position(meshletVertices[meshlet.vertexOffset + ((packed >> 16) & 0xff)]);
+				const glm::vec3 n = glm::cross(p1 - p0, p2 - p0);
+				const float length = glm::length(n);
+				if (length > 0.0f) {
+					normals.push_back(n / length);
+					axis += n / length;
+				}
+			}
+
+			// a cutoff of 1 never culls; used when the normals spread too wide for a useful cone
+			meshlet.coneAxis = glm::vec3(0.0f, 0.0f, 1.0f);
+			meshlet.coneCutoff = 1.0f;
+			const float axisLength = glm::length(axis);
+			if (axisLength <= 0.0f)
+				return;
+
+			axis /= axisLength;
+			float minDot = 1.0f;
+			for (const auto& n : normals)
+				minDot = std::min(minDot, glm::dot(axis, n));
+
+			meshlet.coneAxis = axis;
+			if (minDot > 0.1f)
+				meshlet.coneCutoff = std::sqrt(1.0f - minDot * minDot);
+		};
+
+		constexpr uint8_t unused = 0xff;
+		std::vector<uint8_t> localIndex(vertexCount, unused);
+
+		Meshlet current{};
+		current.vertexOffset = static_cast<uint32_t>(meshletVertices.size());
+		current.triangleOffset = static_cast<uint32_t>(meshletTriangles.size());
+
+		auto flush = [&]() {
+			if (current.triangleCount == 0)
+				return;
+			for (uint32_t v = 0; v < current.vertexCount; v++)
+				localIndex[meshletVertices[current.vertexOffset + v]] = unused;
+			computeBounds(current);
+			meshlets.push_back(current);
+
+			current = {};
+			current.vertexOffset = static_cast<uint32_t>(meshletVertices.size());
+			current.triangleOffset = static_cast<uint32_t>(meshletTriangles.size());
+		};
+
+		for (size_t i = 0; i + 2 < indexCount; i += 3)
+		{
+			uint32_t newVertices = 0;
+			for (uint32_t k = 0; k < 3; k++)
+				newVertices += localIndex[indices[i + k]] == unused;
+
+			if (current.vertexCount + newVertices > MESHLET_MAX_VERTICES || current.triangleCount + 1 > MESHLET_MAX_TRIANGLES)
+				flush();
+
+			uint32_t packed = 0;
+			for (uint32_t k = 0; k < 3; k++)
+			{
+				uint8_t& local = localIndex[indices[i + k]];
+				if (local == unused)
+				{
+					local = static_cast<uint8_t>(current.vertexCount++);
+					meshletVertices.push_back(indices[i + k]);
+				}
+				packed |= uint32_t(local) << (8 * k);
+			}
+			meshletTriangles.push_back(packed);
+			current.triangleCount++;
+		}
+		flush();
+	}
+}
@@ -0,0 +1,178 @@
+#pragma once
+#include "Core/Nyxispch.hpp"
+
+namespace Nyxis
+{
+	// Import-time triangle list optimizations. All index buffers passed in here are local to the mesh
+	// (0 .. vertexCount - 1) and are rewritten in place.
+	class MeshOptimizer
+	{
+	public:
+		// post-transform cache size used both for optimization and for the FIFO analysis
+		static constexpr uint32_t CACHE_SIZE = 16;
+		// meshlet limits, 124 triangles keep the packed triangle data of a meshlet under 512 bytes
+		static constexpr uint32_t MESHLET_MAX_VERTICES = 64;
+		static constexpr uint32_t MESHLET_MAX_TRIANGLES = 124;
+
+		struct Statistics
+		{
+			size_t cacheMisses = 0;
+			size_t triangleCount = 0;
+			size_t vertexCount = 0;
+
+			// average cache miss ratio: transformed vertices per triangle (0.5 is optimal, 3.0 is worst)
+			float acmr() const { return triangleCount ? static_cast<float>(cacheMisses) / triangleCount : 0.0f; }
+			// average transform to vertex ratio: transformed vertices per vertex (1.0 is optimal)
+			float atvr() const { return vertexCount ? static_cast<float>(cacheMisses) / vertexCount : 0.0f; }
+
+			Statistics& operator+=(const Statistics& other)
+			{
+				cacheMisses += other.cacheMisses;
+				triangleCount += other.triangleCount;
+				vertexCount += other.vertexCount;
+				return *this;
+			}
+		};
+
+		struct Meshlet
+		{
+			uint32_t vertexOffset;   // into meshletVertices
+			uint32_t triangleOffset; // into meshletTriangles
+			uint32_t vertexCount;
+			uint32_t triangleCount;
+			// bounding sphere
+			glm::vec3 center;
+			float radius;
+			// normal cone, the meshlet is backfacing if dot(center - camera, coneAxis) >= coneCutoff * |center - camera| + radius
+			glm::vec3 coneAxis;
+			float coneCutoff;
+		};
+
+		struct Result
+		{
+			size_t vertexCount = 0;
+			Statistics before;
+			Statistics after;
+		};
+
+		static Statistics AnalyzeVertexCache(const uint32_t* indices, size_t indexCount, size_t vertexCount, uint32_t cacheSize = CACHE_SIZE);
+
+		// Tipsify (Sander et al. 2007): fans around the most recently used vertex that still has live triangles
+		static void OptimizeVertexCache(uint32_t* indices, size_t indexCount, size_t vertexCount, uint32_t cacheSize = CACHE_SIZE);
+
+		// splits the cache optimized list into clusters whose ACMR stays within threshold of the whole mesh
+		// and sorts them front-to-back by how far they face outwards from the mesh centroid
+		static void OptimizeOverdraw(uint32_t* indices, size_t indexCount, const float* positions, size_t positionStride,
+			size_t vertexCount, float threshold = 1.05f, uint32_t cacheSize = CACHE_SIZE);
+
+		// quadric error metric edge collapse (Garland & Heckbert 1997). Vertices are only collapsed onto existing
+		// vertices, so the vertex buffer is shared with the source index range. Border and attribute seam vertices
+		// are locked to keep the silhouette and avoid cracks. Stops at targetIndexCount or when the next collapse
+		// would exceed targetError (object space distance); the reached error is written to resultError
+		static std::vector<uint32_t> Simplify(const uint32_t* indices, size_t indexCount, const float* positions, size_t positionStride,
+			size_t vertexCount, size_t targetIndexCount, float targetError, float* resultError = nullptr);
+
+		// greedily splits the triangle list in index order into meshlets. meshletVertices holds mesh vertex indices,
+		// meshletTriangles one entry per triangle with the three meshlet local indices packed into the low 24 bits.
+		// Results are appended, offsets are relative to the passed vectors
+		static void BuildMeshlets(const uint32_t* indices, size_t indexCount, const float* positions, size_t positionStride, size_t vertexCount,
+			std::vector<Meshlet>& meshlets, std::vector<uint32_t>& meshletVertices, std::vector<uint32_t>& meshletTriangles);
+
+		// merges bitwise identical vertices, returns the new vertex count
+		template<typename T>
+		static size_t DeduplicateVertices(T* vertices, size_t vertexCount, uint32_t* indices, size_t indexCount);
+
+		// reorders vertices to the order they are first referenced in and drops unreferenced ones,
+		// returns the new vertex count
+		template<typename T>
+		static size_t OptimizeVertexFetch(T* vertices, size_t vertexCount, uint32_t* indices, size_t indexCount);
+
+		// runs the full pipeline: dedup -> vertex cache -> overdraw -> vertex fetch
+		template<typename T>
+		static Result Optimize(T* vertices, size_t vertexCount, uint32_t* indices, size_t indexCount, glm::vec3 T::* position);
+
+		// true if every index of a mesh with this many vertices fits into VK_INDEX_TYPE_UINT16
+		static bool FitsUint16(size_t vertexCount) { return vertexCount < std::numeric_limits<uint16_t>::max() + size_t(1); }
+	};
+
+	template<typename T>
+	size_t MeshOptimizer::DeduplicateVertices(T* vertices, size_t vertexCount, uint32_t* indices, size_t indexCount)
+	{
+		static_assert(std::is_trivially_copyable_v<T>, "vertices are compared bitwise");
+
+		std::vector<uint32_t> remap(vertexCount);
+		std::unordered_map<std::string_view, uint32_t> unique;
+		unique.reserve(vertexCount);
+
+		uint32_t uniqueCount = 0;
+		for (size_t v = 0; v < vertexCount; v++)
+		{
+			const std::string_view key(reinterpret_cast<const char*>(&vertices[v]), sizeof(T));
+			auto [it, inserted] = unique.try_emplace(key, uniqueCount);
+			if (inserted)
+				uniqueCount++;
+			remap[v] = it->second;
+		}
+
+		if (uniqueCount == vertexCount)
+			return vertexCount;
+
+		// unique slots are assigned in increasing order, so compacting forward never overwrites an unread vertex
+		uint32_t next = 0;
+		for (size_t v = 0; v < vertexCount; v++)
+		{
+			if (remap[v] == next)
+				vertices[next++] = vertices[v];
+		}
+
+		for (size_t i = 0; i < indexCount; i++)
+			indices[i] = remap[indices[i]];
+
+		return uniqueCount;
+	}
+
+	template<typename T>
+	size_t MeshOptimizer::OptimizeVertexFetch(T* vertices, size_t vertexCount, uint32_t* indices, size_t indexCount)
+	{
+		constexpr uint32_t unused = ~0u;
+		std::vector<uint32_t> remap(vertexCount, unused);
+
+		uint32_t next = 0;
+		for (size_t i = 0; i < indexCount; i++)
+		{
+			uint32_t& slot = remap[indices[i]];
+			if (slot == unused)
+				slot = next++;
+			indices[i] = slot;
+		}
+
+		const std::vector<T> source(vertices, vertices + vertexCount);
+		for (size_t v = 0; v < vertexCount; v++)
+		{
+			if (remap[v] != unused)
+				vertices[remap[v]] = source[v];
+		}
+
+		return next;
+	}
+
+	template<typename T>
+	MeshOptimizer::Result MeshOptimizer::Optimize(T* vertices, size_t vertexCount, uint32_t* indices, size_t indexCount, glm::vec3 T::* position)
+	{
+		Result result;
+		result.vertexCount = vertexCount;
+		if (vertexCount == 0 || indexCount == 0 || indexCount % 3 != 0)
+			return result;
+
+		result.before = AnalyzeVertexCache(indices, indexCount, vertexCount);
+
+		vertexCount = DeduplicateVertices(vertices, vertexCount, indices, indexCount);
+		OptimizeVertexCache(indices, indexCount, vertexCount);
+		OptimizeOverdraw(indices, indexCount, &(vertices[0].*position).x, sizeof(T), vertexCount);
+		vertexCount = OptimizeVertexFetch(vertices, vertexCount, indices, indexCount);
+
+		result.vertexCount = vertexCount;
+		result.after = AnalyzeVertexCache(indices, indexCount, vertexCount);
+		return result;
+	}
+}
@@ -1,4 +1,5 @@
 #include "Graphics/OBJModel.hpp"
+#include "Graphics/MeshOptimizer.hpp"
 #include "Core/Log.hpp"
 #include "Core/Nyxis.hpp"
 #include "Utils/Utils.hpp"
@@ -75,16 +76,26 @@ namespace Nyxis
         if (!hasIndexBuffer)
             return;
 
-        VkDeviceSize bufferSize = sizeof(indices[0]) * indexCount;
+        // use 16 bit indices whenever the vertex count allows it
+        std::vector<uint16_t> indices16;
+        const void* indexData = indices.data();
+        indexType = VK_INDEX_TYPE_UINT32;
+        if (MeshOptimizer::FitsUint16(vertexCount))
+        {
+            indices16.assign(indices.begin(), indices.end());
+            indexData = indices16.data();
+            indexType = VK_INDEX_TYPE_UINT16;
+        }
 
-        uint32_t indexSize = sizeof(indices[0]);
+        uint32_t indexSize = indexType == VK_INDEX_TYPE_UINT16 ? sizeof(uint16_t) : sizeof(uint32_t);
+        VkDeviceSize bufferSize = static_cast<VkDeviceSize>(indexSize) * indexCount;
 
         Buffer stagingBuffer{indexSize, indexCount,
                              VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
                              VK_MEMORY_PROPERTY_HOST_COHERENT_BIT | VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT};
         
         stagingBuffer.map();
-        stagingBuffer.writeToBuffer((void*) indices.data());
+        stagingBuffer.writeToBuffer(const_cast<void*>(indexData));
 
         indexBuffer = std::make_unique<Buffer>(indexSize, indexCount,
                                                VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
@@ -124,7 +135,7 @@ namespace Nyxis
         vkCmdBindVertexBuffers(commandBuffer, 0, 1, buffers, offsets);
 
         if (hasIndexBuffer)
-            vkCmdBindIndexBuffer(commandBuffer, indexBuffer->getBuffer(), 0, VK_INDEX_TYPE_UINT32);
+            vkCmdBindIndexBuffer(commandBuffer, indexBuffer->getBuffer(), 0, indexType);
     }
 
     std::vector<VkVertexInputBindingDescription> OBJModel::Vertex::getBindingDescriptions()
@@ -166,8 +177,8 @@ namespace Nyxis
 
         std::unordered_map<Vertex, uint32_t> uniqueVertices{};
 
-//        for (const auto &shape : shapes
-	    std::for_each(std::execution::par, shapes.begin(), shapes.end(), [&](const auto &shape)
+        // serial on purpose: all shapes share uniqueVertices and the output vectors
+        for (const auto &shape : shapes)
         {
             for (const auto &index : shape.mesh.indices)
             {
@@ -212,9 +223,14 @@ namespace Nyxis
                 }
                 indices.push_back(uniqueVertices[vertex]);
             }
-        });
+        }
+
+        const auto result = MeshOptimizer::Optimize(vertices.data(), vertices.size(), indices.data(), indices.size(), &Vertex::position);
+        vertices.resize(result.vertexCount);
 		#ifdef LOGGING
 	    LOG_INFO("Model {} loaded, {} vertices", filepath, vertices.size());
+	    LOG_INFO("Model {} optimized, ACMR {:.3f} -> {:.3f}, ATVR {:.3f} -> {:.3f}", filepath,
+	             result.before.acmr(), result.after.acmr(), result.before.atvr(), result.after.atvr());
 		#endif // LOGGING
     }
 }
\ No newline at end of file
@@ -77,6 +77,7 @@ namespace Nyxis
 
         std::unique_ptr<Buffer> indexBuffer;
         uint32_t indexCount;
+        VkIndexType indexType = VK_INDEX_TYPE_UINT32;
         static ModelMap models;
 	};
 }
\ No newline at end of file
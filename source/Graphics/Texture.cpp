@@ -1,6 +1,7 @@
 #include "Graphics/Texture.hpp"
 #define STB_IMAGE_IMPLEMENTATION
 #include <gli/load.hpp>
+#include <gli/save_ktx.hpp>
 #include <gli/texture2d.hpp>
 #include <gli/texture_cube.hpp>
 #include <stbimage/stb_image.h>
@@ -9,18 +10,98 @@
 
 namespace Nyxis
 {
+	static gli::format toGliFormat(VkFormat format)
+	{
+		switch (format)
+		{
+		case VK_FORMAT_R8G8B8A8_UNORM: return gli::FORMAT_RGBA8_UNORM_PACK8;
+		case VK_FORMAT_R16G16_SFLOAT: return gli::FORMAT_RG16_SFLOAT_PACK16;
+		case VK_FORMAT_R16G16B16A16_SFLOAT: return gli::FORMAT_RGBA16_SFLOAT_PACK16;
+		case VK_FORMAT_R32G32B32A32_SFLOAT: return gli::FORMAT_RGBA32_SFLOAT_PACK32;
+		default: return gli::FORMAT_UNDEFINED;
+		}
+	}
+
+	// Copies every face and mip level of the texture's image into the storage of the gli texture,
+	// the image is returned to its current layout afterwards
+	static void readbackImage(const Texture& texture, gli::texture& target)
+	{
+		auto& device = Device::Get();
+		const auto faces = static_cast<uint32_t>(target.faces());
+		const auto levels = static_cast<uint32_t>(target.levels());
+		const auto* base = static_cast<const uint8_t*>(target.data());
+
+		std::vector<VkBufferImageCopy> regions;
+		for (uint32_t face = 0; face < faces; face++)
+		{
+			for (uint32_t level = 0; level < levels; level++)
+			{
+				VkBufferImageCopy region{};
+				region.bufferOffset = static_cast<const uint8_t*>(target.data(0, face, level)) - base;
+				region.imageSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, level, face, 1 };
+				region.imageExtent.width = static_cast<uint32_t>(target.extent(level).x);
+				region.imageExtent.height = static_cast<uint32_t>(target.extent(level).y);
+				region.imageExtent.depth = 1;
+				regions.push_back(region);
+			}
+		}
+
+		Buffer stagingBuffer(target.size(), 1, VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+
+		VkImageMemoryBarrier imageMemoryBarrier{};
+		imageMemoryBarrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+		imageMemoryBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		imageMemoryBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		imageMemoryBarrier.image = texture.m_Image;
+		imageMemoryBarrier.subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, 0, levels, 0, faces };
+
+		auto copyCmd = device.beginSingleTimeCommands();
+
+		imageMemoryBarrier.oldLayout = texture.m_ImageLayout;
+		imageMemoryBarrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+		imageMemoryBarrier.srcAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_TRANSFER_WRITE_BIT;
+		imageMemoryBarrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+		vkCmdPipelineBarrier(copyCmd, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, 1, &imageMemoryBarrier);
+
+		vkCmdCopyImageToBuffer(copyCmd, texture.m_Image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, stagingBuffer.getBuffer(),
+			static_cast<uint32_t>(regions.size()), regions.data());
+
+		imageMemoryBarrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+		imageMemoryBarrier.newLayout = texture.m_ImageLayout;
+		imageMemoryBarrier.srcAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+		imageMemoryBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+		vkCmdPipelineBarrier(copyCmd, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, 0, 0, nullptr, 0, nullptr, 1, &imageMemoryBarrier);
+
+		VkBufferMemoryBarrier bufferMemoryBarrier{};
+		bufferMemoryBarrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+		bufferMemoryBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		bufferMemoryBarrier.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+		bufferMemoryBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		bufferMemoryBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		bufferMemoryBarrier.buffer = stagingBuffer.getBuffer();
+		bufferMemoryBarrier.size = VK_WHOLE_SIZE;
+		vkCmdPipelineBarrier(copyCmd, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_HOST_BIT, 0, 0, nullptr, 1, &bufferMemoryBarrier, 0, nullptr);
+
+		device.endSingleTimeCommands(copyCmd);
+
+		stagingBuffer.map();
+		memcpy(target.data(), stagingBuffer.getMappedMemory(), target.size());
+		stagingBuffer.unmap();
+	}
+
 	void Texture2D::LoadFromFile(std::string filename, VkFormat format, VkImageUsageFlags imageUsageFlags,
-	                             VkImageLayout imageLayout)
+	                             VkImageLayout imageLayout, VkSamplerAddressMode addressMode)
     {
 		if(filename.ends_with(".ktx"))
-			LoadFromKTXFile(filename, format, imageUsageFlags, imageLayout);
+			LoadFromKTXFile(filename, format, imageUsageFlags, imageLayout, addressMode);
 		else
 			LoadFromSTBFile(filename, format, imageUsageFlags, imageLayout);
     }
 
 
 	void Texture2D::LoadFromKTXFile(std::string filename, VkFormat format, VkImageUsageFlags imageUsageFlags,
-		VkImageLayout imageLayout)
+		VkImageLayout imageLayout, VkSamplerAddressMode addressMode)
 	{
 		auto& device = Device::Get();
 		gli::texture2d tex2D(gli::load(filename.c_str()));
@@ -143,9 +224,9 @@ namespace Nyxis
 		samplerCreateInfo.magFilter = VK_FILTER_LINEAR;
 		samplerCreateInfo.minFilter = VK_FILTER_LINEAR;
 		samplerCreateInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR;
-		samplerCreateInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_REPEAT;
-		samplerCreateInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_REPEAT;
-		samplerCreateInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+		samplerCreateInfo.addressModeU = addressMode;
+		samplerCreateInfo.addressModeV = addressMode;
+		samplerCreateInfo.addressModeW = addressMode;
 		samplerCreateInfo.mipLodBias = 0.0f;
 		samplerCreateInfo.compareOp = VK_COMPARE_OP_NEVER;
 		samplerCreateInfo.minLod = 0.0f;
@@ -320,9 +401,19 @@ namespace Nyxis
 
 	void TextureCubeMap::LoadFromFile(std::string filename, VkFormat format, VkImageUsageFlags imageUsageFlags,
 		VkImageLayout imageLayout)
+	{
+		LoadFromTexture(*ReadFile(filename), format, imageUsageFlags, imageLayout);
+	}
+
+	Ref<gli::texture_cube> TextureCubeMap::ReadFile(const std::string& filename)
+	{
+		return std::make_shared<gli::texture_cube>(gli::load(filename));
+	}
+
+	void TextureCubeMap::LoadFromTexture(const gli::texture_cube& texCube, VkFormat format, VkImageUsageFlags imageUsageFlags,
+		VkImageLayout imageLayout)
 	{
 		auto& device = Device::Get();
-		gli::texture_cube texCube(gli::load(filename));
 		assert(!texCube.empty());
 
 		m_Width = static_cast<uint32_t>(texCube.extent().x);
@@ -475,4 +566,96 @@ namespace Nyxis
 		// Update descriptor image info member that can be used for setting up descriptor sets
 		UpdateDescriptor();
 	}
+
+	bool Texture2D::SaveToFile(const std::string& filename, VkFormat format)
+	{
+		const gli::format gliFormat = toGliFormat(format);
+		if (gliFormat == gli::FORMAT_UNDEFINED)
+			return false;
+
+		gli::texture2d tex2D(gliFormat, gli::extent2d(m_Width, m_Height), m_MipLevels);
+		readbackImage(*this, tex2D);
+		return gli::save_ktx(tex2D, filename);
+	}
+
+	bool TextureCubeMap::SaveToFile(const std::string& filename, VkFormat format)
+	{
+		const gli::format gliFormat = toGliFormat(format);
+		if (gliFormat == gli::FORMAT_UNDEFINED)
+			return false;
+
+		gli::texture_cube texCube(gliFormat, gli::extent2d(m_Width, m_Height), m_MipLevels);
+		readbackImage(*this, texCube);
+		return gli::save_ktx(texCube, filename);
+	}
+
+	Ref<TextureReadback> TextureCubeMap::RecordReadback(VkCommandBuffer commandBuffer, VkImageLayout layout, VkFormat format)
+	{
+		const gli::format gliFormat = toGliFormat(format);
+		if (gliFormat == gli::FORMAT_UNDEFINED)
+			return nullptr;
+
+		// gli stores the mip levels of a face next to each other, the faces follow each other
+		const VkDeviceSize texelSize = gli::block_size(gliFormat);
+		std::vector<VkBufferImageCopy> regions;
+		VkDeviceSize size = 0;
+		for (uint32_t face = 0; face < 6; face++)
+		{
+			for (uint32_t level = 0; level < m_MipLevels; level++)
+			{
+				VkBufferImageCopy region{};
+				region.bufferOffset = size;
+				region.imageSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, level, face, 1 };
+				region.imageExtent.width = std::max(1u, m_Width >> level);
+				region.imageExtent.height = std::max(1u, m_Height >> level);
+				region.imageExtent.depth = 1;
+				regions.push_back(region);
+				size += region.imageExtent.width * region.imageExtent.height * texelSize;
+			}
+		}
+
+		auto readback = std::make_shared<TextureReadback>();
+		readback->buffer = std::make_unique<Buffer>(size, 1, VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+		readback->format = format;
+		readback->width = m_Width;
+		readback->height = m_Height;
+		readback->mipLevels = m_MipLevels;
+
+		VkImageMemoryBarrier imageMemoryBarrier{};
+		imageMemoryBarrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+		imageMemoryBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		imageMemoryBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		imageMemoryBarrier.image = m_Image;
+		imageMemoryBarrier.subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, 0, m_MipLevels, 0, 6 };
+		imageMemoryBarrier.oldLayout = layout;
+		imageMemoryBarrier.newLayout = layout;
+		imageMemoryBarrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_TRANSFER_WRITE_BIT;
+		imageMemoryBarrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+		vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, 1, &imageMemoryBarrier);
+
+		vkCmdCopyImageToBuffer(commandBuffer, m_Image, layout, readback->buffer->getBuffer(), static_cast<uint32_t>(regions.size()), regions.data());
+
+		VkBufferMemoryBarrier bufferMemoryBarrier{};
+		bufferMemoryBarrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+		bufferMemoryBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		bufferMemoryBarrier.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+		bufferMemoryBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		bufferMemoryBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		bufferMemoryBarrier.buffer = readback->buffer->getBuffer();
+		bufferMemoryBarrier.size = VK_WHOLE_SIZE;
+		vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_HOST_BIT, 0, 0, nullptr, 1, &bufferMemoryBarrier, 0, nullptr);
+
+		return readback;
+	}
+
+	bool TextureCubeMap::SaveReadback(const TextureReadback& readback, const std::string& filename)
+	{
+		gli::texture_cube texCube(toGliFormat(readback.format), gli::extent2d(readback.width, readback.height), readback.mipLevels);
+		if (texCube.size() != readback.buffer->getBufferSize() || readback.buffer->map() != VK_SUCCESS)
+			return false;
+		memcpy(texCube.data(), readback.buffer->getMappedMemory(), texCube.size());
+		readback.buffer->unmap();
+		return gli::save_ktx(texCube, filename);
+	}
 }
@@ -1,8 +1,21 @@
 #pragma once
 #include "Core/Device.hpp"
 #include "Core/Descriptors.hpp"
+#include "Core/Buffer.hpp"
+
+namespace gli { class texture_cube; }
 
 namespace Nyxis{
+	// Image contents copied into a host visible buffer, laid out like the storage of the matching gli texture
+	struct TextureReadback
+	{
+		Scope<Buffer> buffer;
+		VkFormat format = VK_FORMAT_UNDEFINED;
+		uint32_t width = 0;
+		uint32_t height = 0;
+		uint32_t mipLevels = 0;
+	};
+
 	class Texture {
 	public:
 		VkImage m_Image = VK_NULL_HANDLE;
@@ -43,7 +56,8 @@ namespace Nyxis{
 			std::string filename,
 			VkFormat format,
 			VkImageUsageFlags imageUsageFlags = VK_IMAGE_USAGE_SAMPLED_BIT,
-			VkImageLayout imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+			VkImageLayout imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+			VkSamplerAddressMode addressMode = VK_SAMPLER_ADDRESS_MODE_REPEAT);
 
 		void LoadFromBuffer(
 			void* buffer,
@@ -54,12 +68,16 @@ namespace Nyxis{
 			VkFilter filter = VK_FILTER_LINEAR,
 			VkImageUsageFlags imageUsageFlags = VK_IMAGE_USAGE_SAMPLED_BIT,
 			VkImageLayout imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+
+		// Writes all mip levels to a KTX file, the image needs TRANSFER_SRC usage
+		bool SaveToFile(const std::string& filename, VkFormat format);
 	private:
 		void LoadFromKTXFile(
 			std::string filename,
 			VkFormat format,
 			VkImageUsageFlags imageUsageFlags,
-			VkImageLayout imageLayout);
+			VkImageLayout imageLayout,
+			VkSamplerAddressMode addressMode);
 
 		void LoadFromSTBFile(
 			std::string filename,
@@ -75,5 +93,22 @@ namespace Nyxis{
 			VkFormat format,
 			VkImageUsageFlags imageUsageFlags = VK_IMAGE_USAGE_SAMPLED_BIT,
 			VkImageLayout imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+
+		// Reads the faces and mip levels of a KTX file without touching the device, safe to call from any thread
+		static Ref<gli::texture_cube> ReadFile(const std::string& filename);
+		// Uploads a texture read by ReadFile, on the thread that owns the device
+		void LoadFromTexture(
+			const gli::texture_cube& texCube,
+			VkFormat format,
+			VkImageUsageFlags imageUsageFlags = VK_IMAGE_USAGE_SAMPLED_BIT,
+			VkImageLayout imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+
+		// Writes all faces and mip levels to a KTX file, the image needs TRANSFER_SRC usage
+		bool SaveToFile(const std::string& filename, VkFormat format);
+
+		// Records the copy of all faces and mip levels into a readback buffer, the image stays in its layout.
+		// Once the command buffer completed the readback can be saved from any thread
+		Ref<TextureReadback> RecordReadback(VkCommandBuffer commandBuffer, VkImageLayout layout, VkFormat format);
+		static bool SaveReadback(const TextureReadback& readback, const std::string& filename);
 	};
 }
@@ -0,0 +1,342 @@
+#include "Graphics/TextureStreamer.hpp"
+
+#include "Core/DeletionQueue.hpp"
+#include "Graphics/GLTFModel.hpp"
+
+namespace Nyxis
+{
+	namespace
+	{
+		uint32_t mipExtent(uint32_t extent, uint32_t mip) { return std::max(1u, extent >> mip); }
+
+		// 2x2 box filter, odd extents repeat the last row / column
+		void downsample(const uint8_t* src, uint32_t srcWidth, uint32_t srcHeight, uint8_t* dst)
+		{
+			const uint32_t dstWidth = std::max(1u, srcWidth / 2);
+			const uint32_t dstHeight = std::max(1u, srcHeight / 2);
+			for (uint32_t y = 0; y < dstHeight; y++)
+			{
+				const uint32_t y0 = std::min(y * 2, srcHeight - 1);
+				const uint32_t y1 = std::min(y * 2 + 1, srcHeight - 1);
+				for (uint32_t x = 0; x < dstWidth; x++)
+				{
+					const uint32_t x0 = std::min(x * 2, srcWidth - 1);
+					const uint32_t x1 = std::min(x * 2 + 1, srcWidth - 1);
+					for (uint32_t c = 0; c < 4; c++)
+					{
+						const uint32_t sum = src[(y0 * srcWidth + x0) * 4 + c] + src[(y0 * srcWidth + x1) * 4 + c]
+							+ src[(y1 * srcWidth + x0) * 4 + c] + src[(y1 * srcWidth + x1) * 4 + c];
+						dst[(y * dstWidth + x) * 4 + c] = static_cast<uint8_t>((sum + 2) / 4);
+					}
+				}
+			}
+		}
+	}
+
+	uint32_t TextureStreamer::Register(const uint8_t* pixels, uint32_t width, uint32_t height)
+	{
+		uint32_t handle;
+		if (!s_FreeHandles.empty())
+		{
+			handle = s_FreeHandles.back();
+			s_FreeHandles.pop_back();
+		}
+		else
+		{
+			handle = static_cast<uint32_t>(s_Textures.size());
+			s_Textures.emplace_back();
+		}
+
+		auto& texture = s_Textures[handle];
+		texture = StreamedTexture{};
+		texture.alive = true;
+		texture.width = width;
+		texture.height = height;
+
+		const uint32_t mipLevels = static_cast<uint32_t>(floor(log2(std::max(width, height))) + 1);
+		size_t size = 0;
+		for (uint32_t mip = 0; mip < mipLevels; mip++)
+		{
+			texture.mipOffsets.push_back(size);
+			size += static_cast<size_t>(mipExtent(width, mip)) * mipExtent(height, mip) * 4;
+		}
+
+		texture.pixels.resize(size);
+		memcpy(texture.pixels.data(), pixels, static_cast<size_t>(width) * height * 4);
+		for (uint32_t mip = 1; mip < mipLevels; mip++)
+		{
+			downsample(&texture.pixels[texture.mipOffsets[mip - 1]], mipExtent(width, mip - 1), mipExtent(height, mip - 1),
+				&texture.pixels[texture.mipOffsets[mip]]);
+		}
+
+		texture.tailMip = 0;
+		while (texture.tailMip + 1 < mipLevels && std::max(mipExtent(width, texture.tailMip), mipExtent(height, texture.tailMip)) > s_Settings.initialSize)
+			texture.tailMip++;
+
+		auto& device = Device::Get();
+		std::vector<Scope<Buffer>> stagingBuffers;
+		auto commandBuffer = device.beginSingleTimeCommands();
+		MakeResident(texture, texture.tailMip, commandBuffer, stagingBuffers);
+		device.endSingleTimeCommands(commandBuffer);
+
+		return handle;
+	}
+
+	void TextureStreamer::Unregister(uint32_t handle)
+	{
+		auto& texture = s_Textures[handle];
+		Retire(texture);
+		texture = StreamedTexture{};
+		s_FreeHandles.push_back(handle);
+	}
+
+	void TextureStreamer::Request(uint32_t handle, uint32_t mip)
+	{
+		auto& texture = s_Textures[handle];
+		texture.requestedMip = std::min(texture.requestedMip, mip);
+		texture.lastRequestFrame = s_Frame;
+	}
+
+	void TextureStreamer::Update(VkCommandBuffer commandBuffer)
+	{
+		s_Frame++;
+
+		if (!s_Settings.enabled)
+			return;
+
+		auto& device = Device::Get();
+
+		s_Statistics = Statistics{};
+		for (const auto& texture : s_Textures)
+		{
+			if (texture.alive)
+			{
+				s_Statistics.residentBytes += texture.allocationSize;
+				s_Statistics.textureCount++;
+			}
+		}
+
+		// never exceed what the driver reports as available next to everything else the process allocated
+		VkDeviceSize budget = s_Settings.budget;
+		if (device.hasMemoryBudget())
+		{
+			const auto memoryBudget = device.getMemoryBudget();
+			const VkDeviceSize otherUsage = memoryBudget.usage > s_Statistics.residentBytes ? memoryBudget.usage - s_Statistics.residentBytes : 0;
+			const VkDeviceSize available = memoryBudget.budget > otherUsage ? memoryBudget.budget - otherUsage : 0;
+			budget = std::min(budget, static_cast<VkDeviceSize>(available * s_Settings.deviceBudgetFraction));
+		}
+		s_Statistics.budget = budget;
+
+		// the requests of this frame, unrequested textures fall back to the always resident tail
+		std::vector<uint32_t> desired(s_Textures.size(), 0);
+		VkDeviceSize total = 0;
+		for (size_t i = 0; i < s_Textures.size(); i++)
+		{
+			auto& texture = s_Textures[i];
+			if (!texture.alive)
+				continue;
+
+			uint32_t mip = texture.tailMip;
+			if (texture.requestedMip != UINT32_MAX)
+				mip = static_cast<uint32_t>(std::clamp<int32_t>(static_cast<int32_t>(texture.requestedMip) + s_Settings.mipBias, 0, static_cast<int32_t>(texture.tailMip)));
+			texture.requestedMip = UINT32_MAX;
+
+			desired[i] = mip;
+			total += MipBytes(texture, mip);
+		}
+		s_Statistics.requestedBytes = total;
+
+		// over budget: drop the largest mip of the textures that were requested longest ago first
+		while (total > budget)
+		{
+			size_t victim = s_Textures.size();
+			for (size_t i = 0; i < s_Textures.size(); i++)
+			{
+				const auto& texture = s_Textures[i];
+				if (!texture.alive || desired[i] >= texture.tailMip)
+					continue;
+				if (victim == s_Textures.size())
+				{
+					victim = i;
+					continue;
+				}
+				const auto& current = s_Textures[victim];
+				const VkDeviceSize size = MipBytes(texture, desired[i]) - MipBytes(texture, desired[i] + 1);
+				const VkDeviceSize currentSize = MipBytes(current, desired[victim]) - MipBytes(current, desired[victim] + 1);
+				if (texture.lastRequestFrame < current.lastRequestFrame || (texture.lastRequestFrame == current.lastRequestFrame && size > currentSize))
+					victim = i;
+			}
+			if (victim == s_Textures.size())
+				break;
+
+			const auto& texture = s_Textures[victim];
+			total -= MipBytes(texture, desired[victim]) - MipBytes(texture, desired[victim] + 1);
+			desired[victim]++;
+		}
+
+		std::vector<size_t> evictions;
+		std::vector<size_t> uploads;
+		for (size_t i = 0; i < s_Textures.size(); i++)
+		{
+			if (!s_Textures[i].alive)
+				continue;
+			if (desired[i] > s_Textures[i].residency.residentMip)
+				evictions.push_back(i);
+			else if (desired[i] < s_Textures[i].residency.residentMip)
+				uploads.push_back(i);
+		}
+		if (evictions.empty() && uploads.empty())
+			return;
+
+		// the textures missing the most detail first
+		std::sort(uploads.begin(), uploads.end(), [&](size_t a, size_t b) {
+			return s_Textures[a].residency.residentMip - desired[a] > s_Textures[b].residency.residentMip - desired[b];
+		});
+
+		std::vector<Scope<Buffer>> stagingBuffers;
+
+		// evictions only shrink images, they do not count against the upload limit
+		for (size_t i : evictions)
+			MakeResident(s_Textures[i], desired[i], commandBuffer, stagingBuffers);
+
+		VkDeviceSize uploaded = 0;
+		for (size_t i : uploads)
+		{
+			auto& texture = s_Textures[i];
+			if (uploaded >= s_Settings.uploadBytesPerFrame)
+			{
+				s_Statistics.pendingUploads++;
+				continue;
+			}
+
+			// step one mip at a time if the full jump does not fit into this frame
+			uint32_t mip = desired[i];
+			if (uploaded + MipBytes(texture, mip) > s_Settings.uploadBytesPerFrame && mip + 1 < texture.residency.residentMip)
+			{
+				mip = texture.residency.residentMip - 1;
+				s_Statistics.pendingUploads++;
+			}
+
+			uploaded += MipBytes(texture, mip);
+			MakeResident(texture, mip, commandBuffer, stagingBuffers);
+		}
+
+		// the copies run with this frame's command buffer
+		DeletionQueue::Release(std::move(stagingBuffers));
+	}
+
+	VkDeviceSize TextureStreamer::MipBytes(const StreamedTexture& texture, uint32_t firstMip)
+	{
+		if (firstMip >= texture.mipOffsets.size())
+			return 0;
+		return texture.pixels.size() - texture.mipOffsets[firstMip];
+	}
+
+	void TextureStreamer::MakeResident(StreamedTexture& texture, uint32_t firstMip, VkCommandBuffer commandBuffer, std::vector<Scope<Buffer>>& stagingBuffers)
+	{
+		auto& device = Device::Get();
+
+		const uint32_t mipLevels = static_cast<uint32_t>(texture.mipOffsets.size()) - firstMip;
+		const VkDeviceSize size = MipBytes(texture, firstMip);
+		const size_t baseOffset = texture.mipOffsets[firstMip];
+
+		stagingBuffers.push_back(std::make_unique<Buffer>(size, 1, VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, &texture.pixels[baseOffset]));
+
+		VkImageCreateInfo imageInfo{};
+		imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+		imageInfo.imageType = VK_IMAGE_TYPE_2D;
+		imageInfo.format = VK_FORMAT_R8G8B8A8_UNORM;
+		imageInfo.mipLevels = mipLevels;
+		imageInfo.arrayLayers = 1;
+		imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+		imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+		imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+		imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+		imageInfo.extent = { mipExtent(texture.width, firstMip), mipExtent(texture.height, firstMip), 1 };
+		imageInfo.usage = VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+
+		VkImage image;
+		VkDeviceMemory memory;
+		device.createImageWithInfo(imageInfo, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, image, memory);
+
+		VkMemoryRequirements memReqs;
+		vkGetImageMemoryRequirements(device.device(), image, &memReqs);
+
+		VkImageSubresourceRange subresourceRange{};
+		subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		subresourceRange.levelCount = mipLevels;
+		subresourceRange.layerCount = 1;
+
+		VkImageMemoryBarrier barrier{};
+		barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+		barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+		barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+		barrier.srcAccessMask = 0;
+		barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.image = image;
+		barrier.subresourceRange = subresourceRange;
+		vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+
+		std::vector<VkBufferImageCopy> regions(mipLevels);
+		for (uint32_t level = 0; level < mipLevels; level++)
+		{
+			auto& region = regions[level];
+			region.bufferOffset = texture.mipOffsets[firstMip + level] - baseOffset;
+			region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+			region.imageSubresource.mipLevel = level;
+			region.imageSubresource.layerCount = 1;
+			region.imageExtent = { mipExtent(texture.width, firstMip + level), mipExtent(texture.height, firstMip + level), 1 };
+		}
+		vkCmdCopyBufferToImage(commandBuffer, stagingBuffers.back()->getBuffer(), image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+			static_cast<uint32_t>(regions.size()), regions.data());
+
+		barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+		barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+		barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+		vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+
+		VkImageViewCreateInfo viewInfo{};
+		viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+		viewInfo.image = image;
+		viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+		viewInfo.format = imageInfo.format;
+		viewInfo.components = { VK_COMPONENT_SWIZZLE_R, VK_COMPONENT_SWIZZLE_G, VK_COMPONENT_SWIZZLE_B, VK_COMPONENT_SWIZZLE_A };
+		viewInfo.subresourceRange = subresourceRange;
+
+		VkImageView view;
+		if (vkCreateImageView(device.device(), &viewInfo, nullptr, &view) != VK_SUCCESS)
+			throw std::runtime_error("failed to create texture image view!");
+
+		// the previous image may still be sampled by frames in flight
+		Retire(texture);
+
+		texture.memory = memory;
+		texture.allocationSize = memReqs.size;
+		texture.residency.image = image;
+		texture.residency.view = view;
+		texture.residency.residentMip = firstMip;
+		texture.residency.version++;
+	}
+
+	void TextureStreamer::Retire(StreamedTexture& texture)
+	{
+		if (texture.residency.image == VK_NULL_HANDLE)
+			return;
+
+		DeletionQueue::Push([image = texture.residency.image, view = texture.residency.view, memory = texture.memory]() {
+			auto& device = Device::Get();
+			vkDestroyImageView(device.device(), view, nullptr);
+			vkDestroyImage(device.device(), image, nullptr);
+			vkFreeMemory(device.device(), memory, nullptr);
+		});
+
+		texture.residency.image = VK_NULL_HANDLE;
+		texture.residency.view = VK_NULL_HANDLE;
+		texture.memory = VK_NULL_HANDLE;
+		texture.allocationSize = 0;
+	}
+}
@@ -0,0 +1,91 @@
+#pragma once
+#include "Core/Nyxispch.hpp"
+#include "Core/Device.hpp"
+#include "Core/Buffer.hpp"
+
+namespace Nyxis
+{
+	// Mip residency for model textures. The full mip chain is kept in system memory, the GPU image only holds
+	// the mips from residentMip down to the smallest one. Renderers request the mip they need every frame,
+	// Update() then streams higher mips in and evicts mips that are no longer needed or do not fit the budget.
+	// Streaming swaps whole images, users pick up the new image through the version counter.
+	// The copies are recorded into the frame's command buffer, the replaced images and staging buffers are
+	// released through the deletion queue once the frame completed.
+	class TextureStreamer
+	{
+	public:
+		static constexpr uint32_t INVALID_HANDLE = UINT32_MAX;
+
+		struct Settings
+		{
+			bool enabled = true;
+			// upper limit for resident texture memory
+			VkDeviceSize budget = 512ull << 20;
+			// share of the device local budget left by other allocations textures may use
+			float deviceBudgetFraction = 0.8f;
+			// the mips up to this size are uploaded at load and never evicted
+			uint32_t initialSize = 128;
+			// limits the upload work done by a single Update()
+			VkDeviceSize uploadBytesPerFrame = 16ull << 20;
+			// added to requested mips, positive values trade sharpness for memory
+			int32_t mipBias = 0;
+		};
+
+		struct Residency
+		{
+			VkImage image = VK_NULL_HANDLE;
+			VkImageView view = VK_NULL_HANDLE;
+			uint32_t residentMip = 0;
+			uint32_t version = 0;
+		};
+
+		struct Statistics
+		{
+			VkDeviceSize residentBytes = 0;
+			VkDeviceSize requestedBytes = 0;
+			VkDeviceSize budget = 0;
+			uint32_t textureCount = 0;
+			uint32_t pendingUploads = 0;
+		};
+
+		static inline Settings s_Settings{};
+
+		// takes a copy of the RGBA8 level 0 pixels and uploads the initial mips
+		static uint32_t Register(const uint8_t* pixels, uint32_t width, uint32_t height);
+		static void Unregister(uint32_t handle);
+
+		// keeps the smallest requested mip of this frame
+		static void Request(uint32_t handle, uint32_t mip);
+		// records the residency changes outside of a render pass
+		static void Update(VkCommandBuffer commandBuffer);
+
+		static const Residency& GetResidency(uint32_t handle) { return s_Textures[handle].residency; }
+		static uint32_t GetMipLevels(uint32_t handle) { return static_cast<uint32_t>(s_Textures[handle].mipOffsets.size()); }
+		static const Statistics& GetStatistics() { return s_Statistics; }
+
+	private:
+		struct StreamedTexture
+		{
+			bool alive = false;
+			uint32_t width = 0;
+			uint32_t height = 0;
+			std::vector<uint8_t> pixels;        // all mips, tightly packed
+			std::vector<size_t> mipOffsets;
+			uint32_t tailMip = 0;               // first mip that is always resident
+			uint32_t requestedMip = UINT32_MAX; // smallest mip requested this frame
+			uint64_t lastRequestFrame = 0;
+			VkDeviceMemory memory = VK_NULL_HANDLE;
+			VkDeviceSize allocationSize = 0;
+			Residency residency;
+		};
+
+		static VkDeviceSize MipBytes(const StreamedTexture& texture, uint32_t firstMip);
+		static void MakeResident(StreamedTexture& texture, uint32_t firstMip, VkCommandBuffer commandBuffer, std::vector<Scope<Buffer>>& stagingBuffers);
+		static void Retire(StreamedTexture& texture);
+
+		static inline std::vector<StreamedTexture> s_Textures{};
+		static inline std::vector<uint32_t> s_FreeHandles{};
+		static inline uint64_t s_Frame = 0;
+		static inline Statistics s_Statistics{};
+	};
+}
@@ -293,12 +293,31 @@ namespace Nyxis
 
 	void EditorLayer::SetSelectedEntity(Entity entity) {
 		m_SelectedEntity = entity;
+		m_SelectedEntities.assign(1, entity);
 		m_SelectedMaterial = nullptr;
 		m_SelectedNode = nullptr;
 	}
 
+	void EditorLayer::SetSelectedEntities(const std::vector<Entity>& entities) {
+		if (entities.empty()) {
+			DeselectEntity();
+			return;
+		}
+		// the primary selection is kept if it is still part of the set
+		const bool keepPrimary = std::find(entities.begin(), entities.end(), m_SelectedEntity) != entities.end();
+		m_SelectedEntities = entities;
+		if (keepPrimary)
+			std::iter_swap(m_SelectedEntities.begin(), std::find(m_SelectedEntities.begin(), m_SelectedEntities.end(), m_SelectedEntity));
+		else {
+			m_SelectedEntity = m_SelectedEntities.front();
+			m_SelectedMaterial = nullptr;
+			m_SelectedNode = nullptr;
+		}
+	}
+
 	void EditorLayer::DeselectEntity() {
 		m_SelectedEntity = entt::null;
+		m_SelectedEntities.clear();
 		m_SelectedMaterial = nullptr;
 		m_SelectedNode = nullptr;
 	}
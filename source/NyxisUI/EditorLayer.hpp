@@ -32,10 +32,14 @@ namespace Nyxis
 
     	VkExtent2D GetViewportExtent() const { return m_Viewport->GetExtent(); }
     	static Entity GetSelectedEntity() { return m_SelectedEntity; }
+        // every selected entity, the primary selection is the first one
+        static const std::vector<Entity>& GetSelectedEntities() { return m_SelectedEntities; }
+        static bool IsSelected(Entity entity) { return std::find(m_SelectedEntities.begin(), m_SelectedEntities.end(), entity) != m_SelectedEntities.end(); }
         static Node* GetSelectedNode() { return m_SelectedNode; }
         static Material* GetSelectedMaterial() { return m_SelectedMaterial; }
 
         static void SetSelectedEntity(Entity entity);
+        static void SetSelectedEntities(const std::vector<Entity>& entities);
         static void SetSelectedNode(Node* node) { m_SelectedNode = node; }
         static void SetSelectedMaterial(Material* material) { m_SelectedMaterial = material; }
         static void DeselectEntity();
@@ -50,6 +54,7 @@ namespace Nyxis
         Ref<Viewport> m_Viewport;
 
 		static inline Entity m_SelectedEntity = entt::null;
+		static inline std::vector<Entity> m_SelectedEntities{};
         static inline Node* m_SelectedNode = nullptr;
     	static inline Material* m_SelectedMaterial = nullptr;
         static inline std::vector<std::function<void()>> functions;
@@ -25,6 +25,11 @@ namespace Nyxis
 			{
 				Application::GetProject()->Save();
 			}
+			if (ImGui::MenuItem("Export JSON"))
+			{
+				const auto project = Application::GetProject();
+				project->ExportJson(project->GetPath() + ".export.json");
+			}
 			ImGui::Separator();
 			ImGui::EndMenu();
 		}
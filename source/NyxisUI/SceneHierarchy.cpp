@@ -67,7 +67,7 @@ namespace Nyxis
 		const auto& tag = scene->GetComponent<TagComponent>(entity).Tag;
 		const auto selectedEntity = EditorLayer::GetSelectedEntity();
 
-		ImGuiTreeNodeFlags flags = ((selectedEntity == entity) ? ImGuiTreeNodeFlags_Selected : 0) | 
+		ImGuiTreeNodeFlags flags = (EditorLayer::IsSelected(entity) ? ImGuiTreeNodeFlags_Selected : 0) | 
 			ImGuiTreeNodeFlags_OpenOnArrow | ImGuiTreeNodeFlags_OpenOnDoubleClick;
 		flags |= ImGuiTreeNodeFlags_SpanAvailWidth;
 		bool expanded = ImGui::TreeNodeEx(reinterpret_cast<void*>(static_cast<uint64_t>(static_cast<uint32_t>(entity))), flags, "%s", tag.c_str());
@@ -2,6 +2,7 @@
 #include "Core/Application.hpp"
 #include "Core/Renderer.hpp"
 #include "Events/MouseEvents.hpp"
+#include "Graphics/MarqueeSelection.hpp"
 
 #include <imgui/imgui.h>
 #include <imgui/backends/imgui_impl_vulkan.h>
@@ -13,6 +14,8 @@ namespace Nyxis
 	static const float TRANSLATE_SNAP_VALUES[3] = { 0.1f, 0.1f, 0.1f };
 	static const float ROTATE_SNAP_VALUES[3] = { 45.0f, 45.0f, 45.0f };
 	static const float SCALE_SNAP_VALUES[3] = { 0.1f, 0.1f, 0.1f };
+	// drags shorter than this stay a click
+	static constexpr float MARQUEE_THRESHOLD = 4.0f;
 
 	bool DecomposeTransform(const glm::mat4& transform, glm::vec3& translation, glm::vec3& rotation, glm::vec3& scale)
 	{
@@ -99,7 +102,12 @@ namespace Nyxis
 			projection[1][1] *= -1.0f;
 
 			auto& transform = scene->GetComponent<TransformComponent>(selected_entity);
-			auto modelMatrix = transform.mat4(true);
+			// the gizmo works in world space, edits are written back relative to the parent
+			const glm::mat4 flipY = glm::scale(glm::mat4(1.0f), glm::vec3(1.0f, -1.0f, 1.0f));
+			const auto* parent = scene->m_Registry.try_get<Parent>(selected_entity);
+			const glm::mat4 parentMatrix = parent ? flipY * scene->GetComponent<WorldTransform>(parent->entity).matrix * flipY : glm::mat4(1.0f);
+			auto modelMatrix = flipY * scene->GetComponent<WorldTransform>(selected_entity).matrix * flipY;
+			const auto previousMatrix = modelMatrix;
 
 			if (m_DrawGizmos)
 			{
@@ -114,12 +122,33 @@ namespace Nyxis
 			if (m_UsingGizmo)
 			{
 				glm::vec3 translation, rotation, scale;
-				DecomposeTransform(glm::mat4(modelMatrix), translation, rotation, scale);
+				DecomposeTransform(glm::inverse(parentMatrix) * modelMatrix, translation, rotation, scale);
 
 				glm::vec3 deltaRotation = rotation - transform.rotation;
 				transform.translation = translation;
 				transform.rotation += deltaRotation;
 				transform.scale = scale;
+
+				// the rest of the selection follows the primary one, children of selected entities already do
+				const glm::mat4 delta = modelMatrix * glm::inverse(previousMatrix);
+				for (auto entity : EditorLayer::GetSelectedEntities())
+				{
+					if (entity == selected_entity || !scene->m_Registry.valid(entity))
+						continue;
+					bool selectedAncestor = false;
+					for (auto* ancestor = scene->m_Registry.try_get<Parent>(entity); ancestor && !selectedAncestor;
+						ancestor = scene->m_Registry.try_get<Parent>(ancestor->entity))
+						selectedAncestor = EditorLayer::IsSelected(ancestor->entity);
+					if (selectedAncestor)
+						continue;
+
+					const auto* otherParent = scene->m_Registry.try_get<Parent>(entity);
+					const glm::mat4 otherParentMatrix = otherParent ? flipY * scene->GetComponent<WorldTransform>(otherParent->entity).matrix * flipY : glm::mat4(1.0f);
+					const glm::mat4 otherMatrix = delta * flipY * scene->GetComponent<WorldTransform>(entity).matrix * flipY;
+
+					auto& otherTransform = scene->GetComponent<TransformComponent>(entity);
+					DecomposeTransform(glm::inverse(otherParentMatrix) * otherMatrix, otherTransform.translation, otherTransform.rotation, otherTransform.scale);
+				}
 				mousePos = { -1, -1 };
 			}
 		}
@@ -148,11 +177,75 @@ namespace Nyxis
 
 		UpdateViewport();
 		UpdateGizmo();
+		UpdateMarquee();
 
 		ImGui::End();
 		ImGui::PopStyleVar();
 	}
 
+	void Viewport::UpdateMarquee()
+	{
+		const ImVec2 mouse = ImGui::GetMousePos();
+		const glm::vec2 point = { mouse.x - m_WindowPos.x, mouse.y - m_WindowPos.y };
+
+		if (m_IsClicked && !m_OverGizmo && !m_UsingGizmo)
+		{
+			m_MarqueeActive = true;
+			m_Lasso = ImGui::GetIO().KeyAlt;
+			m_MarqueePoints.assign(1, point);
+		}
+		if (!m_MarqueeActive)
+			return;
+
+		if (m_UsingGizmo)
+		{
+			m_MarqueeActive = false;
+			return;
+		}
+
+		const bool dragged = glm::length(point - m_MarqueePoints.front()) >= MARQUEE_THRESHOLD || m_MarqueePoints.size() > 2;
+		if (m_Lasso)
+		{
+			if (glm::length(point - m_MarqueePoints.back()) >= MARQUEE_THRESHOLD)
+				m_MarqueePoints.push_back(point);
+		}
+		else
+			m_MarqueePoints.resize(1);
+
+		if (ImGui::IsMouseReleased(ImGuiMouseButton_Left))
+		{
+			m_MarqueeActive = false;
+			if (!dragged)
+				return;
+			if (!m_Lasso)
+				m_MarqueePoints.push_back(point);
+			if (m_MarqueePoints.size() >= (m_Lasso ? 3u : 2u))
+				MarqueeSelection::Request(m_MarqueePoints);
+			return;
+		}
+
+		if (!dragged)
+			return;
+
+		auto* drawList = ImGui::GetWindowDrawList();
+		const ImU32 outline = IM_COL32(90, 160, 255, 255);
+		const ImU32 fill = IM_COL32(90, 160, 255, 40);
+		if (m_Lasso)
+		{
+			std::vector<ImVec2> outlinePoints;
+			outlinePoints.reserve(m_MarqueePoints.size());
+			for (const auto& p : m_MarqueePoints)
+				outlinePoints.push_back({ p.x + m_WindowPos.x, p.y + m_WindowPos.y });
+			drawList->AddPolyline(outlinePoints.data(), static_cast<int>(outlinePoints.size()), outline, ImDrawFlags_Closed, 1.0f);
+		}
+		else
+		{
+			const ImVec2 start = { m_MarqueePoints.front().x + m_WindowPos.x, m_MarqueePoints.front().y + m_WindowPos.y };
+			drawList->AddRectFilled(start, mouse, fill);
+			drawList->AddRect(start, mouse, outline);
+		}
+	}
+
 	void Viewport::OnEvent(Event& event)
 	{
 		// do not process any events if the event is handled
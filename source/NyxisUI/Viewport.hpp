@@ -27,6 +27,7 @@ namespace Nyxis
 	private:
 		void UpdateViewport();
 		void UpdateGizmo();
+		void UpdateMarquee();
 		ImGuizmo::OPERATION m_CurrentGizmoOperation = ImGuizmo::OPERATION::TRANSLATE;
 		ImGuizmo::OPERATION m_LastGizmoOperation = ImGuizmo::OPERATION::TRANSLATE;
 		ImGuizmo::MODE m_CurrentGizmoMode = ImGuizmo::MODE::WORLD;
@@ -37,6 +38,10 @@ namespace Nyxis
 		std::vector<VkDescriptorSet> m_DescriptorSets;
 		VkSampler m_Sampler = VK_NULL_HANDLE;
 		float m_SnapValue = 0.1f;
+		// left drag outside the gizmo, a rectangle or with alt held a lasso, in viewport pixels
+		bool m_MarqueeActive = false;
+		bool m_Lasso = false;
+		std::vector<glm::vec2> m_MarqueePoints;
 		bool m_DrawGizmos = true;
 		bool m_GizmoSnapping = false;
 		static inline bool m_UsingGizmo = false;
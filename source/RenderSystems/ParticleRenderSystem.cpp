@@ -60,7 +60,7 @@ namespace Nyxis
 			"../shaders/particle_shader.vert.spv",
 			"../shaders/particle_shader.frag.spv"
 			);
-		auto pipelineConfig = m_Pipeline->GetConfig();
+		auto& pipelineConfig = m_Pipeline->GetConfig();
 		Pipeline::DefaultPipelineConfigInfo(pipelineConfig);
 		
 		pipelineConfig.attributeDescriptions.clear();
@@ -49,7 +49,7 @@ namespace Nyxis
 			current_path + "/../shaders/point_light.vert.spv",
 			current_path + "/../shaders/point_light.frag.spv"
 		);
-        auto pipelineConfig = pipeline->GetConfig();
+        auto& pipelineConfig = pipeline->GetConfig();
         Pipeline::DefaultPipelineConfigInfo(pipelineConfig);
 
         // clear prevoiiusly set values
@@ -35,7 +35,7 @@ namespace Nyxis
 	void RenderSystem::CreatePipeline(VkRenderPass renderPass)
 	{
 		pPipeline = std::make_unique<Pipeline>(VertexShaderPath, FragmentShaderPath);
-		auto pipelineConfig = pPipeline->GetConfig();
+		auto& pipelineConfig = pPipeline->GetConfig();
 		Pipeline::DefaultPipelineConfigInfo(pipelineConfig);
 		pipelineConfig.renderPass = renderPass;
 		pipelineConfig.pipelineLayout = pipelineLayout;
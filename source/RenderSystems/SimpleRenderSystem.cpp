@@ -55,7 +55,7 @@ namespace Nyxis
 			current_path + "/../shaders/simple_shader.frag.spv"
 		);
 
-        auto pipelineConfig = pPipeline->GetConfig();
+        auto& pipelineConfig = pPipeline->GetConfig();
         Pipeline::DefaultPipelineConfigInfo(pipelineConfig);
         pipelineConfig.renderPass = renderPass;
         pipelineConfig.pipelineLayout = pipelineLayout;
@@ -72,14 +72,14 @@ namespace Nyxis
                                 0, 1,
                                 &frameInfo.globalDescriptorSet, 0, nullptr);
 
-        Application::GetScene()->m_Registry.view<RigidBody, TransformComponent, MeshComponent>().each([&](auto entity, auto& rigidBody, auto& transform, auto& mesh)
+        Application::GetScene()->m_Registry.view<RigidBody, WorldTransform, MeshComponent>().each([&](auto entity, auto& rigidBody, auto& world, auto& mesh)
 		{
 			auto& model = *mesh.model;
 			if(model.loaded)
 			{
 				SimplePushConstantData push{};
-				push.modelMatrix = transform.mat4 ();
-				push.normalMatrix = transform.normalMatrix ();
+				push.modelMatrix = world.matrix;
+				push.normalMatrix = world.normalMatrix;
 				push.roughness = rigidBody.roughness;
 				vkCmdPushConstants (
 					frameInfo.commandBuffer,
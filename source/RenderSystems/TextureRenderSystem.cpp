@@ -133,7 +133,7 @@ namespace Nyxis
 			"../shaders/texture_shader.vert.spv",
 			"../shaders/texture_shader.frag.spv"
 			);
-		auto pipelineConfig = pPipeline->GetConfig();
+		auto& pipelineConfig = pPipeline->GetConfig();
 		Pipeline::DefaultPipelineConfigInfo(pipelineConfig);
 		pipelineConfig.renderPass = renderPass;
 		pipelineConfig.pipelineLayout = m_PipelineLayout;
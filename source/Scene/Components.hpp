@@ -47,6 +47,32 @@ namespace Nyxis
         glm::mat3 normalMatrix();
     };
 
+    // entity hierarchy, set through Scene::SetParent which keeps both sides in sync
+    struct Parent
+    {
+        entt::entity entity = entt::null;
+    };
+
+    struct Children
+    {
+        std::vector<entt::entity> entities;
+    };
+
+    // world matrix cached by Scene::UpdateWorldTransforms, rebuilt only when the local transform or an ancestor changed
+    struct WorldTransform
+    {
+        glm::mat4 matrix{ 1.0f };
+        glm::mat3 normalMatrix{ 1.0f };
+        // local transform the matrix was built from
+        glm::vec3 translation{ 0.0f };
+        glm::vec3 rotation{ 0.0f };
+        glm::vec3 scale{ 1.0f };
+        uint32_t depth = 0;
+        bool dirty = true;
+        // bumped on every rebuild
+        uint32_t version = 0;
+    };
+
     struct RigidBody
     {
         float roughness{ 0.0f };
@@ -2,8 +2,11 @@
 
 #include "Core/Application.hpp"
 #include "Core/Log.hpp"
+#include "Scene/SceneSerializer.hpp"
 #include "json/json.hpp"
 
+#include <filesystem>
+
 namespace Nyxis
 {
 	using json = nlohmann::json;
@@ -19,108 +22,144 @@ namespace Nyxis
 		LOG_INFO("[Core] Destroying project: {}", m_Name);
 	}
 
+	namespace
+	{
+		json transformToJson(const TransformComponent& transform)
+		{
+			return {
+				{"Position", {transform.translation.x, transform.translation.y, transform.translation.z}},
+				{"Rotation", {transform.rotation.x, transform.rotation.y, transform.rotation.z}},
+				{"Scale", {transform.scale.x, transform.scale.y, transform.scale.z}}
+			};
+		}
+
+		TransformComponent transformFromJson(const json& transformJson)
+		{
+			TransformComponent transform;
+			for (int i = 0; i < 3; i++)
+			{
+				transform.translation[i] = transformJson["Position"][i];
+				transform.rotation[i] = transformJson["Rotation"][i];
+				transform.scale[i] = transformJson["Scale"][i];
+			}
+			return transform;
+		}
+
+		// inline scene format of older projects, still written by ExportJson
+		void sceneFromJson(const json& sceneJson, SceneData& data)
+		{
+			data = {};
+			data.name = sceneJson["Name"];
+			data.camera = transformFromJson(sceneJson["Editor Camera"]["Transform"]);
+			for (const auto& entity : sceneJson["Entities"])
+			{
+				const auto index = static_cast<uint32_t>(data.tags.size());
+				data.tags.emplace_back(entity["Tag"].get<std::string>());
+				data.transforms.push_back(transformFromJson(entity["Transform"]));
+				data.parents.push_back(entity.value("Parent", SceneData::NO_PARENT));
+				if (entity.contains("Model"))
+					data.models.emplace_back(index, entity["Model"].get<std::string>());
+			}
+		}
+
+		json sceneToJson(const SceneData& data)
+		{
+			std::vector<const std::string*> models(data.tags.size(), nullptr);
+			for (const auto& [entity, path] : data.models)
+				models[entity] = &path;
+
+			json sceneJson;
+			sceneJson["Name"] = data.name;
+			sceneJson["Editor Camera"]["Transform"] = transformToJson(data.camera);
+			sceneJson["Entities"] = json::array();
+			for (size_t i = 0; i < data.tags.size(); i++)
+			{
+				json entityJson;
+				entityJson["Tag"] = data.tags[i].Tag;
+				entityJson["Transform"] = transformToJson(data.transforms[i]);
+				if (data.parents[i] != SceneData::NO_PARENT)
+					entityJson["Parent"] = data.parents[i];
+				if (models[i])
+					entityJson["Model"] = *models[i];
+				sceneJson["Entities"].push_back(entityJson);
+			}
+			return sceneJson;
+		}
+
+		std::string sceneFileName(const std::string& sceneName)
+		{
+			std::string name = sceneName;
+			for (auto& c : name)
+			{
+				if (!std::isalnum(static_cast<unsigned char>(c)) && c != '-' && c != '_')
+					c = '_';
+			}
+			return (name.empty() ? "Scene" : name) + SceneSerializer::EXTENSION;
+		}
+	}
+
 	/**
 	 * \brief Load a project from path file
 	 */
 	void NyxisProject::Load()
 	{
-		// wait to finish all rendering
-		vkDeviceWaitIdle(Device::Get().device());
-
-		// TODO: Load project from path file
 		std::ifstream stream(m_Path);
 		std::string file((std::istreambuf_iterator<char>(stream)), std::istreambuf_iterator<char>());
 
 		json j = json::parse(file);
 		m_Name = j["name"];
-		m_AssetsPath = j["assetsPath"];
+		m_AssetsPath = j.value("assetsPath", j.value("assetPath", m_AssetsPath));
 		m_ScenesPath = j["scenesPath"];
 
-		for(auto scene : j["Scenes"])
+		// the scenes being replaced release their GPU objects through the DeletionQueue
+		m_Scenes.clear();
+		for (const auto& sceneJson : j["Scenes"])
 		{
-			auto newScene = std::make_shared<Scene>(scene["Name"]);
-			for(auto entity : scene["Entities"])
+			SceneData data;
+			if (sceneJson.contains("File"))
 			{
-				auto newEntity = newScene->CreateEntity(entity["Tag"]);
-				newScene->AddComponent<Model>(newEntity, entity["Model"]);
-				auto& transform = newScene->GetComponent<TransformComponent>(newEntity);
-				auto& transformJson = entity["Transform"];
-				transform.translation.x = transformJson["Position"][0];
-				transform.translation.y = transformJson["Position"][1];
-				transform.translation.z = transformJson["Position"][2];
-				transform.rotation.x = transformJson["Rotation"][0];
-				transform.rotation.y = transformJson["Rotation"][1];
-				transform.rotation.z = transformJson["Rotation"][2];
-				transform.scale.x = transformJson["Scale"][0];
-				transform.scale.y = transformJson["Scale"][1];
-				transform.scale.z = transformJson["Scale"][2];
+				const auto path = (std::filesystem::path(m_ScenesPath) / sceneJson["File"].get<std::string>()).string();
+				if (!SceneSerializer::Read(path, data))
+					continue;
 			}
-
-			auto camera = newScene->GetCameraEntity();
-			auto& transform = newScene->GetComponent<TransformComponent>(camera);
-			transform.translation.x = scene["Editor Camera"]["Transform"]["Position"][0];
-			transform.translation.y = scene["Editor Camera"]["Transform"]["Position"][1];
-			transform.translation.z = scene["Editor Camera"]["Transform"]["Position"][2];
-			transform.rotation.x = scene["Editor Camera"]["Transform"]["Rotation"][0];
-			transform.rotation.y = scene["Editor Camera"]["Transform"]["Rotation"][1];
-			transform.rotation.z = scene["Editor Camera"]["Transform"]["Rotation"][2];
-			transform.scale.x = scene["Editor Camera"]["Transform"]["Scale"][0];
-			transform.scale.y = scene["Editor Camera"]["Transform"]["Scale"][1];
-			transform.scale.z = scene["Editor Camera"]["Transform"]["Scale"][2];
-
-			m_Scenes.push_back(newScene);
+			else
+			{
+				sceneFromJson(sceneJson, data);
+			}
+			m_Scenes.push_back(SceneSerializer::Instantiate(data, m_AssetsPath));
 		}
 
+		if (m_Scenes.empty())
+		{
+			LOG_WARN("[Core] Project {} has no loadable scenes", m_Name);
+			return;
+		}
 		Application::SetScene(m_Scenes.back());
 	}
 
 	/**
-	 * \brief Save the project to path file
+	 * \brief Save the project to path file, every scene goes to its own binary file in the scenes folder
 	 */
 	void NyxisProject::Save() const
 	{
-		auto scene = Application::GetScene();
+		std::error_code error;
+		std::filesystem::create_directories(m_ScenesPath, error);
 
-		std::ifstream stream(m_Path);
-		std::string file((std::istreambuf_iterator<char>(stream)), std::istreambuf_iterator<char>());
-
-		json j = json::parse(file);
+		json j;
 		j["name"] = m_Name;
-		j["assetPath"] = m_AssetsPath;
+		j["assetsPath"] = m_AssetsPath;
 		j["scenesPath"] = m_ScenesPath;
 		j["Scenes"] = json::array();
 
-		for(auto& scene : m_Scenes)
+		for (auto& scene : m_Scenes)
 		{
-			json sceneJson;
-			sceneJson["Entities"] = json::array();
-			for(auto&& [entity, model, transform] : scene->m_Registry.view<Model, TransformComponent>().each())
-			{
-				json entityJson;
-				entityJson["Transform"] = 
-				{
-						{"Position", {transform.translation.x, transform.translation.y, transform.translation.z}},
-						{"Rotation", {transform.rotation.x, transform.rotation.y, transform.rotation.z}},
-						{"Scale", {transform.scale.x, transform.scale.y, transform.scale.z}}
-				};
-
-				entityJson["Tag"] = scene->GetComponent<TagComponent>(entity).Tag;
-				entityJson["Model"] = model.path;
-				sceneJson["Entities"].push_back(entityJson);
-			}
+			SceneData data;
+			SceneSerializer::Capture(*scene, data);
 
-			// Editor Camera
-			auto cameraEntity = scene->GetCameraEntity();
-			auto& transform = scene->GetComponent<TransformComponent>(cameraEntity);
-			sceneJson["Editor Camera"]["Transform"] =
-			{
-					{"Position", {transform.translation.x, transform.translation.y, transform.translation.z}},
-					{"Rotation", {transform.rotation.x, transform.rotation.y, transform.rotation.z}},
-					{"Scale", {transform.scale.x, transform.scale.y, transform.scale.z}}
-			};
-
-			sceneJson["Name"] = scene->GetSceneName();
-			j["Scenes"].push_back(sceneJson);
+			const auto fileName = sceneFileName(data.name);
+			if (!SceneSerializer::Write((std::filesystem::path(m_ScenesPath) / fileName).string(), data))
+				continue;
+			j["Scenes"].push_back({ {"Name", data.name}, {"File", fileName} });
 		}
 
 		std::ofstream output_stream(m_Path);
@@ -129,6 +168,30 @@ namespace Nyxis
 		LOG_INFO("[Core] Saved project to {}", m_Path);
 	}
 
+	/**
+	 * \brief Write the project with its scenes inline as json, for diffing and other tools
+	 */
+	void NyxisProject::ExportJson(const std::string& path) const
+	{
+		json j;
+		j["name"] = m_Name;
+		j["assetsPath"] = m_AssetsPath;
+		j["scenesPath"] = m_ScenesPath;
+		j["Scenes"] = json::array();
+
+		for (auto& scene : m_Scenes)
+		{
+			SceneData data;
+			SceneSerializer::Capture(*scene, data);
+			j["Scenes"].push_back(sceneToJson(data));
+		}
+
+		std::ofstream output_stream(path);
+		output_stream << std::setw(4) << j << std::endl;
+		output_stream.close();
+		LOG_INFO("[Core] Exported project to {}", path);
+	}
+
 	const std::string& NyxisProject::GetAssetPath() const
 	{
 		return m_AssetsPath;
@@ -18,9 +18,11 @@ namespace Nyxis
 		void Create();
 		void Load();
 		void Save() const;
+		void ExportJson(const std::string& path) const;
 		void SetAssetsPath(const std::string& path) { m_AssetsPath = path; }
 		void SetScenesPath(const std::string& path) { m_ScenesPath = path; }
 		const std::string& GetAssetPath() const;
+		const std::string& GetPath() const { return m_Path; }
 
 		void AddScene(const Ref<Scene>& scene) { m_Scenes.push_back(scene); }
 
@@ -27,10 +27,24 @@ namespace Nyxis
         auto entity = m_Registry.create();
         m_Registry.emplace<TagComponent>(entity, name);
         m_Registry.emplace<TransformComponent>(entity);
+        m_Registry.emplace<WorldTransform>(entity);
         m_EntityCount++;
         return entity;
     }
 
+    void Scene::CreateEntities(std::vector<Entity> &entities, const std::vector<TagComponent> &tags, const std::vector<TransformComponent> &transforms)
+    {
+        entities.resize(tags.size());
+        m_Registry.create(entities.begin(), entities.end());
+        m_Registry.insert<TagComponent>(entities.begin(), entities.end(), tags.begin());
+        if (transforms.size() == tags.size())
+            m_Registry.insert<TransformComponent>(entities.begin(), entities.end(), transforms.begin());
+        else
+            m_Registry.insert<TransformComponent>(entities.begin(), entities.end());
+        m_Registry.insert<WorldTransform>(entities.begin(), entities.end());
+        m_EntityCount += static_cast<uint32_t>(entities.size());
+    }
+
     void Scene::DestroyEntity(Entity entity)
     {
         m_EntityDeletionQueue.emplace(entity);
@@ -54,17 +68,6 @@ namespace Nyxis
 
     void Scene::OnUpdate(float dt, float aspect)
     {
-        if (SaveSceneFlag)
-        {
-            SaveSceneFlag = false;
-            vkDeviceWaitIdle(device.device());
-        }
-        if (LoadSceneFlag)
-        {
-            LoadSceneFlag = false;
-            vkDeviceWaitIdle(device.device());
-        }
-
     	if (m_Camera->getType() == CameraType::Perspective)
     	{
             if (aspect > 0)
@@ -89,17 +92,150 @@ namespace Nyxis
 
         if (!m_EntityDeletionQueue.empty())
         {
-            vkDeviceWaitIdle(device.device());
             for (int i = 0; i < m_EntityDeletionQueue.size(); i++)
             {
                 const auto entity = m_EntityDeletionQueue.front();
                 m_EntityDeletionQueue.pop();
+                if (!m_Registry.valid(entity))
+                    continue;
+                // children are kept and become roots
+                if (auto* children = m_Registry.try_get<Children>(entity))
+                {
+                    for (auto child : std::vector<Entity>(children->entities))
+                        SetParent(child, entt::null);
+                }
+                SetParent(entity, entt::null);
                 m_Registry.destroy(entity);
                 m_EntityCount--;
             }
         }
     }
 
+    void Scene::SetParent(Entity child, Entity parent)
+    {
+        for (auto ancestor = parent; ancestor != entt::null; )
+        {
+            if (ancestor == child)
+            {
+                LOG_WARN("[Core] Cannot parent an entity to one of its descendants");
+                return;
+            }
+            const auto* next = m_Registry.try_get<Parent>(ancestor);
+            ancestor = next ? next->entity : entt::null;
+        }
+
+        if (const auto* current = m_Registry.try_get<Parent>(child))
+        {
+            if (auto* siblings = m_Registry.try_get<Children>(current->entity))
+            {
+                auto& entities = siblings->entities;
+                entities.erase(std::remove(entities.begin(), entities.end(), child), entities.end());
+            }
+            m_Registry.remove<Parent>(child);
+        }
+
+        if (parent != entt::null)
+        {
+            m_Registry.emplace<Parent>(child, parent);
+            m_Registry.get_or_emplace<Children>(parent).entities.push_back(child);
+        }
+
+        if (auto* world = m_Registry.try_get<WorldTransform>(child))
+            world->dirty = true;
+        m_HierarchyChanged = true;
+    }
+
+    void Scene::TransformBatch::clear()
+    {
+        entities.clear();
+        for (auto* values : { &tx, &ty, &tz, &rx, &ry, &rz, &sx, &sy, &sz })
+            values->clear();
+    }
+
+    void Scene::TransformBatch::add(Entity entity, const TransformComponent& transform)
+    {
+        entities.push_back(entity);
+        tx.push_back(transform.translation.x);
+        ty.push_back(transform.translation.y);
+        tz.push_back(transform.translation.z);
+        rx.push_back(transform.rotation.x);
+        ry.push_back(transform.rotation.y);
+        rz.push_back(transform.rotation.z);
+        sx.push_back(transform.scale.x);
+        sy.push_back(transform.scale.y);
+        sz.push_back(transform.scale.z);
+    }
+
+    void Scene::UpdateWorldTransforms()
+    {
+        if (m_HierarchyChanged)
+        {
+            m_HierarchyChanged = false;
+            m_Registry.view<WorldTransform>().each([&](auto entity, auto& world)
+            {
+                uint32_t depth = 0;
+                for (const auto* parent = m_Registry.try_get<Parent>(entity); parent; parent = m_Registry.try_get<Parent>(parent->entity))
+                    depth++;
+                world.depth = depth;
+            });
+            m_Registry.sort<WorldTransform>([](const WorldTransform& lhs, const WorldTransform& rhs) { return lhs.depth < rhs.depth; });
+        }
+
+        // parents are visited first, so their dirty flag is final when their children check it
+        auto& batch = m_TransformBatch;
+        batch.clear();
+        m_Registry.view<WorldTransform>().each([&](auto entity, auto& world)
+        {
+            const auto& local = m_Registry.get<TransformComponent>(entity);
+            if (local.translation != world.translation || local.rotation != world.rotation || local.scale != world.scale)
+                world.dirty = true;
+            if (const auto* parent = m_Registry.try_get<Parent>(entity); parent && m_Registry.get<WorldTransform>(parent->entity).dirty)
+                world.dirty = true;
+            if (!world.dirty)
+                return;
+            world.translation = local.translation;
+            world.rotation = local.rotation;
+            world.scale = local.scale;
+            batch.add(entity, local);
+        });
+
+        if (batch.entities.empty())
+            return;
+
+        // T * Rz * Ry * Rx * S, the rotation matches glm::quat(eulerAngles)
+        const size_t count = batch.entities.size();
+        batch.matrices.resize(count);
+        for (size_t i = 0; i < count; i++)
+        {
+            const float cx = std::cos(batch.rx[i]), sx = std::sin(batch.rx[i]);
+            const float cy = std::cos(batch.ry[i]), sy = std::sin(batch.ry[i]);
+            const float cz = std::cos(batch.rz[i]), sz = std::sin(batch.rz[i]);
+            glm::mat4& m = batch.matrices[i];
+            m[0] = glm::vec4(cy * cz, cy * sz, -sy, 0.0f) * batch.sx[i];
+            m[1] = glm::vec4(sx * sy * cz - cx * sz, sx * sy * sz + cx * cz, sx * cy, 0.0f) * batch.sy[i];
+            m[2] = glm::vec4(cx * sy * cz + sx * sz, cx * sy * sz - sx * cz, cx * cy, 0.0f) * batch.sz[i];
+            m[3] = glm::vec4(batch.tx[i], batch.ty[i], batch.tz[i], 1.0f);
+        }
+
+        // patched so on_update observers pick the rebuilt entities up
+        for (size_t i = 0; i < count; i++)
+        {
+            const auto entity = batch.entities[i];
+            const auto* parent = m_Registry.try_get<Parent>(entity);
+            const glm::mat4 matrix = parent ? m_Registry.get<WorldTransform>(parent->entity).matrix * batch.matrices[i] : batch.matrices[i];
+            m_Registry.patch<WorldTransform>(entity, [&](auto& world)
+            {
+                world.matrix = matrix;
+                world.normalMatrix = glm::transpose(glm::inverse(glm::mat3(matrix)));
+                world.version++;
+            });
+        }
+
+        // cleared only now, children had to see their parents' flags
+        for (const auto entity : batch.entities)
+            m_Registry.get<WorldTransform>(entity).dirty = false;
+    }
+
     /**
      * @brief - Clear the scene by destroying all entities and components
      */
@@ -112,7 +248,6 @@ namespace Nyxis
 
 	void Scene::LoadModel(const Entity entity, const std::string &filename)
     {
-        vkDeviceWaitIdle(device.device());
         m_Registry.remove<Model>(entity);
 		m_Registry.emplace<Model>(entity, filename);
 	}
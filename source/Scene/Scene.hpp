@@ -18,6 +18,8 @@ namespace Nyxis
         ~Scene();
 
         Entity CreateEntity(const std::string &name);
+        // creates one entity per tag in a single registry call, entities is resized to match
+        void CreateEntities(std::vector<Entity> &entities, const std::vector<TagComponent> &tags, const std::vector<TransformComponent> &transforms);
         std::pair<std::string, Entity> AddEntity(const std::string &filename);
         void DestroyEntity(Entity entity);
 
@@ -45,12 +47,20 @@ namespace Nyxis
 			return m_Registry.view<Comps...>();
         }
 
+        // components owning GPU objects hand them to the DeletionQueue, frames in flight keep drawing
         template <typename T> void RemoveComponent(Entity entity)
         {
-            vkDeviceWaitIdle(device.device());
             m_Registry.remove<T>(entity);
         }
 
+        // parent may be entt::null to detach, cycles are rejected
+        void SetParent(Entity child, Entity parent);
+        void MarkTransformDirty(Entity entity) { m_Registry.get<WorldTransform>(entity).dirty = true; }
+        // rebuilds the world matrices of changed entities and their descendants
+        void UpdateWorldTransforms();
+        // entities whose WorldTransform was rebuilt since the consumer last cleared it
+        entt::observer& GetTransformObserver() { return m_TransformObserver; }
+
         void ClearScene();
 		void LoadModel(Entity entity, const std::string& filename);
 
@@ -62,8 +72,8 @@ namespace Nyxis
         std::string GetSceneName() { return m_SceneName; }
 
         Registry m_Registry;
-        bool SaveSceneFlag = false;
-        bool LoadSceneFlag = false;
+        // declared after the registry, so it disconnects before the registry is destroyed
+        entt::observer m_TransformObserver{ m_Registry, entt::collector.update<WorldTransform>() };
 
 
     private:
@@ -73,9 +83,25 @@ namespace Nyxis
 		Entity m_CameraEntity = entt::null;
         uint32_t m_EntityCount = 0;
         std::atomic_int m_loadingEntity = 0;
-        Device &device = Device::Get();
 
         bool m_CameraControl = false;
     	std::queue<Entity> m_EntityDeletionQueue;
+
+        // WorldTransform storage is kept sorted by depth, parents first
+        bool m_HierarchyChanged = false;
+
+        // local transforms of the entities rebuilt this frame, in structure of arrays form so the matrix build vectorizes
+        struct TransformBatch
+        {
+            std::vector<Entity> entities;
+            std::vector<float> tx, ty, tz;
+            std::vector<float> rx, ry, rz;
+            std::vector<float> sx, sy, sz;
+            std::vector<glm::mat4> matrices;
+
+            void clear();
+            void add(Entity entity, const TransformComponent& transform);
+        };
+        TransformBatch m_TransformBatch;
     };
 } // namespace Nyxis
\ No newline at end of file
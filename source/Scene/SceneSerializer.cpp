@@ -0,0 +1,417 @@
+#include "Scene/SceneSerializer.hpp"
+
+#include "Core/Application.hpp"
+#include "Core/Log.hpp"
+#include "Graphics/GLTFModel.hpp"
+#include "Scene/Scene.hpp"
+#include "Utils/MappedFile.hpp"
+#include "Utils/ThreadPool.hpp"
+
+namespace Nyxis
+{
+	namespace
+	{
+		constexpr uint32_t fourCC(const char (&code)[5])
+		{
+			return static_cast<uint32_t>(code[0]) | static_cast<uint32_t>(code[1]) << 8 |
+				static_cast<uint32_t>(code[2]) << 16 | static_cast<uint32_t>(code[3]) << 24;
+		}
+
+		constexpr uint32_t MAGIC = fourCC("NXSC");
+		constexpr uint32_t CHUNK_STRINGS = fourCC("STRS");
+		constexpr uint32_t CHUNK_SCENE = fourCC("SCNE");
+		constexpr uint32_t CHUNK_TAGS = fourCC("TAGS");
+		constexpr uint32_t CHUNK_TRANSFORMS = fourCC("XFRM");
+		constexpr uint32_t CHUNK_PARENTS = fourCC("PRNT");
+		constexpr uint32_t CHUNK_MODELS = fourCC("MODL");
+
+		struct FileHeader
+		{
+			uint32_t magic;
+			uint32_t version;
+			uint32_t chunkCount;
+			uint32_t reserved;
+		};
+
+		struct ChunkHeader
+		{
+			uint32_t id;
+			uint32_t count;
+			uint64_t offset;
+			uint64_t size;
+		};
+
+		struct TransformRecord
+		{
+			float translation[3];
+			float rotation[3];
+			float scale[3];
+		};
+
+		struct SceneRecord
+		{
+			uint32_t name;
+			uint32_t entityCount;
+			TransformRecord camera;
+		};
+
+		struct ModelRecord
+		{
+			uint32_t entity;
+			uint32_t path;
+		};
+
+		TransformRecord toRecord(const TransformComponent& transform)
+		{
+			TransformRecord record{};
+			memcpy(record.translation, glm::value_ptr(transform.translation), sizeof(record.translation));
+			memcpy(record.rotation, glm::value_ptr(transform.rotation), sizeof(record.rotation));
+			memcpy(record.scale, glm::value_ptr(transform.scale), sizeof(record.scale));
+			return record;
+		}
+
+		TransformComponent fromRecord(const TransformRecord& record)
+		{
+			return TransformComponent(glm::make_vec3(record.translation), glm::make_vec3(record.rotation), glm::make_vec3(record.scale));
+		}
+
+		// strings are stored once, chunks refer to them by index
+		class StringTable
+		{
+		public:
+			uint32_t add(const std::string& string)
+			{
+				auto [it, inserted] = m_Indices.try_emplace(string, static_cast<uint32_t>(m_Offsets.size() - 1));
+				if (inserted)
+				{
+					m_Data.insert(m_Data.end(), string.begin(), string.end());
+					m_Offsets.push_back(static_cast<uint32_t>(m_Data.size()));
+				}
+				return it->second;
+			}
+
+			uint32_t count() const { return static_cast<uint32_t>(m_Offsets.size() - 1); }
+			const std::vector<uint32_t>& offsets() const { return m_Offsets; }
+			const std::vector<char>& data() const { return m_Data; }
+
+		private:
+			std::unordered_map<std::string, uint32_t> m_Indices;
+			std::vector<uint32_t> m_Offsets{ 0 };
+			std::vector<char> m_Data;
+		};
+
+		class ChunkWriter
+		{
+		public:
+			void begin(uint32_t id, uint32_t count)
+			{
+				// payloads start 8 byte aligned so mapped records can be read in place
+				m_Payload.resize((m_Payload.size() + 7) & ~size_t(7));
+				m_Chunks.push_back({ id, count, m_Payload.size(), 0 });
+			}
+
+			void append(const void* data, size_t size)
+			{
+				const auto* bytes = static_cast<const uint8_t*>(data);
+				m_Payload.insert(m_Payload.end(), bytes, bytes + size);
+				m_Chunks.back().size += size;
+			}
+
+			template<typename T>
+			void append(const std::vector<T>& values) { append(values.data(), values.size() * sizeof(T)); }
+
+			bool write(const std::string& path) const
+			{
+				FileHeader header{ MAGIC, SceneSerializer::VERSION, static_cast<uint32_t>(m_Chunks.size()), 0 };
+				const uint64_t payloadOffset = sizeof(FileHeader) + m_Chunks.size() * sizeof(ChunkHeader);
+
+				std::vector<ChunkHeader> chunks = m_Chunks;
+				for (auto& chunk : chunks)
+					chunk.offset += payloadOffset;
+
+				std::ofstream stream(path, std::ios::binary | std::ios::trunc);
+				if (!stream)
+					return false;
+				stream.write(reinterpret_cast<const char*>(&header), sizeof(header));
+				stream.write(reinterpret_cast<const char*>(chunks.data()), static_cast<std::streamsize>(chunks.size() * sizeof(ChunkHeader)));
+				stream.write(reinterpret_cast<const char*>(m_Payload.data()), static_cast<std::streamsize>(m_Payload.size()));
+				return static_cast<bool>(stream);
+			}
+
+		private:
+			std::vector<ChunkHeader> m_Chunks;
+			std::vector<uint8_t> m_Payload;
+		};
+
+		// bounds checked view of a chunk in the mapped file
+		template<typename T>
+		const T* chunkData(const MappedFile& file, const ChunkHeader& chunk, uint64_t count)
+		{
+			if (chunk.offset % alignof(T) != 0 || chunk.offset > file.size() || count * sizeof(T) > file.size() - chunk.offset)
+				return nullptr;
+			return reinterpret_cast<const T*>(file.data() + chunk.offset);
+		}
+	}
+
+	void SceneSerializer::Capture(Scene& scene, SceneData& data)
+	{
+		auto& registry = scene.m_Registry;
+		const auto camera = scene.GetCameraEntity();
+
+		data = {};
+		data.name = scene.GetSceneName();
+		data.camera = registry.get<TransformComponent>(camera);
+
+		// Model::loadNode creates an entity per glTF node plus one for its id, loading the model recreates both
+		std::unordered_set<Entity> modelOwned;
+		for (auto&& [entity, node] : registry.view<Node>().each())
+		{
+			modelOwned.insert(entity);
+			modelOwned.insert(static_cast<Entity>(node.entityID));
+		}
+
+		std::unordered_map<Entity, uint32_t> indices;
+		std::vector<Entity> entities;
+		for (auto&& [entity, tag, transform] : registry.view<TagComponent, TransformComponent>().each())
+		{
+			if (entity == camera || modelOwned.contains(entity))
+				continue;
+			indices.emplace(entity, static_cast<uint32_t>(entities.size()));
+			entities.push_back(entity);
+			data.tags.push_back(tag);
+			data.transforms.push_back(transform);
+		}
+
+		data.parents.resize(entities.size(), SceneData::NO_PARENT);
+		for (size_t i = 0; i < entities.size(); i++)
+		{
+			if (const auto* parent = registry.try_get<Parent>(entities[i]))
+			{
+				const auto it = indices.find(parent->entity);
+				if (it != indices.end())
+					data.parents[i] = it->second;
+			}
+			if (const auto* model = registry.try_get<Model>(entities[i]); model && !model->path.empty() && model->path != "None")
+				data.models.emplace_back(static_cast<uint32_t>(i), model->path);
+		}
+	}
+
+	Ref<Scene> SceneSerializer::Instantiate(const SceneData& data, const std::string& assetsPath)
+	{
+		auto tStart = std::chrono::high_resolution_clock::now();
+
+		// parsing is the expensive part of a model load and does not touch the device
+		struct ModelFile
+		{
+			Ref<tinygltf::Model> parsed;
+			std::future<void> parsing;
+			std::vector<uint32_t> entities;
+		};
+		std::vector<ModelFile> files;
+		std::unordered_map<std::string, size_t> fileIndices;
+		for (const auto& [entity, path] : data.models)
+		{
+			auto [it, inserted] = fileIndices.try_emplace(path, files.size());
+			if (inserted)
+				files.emplace_back();
+			files[it->second].entities.push_back(entity);
+		}
+
+		ThreadPool loaders(std::max(2u, std::thread::hardware_concurrency()) - 1);
+		for (const auto& [path, index] : fileIndices)
+		{
+			auto& file = files[index];
+			const auto filename = assetsPath + path;
+			file.parsing = loaders.submit([&file, filename]() { file.parsed = Model::parseFile(filename); });
+		}
+
+		auto scene = std::make_shared<Scene>(data.name);
+		scene->GetComponent<TransformComponent>(scene->GetCameraEntity()) = data.camera;
+
+		std::vector<Entity> entities(data.tags.size());
+		scene->CreateEntities(entities, data.tags, data.transforms);
+		for (size_t i = 0; i < data.parents.size() && i < entities.size(); i++)
+		{
+			if (data.parents[i] < entities.size())
+				scene->SetParent(entities[i], entities[data.parents[i]]);
+		}
+
+		// models create their node entities in the current scene
+		Application::SetScene(scene);
+
+		// device uploads stay on this thread, they overlap with the files still being parsed
+		std::vector<const std::string*> paths(files.size());
+		for (const auto& [path, index] : fileIndices)
+			paths[index] = &path;
+		for (size_t i = 0; i < files.size(); i++)
+		{
+			auto& file = files[i];
+			file.parsing.get();
+			if (!file.parsed)
+				continue;
+			for (auto entity : file.entities)
+			{
+				if (entity < entities.size())
+					scene->AddComponent<Model>(entities[entity], *paths[i], file.parsed);
+			}
+			file.parsed.reset();
+		}
+
+		auto tDiff = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - tStart).count();
+		LOG_INFO("[Core] Instantiated scene {} with {} entities and {} model files in {} ms", data.name, entities.size(), files.size(), tDiff);
+		return scene;
+	}
+
+	bool SceneSerializer::Write(const std::string& path, const SceneData& data)
+	{
+		StringTable strings;
+		std::vector<uint32_t> tags;
+		tags.reserve(data.tags.size());
+		for (const auto& tag : data.tags)
+			tags.push_back(strings.add(tag.Tag));
+
+		std::vector<TransformRecord> transforms;
+		transforms.reserve(data.transforms.size());
+		for (const auto& transform : data.transforms)
+			transforms.push_back(toRecord(transform));
+
+		std::vector<ModelRecord> models;
+		models.reserve(data.models.size());
+		for (const auto& [entity, modelPath] : data.models)
+			models.push_back({ entity, strings.add(modelPath) });
+
+		SceneRecord sceneRecord{ strings.add(data.name), static_cast<uint32_t>(data.tags.size()), toRecord(data.camera) };
+
+		ChunkWriter writer;
+		writer.begin(CHUNK_STRINGS, strings.count());
+		writer.append(strings.offsets());
+		writer.append(strings.data());
+		writer.begin(CHUNK_SCENE, 1);
+		writer.append(&sceneRecord, sizeof(sceneRecord));
+		writer.begin(CHUNK_TAGS, static_cast<uint32_t>(tags.size()));
+		writer.append(tags);
+		writer.begin(CHUNK_TRANSFORMS, static_cast<uint32_t>(transforms.size()));
+		writer.append(transforms);
+		writer.begin(CHUNK_PARENTS, static_cast<uint32_t>(data.parents.size()));
+		writer.append(data.parents);
+		writer.begin(CHUNK_MODELS, static_cast<uint32_t>(models.size()));
+		writer.append(models);
+
+		if (!writer.write(path))
+		{
+			LOG_ERROR("[Core] Could not write scene file {}", path);
+			return false;
+		}
+		return true;
+	}
+
+	bool SceneSerializer::Read(const std::string& path, SceneData& data)
+	{
+		MappedFile file(path);
+		if (!file.isOpen())
+		{
+			LOG_ERROR("[Core] Could not open scene file {}", path);
+			return false;
+		}
+
+		const auto* header = file.size() >= sizeof(FileHeader) ? reinterpret_cast<const FileHeader*>(file.data()) : nullptr;
+		if (!header || header->magic != MAGIC)
+		{
+			LOG_ERROR("[Core] {} is not a scene file", path);
+			return false;
+		}
+		if (header->version > VERSION)
+		{
+			LOG_ERROR("[Core] Scene file {} has version {}, this build reads up to {}", path, header->version, VERSION);
+			return false;
+		}
+		if (static_cast<uint64_t>(header->chunkCount) * sizeof(ChunkHeader) > file.size() - sizeof(FileHeader))
+		{
+			LOG_ERROR("[Core] Scene file {} is truncated", path);
+			return false;
+		}
+
+		std::unordered_map<uint32_t, ChunkHeader> chunks;
+		const auto* chunkHeaders = reinterpret_cast<const ChunkHeader*>(file.data() + sizeof(FileHeader));
+		for (uint32_t i = 0; i < header->chunkCount; i++)
+			chunks.emplace(chunkHeaders[i].id, chunkHeaders[i]);
+
+		const auto stringsChunk = chunks.find(CHUNK_STRINGS);
+		const auto sceneChunk = chunks.find(CHUNK_SCENE);
+		if (stringsChunk == chunks.end() || sceneChunk == chunks.end())
+		{
+			LOG_ERROR("[Core] Scene file {} misses required chunks", path);
+			return false;
+		}
+
+		// count + 1 offsets into the characters that follow them, each string ends where the next one starts
+		const auto& stringsHeader = stringsChunk->second;
+		const uint64_t offsetsSize = (uint64_t(stringsHeader.count) + 1) * sizeof(uint32_t);
+		const auto* offsets = stringsHeader.size >= offsetsSize ? chunkData<uint32_t>(file, stringsHeader, uint64_t(stringsHeader.count) + 1) : nullptr;
+		bool stringsValid = offsets && chunkData<char>(file, stringsHeader, stringsHeader.size);
+		const uint64_t characterCount = stringsHeader.size - offsetsSize;
+		for (uint32_t i = 0; stringsValid && i < stringsHeader.count; i++)
+			stringsValid = offsets[i] <= offsets[i + 1];
+		if (!stringsValid || offsets[stringsHeader.count] > characterCount)
+		{
+			LOG_ERROR("[Core] Scene file {} has a broken string table", path);
+			return false;
+		}
+		const auto* characters = reinterpret_cast<const char*>(offsets + stringsHeader.count + 1);
+		auto string = [&](uint32_t index) -> std::string {
+			if (index >= stringsHeader.count)
+				return {};
+			return std::string(characters + offsets[index], offsets[index + 1] - offsets[index]);
+		};
+
+		const auto* sceneRecord = chunkData<SceneRecord>(file, sceneChunk->second, 1);
+		if (!sceneRecord)
+		{
+			LOG_ERROR("[Core] Scene file {} is truncated", path);
+			return false;
+		}
+		const uint32_t entityCount = sceneRecord->entityCount;
+
+		data = {};
+		data.name = string(sceneRecord->name);
+		data.camera = fromRecord(sceneRecord->camera);
+		data.tags.resize(entityCount);
+		data.transforms.resize(entityCount);
+		data.parents.assign(entityCount, SceneData::NO_PARENT);
+
+		auto find = [&](uint32_t id, auto* type) -> decltype(type) {
+			using T = std::remove_const_t<std::remove_pointer_t<decltype(type)>>;
+			const auto it = chunks.find(id);
+			if (it == chunks.end() || it->second.count != entityCount)
+				return nullptr;
+			return chunkData<T>(file, it->second, entityCount);
+		};
+
+		if (const auto* tags = find(CHUNK_TAGS, static_cast<const uint32_t*>(nullptr)))
+		{
+			for (uint32_t i = 0; i < entityCount; i++)
+				data.tags[i].Tag = string(tags[i]);
+		}
+		if (const auto* transforms = find(CHUNK_TRANSFORMS, static_cast<const TransformRecord*>(nullptr)))
+		{
+			for (uint32_t i = 0; i < entityCount; i++)
+				data.transforms[i] = fromRecord(transforms[i]);
+		}
+		if (const auto* parents = find(CHUNK_PARENTS, static_cast<const uint32_t*>(nullptr)))
+			data.parents.assign(parents, parents + entityCount);
+
+		if (const auto modelsChunk = chunks.find(CHUNK_MODELS); modelsChunk != chunks.end())
+		{
+			if (const auto* models = chunkData<ModelRecord>(file, modelsChunk->second, modelsChunk->second.count))
+			{
+				data.models.reserve(modelsChunk->second.count);
+				for (uint32_t i = 0; i < modelsChunk->second.count; i++)
+				{
+					if (models[i].entity < entityCount)
+						data.models.emplace_back(models[i].entity, string(models[i].path));
+				}
+			}
+		}
+		return true;
+	}
+}
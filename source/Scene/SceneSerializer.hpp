@@ -0,0 +1,45 @@
+#pragma once
+#include "Core/Nyxis.hpp"
+#include "Core/Nyxispch.hpp"
+#include "Scene/Components.hpp"
+
+namespace Nyxis
+{
+	class Scene;
+
+	// Scene contents in serialization order, independent of the file format
+	struct SceneData
+	{
+		static constexpr uint32_t NO_PARENT = UINT32_MAX;
+
+		std::string name;
+		TransformComponent camera;
+		std::vector<TagComponent> tags;
+		std::vector<TransformComponent> transforms;
+		// index of the parent entity or NO_PARENT
+		std::vector<uint32_t> parents;
+		// entity index and asset relative path
+		std::vector<std::pair<uint32_t, std::string>> models;
+	};
+
+	/**
+	 * \brief Binary scene files (.nxscene)
+	 *
+	 * Versioned header, chunk table, a string table and one chunk per component type. Every chunk is a flat
+	 * array, so a mapped file is read without parsing. Unknown chunks are skipped, so newer writers stay readable.
+	 */
+	class SceneSerializer
+	{
+	public:
+		static constexpr uint32_t VERSION = 1;
+		static constexpr const char* EXTENSION = ".nxscene";
+
+		static void Capture(Scene& scene, SceneData& data);
+		// creates the entities in bulk, every distinct model file is parsed once on a worker thread.
+		// The scene becomes the application's current scene.
+		static Ref<Scene> Instantiate(const SceneData& data, const std::string& assetsPath);
+
+		static bool Write(const std::string& path, const SceneData& data);
+		static bool Read(const std::string& path, SceneData& data);
+	};
+}
@@ -0,0 +1,34 @@
+#pragma once
+#include "Core/Nyxispch.hpp"
+
+namespace Nyxis
+{
+    // read only memory mapping of a whole file, the pages are loaded by the OS on first access
+    class MappedFile
+    {
+    public:
+        MappedFile() = default;
+        explicit MappedFile(const std::string &path) { open(path); }
+        ~MappedFile() { close(); }
+
+        MappedFile(const MappedFile &) = delete;
+        MappedFile &operator=(const MappedFile &) = delete;
+
+        bool open(const std::string &path);
+        void close();
+
+        [[nodiscard]] bool isOpen() const { return m_Data != nullptr; }
+        [[nodiscard]] const uint8_t *data() const { return m_Data; }
+        [[nodiscard]] size_t size() const { return m_Size; }
+
+    private:
+        const uint8_t *m_Data = nullptr;
+        size_t m_Size = 0;
+#ifdef _WIN32
+        void *m_File = nullptr;
+        void *m_Mapping = nullptr;
+#else
+        int m_File = -1;
+#endif
+    };
+} // namespace Nyxis
@@ -56,6 +56,16 @@ namespace Nyxis
 			pCondition.notify_one();
 		}
 
+		// like enqueue, the future becomes ready once the task ran and rethrows its exception
+		template <class F>
+		std::future<void> submit(F&& task)
+		{
+			auto packagedTask = std::make_shared<std::packaged_task<void()>>(std::forward<F>(task));
+			auto future = packagedTask->get_future();
+			enqueue([packagedTask] { (*packagedTask)(); });
+			return future;
+		}
+
 		void wait()
 		{
 			for (auto& thread : pThreads)
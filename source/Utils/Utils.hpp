@@ -9,4 +9,23 @@ namespace Nyxis
         seed ^= std::hash<T>{}(v) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
         (hashCombine(seed, rest), ...);
     };
+
+    // FNV-1a, stable across runs and platforms so it can key on-disk caches
+    inline uint64_t hashBytes(const void *data, size_t size, uint64_t seed = 0xcbf29ce484222325ull)
+    {
+        const auto *bytes = static_cast<const uint8_t *>(data);
+        for (size_t i = 0; i < size; i++)
+        {
+            seed ^= bytes[i];
+            seed *= 0x100000001b3ull;
+        }
+        return seed;
+    }
+
+    // only for types without padding, the padding bytes would be hashed as well
+    template <typename T>
+    uint64_t hashValue(const T &value, uint64_t seed = 0xcbf29ce484222325ull)
+    {
+        return hashBytes(&value, sizeof(T), seed);
+    }
 }
\ No newline at end of file